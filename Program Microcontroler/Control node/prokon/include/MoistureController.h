@@ -0,0 +1,88 @@
+/*
+ * MoistureController - Penyiraman closed-loop berdasarkan kelembapan tanah
+ *
+ * Jadwal RTC tetap menentukan KAPAN penyiraman dipertimbangkan; controller ini
+ * menentukan APAKAH dan BERAPA LAMA, berdasarkan bacaan soil terbaru:
+ *
+ *   - Histeresis: tanah dianggap "basah" setelah mencapai targetHigh dan baru
+ *     dianggap "perlu air" lagi setelah turun di bawah targetLow. Selama basah,
+ *     jadwal dilewati (mis. setelah hujan).
+ *   - Proporsional: durasi = durasi dasar x (targetHigh - m) / (targetHigh - targetLow),
+ *     dibatasi [minScale, maxScale]. Tepat di targetLow = durasi dasar, lebih
+ *     kering = diperpanjang, lebih basah = diperpendek.
+ *   - Cutoff: penyiraman berjalan dihentikan lebih awal jika bacaan baru sudah
+ *     mencapai targetHigh.
+ *   - Tanpa bacaan segar (sensor/server mati), kembali ke durasi dasar
+ *     (perilaku open-loop lama).
+ *
+ * Tidak bergantung pada Arduino; waktu diberikan oleh pemanggil (ms).
+ */
+#pragma once
+
+#include <stdint.h>
+
+struct MoistureControllerConfig {
+    float targetLow;              // % — di bawah ini tanah perlu disiram
+    float targetHigh;             // % — di atas ini tanah cukup basah
+    float minScale;               // Faktor durasi minimum saat disiram
+    float maxScale;               // Faktor durasi maksimum (tanah sangat kering)
+    unsigned long maxReadingAgeMs; // Bacaan lebih tua dari ini diabaikan
+};
+
+class MoistureController {
+public:
+    enum Action : uint8_t {
+        RUN_OPEN_LOOP,  // Tidak ada bacaan segar: durasi dasar
+        RUN,            // Siram dengan durasi hasil controller
+        SKIP,           // Tanah cukup basah: lewati jadwal
+    };
+
+    struct Plan {
+        Action action;
+        unsigned long durationSec;
+        float moisture;
+    };
+
+    explicit MoistureController(const MoistureControllerConfig& config) : _config(config) {}
+
+    void ingest(float moisture, unsigned long nowMs) {
+        _moisture = moisture;
+        _readingAt = nowMs;
+        _hasReading = true;
+
+        if (moisture >= _config.targetHigh) _wet = true;
+        else if (moisture < _config.targetLow) _wet = false;
+    }
+
+    bool fresh(unsigned long nowMs) const {
+        return _hasReading && nowMs - _readingAt <= _config.maxReadingAgeMs;
+    }
+
+    Plan plan(unsigned long baseDurationSec, unsigned long nowMs) const {
+        if (!fresh(nowMs)) return {RUN_OPEN_LOOP, baseDurationSec, _moisture};
+        if (_wet) return {SKIP, 0, _moisture};
+
+        float span = _config.targetHigh - _config.targetLow;
+        float scale = span > 0 ? (_config.targetHigh - _moisture) / span : 1.0f;
+        if (scale < _config.minScale) scale = _config.minScale;
+        if (scale > _config.maxScale) scale = _config.maxScale;
+
+        unsigned long duration = (unsigned long)(baseDurationSec * scale + 0.5f);
+        return {RUN, duration > 0 ? duration : 1, _moisture};
+    }
+
+    // true jika penyiraman yang sedang berjalan sebaiknya dihentikan
+    bool shouldStop(unsigned long nowMs) const {
+        return fresh(nowMs) && _moisture >= _config.targetHigh;
+    }
+
+    float moisture() const { return _moisture; }
+    bool hasReading() const { return _hasReading; }
+
+private:
+    MoistureControllerConfig _config;
+    float _moisture = 0;
+    unsigned long _readingAt = 0;
+    bool _hasReading = false;
+    bool _wet = false;
+};
@@ -0,0 +1,295 @@
+/*
+ * RemoteApi - Parse response server Laravel untuk control node
+ *
+ *   parseValveStatus()   : body /api/water-status atau data event SSE
+ *   readScheduleArray()  : array /api/schedules, satu entri per satu dari stream
+ *   parseMoisture()      : body /api/sensor/latest (bacaan soil terbaru)
+ *   pollValveStatus()    : GET /api/water-status + parse (checkRemoteStatus)
+ *   syncScheduleTable()  : GET /api/schedules kondisional (ETag) + parse +
+ *                          bandingkan dengan jadwal aktif (syncSchedulesFromAPI)
+ *
+ * Semua dokumen berukuran tetap (StaticJsonDocument + filter field yang
+ * dipakai), jadi parse tidak mengalokasikan heap dan memorinya tidak tumbuh
+ * dengan ukuran response. Dipakai firmware (stream HTTP/SSE) dan benchmark
+ * host (body rekaman), sehingga jalur yang diukur di --bench sama dengan yang
+ * berjalan di ESP32.
+ *
+ * TStream menyediakan int peek(), int read() dan size_t readBytes(char*, size_t);
+ * peek()/read() mengembalikan -1 jika data habis. Di firmware, stream HTTP
+ * (HttpTransport::bodyStream()) menunggu data seperti Stream::timedRead.
+ *
+ * TTransport menyediakan int get(path), setIfNoneMatch(etag), header("ETag")
+ * (objek dengan c_str()), TStream& bodyStream() dan end(): HttpTransport di
+ * firmware, transport rekaman di benchmark host.
+ *
+ * Tidak bergantung pada Arduino (ArduinoJson v6).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <ArduinoJson.h>
+#include "ScheduleTable.h"
+
+// Ukuran dokumen JSON tetap (setelah filter) — tidak ada alokasi heap saat parse
+const size_t STATUS_DOC_SIZE = JSON_OBJECT_SIZE(2) + 16;
+// Jadwal di-parse per entri, jadi ukurannya tidak bergantung jumlah jadwal
+const size_t SCHEDULE_ENTRY_DOC_SIZE = JSON_OBJECT_SIZE(6) + JSON_ARRAY_SIZE(7) +
+                                       96; // key + string type/time
+const size_t MOISTURE_DOC_SIZE = JSON_OBJECT_SIZE(2) + 32;
+
+// ==================== STATUS VALVE ====================
+
+struct RemoteValveStatus {
+    bool on;
+    int zone;   // Mulai 1 (default 1 untuk server lama tanpa field "zone")
+};
+
+// Filter JSON water-status: hanya "valve_status" & "zone" yang disimpan ke dokumen
+inline const JsonDocument& valveStatusFilter() {
+    static StaticJsonDocument<64> filter;
+    if (filter.isNull()) {
+        filter["valve_status"] = true;
+        filter["zone"] = true;
+    }
+    return filter;
+}
+
+// Response dari Laravel SensorController / event SSE:
+// {"id":1,"valve_status":"ON","zone":1,"duration":30,"created_at":"...","updated_at":"..."}
+// false jika JSON rusak atau "valve_status" (bukan "status") bukan ON/OFF.
+template <typename TInput>
+bool parseValveStatus(TInput& input, RemoteValveStatus& out) {
+    StaticJsonDocument<STATUS_DOC_SIZE> doc;
+    if (deserializeJson(doc, input, DeserializationOption::Filter(valveStatusFilter()))) return false;
+
+    const char* status = doc["valve_status"] | "";
+    if (strcmp(status, "ON") == 0) {
+        out.on = true;
+    } else if (strcmp(status, "OFF") == 0) {
+        out.on = false;
+    } else {
+        return false;
+    }
+    out.zone = doc["zone"] | 1;
+    return true;
+}
+
+// ==================== JADWAL ====================
+
+// Field mentah satu entri jadwal, untuk log
+struct ScheduleFields {
+    const char* scheduleType;
+    const char* scheduleTime;
+    bool active;
+    int durationMinutes;
+    int zone;
+    uint8_t weekdays;
+};
+
+// Dipanggil untuk setiap entri di response (number mulai 1), valid atau tidak
+typedef void (*ScheduleEntryFn)(int number, const ScheduleFields& fields, bool valid);
+
+struct ScheduleParseResult {
+    enum Status : uint8_t { OK, NOT_ARRAY, BAD_JSON, TRUNCATED };
+
+    Status status;
+    DeserializationError error; // BAD_JSON
+    int total;                  // Entri di response, termasuk yang tidak valid/tidak muat
+    uint8_t count;              // Entri valid yang ditulis ke tabel
+};
+
+// Lewati whitespace dan kembalikan karakter berikutnya tanpa membacanya
+// (-1 jika data habis)
+template <typename TStream>
+int peekToken(TStream& stream) {
+    for (;;) {
+        int c = stream.peek();
+        if (c < 0 || !isspace(c)) return c;
+        stream.read();
+    }
+}
+
+// Satu objek jadwal dari server:
+// {"schedule_type":"pagi","schedule_time":"06:00:00","is_active":1,
+//  "duration_minutes":5,"days":[1,2,3,4,5],"zone":1}
+// "days" (0 = Minggu) dan "zone" (mulai 1) opsional: default setiap hari, zona 1.
+inline bool parseScheduleEntry(JsonObjectConst schedule, ScheduleFields& fields, ScheduleEntry& entry) {
+    fields.scheduleType = schedule["schedule_type"] | "";
+    fields.scheduleTime = schedule["schedule_time"] | "";
+
+    // 🔥 FIX: Parse is_active sebagai integer dulu, baru convert ke bool
+    int isActiveInt = schedule["is_active"] | 0;
+    fields.active = (isActiveInt == 1 || isActiveInt == true);
+
+    fields.durationMinutes = schedule["duration_minutes"] | 30;
+    fields.zone = schedule["zone"] | 1;
+
+    fields.weekdays = WEEKDAYS_ALL;
+    if (schedule["days"].is<JsonArrayConst>()) {
+        fields.weekdays = 0;
+        for (int day : schedule["days"].as<JsonArrayConst>()) {
+            if (day >= 0 && day <= 6) fields.weekdays |= 1 << day;
+        }
+    }
+
+    const char* scheduleTime = fields.scheduleTime;
+    if (strlen(scheduleTime) < 5) return false;
+    int hour = (scheduleTime[0] - '0') * 10 + (scheduleTime[1] - '0');
+    int minute = (scheduleTime[3] - '0') * 10 + (scheduleTime[4] - '0');
+    if (hour < 0 || hour > 23 || minute < 0 || minute > 59) return false;
+
+    long durationSec = (long)fields.durationMinutes * 60;
+    int zone = fields.zone;
+    entry.minuteOfDay = hour * 60 + minute;
+    entry.durationSec = durationSec < 1 ? 1 : (durationSec > 65535 ? 65535 : durationSec);
+    entry.weekdays = fields.weekdays;
+    entry.zone = zone < 1 ? 0 : (zone > 255 ? 254 : zone - 1);
+    entry.enabled = fields.active;
+    entry.reserved = 0;
+    return true;
+}
+
+// Parse array jadwal satu entri per satu langsung dari stream, sehingga
+// memori parse tetap ~1 entri berapa pun panjang tabelnya. Entri yang tidak
+// valid dilewati; entri di atas `capacity` dihitung di `total` saja.
+template <typename TStream>
+ScheduleParseResult readScheduleArray(TStream& body, ScheduleEntry* out, uint8_t capacity,
+                                      ScheduleEntryFn onEntry = nullptr) {
+    StaticJsonDocument<160> filter;
+    filter["schedule_type"] = true;
+    filter["schedule_time"] = true;
+    filter["is_active"] = true;
+    filter["duration_minutes"] = true;
+    filter["days"] = true;
+    filter["zone"] = true;
+
+    ScheduleParseResult result;
+    result.status = ScheduleParseResult::OK;
+    result.error = DeserializationError::Ok;
+    result.total = 0;
+    result.count = 0;
+
+    int c;
+    while ((c = body.read()) >= 0 && c != '[') {}
+    if (c < 0) {
+        result.status = ScheduleParseResult::NOT_ARRAY;
+        return result;
+    }
+    if (peekToken(body) == ']') return result; // Tidak ada jadwal
+
+    for (;;) {
+        StaticJsonDocument<SCHEDULE_ENTRY_DOC_SIZE> doc;
+        result.error = deserializeJson(doc, body, DeserializationOption::Filter(filter));
+        if (result.error) {
+            result.status = ScheduleParseResult::BAD_JSON;
+            return result;
+        }
+
+        result.total++;
+        if (result.count < capacity) {
+            ScheduleFields fields;
+            bool valid = parseScheduleEntry(doc.as<JsonObjectConst>(), fields, out[result.count]);
+            if (onEntry) onEntry(result.total, fields, valid);
+            if (valid) result.count++;
+        }
+
+        int separator = peekToken(body);
+        body.read();
+        if (separator == ']') return result;
+        if (separator != ',') {
+            result.status = ScheduleParseResult::TRUNCATED;
+            return result;
+        }
+    }
+}
+
+// ==================== KELEMBAPAN TANAH ====================
+
+struct RemoteMoisture {
+    float soil;             // %
+    uint32_t ageSeconds;    // Umur bacaan di server (0 jika tidak dikirim)
+};
+
+// Response /api/sensor/latest: {"soil":42,"age_seconds":12,...}; field lain dibuang.
+// false jika JSON rusak atau "soil" tidak ada.
+template <typename TInput>
+bool parseMoisture(TInput& input, RemoteMoisture& out) {
+    StaticJsonDocument<32> filter;
+    filter["soil"] = true;
+    filter["age_seconds"] = true;
+
+    StaticJsonDocument<MOISTURE_DOC_SIZE> doc;
+    if (deserializeJson(doc, input, DeserializationOption::Filter(filter))) return false;
+    if (!doc["soil"].is<float>()) return false;
+
+    out.soil = doc["soil"];
+    out.ageSeconds = doc["age_seconds"] | 0UL;
+    return true;
+}
+
+// ==================== REQUEST ====================
+
+struct ValveStatusPoll {
+    int code;               // Kode HTTP (<= 0 = error transport)
+    bool parsed;            // status valid
+    RemoteValveStatus status;
+};
+
+// Satu polling water-status: GET, parse dari stream, selesai request
+template <typename TTransport>
+ValveStatusPoll pollValveStatus(TTransport& api, const char* path) {
+    ValveStatusPoll poll;
+    poll.parsed = false;
+    poll.code = api.get(path);
+    if (poll.code > 0) poll.parsed = parseValveStatus(api.bodyStream(), poll.status);
+    api.end();
+    return poll;
+}
+
+struct ScheduleSync {
+    enum Status : uint8_t { NOT_MODIFIED, CHANGED, UNCHANGED, PARSE_FAILED, HTTP_ERROR };
+
+    Status status;
+    int code;
+    ScheduleParseResult parse;  // CHANGED / UNCHANGED / PARSE_FAILED
+};
+
+// Sinkronisasi kondisional: `etag` dikirim sebagai If-None-Match (304 = tidak
+// berubah) dan diganti ETag baru hanya setelah body berhasil di-parse. Jadwal
+// baru ditulis ke `out` (kapasitas `capacity`); CHANGED jika berbeda dari
+// `current`.
+template <typename TTransport>
+ScheduleSync syncScheduleTable(TTransport& api, const char* path, char* etag, size_t etagSize,
+                               const ScheduleEntry* current, uint8_t currentCount, ScheduleEntry* out,
+                               uint8_t capacity, ScheduleEntryFn onEntry = nullptr) {
+    ScheduleSync sync;
+    sync.parse.status = ScheduleParseResult::OK;
+    sync.parse.error = DeserializationError::Ok;
+    sync.parse.total = 0;
+    sync.parse.count = 0;
+
+    api.setIfNoneMatch(etag);
+    sync.code = api.get(path);
+    if (sync.code == 304) {
+        sync.status = ScheduleSync::NOT_MODIFIED;
+    } else if (sync.code <= 0) {
+        sync.status = ScheduleSync::HTTP_ERROR;
+    } else {
+        auto newEtag = api.header("ETag");
+        sync.parse = readScheduleArray(api.bodyStream(), out, capacity, onEntry);
+        if (sync.parse.status != ScheduleParseResult::OK) {
+            sync.status = ScheduleSync::PARSE_FAILED;
+        } else {
+            snprintf(etag, etagSize, "%s", newEtag.c_str());
+            bool changed = sync.parse.count != currentCount ||
+                           memcmp(out, current, sync.parse.count * sizeof(ScheduleEntry)) != 0;
+            sync.status = changed ? ScheduleSync::CHANGED : ScheduleSync::UNCHANGED;
+        }
+    }
+    api.end();
+    return sync;
+}
@@ -0,0 +1,168 @@
+/*
+ * ScheduleTable - Tabel jadwal penyiraman dengan event berikutnya yang sudah dihitung
+ *
+ * Setiap entri punya jam:menit, mask hari, zona dan durasi sendiri. Tabel
+ * disimpan terurut per menit-dalam-hari; event berikutnya dihitung sekali
+ * (saat tabel berubah atau setelah event jatuh tempo), sehingga pengecekan
+ * tiap detik cukup satu perbandingan waktu.
+ *
+ * Catch-up: tick yang terlambat (task sibuk, detik ke-0 terlewat) tetap
+ * menjalankan event selama keterlambatannya <= catchUpSec. Event yang lebih
+ * lama terlewat (mis. node mati semalaman, RTC lompat maju) dilewati, bukan
+ * dijalankan beruntun; setiap celah seperti itu dihitung di skipped().
+ *
+ * Waktu dalam detik "epoch lokal" (TimeService::now(), basis yang sama dengan
+ * DateTime::unixtime() dari RTC). Tidak bergantung pada Arduino.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define WEEKDAYS_ALL 0x7F // bit 0 = Minggu ... bit 6 = Sabtu (DateTime::dayOfTheWeek)
+
+struct ScheduleEntry {
+    uint16_t minuteOfDay;   // 0-1439
+    uint16_t durationSec;
+    uint8_t weekdays;       // Mask hari aktif
+    uint8_t zone;           // Zona/valve tujuan
+    uint8_t enabled;
+    uint8_t reserved;
+};
+
+template <size_t MAX_ENTRIES = 32>
+class ScheduleTable {
+public:
+    struct Event {
+        uint32_t at;        // Epoch lokal saat event jatuh tempo
+        uint8_t index;      // Indeks entri pada tabel asli (urutan server)
+    };
+
+    explicit ScheduleTable(uint32_t catchUpSec = 300) : _catchUpSec(catchUpSec) {}
+
+    // Ganti isi tabel; event berikutnya dihitung ulang dari `now`
+    void load(const ScheduleEntry* entries, size_t count, uint32_t now) {
+        _count = count > MAX_ENTRIES ? MAX_ENTRIES : count;
+        for (size_t i = 0; i < _count; i++) {
+            _entries[i] = entries[i];
+            _order[i] = (uint8_t)i;
+        }
+        // Insertion sort berdasarkan menit (stabil; n kecil, jarang dipanggil)
+        for (size_t i = 1; i < _count; i++) {
+            uint8_t v = _order[i];
+            size_t j = i;
+            while (j > 0 && _entries[_order[j - 1]].minuteOfDay > _entries[v].minuteOfDay) {
+                _order[j] = _order[j - 1];
+                j--;
+            }
+            _order[j] = v;
+        }
+        rearm(now);
+    }
+
+    // Hitung ulang event berikutnya (mis. setelah RTC disetel ulang)
+    void rearm(uint32_t now) {
+        _hasNext = find(now, _next);
+        _lastNow = now;
+    }
+
+    // Dipanggil tiap tick; true jika ada event jatuh tempo untuk dijalankan.
+    // Panggil berulang sampai false jika beberapa event jatuh tempo bersamaan.
+    bool poll(uint32_t now, Event& out) {
+        // RTC mundur lebih dari satu menit: event yang dihitung sudah tidak berlaku
+        if (now + 60 < _lastNow) rearm(now);
+        _lastNow = now;
+
+        // Terlewat jauh: lompat langsung ke jendela catch-up
+        if (_hasNext && now >= _next.at && now - _next.at > _catchUpSec) {
+            _hasNext = find(now - _catchUpSec, _next);
+            _skipped++;
+        }
+
+        while (_hasNext && now >= _next.at) {
+            Event due = _next;
+            _hasNext = findAfter(due, _next);
+            if (now - due.at <= _catchUpSec) {
+                out = due;
+                return true;
+            }
+            _skipped++;
+        }
+        return false;
+    }
+
+    // Detik sampai event berikutnya (0xFFFFFFFF jika tabel kosong/semua nonaktif)
+    uint32_t untilNext(uint32_t now) const {
+        if (!_hasNext) return 0xFFFFFFFF;
+        return _next.at > now ? _next.at - now : 0;
+    }
+
+    // ms sampai pengecekan berikutnya: tepat saat event jatuh tempo, paling
+    // lama maxSleepMs (agar koreksi jam tetap terkejar), minimal 1 detik
+    // (resolusi jam 1 detik)
+    unsigned long sleepMs(uint32_t now, unsigned long maxSleepMs) const {
+        uint32_t waitSec = untilNext(now);
+        unsigned long waitMs = waitSec >= maxSleepMs / 1000 ? maxSleepMs : waitSec * 1000UL;
+        return waitMs == 0 ? 1000UL : waitMs;
+    }
+
+    bool hasNext() const { return _hasNext; }
+    const Event& next() const { return _next; }
+    const ScheduleEntry& entry(size_t index) const { return _entries[index]; }
+    size_t size() const { return _count; }
+    size_t capacity() const { return MAX_ENTRIES; }
+    uint32_t skipped() const { return _skipped; }
+
+private:
+    static const uint32_t SECONDS_PER_DAY = 86400;
+
+    // 1970-01-01 adalah Kamis (4)
+    static uint8_t weekdayOf(uint32_t day) { return (uint8_t)((day + 4) % 7); }
+
+    bool active(const ScheduleEntry& e, uint8_t weekday) const {
+        return e.enabled && (e.weekdays & (1 << weekday));
+    }
+
+    // Event pertama dengan waktu >= from (paling jauh 7 hari ke depan)
+    bool find(uint32_t from, Event& out) const {
+        uint32_t day = from / SECONDS_PER_DAY;
+        uint32_t secOfDay = from % SECONDS_PER_DAY;
+
+        for (uint32_t d = 0; d <= 7; d++) {
+            uint8_t weekday = weekdayOf(day + d);
+            for (size_t k = 0; k < _count; k++) {
+                const ScheduleEntry& e = _entries[_order[k]];
+                if (d == 0 && (uint32_t)e.minuteOfDay * 60 < secOfDay) continue;
+                if (!active(e, weekday)) continue;
+                out.at = (day + d) * SECONDS_PER_DAY + (uint32_t)e.minuteOfDay * 60;
+                out.index = _order[k];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Event setelah `prev`; entri lain di menit yang sama dengan prev ikut dijalankan
+    bool findAfter(const Event& prev, Event& out) const {
+        bool passed = false;
+        for (size_t k = 0; k < _count; k++) {
+            uint8_t idx = _order[k];
+            if (passed && _entries[idx].minuteOfDay * 60U == prev.at % SECONDS_PER_DAY &&
+                active(_entries[idx], weekdayOf(prev.at / SECONDS_PER_DAY))) {
+                out = {prev.at, idx};
+                return true;
+            }
+            if (idx == prev.index) passed = true;
+        }
+        return find(prev.at + 1, out);
+    }
+
+    ScheduleEntry _entries[MAX_ENTRIES];
+    uint8_t _order[MAX_ENTRIES];       // Indeks entri terurut per menit
+    size_t _count = 0;
+    uint32_t _catchUpSec;
+    Event _next = {0, 0};
+    bool _hasNext = false;
+    uint32_t _lastNow = 0;
+    uint32_t _skipped = 0;
+};
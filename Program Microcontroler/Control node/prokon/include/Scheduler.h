@@ -0,0 +1,214 @@
+/*
+ * Scheduler - Penjadwal job berbasis deadline (min-heap)
+ *
+ * Pengganti MinimalTimer:
+ * - Jumlah job ditentukan parameter template (bukan 5 slot tetap)
+ * - Job periodik (every) dan sekali jalan (after)
+ * - Pembatalan lewat handle; handle lama tidak bisa membatalkan job lain
+ *   yang kebetulan memakai slot yang sama (dicek lewat nomor generasi)
+ * - run() hanya membaca jam sekali per panggilan dan hanya menyentuh job
+ *   yang sudah jatuh tempo; nilai kembaliannya adalah sisa waktu ke
+ *   deadline berikutnya sehingga loop bisa tidur sampai saat itu
+ *
+ * Tidak bergantung pada Arduino: sumber waktu diberikan lewat konstruktor
+ * (millis() di ESP32, jam tiruan di host).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+template <size_t MAX_JOBS = 16>
+class Scheduler {
+public:
+    typedef void (*Callback)();
+    typedef unsigned long (*Clock)();
+    typedef uint32_t Handle;              // 0 = handle tidak valid
+
+    static const unsigned long NO_DEADLINE = 0xFFFFFFFFUL;
+
+    explicit Scheduler(Clock clock) : _clock(clock) {
+        for (size_t i = 0; i < MAX_JOBS; i++) {
+            _jobs[i].active = false;
+            _jobs[i].generation = 0;
+            _jobs[i].heapPos = -1;
+        }
+    }
+
+    // Job periodik; pertama kali jatuh tempo setelah `interval` ms
+    Handle every(unsigned long interval, Callback callback) {
+        return add(interval, interval, callback);
+    }
+
+    // Job sekali jalan setelah `delay` ms
+    Handle after(unsigned long delay, Callback callback) {
+        return add(delay, 0, callback);
+    }
+
+    // Batalkan job. Aman dipanggil dari dalam callback (termasuk job itu sendiri).
+    bool cancel(Handle handle) {
+        int slot = slotOf(handle);
+        if (slot < 0) return false;
+
+        Job& job = _jobs[slot];
+        if (job.heapPos >= 0) removeAt(job.heapPos);
+        release(slot);
+        return true;
+    }
+
+    bool active(Handle handle) const {
+        return slotOf(handle) >= 0;
+    }
+
+    // Jalankan semua job yang sudah jatuh tempo.
+    // Mengembalikan ms sampai deadline berikutnya (NO_DEADLINE jika kosong).
+    unsigned long run() {
+        unsigned long now = _clock();
+
+        while (_heapSize > 0) {
+            int slot = _heap[0];
+            Job& job = _jobs[slot];
+            if (before(now, job.deadline)) break;
+
+            removeAt(0);
+            uint16_t generation = job.generation;
+            job.callback();
+            _dispatched++;
+
+            // Callback bisa saja membatalkan job ini atau membuat job baru
+            if (!job.active || job.generation != generation) continue;
+
+            if (job.interval == 0) {
+                release(slot);
+            } else {
+                // Tanpa drift: deadline berikutnya dihitung dari deadline lama,
+                // kecuali tertinggal lebih dari satu interval (tidak ada burst)
+                job.deadline += job.interval;
+                if (before(job.deadline, now)) job.deadline = now + job.interval;
+                push(slot);
+            }
+        }
+
+        return untilNext(now);
+    }
+
+    unsigned long untilNext() const {
+        return untilNext(_clock());
+    }
+
+    size_t size() const { return _heapSize; }
+    uint32_t dispatched() const { return _dispatched; }
+
+private:
+    struct Job {
+        unsigned long deadline;
+        unsigned long interval;     // 0 = sekali jalan
+        Callback callback;
+        uint16_t generation;
+        int16_t heapPos;            // -1 = tidak di heap
+        bool active;
+    };
+
+    // a < b dengan memperhitungkan overflow millis() (~49 hari)
+    static bool before(unsigned long a, unsigned long b) {
+        return (int32_t)(uint32_t)(a - b) < 0;
+    }
+
+    unsigned long untilNext(unsigned long now) const {
+        if (_heapSize == 0) return NO_DEADLINE;
+        unsigned long deadline = _jobs[_heap[0]].deadline;
+        return before(now, deadline) ? (uint32_t)(deadline - now) : 0;
+    }
+
+    Handle add(unsigned long delay, unsigned long interval, Callback callback) {
+        if (!callback) return 0;
+        for (size_t i = 0; i < MAX_JOBS; i++) {
+            Job& job = _jobs[i];
+            if (job.active) continue;
+
+            job.active = true;
+            job.generation++;
+            if (job.generation == 0) job.generation = 1;
+            job.deadline = _clock() + delay;
+            job.interval = interval;
+            job.callback = callback;
+            push(i);
+            return ((Handle)job.generation << 16) | (Handle)(i + 1);
+        }
+        return 0;
+    }
+
+    int slotOf(Handle handle) const {
+        size_t slot = (handle & 0xFFFF);
+        if (slot == 0 || slot > MAX_JOBS) return -1;
+        const Job& job = _jobs[slot - 1];
+        if (!job.active || job.generation != (uint16_t)(handle >> 16)) return -1;
+        return (int)(slot - 1);
+    }
+
+    void release(int slot) {
+        _jobs[slot].active = false;
+        _jobs[slot].heapPos = -1;
+    }
+
+    // ---------- Min-heap berdasarkan deadline ----------
+    bool less(int a, int b) const {
+        return before(_jobs[_heap[a]].deadline, _jobs[_heap[b]].deadline);
+    }
+
+    void place(int pos, int slot) {
+        _heap[pos] = slot;
+        _jobs[slot].heapPos = pos;
+    }
+
+    void swap(int a, int b) {
+        int slotA = _heap[a];
+        place(a, _heap[b]);
+        place(b, slotA);
+    }
+
+    void push(int slot) {
+        int pos = (int)_heapSize++;
+        place(pos, slot);
+        siftUp(pos);
+    }
+
+    void removeAt(int pos) {
+        int slot = _heap[pos];
+        _jobs[slot].heapPos = -1;
+        int last = (int)--_heapSize;
+        if (pos == last) return;
+
+        place(pos, _heap[last]);
+        siftUp(pos);
+        siftDown(pos);
+    }
+
+    void siftUp(int pos) {
+        while (pos > 0) {
+            int parent = (pos - 1) / 2;
+            if (!less(pos, parent)) break;
+            swap(pos, parent);
+            pos = parent;
+        }
+    }
+
+    void siftDown(int pos) {
+        for (;;) {
+            int left = pos * 2 + 1;
+            int right = left + 1;
+            int smallest = pos;
+            if (left < (int)_heapSize && less(left, smallest)) smallest = left;
+            if (right < (int)_heapSize && less(right, smallest)) smallest = right;
+            if (smallest == pos) break;
+            swap(pos, smallest);
+            pos = smallest;
+        }
+    }
+
+    Clock _clock;
+    Job _jobs[MAX_JOBS];
+    int _heap[MAX_JOBS];
+    size_t _heapSize = 0;
+    uint32_t _dispatched = 0;
+};
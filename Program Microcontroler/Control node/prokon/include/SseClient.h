@@ -0,0 +1,213 @@
+/*
+ * SseClient - Logika stream Server-Sent Events tanpa blocking, tanpa Arduino
+ *
+ *   IDLE ──connect()──> CONNECTING ──socket siap──> HEADERS ──"200" + baris kosong──> STREAMING
+ *     ▲                    │ gagal/timeout              │ status lain/putus                │ putus/idle
+ *     └────────────────────┴────────────────────────────┴──────────────────────────────────┘
+ *                          (percobaan berikutnya setelah backoff 5-60 detik)
+ *
+ * connect() hanya menandai bahwa stream diinginkan; poll(now) yang memulai
+ * koneksi TCP, memeriksa apakah sudah tersambung, lalu membaca byte yang
+ * sudah ada di buffer socket. Tidak ada langkah yang menunggu jaringan,
+ * jadi pemanggil (networkTask) tidak pernah tertahan oleh server yang mati.
+ *
+ * TTransport menyediakan socket non-blocking:
+ *   bool start(const char* host, int port)   // Mulai connect; false = gagal langsung
+ *   int  finish()                            // 1 tersambung, 0 belum, -1 gagal
+ *   bool connected(); int available(); int read();
+ *   size_t write(const uint8_t* data, size_t length); void stop();
+ * WiFiClient dibungkus di StatusStream.h; simulasi memakai socket tiruan.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+template <typename TTransport>
+class SseClient {
+public:
+    enum State : uint8_t { IDLE, CONNECTING, HEADERS, STREAMING };
+    // Hasil poll() yang perlu dilaporkan pemanggil (log/metrik)
+    enum Event : uint8_t { NO_EVENT, OPENED_EVENT, LOST_EVENT, REJECTED_EVENT, FAILED_EVENT };
+
+    typedef void (*EventHandler)(const char* data);
+
+    static const unsigned long CONNECT_TIMEOUT_MS = 3000;
+    static const unsigned long IDLE_TIMEOUT_MS = 30000;   // Tanpa ping 30 detik = putus
+    static const unsigned long RETRY_MIN_MS = 5000;
+    static const unsigned long RETRY_MAX_MS = 60000;
+
+    explicit SseClient(TTransport& transport) : _transport(transport) {}
+
+    void begin(const char* host, int port, const char* path, EventHandler handler) {
+        _host = host;
+        _port = port;
+        _path = path;
+        _handler = handler;
+    }
+
+    // Header X-Node-Id pada request stream (nullptr = tanpa)
+    void setNodeId(const char* id) { _nodeId = id; }
+
+    State state() const { return _state; }
+
+    // true jika header HTTP sudah diterima dan event bisa mengalir
+    bool connected() { return _state == STREAMING && _transport.connected(); }
+
+    // Minta stream dibuka. Langsung kembali; percobaan dilakukan poll()
+    // setelah backoff habis.
+    void connect() { _wanted = true; }
+
+    Event poll(unsigned long now) {
+        switch (_state) {
+            case IDLE:
+                if (!_wanted) return NO_EVENT;
+                if (_attempted && now - _lastAttempt < _retryDelay) return NO_EVENT;
+                _attempted = true;
+                _lastAttempt = now;
+                if (!_transport.start(_host, _port)) return fail();
+                _state = CONNECTING;
+                return NO_EVENT;
+
+            case CONNECTING: {
+                int result = _transport.finish();
+                if (result < 0 || (result == 0 && now - _lastAttempt > CONNECT_TIMEOUT_MS)) {
+                    _transport.stop();
+                    return fail();
+                }
+                if (result == 0) return NO_EVENT;
+                sendRequest();
+                _state = HEADERS;
+                _statusOk = false;
+                _lineLen = 0;
+                _dataLen = 0;
+                _lastActivity = now;
+                return NO_EVENT;
+            }
+
+            default:
+                return readAvailable(now);
+        }
+    }
+
+    // Tutup stream; connect() berikutnya mencoba lagi setelah backoff
+    Event drop() {
+        bool wasStreaming = _state == STREAMING;
+        if (_state != IDLE) _transport.stop();
+        _state = IDLE;
+        _wanted = false;
+        return wasStreaming ? LOST_EVENT : NO_EVENT;
+    }
+
+private:
+    Event fail() {
+        _state = IDLE;
+        _wanted = false;
+        _retryDelay = (_retryDelay * 2 > RETRY_MAX_MS) ? RETRY_MAX_MS : _retryDelay * 2;
+        return FAILED_EVENT;
+    }
+
+    // HTTP/1.0 agar server tidak memakai chunked encoding;
+    // body stream dibatasi oleh penutupan koneksi.
+    void sendRequest() {
+        char request[256];
+        int n = snprintf(request, sizeof(request),
+                         "GET %s HTTP/1.0\r\n"
+                         "Host: %s:%d\r\n"
+                         "Accept: text/event-stream\r\n"
+                         "Cache-Control: no-cache\r\n"
+                         "%s%s%s\r\n",
+                         _path, _host, _port,
+                         _nodeId ? "X-Node-Id: " : "", _nodeId ? _nodeId : "", _nodeId ? "\r\n" : "");
+        if (n <= 0 || n >= (int)sizeof(request)) return; // Path/ID terlalu panjang: server akan timeout
+        _transport.write((const uint8_t*)request, (size_t)n);
+    }
+
+    Event readAvailable(unsigned long now) {
+        if (!_transport.connected() && !_transport.available()) return drop();
+
+        while (_transport.available()) {
+            int c = _transport.read();
+            if (c < 0) break;
+            _lastActivity = now;
+
+            if (c == '\r') continue;
+            if (c != '\n') {
+                if (_lineLen < sizeof(_line) - 1) _line[_lineLen++] = (char)c;
+                continue;
+            }
+
+            _line[_lineLen] = '\0';
+            Event event = handleLine();
+            _lineLen = 0;
+            if (event != NO_EVENT) return event;
+        }
+
+        if (now - _lastActivity > IDLE_TIMEOUT_MS) return drop();
+        return NO_EVENT;
+    }
+
+    Event handleLine() {
+        if (_state == HEADERS) {
+            if (!_statusOk && strncmp(_line, "HTTP/1.", 7) == 0) {
+                _statusOk = (strstr(_line, " 200") != nullptr);
+            } else if (_lineLen == 0) {
+                if (!_statusOk) {
+                    _transport.stop();
+                    fail();
+                    return REJECTED_EVENT;
+                }
+                _state = STREAMING;
+                _retryDelay = RETRY_MIN_MS;
+                return OPENED_EVENT;
+            }
+            return NO_EVENT;
+        }
+
+        // Baris kosong = akhir satu event
+        if (_lineLen == 0) {
+            if (_dataLen > 0) {
+                _data[_dataLen] = '\0';
+                if (_handler) _handler(_data);
+                _dataLen = 0;
+            }
+            return NO_EVENT;
+        }
+
+        if (_line[0] == ':') return NO_EVENT; // Komentar / keep-alive
+
+        if (strncmp(_line, "data:", 5) == 0) {
+            const char* value = _line + 5;
+            if (*value == ' ') value++;
+            size_t len = strlen(value);
+            if (_dataLen + len < sizeof(_data)) {
+                memcpy(_data + _dataLen, value, len);
+                _dataLen += len;
+            }
+        }
+        // Field lain (event:, id:, retry:) diabaikan
+        return NO_EVENT;
+    }
+
+    TTransport& _transport;
+    const char* _host = nullptr;
+    int _port = 0;
+    const char* _path = nullptr;
+    const char* _nodeId = nullptr;
+    EventHandler _handler = nullptr;
+
+    State _state = IDLE;
+    bool _wanted = false;
+    bool _attempted = false;
+    bool _statusOk = false;
+    unsigned long _lastAttempt = 0;
+    unsigned long _lastActivity = 0;
+    unsigned long _retryDelay = RETRY_MIN_MS;
+
+    char _line[320];
+    size_t _lineLen = 0;
+    char _data[320];
+    size_t _dataLen = 0;
+};
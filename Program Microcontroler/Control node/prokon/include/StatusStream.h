@@ -0,0 +1,131 @@
+/*
+ * StatusStream - Klien Server-Sent Events (SSE) untuk perintah valve
+ *
+ * Koneksi TCP ke server dibiarkan terbuka. Server mengirim event
+ * "data: {...}" setiap kali status valve berubah (dan satu event status
+ * terkini saat koneksi dibuka), serta komentar ": ping" sebagai keep-alive.
+ *
+ * connect() dan poll() tidak pernah menunggu jaringan: socket dibuka
+ * non-blocking (lwIP) dan status connect diperiksa di poll() berikutnya,
+ * sehingga server yang mati tidak menahan networkTask (WiFiClient::connect()
+ * menunggu hingga timeout-nya habis). Logika stream ada di SseClient.h.
+ */
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include <lwip/netdb.h>
+#include <AsyncLog.h>
+#include "SseClient.h"
+
+// Socket TCP dengan connect non-blocking; setelah tersambung, I/O lewat WiFiClient
+class NonBlockingTcp {
+public:
+    bool start(const char* host, int port) {
+        stop();
+        IPAddress ip;
+        if (!ip.fromString(host)) return false; // API_HOST berupa IP; resolusi DNS akan blocking
+
+        int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (fd < 0) return false;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = (uint32_t)ip;
+        addr.sin_port = htons(port);
+        if (::connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+            close(fd);
+            return false;
+        }
+        _fd = fd;
+        return true;
+    }
+
+    int finish() {
+        if (_fd < 0) return -1;
+        fd_set writable;
+        FD_ZERO(&writable);
+        FD_SET(_fd, &writable);
+        struct timeval zero = {0, 0};
+        int ready = select(_fd + 1, nullptr, &writable, nullptr, &zero);
+        if (ready == 0) return 0;
+
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (ready < 0 || getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0) {
+            stop();
+            return -1;
+        }
+        // Kembali ke mode blocking seperti socket WiFiClient::connect()
+        fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL, 0) & ~O_NONBLOCK);
+        _client = WiFiClient(_fd); // WiFiClient kini pemilik socket
+        _fd = -1;
+        return 1;
+    }
+
+    bool connected() { return _client.connected(); }
+    int available() { return _client.available(); }
+    int read() { return _client.read(); }
+    size_t write(const uint8_t* data, size_t length) { return _client.write(data, length); }
+
+    void stop() {
+        if (_fd >= 0) {
+            close(_fd);
+            _fd = -1;
+        }
+        _client.stop();
+    }
+
+private:
+    WiFiClient _client;
+    int _fd = -1;
+};
+
+class StatusStream {
+public:
+    typedef SseClient<NonBlockingTcp>::EventHandler EventHandler;
+
+    StatusStream() : _sse(_tcp) {}
+
+    void begin(const char* host, int port, const char* path, EventHandler handler) {
+        _sse.begin(host, port, path, handler);
+    }
+
+    // Header X-Node-Id pada request stream (nullptr = tanpa)
+    void setNodeId(const char* id) {
+        _sse.setNodeId(id);
+    }
+
+    // true jika header HTTP sudah diterima dan event bisa mengalir
+    bool connected() {
+        return _sse.connected();
+    }
+
+    // Minta stream dibuka; percobaan berjalan di poll() dengan backoff 5-60 detik
+    void connect() {
+        _sse.connect();
+    }
+
+    void poll() {
+        report(_sse.poll(millis()));
+    }
+
+    void drop() {
+        report(_sse.drop());
+    }
+
+private:
+    void report(SseClient<NonBlockingTcp>::Event event) {
+        if (event == SseClient<NonBlockingTcp>::OPENED_EVENT) {
+            LOG_I("✅ Stream status terhubung (push aktif).");
+        } else if (event == SseClient<NonBlockingTcp>::LOST_EVENT) {
+            LOG_W("⚠️ Stream status terputus, kembali ke mode polling.");
+        }
+    }
+
+    NonBlockingTcp _tcp;
+    SseClient<NonBlockingTcp> _sse;
+};
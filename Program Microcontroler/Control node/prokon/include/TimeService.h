@@ -0,0 +1,258 @@
+/*
+ * TimeService - Jam dinding dari monotonic clock, didisiplinkan NTP & DS3231
+ *
+ * RTC dibaca sekali saat boot; setelah itu waktu diekstrapolasi dari
+ * monotonic clock (esp_timer_get_time()), jadi now() tidak butuh transaksi
+ * I2C dan murah dipanggil di hot path (checkSchedule, log valve).
+ *
+ * Setiap sampel NTP:
+ *   - offset <= stepThresholdMs di-slew: laju jam digeser maksimal maxSlewPpm
+ *     sampai offset habis. Waktu tidak pernah mundur atau melompat, jadi event
+ *     jadwal di sekitar batas sync tidak dobel dan tidak terlewat.
+ *   - offset lebih besar (RTC kehilangan daya, jam salah saat boot) di-step.
+ *   - frekuensi monotonic clock terhadap NTP diukur dari sampel yang berjarak
+ *     >= minFreqIntervalSec lalu dirata-rata (EMA, freqTimeConstantSec), jadi
+ *     drift kristal ESP32 ikut dikompensasi di antara sampel.
+ *
+ * DS3231 (TCXO, lebih stabil dari kristal ESP32 saat suhu berubah) menjadi
+ * sumber cadangan saat NTP tidak tersedia: rtcSample() dengan toleransi
+ * rtcToleranceMs karena resolusinya 1 detik. Drift DS3231 diestimasi dari
+ * selisih RTC - NTP pada sync yang berjarak >= rtcDriftMinSec, lalu dipakai
+ * untuk mengoreksi sampel RTC. RTC hanya ditulis ulang jika selisihnya
+ * dengan NTP >= rtcRewriteSec (rtcCheck()).
+ *
+ * Satuan: waktu dinding dalam µs "epoch lokal" (basis yang sama dengan
+ * DateTime::unixtime() dari RTC dan ScheduleTable), monotonic dalam µs.
+ * Tidak thread-safe: firmware memanggilnya di bawah spinlock. Tidak
+ * bergantung pada Arduino.
+ */
+#pragma once
+
+#include <stdint.h>
+
+struct TimeServiceConfig {
+    uint32_t stepThresholdMs;       // |offset| di atas ini di-step, di bawahnya di-slew
+    uint32_t maxSlewPpm;            // Laju koreksi offset maksimum
+    uint32_t maxFreqPpm;            // Batas koreksi frekuensi monotonic clock
+    uint32_t minFreqIntervalSec;    // Jarak minimum dua sampel NTP untuk mengukur frekuensi
+    uint32_t freqTimeConstantSec;   // Konstanta waktu rata-rata frekuensi
+    uint32_t rtcToleranceMs;        // Sampel RTC dengan |offset| <= ini diabaikan
+    uint32_t rtcRewriteSec;         // Tulis ulang RTC jika |RTC - NTP| >= ini
+    uint32_t rtcDriftMinSec;        // Jarak minimum untuk estimasi drift DS3231
+};
+
+class TimeService {
+public:
+    enum Result { IGNORED, SLEWED, STEPPED };
+
+    struct Stats {
+        uint32_t ntpSamples;
+        uint32_t rtcSamples;        // Sampel RTC yang dipakai (NTP tidak tersedia)
+        uint32_t steps;
+        uint32_t slews;
+        int32_t lastOffsetMs;       // Referensi - jam pada sampel terakhir yang dipakai
+        int32_t freqPpb;            // Koreksi frekuensi monotonic clock
+        int32_t rtcOffsetMs;        // RTC - NTP pada sync terakhir
+        int32_t rtcDriftPpb;        // Estimasi drift DS3231 (positif = RTC lebih cepat)
+    };
+
+    explicit TimeService(const TimeServiceConfig& config) : _config(config) {}
+
+    // Titik awal dari RTC (boot). Detik RTC dibaca pada fase acak, jadi
+    // diambil tengahnya (+0,5 s).
+    void begin(uint32_t rtcEpoch, uint64_t monoUs) {
+        _baseUs = (int64_t)rtcEpoch * 1000000 + 500000;
+        _anchorMono = monoUs;
+        _slewUs = 0;
+    }
+
+    // Waktu saat ini (µs); tidak pernah mundur selama monoUs tidak mundur
+    int64_t nowUs(uint64_t monoUs) const {
+        int64_t elapsed = (int64_t)(monoUs - _anchorMono);
+        return _baseUs + elapsed + scale(elapsed, _freqPpb) + appliedSlew(elapsed);
+    }
+
+    // Detik epoch lokal (pengganti rtc.now().unixtime())
+    uint32_t now(uint64_t monoUs) const { return (uint32_t)(nowUs(monoUs) / 1000000); }
+
+    // Sampel NTP: refUs = waktu NTP (epoch lokal, µs) pada monoUs
+    Result ntpSample(int64_t refUs, uint64_t monoUs) {
+        _stats.ntpSamples++;
+        reanchor(monoUs); // Frekuensi baru berlaku mulai titik ini
+        updateFrequency(refUs, monoUs);
+        _hasNtp = true;
+        _lastNtpMono = monoUs;
+        return correct(refUs, monoUs);
+    }
+
+    // Sampel DS3231 saat NTP tidak tersedia (offset kecil diabaikan)
+    Result rtcSample(uint32_t rtcEpoch, uint64_t monoUs) {
+        int64_t refUs = rtcTrueUs(rtcEpoch);
+        int64_t offset = refUs - nowUs(monoUs);
+        if (absolute(offset) <= (int64_t)_config.rtcToleranceMs * 1000) return IGNORED;
+        _stats.rtcSamples++;
+        return correct(refUs, monoUs);
+    }
+
+    // Bandingkan RTC yang baru dibaca dengan waktu NTP (dipanggil tepat setelah
+    // ntpSample()). true jika RTC perlu ditulis ulang ke referenceUs(); estimasi
+    // drift berikutnya dihitung dari titik tulis itu.
+    bool rtcCheck(uint32_t rtcEpoch, uint64_t monoUs) {
+        int64_t refUs = referenceUs(monoUs);
+        int64_t offset = (int64_t)rtcEpoch * 1000000 + 500000 - refUs;
+        _stats.rtcOffsetMs = toMs(offset);
+        if (!_hasRtcRef) {
+            setRtcRef(refUs, offset);
+        } else {
+            int64_t span = refUs - _rtcRefUs;
+            if (span >= (int64_t)_config.rtcDriftMinSec * 1000000) {
+                int64_t drift = (offset - _rtcRefOffsetUs) * 1000 / (span / 1000000);
+                _stats.rtcDriftPpb = (int32_t)clamp(drift, (int64_t)_config.maxFreqPpm * 1000);
+            }
+        }
+        if (absolute(offset) < (int64_t)_config.rtcRewriteSec * 1000000) return false;
+        setRtcRef(refUs, 0); // Pemanggil menulis RTC ke referenceUs()
+        return true;
+    }
+
+    // Waktu terbaik tanpa penghalusan slew (sisa offset langsung ditambahkan);
+    // untuk menulis RTC, bukan untuk jadwal
+    int64_t referenceUs(uint64_t monoUs) const { return nowUs(monoUs) + pendingSlewUs(monoUs); }
+
+    // Waktu diset manual (Serial 'T'); RTC juga ditulis oleh pemanggil
+    void set(uint32_t epoch, uint64_t monoUs) {
+        _baseUs = (int64_t)epoch * 1000000;
+        _anchorMono = monoUs;
+        _slewUs = 0;
+        _stats.steps++;
+        _hasRtcRef = false;
+    }
+
+    bool ntpSynced() const { return _hasNtp; }
+    uint64_t lastNtpMono() const { return _lastNtpMono; }
+
+    // Sisa offset yang belum di-slew (µs)
+    int64_t pendingSlewUs(uint64_t monoUs) const {
+        return _slewUs - appliedSlew((int64_t)(monoUs - _anchorMono));
+    }
+
+    Stats stats() const {
+        Stats s = _stats;
+        s.freqPpb = _freqPpb;
+        return s;
+    }
+
+private:
+    // us * ppb / 1e9 tanpa overflow untuk rentang puluhan tahun
+    static int64_t scale(int64_t us, int32_t ppb) {
+        return (us / 1000000) * ppb / 1000 + (us % 1000000) * ppb / 1000000000;
+    }
+
+    static int64_t absolute(int64_t v) { return v < 0 ? -v : v; }
+
+    static int64_t clamp(int64_t v, int64_t limit) { return v > limit ? limit : (v < -limit ? -limit : v); }
+
+    static int32_t toMs(int64_t us) { return (int32_t)clamp(us / 1000, INT32_MAX); }
+
+    int64_t appliedSlew(int64_t elapsed) const {
+        int64_t slew = scale(elapsed, (int32_t)(_config.maxSlewPpm * 1000));
+        int64_t pending = absolute(_slewUs);
+        if (slew > pending) slew = pending;
+        return _slewUs < 0 ? -slew : slew;
+    }
+
+    // Pindahkan titik acuan ke monoUs tanpa mengubah waktu yang dilaporkan
+    void reanchor(uint64_t monoUs) {
+        int64_t elapsed = (int64_t)(monoUs - _anchorMono);
+        int64_t applied = appliedSlew(elapsed);
+        _baseUs += elapsed + scale(elapsed, _freqPpb) + applied;
+        _slewUs -= applied;
+        _anchorMono = monoUs;
+    }
+
+    // Pindahkan titik acuan ke waktu sekarang (kontinu), lalu step atau slew
+    Result correct(int64_t refUs, uint64_t monoUs) {
+        int64_t current = nowUs(monoUs);
+        int64_t offset = refUs - current;
+        _stats.lastOffsetMs = toMs(offset);
+        _anchorMono = monoUs;
+        if (absolute(offset) > (int64_t)_config.stepThresholdMs * 1000) {
+            _baseUs = refUs;
+            _slewUs = 0;
+            _stats.steps++;
+            return STEPPED;
+        }
+        _baseUs = current;
+        _slewUs = offset;
+        _stats.slews++;
+        return SLEWED;
+    }
+
+    // Frekuensi diukur dari NTP & monotonic mentah, tidak dipengaruhi slew
+    void updateFrequency(int64_t refUs, uint64_t monoUs) {
+        if (!_hasFreqRef) {
+            setFreqRef(refUs, monoUs);
+            return;
+        }
+        int64_t span = (int64_t)(monoUs - _freqRefMono);
+        if (span < (int64_t)_config.minFreqIntervalSec * 1000000) return;
+
+        int64_t error = (refUs - _freqRefUs) - span;
+        int64_t limit = (int64_t)_config.maxFreqPpm * 1000;
+        int64_t spanSec = span / 1000000;
+        if (absolute(error) / spanSec > limit / 1000) {
+            setFreqRef(refUs, monoUs); // Waktu NTP lompat (bukan drift): ukur ulang
+            return;
+        }
+        int64_t measured = error * 1000 / spanSec;
+        if (!_hasFreq) {
+            _freqPpb = (int32_t)clamp(measured, limit);
+            _hasFreq = true;
+        } else {
+            int64_t weight = spanSec >= _config.freqTimeConstantSec ? _config.freqTimeConstantSec : spanSec;
+            _freqPpb = (int32_t)clamp(_freqPpb + (measured - _freqPpb) * weight / _config.freqTimeConstantSec, limit);
+        }
+        setFreqRef(refUs, monoUs);
+    }
+
+    void setFreqRef(int64_t refUs, uint64_t monoUs) {
+        _freqRefUs = refUs;
+        _freqRefMono = monoUs;
+        _hasFreqRef = true;
+    }
+
+    void setRtcRef(int64_t refUs, int64_t offset) {
+        _rtcRefUs = refUs;
+        _rtcRefOffsetUs = offset;
+        _hasRtcRef = true;
+    }
+
+    // Waktu sebenarnya menurut RTC: tengah detik dikurangi offset yang
+    // diperkirakan (offset acuan + drift x waktu sejak acuan)
+    int64_t rtcTrueUs(uint32_t rtcEpoch) const {
+        int64_t readUs = (int64_t)rtcEpoch * 1000000 + 500000;
+        if (!_hasRtcRef) return readUs;
+        int64_t predicted = _rtcRefOffsetUs + scale(readUs - _rtcRefUs, _stats.rtcDriftPpb);
+        return readUs - predicted;
+    }
+
+    TimeServiceConfig _config;
+    int64_t _baseUs = 0;
+    uint64_t _anchorMono = 0;
+    int64_t _slewUs = 0;            // Offset yang sedang di-slew sejak _anchorMono
+    int32_t _freqPpb = 0;
+    bool _hasFreq = false;
+
+    bool _hasFreqRef = false;
+    int64_t _freqRefUs = 0;
+    uint64_t _freqRefMono = 0;
+
+    bool _hasNtp = false;
+    uint64_t _lastNtpMono = 0;
+
+    bool _hasRtcRef = false;
+    int64_t _rtcRefUs = 0;
+    int64_t _rtcRefOffsetUs = 0;
+
+    Stats _stats = {};
+};
@@ -0,0 +1,193 @@
+/*
+ * ValveBank - Driver multi-zona dengan sequencer
+ *
+ * Setiap zona punya status sendiri (idle / antri / terbuka), durasi dan
+ * penanda manual. Permintaan buka masuk antrian FIFO; sequencer membuka zona
+ * berikutnya hanya jika jumlah zona terbuka < maxConcurrent (batas pompa /
+ * tekanan) dan jeda sejak pembukaan terakhir >= staggerMs (lonjakan tekanan).
+ * update() menutup zona yang durasinya habis lalu mengembalikan ms sampai aksi
+ * berikutnya, sehingga pemanggil bisa tidur sampai saat itu.
+ *
+ * Relay diakses lewat ValveOutput (GPIO, shift register, atau mock yang
+ * merekam timeline di host). Tidak bergantung pada Arduino.
+ */
+#pragma once
+
+#include <stdint.h>
+
+class ValveOutput {
+public:
+    virtual ~ValveOutput() {}
+    virtual void begin() {}
+    virtual void write(uint8_t zone, bool open) = 0;
+};
+
+struct ValveBankConfig {
+    uint8_t maxConcurrent;      // Zona terbuka bersamaan maksimum
+    unsigned long staggerMs;    // Jeda minimum antar pembukaan zona
+};
+
+template <uint8_t ZONES>
+class ValveBank {
+public:
+    static const unsigned long NO_DEADLINE = 0xFFFFFFFFUL;
+
+    // Dipanggil setiap zona dibuka/ditutup; openMs = lama terbuka (saat ditutup)
+    typedef void (*ChangeFn)(uint8_t zone, bool open, unsigned long openMs, bool manual);
+
+    ValveBank(ValveOutput& output, const ValveBankConfig& config, ChangeFn onChange = nullptr)
+        : _output(output), _config(config), _onChange(onChange) {}
+
+    void begin() {
+        _output.begin();
+        for (uint8_t z = 0; z < ZONES; z++) _output.write(z, false);
+    }
+
+    // Minta zona dibuka selama durationMs (0 = sampai ditutup). false jika zona
+    // tidak ada atau sudah terbuka/antri. Zona dibuka di update() berikutnya
+    // (dipanggil di sini juga) jika batas pompa & stagger mengizinkan.
+    bool request(uint8_t zone, unsigned long durationMs, bool manual, unsigned long now) {
+        if (zone >= ZONES || _zones[zone].state != IDLE) return false;
+        Zone& z = _zones[zone];
+        z.state = QUEUED;
+        z.manual = manual;
+        z.durationMs = durationMs;
+        z.seq = _nextSeq++;
+        update(now);
+        return true;
+    }
+
+    // Tutup zona atau batalkan antriannya; false jika zona memang idle
+    bool close(uint8_t zone, unsigned long now) {
+        if (zone >= ZONES || _zones[zone].state == IDLE) return false;
+        if (_zones[zone].state == OPEN) closeZone(zone, now);
+        else _zones[zone].state = IDLE;
+        update(now);
+        return true;
+    }
+
+    // Tutup/batalkan semua zona terjadwal (manual = false) atau manual (true);
+    // zones = mask bit per zona (bit 0 = zona index 0) untuk membatasi zona yang kena
+    uint8_t closeWhere(bool manual, unsigned long now, uint32_t zones = 0xFFFFFFFFUL) {
+        uint8_t n = 0;
+        for (uint8_t z = 0; z < ZONES; z++) {
+            if (!(zones & (1UL << z))) continue;
+            if (_zones[z].state != IDLE && _zones[z].manual == manual) {
+                if (_zones[z].state == OPEN) closeZone(z, now);
+                else _zones[z].state = IDLE;
+                n++;
+            }
+        }
+        update(now);
+        return n;
+    }
+
+    // Tutup zona yang habis durasinya, buka zona antrian yang diizinkan.
+    // Mengembalikan ms sampai aksi berikutnya (NO_DEADLINE jika tidak ada).
+    unsigned long update(unsigned long now) {
+        for (uint8_t z = 0; z < ZONES; z++) {
+            Zone& zone = _zones[z];
+            if (zone.state == OPEN && zone.durationMs > 0 && now - zone.openedAt >= zone.durationMs) {
+                unsigned long lateMs = now - zone.openedAt - zone.durationMs;
+                if (lateMs > _maxCloseLateMs) _maxCloseLateMs = lateMs;
+                closeZone(z, now);
+            }
+        }
+
+        while (openCount() < _config.maxConcurrent && staggerLeft(now) == 0) {
+            int z = oldestQueued();
+            if (z < 0) break;
+            openZone((uint8_t)z, now);
+        }
+
+        unsigned long next = NO_DEADLINE;
+        for (uint8_t z = 0; z < ZONES; z++) {
+            const Zone& zone = _zones[z];
+            if (zone.state == OPEN && zone.durationMs > 0) {
+                unsigned long left = zone.durationMs - (now - zone.openedAt);
+                if (left < next) next = left;
+            }
+        }
+        if (oldestQueued() >= 0 && openCount() < _config.maxConcurrent) {
+            unsigned long left = staggerLeft(now);
+            if (left < next) next = left;
+        }
+        return next;
+    }
+
+    bool isOpen(uint8_t zone) const { return zone < ZONES && _zones[zone].state == OPEN; }
+    bool isQueued(uint8_t zone) const { return zone < ZONES && _zones[zone].state == QUEUED; }
+    bool isManual(uint8_t zone) const { return zone < ZONES && _zones[zone].manual; }
+    bool anyOpen() const { return openCount() > 0; }
+    bool anyManual() const {
+        for (uint8_t z = 0; z < ZONES; z++) {
+            if (_zones[z].state != IDLE && _zones[z].manual) return true;
+        }
+        return false;
+    }
+
+    uint8_t openCount() const {
+        uint8_t n = 0;
+        for (uint8_t z = 0; z < ZONES; z++) n += _zones[z].state == OPEN;
+        return n;
+    }
+
+    uint8_t queuedCount() const {
+        uint8_t n = 0;
+        for (uint8_t z = 0; z < ZONES; z++) n += _zones[z].state == QUEUED;
+        return n;
+    }
+
+    uint8_t zones() const { return ZONES; }
+    unsigned long maxCloseLateMs() const { return _maxCloseLateMs; }
+
+private:
+    enum State : uint8_t { IDLE, QUEUED, OPEN };
+
+    struct Zone {
+        State state = IDLE;
+        bool manual = false;
+        unsigned long durationMs = 0;
+        unsigned long openedAt = 0;
+        uint32_t seq = 0;
+    };
+
+    int oldestQueued() const {
+        int best = -1;
+        for (uint8_t z = 0; z < ZONES; z++) {
+            if (_zones[z].state != QUEUED) continue;
+            if (best < 0 || (int32_t)(_zones[z].seq - _zones[best].seq) < 0) best = z;
+        }
+        return best;
+    }
+
+    unsigned long staggerLeft(unsigned long now) const {
+        if (!_hasOpened) return 0;
+        unsigned long since = now - _lastOpenAt;
+        return since >= _config.staggerMs ? 0 : _config.staggerMs - since;
+    }
+
+    void openZone(uint8_t z, unsigned long now) {
+        _output.write(z, true);
+        _zones[z].state = OPEN;
+        _zones[z].openedAt = now;
+        _lastOpenAt = now;
+        _hasOpened = true;
+        if (_onChange) _onChange(z, true, 0, _zones[z].manual);
+    }
+
+    void closeZone(uint8_t z, unsigned long now) {
+        _output.write(z, false);
+        _zones[z].state = IDLE;
+        if (_onChange) _onChange(z, false, now - _zones[z].openedAt, _zones[z].manual);
+    }
+
+    ValveOutput& _output;
+    ValveBankConfig _config;
+    ChangeFn _onChange;
+    Zone _zones[ZONES];
+    uint32_t _nextSeq = 0;
+    unsigned long _lastOpenAt = 0;
+    bool _hasOpened = false;
+    unsigned long _maxCloseLateMs = 0;
+};
@@ -0,0 +1,84 @@
+/*
+ * ValveOutputs - Implementasi ValveOutput untuk hardware ESP32
+ *
+ *   GpioValveOutput          : satu pin GPIO per zona (modul relay)
+ *   ShiftRegisterValveOutput : rantai 74HC595, 8 zona per IC (maks. 32 zona)
+ *   SpinlockValveOutput      : GuardedValveOutput (ValveSafety.h) yang aman
+ *                              dipakai valveTask dan timer pengaman bersamaan
+ */
+#pragma once
+
+#include <Arduino.h>
+#include "ValveBank.h"
+#include "ValveSafety.h"
+
+class GpioValveOutput : public ValveOutput {
+public:
+    GpioValveOutput(const uint8_t* pins, uint8_t count, bool activeHigh = true)
+        : _pins(pins), _count(count), _activeHigh(activeHigh) {}
+
+    void begin() override {
+        for (uint8_t z = 0; z < _count; z++) pinMode(_pins[z], OUTPUT);
+    }
+
+    void write(uint8_t zone, bool open) override {
+        if (zone < _count) digitalWrite(_pins[zone], open == _activeHigh ? HIGH : LOW);
+    }
+
+private:
+    const uint8_t* _pins;
+    uint8_t _count;
+    bool _activeHigh;
+};
+
+class ShiftRegisterValveOutput : public ValveOutput {
+public:
+    ShiftRegisterValveOutput(uint8_t dataPin, uint8_t clockPin, uint8_t latchPin, uint8_t zones)
+        : _dataPin(dataPin), _clockPin(clockPin), _latchPin(latchPin),
+          _zones(zones > 32 ? 32 : zones) {}
+
+    void begin() override {
+        pinMode(_dataPin, OUTPUT);
+        pinMode(_clockPin, OUTPUT);
+        pinMode(_latchPin, OUTPUT);
+        _bits = 0;
+        latch();
+    }
+
+    void write(uint8_t zone, bool open) override {
+        if (zone >= _zones) return;
+        uint32_t mask = 1UL << zone;
+        _bits = open ? (_bits | mask) : (_bits & ~mask);
+        latch();
+    }
+
+private:
+    // IC terjauh (zona tertinggi) digeser lebih dulu
+    void latch() {
+        digitalWrite(_latchPin, LOW);
+        for (int chip = (_zones + 7) / 8 - 1; chip >= 0; chip--) {
+            shiftOut(_dataPin, _clockPin, MSBFIRST, (uint8_t)(_bits >> (chip * 8)));
+        }
+        digitalWrite(_latchPin, HIGH);
+    }
+
+    uint8_t _dataPin;
+    uint8_t _clockPin;
+    uint8_t _latchPin;
+    uint8_t _zones;
+    uint32_t _bits = 0;
+};
+
+// Satu latch 74HC595 (~30 µs) atau digitalWrite per zona di dalam critical
+// section, jadi cut() dari timer tidak menyela write() valveTask di tengah
+class SpinlockValveOutput : public GuardedValveOutput {
+public:
+    explicit SpinlockValveOutput(ValveOutput& inner) : GuardedValveOutput(inner) {}
+
+protected:
+    void lock() override { portENTER_CRITICAL(&_mux); }
+    void unlock() override { portEXIT_CRITICAL(&_mux); }
+
+private:
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+};
@@ -0,0 +1,308 @@
+/*
+ * ValveSafety - Lapisan pengaman valve yang terpisah dari ValveBank
+ *
+ * ValveBank menutup zona saat durasinya habis, tetapi hanya jika valveTask
+ * berjalan, dan zona manual (remote) tidak punya batas sama sekali.
+ * ValveSafety mengawasi zona yang terbuka dari timer periodik terpisah:
+ *
+ *   - batas keras lama terbuka untuk semua zona (maxOpenMs) dan untuk zona
+ *     manual (manualMaxMs);
+ *   - failsafe link: zona manual ditutup jika tidak ada kontak dengan server
+ *     selama linkLossMs (perintah OFF tidak akan pernah sampai);
+ *   - anomali sensor (opsional): zona terbuka tanpa aliran (tersumbat, valve
+ *     macet tertutup), aliran saat semua zona tertutup (bocor, valve macet
+ *     terbuka), arus koil di luar rentang (koil putus / hubung singkat).
+ *
+ * Pelanggaran pertama kali meminta valveTask menutup zona (action.close).
+ * Jika zona masih terbuka graceMs setelah batasnya, atau valveTask tidak
+ * mengirim heartbeat selama stallMs, output zona diputus langsung
+ * (action.cut, lihat GuardedValveOutput). Latensi tutup = saat output mati
+ * dikurangi batas yang dilanggar; dengan tick T terjamin <= T + graceMs
+ * selama timer berjalan, apa pun yang terjadi di networkTask dan valveTask.
+ *
+ *   ValveSafety<ZONES> safety(config);
+ *   safety.opened(zone, manual, now);    // Dari callback ValveBank
+ *   safety.heartbeat(now);               // Setiap putaran valveTask
+ *   safety.linkOk(now);                  // Setiap kontak sukses dengan server
+ *   ValveSafetyAction a = safety.check(now);   // Timer periodik
+ *
+ * Tidak thread-safe: firmware memanggilnya di bawah spinlock. Tidak
+ * bergantung pada Arduino.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "ValveBank.h"
+
+struct ValveSafetyConfig {
+    unsigned long maxOpenMs;        // Batas keras semua zona (0 = nonaktif)
+    unsigned long manualMaxMs;      // Batas zona manual (0 = nonaktif)
+    unsigned long linkLossMs;       // Tanpa kontak server selama ini = zona manual ditutup (0 = nonaktif)
+    unsigned long graceMs;          // Waktu untuk valveTask sebelum output diputus langsung
+    unsigned long stallMs;          // valveTask tanpa heartbeat selama ini saat ada zona terbuka = putus
+    float minFlowLpm;               // Zona terbuka dengan aliran di bawah ini = tersumbat (0 = nonaktif)
+    float leakFlowLpm;              // Semua tertutup dengan aliran di atas ini = bocor (0 = nonaktif)
+    unsigned long flowSettleMs;     // Aliran/arus dinilai setelah kondisi bertahan selama ini
+    float minCurrentMa;             // Arus koil zona terbuka minimum (0 = nonaktif)
+    float maxCurrentMa;             // Arus koil maksimum (0 = nonaktif)
+};
+
+enum ValveFault : uint8_t {
+    VALVE_FAULT_NONE,
+    VALVE_FAULT_MAX_OPEN,
+    VALVE_FAULT_MANUAL_MAX,
+    VALVE_FAULT_LINK_LOST,
+    VALVE_FAULT_TASK_STALL,
+    VALVE_FAULT_NO_FLOW,
+    VALVE_FAULT_LEAK,
+    VALVE_FAULT_CURRENT,
+};
+
+inline const char* valveFaultName(ValveFault fault) {
+    static const char* const NAMES[] = {"-",         "max_open", "manual_max", "link_lost",
+                                        "task_stall", "no_flow",  "leak",       "current"};
+    return fault <= VALVE_FAULT_CURRENT ? NAMES[fault] : "?";
+}
+
+struct ValveSafetyAction {
+    uint32_t close;     // Zona baru yang harus ditutup valveTask (bit per zona)
+    uint32_t cut;       // Zona baru yang outputnya harus diputus langsung
+    ValveFault alarm;   // Gangguan baru tingkat sistem (TASK_STALL, LEAK)
+};
+
+template <uint8_t ZONES>
+class ValveSafety {
+public:
+    static_assert(ZONES <= 32, "mask zona 32 bit");
+
+    explicit ValveSafety(const ValveSafetyConfig& config) : _config(config) {}
+
+    void begin(unsigned long now) {
+        _heartbeatAt = now;
+        _linkAt = now;
+    }
+
+    void opened(uint8_t zone, bool manual, unsigned long now) {
+        if (zone >= ZONES) return;
+        Zone& z = _zones[zone];
+        z = Zone();
+        z.open = true;
+        z.manual = manual;
+        z.openedAt = now;
+        _closedAt = now;
+    }
+
+    // Latensi tutup (ms dari batas yang dilanggar) jika zona ditutup karena
+    // ValveSafety, -1 jika ditutup normal
+    long closed(uint8_t zone, unsigned long now) {
+        if (zone >= ZONES || !_zones[zone].open) return -1;
+        Zone& z = _zones[zone];
+        long latency = -1;
+        if (z.fault != VALVE_FAULT_NONE) {
+            latency = z.cut ? (long)(z.cutAt - z.deadline) : (long)(now - z.deadline);
+            observeLatency(latency);
+        }
+        z.open = false;
+        _closedAt = now;
+        return latency;
+    }
+
+    void heartbeat(unsigned long now) {
+        _heartbeatAt = now;
+        _stalled = false;
+    }
+
+    void linkOk(unsigned long now) { _linkAt = now; }
+
+    // Sensor aliran pipa utama (L/menit), dipanggil periodik
+    void reportFlow(float lpm, unsigned long now) {
+        bool open = anyOpen();
+        bool low = open && _config.minFlowLpm > 0 && lpm < _config.minFlowLpm;
+        bool leak = !open && _config.leakFlowLpm > 0 && lpm > _config.leakFlowLpm;
+        if (settled(low, _lowFlowSince, now)) flagOpenZones(VALVE_FAULT_NO_FLOW, now);
+        _leak = settled(leak, _leakSince, now);
+        if (!_leak) _leakReported = false;
+    }
+
+    // Arus koil total (mA), dipanggil periodik
+    void reportCurrent(float ma, unsigned long now) {
+        bool open = anyOpen();
+        bool bad = (open && _config.minCurrentMa > 0 && ma < _config.minCurrentMa) ||
+                   (_config.maxCurrentMa > 0 && ma > _config.maxCurrentMa);
+        if (settled(bad, _badCurrentSince, now)) flagOpenZones(VALVE_FAULT_CURRENT, now);
+    }
+
+    ValveSafetyAction check(unsigned long now) {
+        ValveSafetyAction action = {0, 0, VALVE_FAULT_NONE};
+        bool stalled = anyOpen() && _config.stallMs > 0 && elapsed(_heartbeatAt, now) >= _config.stallMs;
+        if (stalled && !_stalled) {
+            _stalled = true;
+            _stalls++;
+            action.alarm = VALVE_FAULT_TASK_STALL;
+        }
+        if (_leak && !_leakReported) {
+            _leakReported = true;
+            _leaks++;
+            action.alarm = VALVE_FAULT_LEAK;
+        }
+
+        for (uint8_t i = 0; i < ZONES; i++) {
+            Zone& z = _zones[i];
+            if (!z.open) continue;
+            uint32_t bit = 1UL << i;
+
+            if (z.fault == VALVE_FAULT_NONE) {
+                ValveFault fault = VALVE_FAULT_NONE;
+                unsigned long deadline = 0;
+                if (_config.maxOpenMs) earliest(fault, deadline, VALVE_FAULT_MAX_OPEN, z.openedAt + _config.maxOpenMs);
+                if (z.manual && _config.manualMaxMs) {
+                    earliest(fault, deadline, VALVE_FAULT_MANUAL_MAX, z.openedAt + _config.manualMaxMs);
+                }
+                if (z.manual && _config.linkLossMs) {
+                    unsigned long since = (long)(_linkAt - z.openedAt) > 0 ? _linkAt : z.openedAt;
+                    earliest(fault, deadline, VALVE_FAULT_LINK_LOST, since + _config.linkLossMs);
+                }
+                if (z.sensorFault != VALVE_FAULT_NONE) earliest(fault, deadline, z.sensorFault, z.sensorAt);
+                if (fault != VALVE_FAULT_NONE && (long)(now - deadline) >= 0) {
+                    z.fault = fault;
+                    z.deadline = deadline;
+                    _faults[fault]++;
+                    action.close |= bit;
+                }
+            }
+
+            if (stalled && z.fault == VALVE_FAULT_NONE) {
+                z.fault = VALVE_FAULT_TASK_STALL;
+                z.deadline = _heartbeatAt + _config.stallMs;
+                _faults[VALVE_FAULT_TASK_STALL]++;
+                action.close |= bit;
+            }
+            if (z.fault != VALVE_FAULT_NONE && !z.cut && (stalled || elapsed(z.deadline, now) >= _config.graceMs)) {
+                z.cut = true;
+                z.cutAt = now;
+                _cuts++;
+                action.cut |= bit;
+            }
+        }
+        return action;
+    }
+
+    bool anyOpen() const {
+        for (uint8_t i = 0; i < ZONES; i++) {
+            if (_zones[i].open) return true;
+        }
+        return false;
+    }
+
+    ValveFault fault(uint8_t zone) const { return zone < ZONES ? _zones[zone].fault : VALVE_FAULT_NONE; }
+    uint32_t faults(ValveFault fault) const { return fault <= VALVE_FAULT_CURRENT ? _faults[fault] : 0; }
+    uint32_t cuts() const { return _cuts; }
+    uint32_t stalls() const { return _stalls; }
+    uint32_t leaks() const { return _leaks; }
+    bool leaking() const { return _leak; }
+    long maxCloseLatencyMs() const { return _maxLatency; }
+    unsigned long linkAgeMs(unsigned long now) const { return elapsed(_linkAt, now); }
+
+private:
+    struct Zone {
+        bool open = false;
+        bool manual = false;
+        bool cut = false;
+        ValveFault fault = VALVE_FAULT_NONE;
+        ValveFault sensorFault = VALVE_FAULT_NONE;
+        unsigned long openedAt = 0;
+        unsigned long deadline = 0;     // Batas yang dilanggar
+        unsigned long cutAt = 0;
+        unsigned long sensorAt = 0;
+    };
+
+    static unsigned long elapsed(unsigned long from, unsigned long now) { return now - from; }
+
+    // Pilih batas paling awal (aman terhadap overflow millis())
+    static void earliest(ValveFault& fault, unsigned long& deadline, ValveFault candidate, unsigned long at) {
+        if (fault == VALVE_FAULT_NONE || (long)(at - deadline) < 0) {
+            fault = candidate;
+            deadline = at;
+        }
+    }
+
+    // true jika kondisi bertahan selama flowSettleMs (dan zona sudah
+    // terbuka/tertutup selama itu, agar transien tekanan tidak terhitung)
+    bool settled(bool condition, unsigned long& since, unsigned long now) {
+        if (!condition || elapsed(_closedAt, now) < _config.flowSettleMs) {
+            since = 0;
+            return false;
+        }
+        if (!since) since = now ? now : 1;
+        return elapsed(since, now) >= _config.flowSettleMs;
+    }
+
+    void flagOpenZones(ValveFault fault, unsigned long now) {
+        for (uint8_t i = 0; i < ZONES; i++) {
+            Zone& z = _zones[i];
+            if (z.open && z.sensorFault == VALVE_FAULT_NONE) {
+                z.sensorFault = fault;
+                z.sensorAt = now;
+            }
+        }
+    }
+
+    void observeLatency(long latency) {
+        if (latency > _maxLatency) _maxLatency = latency;
+    }
+
+    ValveSafetyConfig _config;
+    Zone _zones[ZONES];
+    unsigned long _heartbeatAt = 0;
+    unsigned long _linkAt = 0;
+    unsigned long _closedAt = 0;        // Perubahan zona terakhir (buka atau tutup)
+    unsigned long _lowFlowSince = 0;
+    unsigned long _leakSince = 0;
+    unsigned long _badCurrentSince = 0;
+    bool _stalled = false;
+    bool _leak = false;
+    bool _leakReported = false;
+    uint32_t _faults[VALVE_FAULT_CURRENT + 1] = {};
+    uint32_t _cuts = 0;
+    uint32_t _stalls = 0;
+    uint32_t _leaks = 0;
+    long _maxLatency = 0;
+};
+
+// Pembungkus ValveOutput dengan pemutus: cut() mematikan output zona langsung
+// dari luar valveTask. Selama zona terputus, write(zone, true) diabaikan;
+// write(zone, false) dari ValveBank (zona ditutup) melepas pemutusnya.
+// Firmware menurunkan kelas ini untuk menambah spinlock (lock/unlock).
+class GuardedValveOutput : public ValveOutput {
+public:
+    explicit GuardedValveOutput(ValveOutput& inner) : _inner(inner) {}
+
+    void begin() override { _inner.begin(); }
+
+    void write(uint8_t zone, bool open) override {
+        lock();
+        uint32_t bit = zone < 32 ? 1UL << zone : 0;
+        if (!open) _cut &= ~bit;
+        if (!(open && (_cut & bit))) _inner.write(zone, open);
+        unlock();
+    }
+
+    void cut(uint32_t zones) {
+        lock();
+        _cut |= zones;
+        for (uint8_t z = 0; z < 32; z++) {
+            if (zones & (1UL << z)) _inner.write(z, false);
+        }
+        unlock();
+    }
+
+    uint32_t cutZones() const { return _cut; }
+
+protected:
+    virtual void lock() {}
+    virtual void unlock() {}
+
+private:
+    ValveOutput& _inner;
+    volatile uint32_t _cut = 0;
+};
@@ -0,0 +1,93 @@
+/*
+ * Watering - Langkah penyiraman terjadwal & closed-loop milik valveTask
+ *
+ *   startScheduledRun()  : satu event ScheduleTable -> rencana MoistureController
+ *                          -> request ke ValveBank
+ *   applyMoisture()      : bacaan soil baru -> MoistureController, lalu cutoff
+ *                          penyiraman terjadwal jika tanah sudah basah
+ *   wateringEvent()      : record LOG_WATERING untuk log flash
+ *
+ * Dipakai checkSchedule()/valveTask firmware dan simulasi host (sim/src/main.cpp),
+ * sehingga alur yang disimulasikan sama dengan yang berjalan di ESP32. Log,
+ * metrics dan antrian FreeRTOS tetap di pemanggil. Tidak bergantung pada Arduino.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ScheduleTable.h"
+#include "MoistureController.h"
+#include "ValveBank.h"
+
+// ==================== RECORD LOG FLASH ====================
+
+// Config disimpan sebagai snapshot utuh hanya saat jadwal berubah (dan di
+// awal setiap sektor log baru); penyiraman dicatat sebagai event kecil,
+// wateringCount = snapshot terakhir + event sesudahnya.
+enum ConfigLogType : uint8_t {
+    LOG_CONFIG_SNAPSHOT = 1,
+    LOG_WATERING = 2,
+};
+
+enum WateringSource : uint8_t {
+    WATERING_SCHEDULED,
+    WATERING_MANUAL,
+};
+
+struct WateringEvent {
+    uint32_t at;            // Epoch lokal RTC saat zona diminta buka
+    uint16_t durationSec;   // Durasi rencana (0 = manual, sampai ditutup)
+    uint8_t zone;
+    uint8_t source;         // WateringSource
+};
+
+// ==================== JADWAL ====================
+
+struct ScheduledRun {
+    MoistureController::Plan plan;
+    bool started;           // false: dilewati (SKIP) atau zona ditolak ValveBank
+};
+
+// Bit entry.zone (bit 0 = zona 1 di log) untuk dipakai sebagai moistureZones
+inline uint32_t moistureZoneBit(uint8_t zone) { return zone < 32 ? 1UL << zone : 0; }
+
+// Mulai satu event jadwal. Rencana MoistureController hanya dipakai untuk zona
+// di moistureZones (bed yang diukur sensor); zona lain dan moisture = nullptr
+// memakai durasi tetap (open-loop).
+// ValveBank hanya mengantrikan tunggu batas pompa/stagger; zona yang masih
+// terbuka/antri ditolak (started = false) dan event-nya dilewati.
+template <uint8_t ZONES>
+ScheduledRun startScheduledRun(const ScheduleEntry& entry, const MoistureController* moisture,
+                               uint32_t moistureZones, ValveBank<ZONES>& valves, unsigned long nowMs) {
+    ScheduledRun run;
+    if (moisture && (moistureZones & moistureZoneBit(entry.zone))) {
+        run.plan = moisture->plan(entry.durationSec, nowMs);
+    } else {
+        run.plan.action = MoistureController::RUN_OPEN_LOOP;
+        run.plan.durationSec = entry.durationSec;
+        run.plan.moisture = 0;
+    }
+    run.started = run.plan.action != MoistureController::SKIP &&
+                  valves.request(entry.zone, run.plan.durationSec * 1000UL, false, nowMs);
+    return run;
+}
+
+// Record LOG_WATERING untuk event jadwal yang sudah dimulai
+inline WateringEvent wateringEvent(const ScheduleEntry& entry, const ScheduledRun& run, uint32_t now) {
+    unsigned long durationSec = run.plan.durationSec > 0xFFFF ? 0xFFFF : run.plan.durationSec;
+    WateringEvent event = {now, (uint16_t)durationSec, entry.zone, WATERING_SCHEDULED};
+    return event;
+}
+
+// ==================== CLOSED-LOOP ====================
+
+// Bacaan soil (%) yang diambil pada sampledAtMs (millis() dikurangi umur
+// bacaan). Cutoff hanya untuk zona terjadwal di moistureZones; zona lain tetap
+// berjalan sampai durasinya habis. Mengembalikan jumlah zona yang dihentikan.
+template <uint8_t ZONES>
+uint8_t applyMoisture(MoistureController& moisture, ValveBank<ZONES>& valves, uint32_t moistureZones,
+                      float soil, unsigned long sampledAtMs, unsigned long nowMs) {
+    moisture.ingest(soil, sampledAtMs);
+    if (!moisture.shouldStop(nowMs)) return 0;
+    return valves.closeWhere(false, nowMs, moistureZones);
+}
@@ -1,10 +1,36 @@
 /*
- * SISTEM PENYIRAMAN TANAMAN OTOMATIS - MODE LOKAL (HTTP Polling)
+ * SISTEM PENYIRAMAN TANAMAN OTOMATIS - MODE LOKAL (SSE Push + HTTP Polling)
  * ESP32 + RTC DS3231 + Solenoid Valve + Web API Lokal
  * * * Fitur Utama:
- * - Penyiraman otomatis berdasarkan jadwal RTC/EEPROM
- * - Kontrol manual dari API Web Server Lokal (water-status)
+ * - Penyiraman otomatis berdasarkan jadwal RTC/log flash (hingga 32 entri,
+ *   durasi/hari/zona per entri, dengan catch-up untuk tick yang terlambat)
+ * - Multi-zona: satu relay per zona (GPIO) atau rantai 74HC595, dengan
+ *   sequencer yang membatasi zona terbuka bersamaan (batas pompa/tekanan)
+ * - Kontrol manual per zona dari API Web Server Lokal (water-status)
+ *   via stream SSE (push), fallback ke polling 5 detik saat stream putus
  * - Sinkronisasi Jadwal dan Durasi dari API Web Server Lokal (schedules)
+ * - Config & riwayat penyiraman di log append-only (partisi "wlog"), bukan
+ *   EEPROM.put seluruh struct setiap kali ada perubahan
+ * - Closed-loop kelembapan tanah: jadwal dilewati/diperpendek/diperpanjang
+ *   berdasarkan bacaan soil terbaru dari server (MoistureController)
+ * - Link lokal: bacaan soil langsung dari sensor node lewat UDP multicast
+ *   (LocalLink), sehingga closed-loop & jadwal tetap jalan tanpa server
+ * - Jam dari esp_timer (TimeService): RTC dibaca saat boot, NTP di-slew dengan
+ *   kompensasi drift, tanpa transaksi I2C di jalur jadwal
+ * - Update firmware OTA dari server lokal (EspOta): unduh streaming ke
+ *   partisi app cadangan, patch delta, rollout bertahap, boot trial + rollback
+ * - Pengaman valve (ValveSafety) dari esp_timer terpisah: batas keras lama
+ *   terbuka, failsafe saat link server hilang, anomali aliran/arus, pemutus
+ *   output langsung jika valveTask macet (task watchdog)
+ *
+ * Arsitektur task (FreeRTOS):
+ * - networkTask (core 0): WiFi, HTTP, SSE, NTP. Boleh blocking; perintah valve
+ *   dikirim lewat valveQueue, tidak pernah menyentuh relay secara langsung.
+ * - valveTask (core 1, prioritas tinggi): satu-satunya pemilik relay/valve.
+ *   Cek jadwal, auto-close, dan eksekusi perintah dari queue.
+ * - timer "safety" (esp_timer, tiap 100 ms): mengawasi zona terbuka, meminta
+ *   valveTask menutup, atau memutus output sendiri jika valveTask tidak bereaksi.
+ * - loop(): hanya input Serial (set waktu manual).
  */
 
 // ==================== LIBRARY ====================
@@ -14,54 +40,45 @@
 #include <EEPROM.h>
 #include <time.h> 
 #include <HTTPClient.h> 
+#include <WebServer.h>
 #include <ArduinoJson.h> 
+#include "StatusStream.h"
+#include "RemoteApi.h"
+#include "Scheduler.h"
+#include "MoistureController.h"
+#include "ScheduleTable.h"
+#include "Watering.h"
+#include "ValveOutputs.h"
+#include "ValveSafety.h"
+#include "TimeService.h"
+#include <esp_timer.h>
+#include <esp_task_wdt.h>
+#include <esp_sntp.h>
+
+#define HTTP_TRANSPORT_BODY_SIZE 2048 // Hanya untuk response chunked; JSON lain di-stream
+#include <HttpTransport.h>
+#include <LogStore.h>
+#include <PartitionFlashRegion.h>
+#define METRICS_MAX_ENTRIES 56 // 50 terdaftar di setupMetrics()
+#include <Metrics.h>
+#include <AsyncLog.h> // LOG_E/W/I/D; level lewat -DLOG_LEVEL, -DLOG_TO_UART=0 untuk /log saja
+#include <WifiManager.h>
+#include <TelemetryCodec.h>
+#include <LocalLink.h>
+#include <NodeId.h>
+#include <EspOta.h>
+
+// Profiling hot path: latensi & pertumbuhan heap per fungsi, stack tiap task.
+// Laporan JSON (awalan "PROFILE ") bersama statistik loop tiap 1 menit.
+// Aktifkan lewat build_flags: -DENABLE_PROFILING=1
+#ifndef ENABLE_PROFILING
+#define ENABLE_PROFILING 0
+#endif
+#include <Profiler.h>
 
-// ==================== DEFINISI MINIMAL TIMER CLASS ====================
-class MinimalTimer {
-private:
-    struct TimerJob {
-        long interval;
-        unsigned long prevMillis;
-        void (*callback)(); 
-        bool enabled;
-        int id; 
-    };
-    TimerJob jobs[5]; 
-    int jobCount = 0;
-
-public:
-    MinimalTimer() {}
-
-    int setInterval(long interval, void (*callback)()) {
-        if (jobCount >= 5) return -1; 
-        jobs[jobCount].interval = interval;
-        jobs[jobCount].prevMillis = millis();
-        jobs[jobCount].callback = callback;
-        jobs[jobCount].enabled = true;
-        jobs[jobCount].id = jobCount;
-        return jobCount++;
-    }
-
-    void run() {
-        for (int i = 0; i < jobCount; i++) {
-            if (jobs[i].enabled) {
-                if (millis() - jobs[i].prevMillis >= (unsigned long)jobs[i].interval) {
-                    jobs[i].prevMillis = millis(); 
-                    jobs[i].callback();             
-                }
-            }
-        }
-    }
-    
-    void disable(int id) {
-        if (id >= 0 && id < jobCount) {
-            jobs[id].enabled = false;
-        }
-    }
-};
 // ====================================================================
 // ==================== KONFIGURASI PIN & JARINGAN ====================
-#define RELAY_PIN 5 
+#define RELAY_PIN 5 // Relay zona 1
 #define SDA_PIN 21  
 #define SCL_PIN 22  
 #define LED_PIN 2 
@@ -72,52 +89,501 @@ char pass[] = "gahya123";
 
 // --- KONFIGURASI API LOKAL (SERVER SIDE) ---
 // ⚠️ GANTI IP INI DENGAN IP KOMPUTER/SERVER LARAVEL ANDA
-const char* apiHost = "10.163.159.210"; // Ganti dengan IP server Laravel Anda
-const int apiPort = 8000; 
-const char* apiEndpoint = "/api/water-status"; 
-// Di bagian konfigurasi API, ubah:
-const char* apiScheduleEndpoint = "/api/schedules/esp32"; // 
+// (atau per node lewat build_flags: -DAPI_HOST=\"10.0.0.5\" -DAPI_PORT=8000)
+#ifndef API_HOST
+#define API_HOST "10.163.159.210"
+#endif
+#ifndef API_PORT
+#define API_PORT 8000
+#endif
+const char* apiHost = API_HOST; // Ganti dengan IP server Laravel Anda
+const int apiPort = API_PORT; 
+
+// Endpoint per node /api/nodes/<id>/... (id = MAC, NodeId.h) agar beberapa
+// pasangan node bisa memakai satu server. 0 = endpoint global (satu pasangan).
+// Aktifkan lewat build_flags: -DNODE_SCOPED_API=1
+#ifndef NODE_SCOPED_API
+#define NODE_SCOPED_API 0
+#endif
+
+// Sensor node pasangan untuk link lokal, mis. -DPAIRED_SENSOR_ID=\"a4cf12b3c4d5\"
+// (ID tercetak di log boot sensor node). Kosong = sensor pertama yang terdengar.
+#ifndef PAIRED_SENSOR_ID
+#define PAIRED_SENSOR_ID ""
+#endif
+
+// Versi firmware ini, dibandingkan dengan manifest OTA dari server.
+// Naikkan setiap rilis: -DFIRMWARE_VERSION=\"1.1.0\"
+#ifndef FIRMWARE_VERSION
+#define FIRMWARE_VERSION "1.0.0"
+#endif
+
+// Diisi ulang oleh setupNodeIdentity() jika NODE_SCOPED_API
+char nodeId[NODE_ID_SIZE] = "";
+char apiEndpoint[48] = "/api/water-status"; 
+char apiScheduleEndpoint[48] = "/api/schedules/esp32"; // 
+char apiStreamEndpoint[48] = "/api/water-status/stream"; // SSE: push perintah valve
+char apiMoistureEndpoint[48] = "/api/sensor/latest"; // Bacaan soil terbaru dari sensor node pasangan
+char apiFirmwareEndpoint[64] = "/api/firmware/prokon?version=" FIRMWARE_VERSION; // Manifest OTA
 
 const char* ntpServer = "id.pool.ntp.org"; 
 const long gmtOffset_sec = 7 * 3600; 
 const int daylightOffset_sec = 0;
 
+// --- KONFIGURASI ZONA VALVE ---
+// Default: satu relay di RELAY_PIN. Multi-zona lewat build_flags, mis.
+//   -D VALVE_ZONE_PINS=5,18,19,23         (satu GPIO per zona)
+//   -D VALVE_SHIFT_REGISTER -D VALVE_SHIFT_ZONES=16  (rantai 74HC595)
+#define VALVE_MAX_CONCURRENT 1   // Zona terbuka bersamaan (kapasitas pompa)
+#define VALVE_STAGGER_MS 5000UL  // Jeda antar pembukaan zona (lonjakan tekanan)
+
+#ifdef VALVE_SHIFT_REGISTER
+#ifndef VALVE_SHIFT_ZONES
+#define VALVE_SHIFT_ZONES 8
+#endif
+#define SR_DATA_PIN 25
+#define SR_CLOCK_PIN 26
+#define SR_LATCH_PIN 27
+const uint8_t VALVE_ZONES = VALVE_SHIFT_ZONES;
+ShiftRegisterValveOutput valveOutput(SR_DATA_PIN, SR_CLOCK_PIN, SR_LATCH_PIN, VALVE_ZONES);
+#else
+#ifndef VALVE_ZONE_PINS
+#define VALVE_ZONE_PINS RELAY_PIN
+#endif
+const uint8_t ZONE_PINS[] = {VALVE_ZONE_PINS};
+const uint8_t VALVE_ZONES = sizeof(ZONE_PINS);
+GpioValveOutput valveOutput(ZONE_PINS, VALVE_ZONES);
+#endif
+
+// --- PENGAMAN VALVE ---
+// Batas keras lama terbuka (semua zona / manual dari remote), mis.
+//   -D VALVE_MAX_OPEN_MS=3600000UL -D VALVE_MANUAL_MAX_MS=900000UL
+// Sensor opsional untuk deteksi anomali:
+//   -D FLOW_SENSOR_PIN=34   (flow meter pulsa di pipa utama, mis. YF-S201)
+//   -D VALVE_CURRENT_PIN=35 (sensor arus koil solenoid, keluaran analog)
+#ifndef VALVE_MAX_OPEN_MS
+#define VALVE_MAX_OPEN_MS 7200000UL   // 2 jam: di atas jadwal terpanjang + perpanjangan closed-loop
+#endif
+#ifndef VALVE_MANUAL_MAX_MS
+#define VALVE_MANUAL_MAX_MS 1800000UL // 30 menit
+#endif
+#ifndef FLOW_PULSES_PER_LITER
+#define FLOW_PULSES_PER_LITER 450.0f  // YF-S201: 7.5 Hz per L/menit
+#endif
+#ifndef VALVE_CURRENT_MA_PER_MV
+#define VALVE_CURRENT_MA_PER_MV 1.0f
+#endif
+
 // ==================== OBJEK ====================
 
 RTC_DS3231 rtc;
-MinimalTimer timer; 
+// Jam dinding dari esp_timer, didisiplinkan NTP; DS3231 dibaca saat boot dan
+// sebagai cadangan saat NTP tidak tersedia. Offset <= 30 detik di-slew
+// (maks. 2000 ppm = 1 detik per ~8 menit), frekuensi dirata-rata 4 jam.
+const TimeServiceConfig TIME_SERVICE_CONFIG = {30000, 2000, 500, 3600, 14400, 1500, 2, 86400};
+TimeService timeService(TIME_SERVICE_CONFIG);
+portMUX_TYPE timeMux = portMUX_INITIALIZER_UNLOCKED; // timeService dipakai valveTask & networkTask
+Scheduler<> netTimer(millis);   // Job jaringan, dijalankan networkTask
+Scheduler<> valveTimer(millis); // Job valve & jadwal, dijalankan valveTask
+StatusStream statusStream;
+HttpTransport api; // Koneksi keep-alive ke server Laravel
+WifiManager wifi;  // Reconnect di latar dengan backoff; di-update oleh networkTask
+LocalLink localLink; // Bacaan dari sensor node tanpa server; hanya diakses networkTask
+
+// ==================== FREERTOS ====================
+#define NET_TASK_CORE 0
+#define VALVE_TASK_CORE 1
+#define NET_TASK_PRIORITY 1
+#define VALVE_TASK_PRIORITY 3 // Di atas loopTask (1) agar valve tidak tertunda
+#define NET_TASK_STACK 10240
+#define VALVE_TASK_STACK 4096
+#define VALVE_QUEUE_LENGTH 8
+
+enum ValveCommandType : uint8_t {
+    VALVE_CMD_REMOTE_ON,
+    VALVE_CMD_REMOTE_OFF,
+    VALVE_CMD_MOISTURE,     // Bacaan soil baru untuk MoistureController
+    VALVE_CMD_RELOAD_SCHEDULES, // Jadwal di config berubah atau jam di-step
+    VALVE_CMD_RESTART,      // Firmware baru siap: restart begitu semua zona tertutup
+    VALVE_CMD_SAFETY_CLOSE, // Dari timer pengaman; value = ValveFault
+};
 
-// ==================== STRUKTUR DATA (EEPROM) ====================
-struct Schedule {
-    int hour;
-    int minute;
-    bool enabled;
+struct ValveCommand {
+    ValveCommandType type;
+    unsigned long issuedAt; // millis() saat perintah diterima dari server
+    float value;            // Kelembapan tanah (%) untuk VALVE_CMD_MOISTURE
+    uint8_t zone;           // Zona (mulai 0) untuk VALVE_CMD_REMOTE_*
 };
 
+QueueHandle_t valveQueue;
+TaskHandle_t netTaskHandle = nullptr;
+TaskHandle_t valveTaskHandle = nullptr;
+SemaphoreHandle_t configMutex; // Melindungi config, configLog & riwayat penyiraman
+SemaphoreHandle_t rtcMutex;    // Satu transaksi I2C DS3231 dalam satu waktu
+QueueHandle_t ntpQueue;        // Sampel NTP terbaru dari callback SNTP (panjang 1, ditimpa)
+
+// ==================== STRUKTUR DATA (LOG FLASH) ====================
+#define MAX_SCHEDULES 32
+
 struct Config {
-    Schedule schedules[3];
-    int duration; 
+    ScheduleEntry schedules[MAX_SCHEDULES]; // Urutan sesuai server
+    int scheduleCount;
     int wateringCount;
     int magicNumber; 
 } config;
 
-#define MAGIC_NUMBER 54321
-#define EEPROM_SIZE 512
+#define MAGIC_NUMBER 54322 // Naik saat layout Config berubah
+#define EEPROM_SIZE 512     // Hanya untuk migrasi config lama / fallback
+
+// Record di log flash (LOG_CONFIG_SNAPSHOT / LOG_WATERING): lihat Watering.h
+
+#define CONFIG_LOG_PARTITION "wlog"
+#define WATERING_HISTORY_SIZE 16
+PartitionFlashRegion configFlash;
+LogStore configLog(configFlash);
+bool configLogReady = false;
+WateringEvent wateringHistory[WATERING_HISTORY_SIZE]; // Ring, terbaru di akhir
+size_t wateringHistoryCount = 0;
 
 // ==================== VARIABEL GLOBAL ====================
-bool valveOpen = false;
-bool isWatering = false;
-bool manualMode = false; 
-unsigned long valveOpenTime = 0;
-bool lastScheduleCheck[3] = {false, false, false}; 
-long lastRTCSync = 0; 
+const unsigned long NTP_SYNC_INTERVAL_MS = 900000UL; // Interval klien SNTP (default lwIP 1 jam)
+const unsigned long NTP_STALE_MS = 3600000UL;        // Tanpa sampel NTP selama ini = jam ikut DS3231
 const long REMOTE_CHECK_INTERVAL = 5000L; 
+const unsigned long LOOP_MAX_SLEEP_MS = 20; // Batas tidur networkTask agar SSE tetap responsif
+unsigned long loopIterations = 0;
+unsigned long loopSleepMs = 0;
+unsigned long commandLatencyMaxMs = 0;      // Perintah remote -> relay terburuk
+char scheduleEtag[64] = ""; // Versi jadwal terakhir yang diterapkan (header ETag)
+unsigned long wateredSecondsTotal = 0;      // Total detik valve terbuka sejak boot (pemakaian air)
+
+// --- TABEL JADWAL ---
+// valveTask tidur sampai event berikutnya, paling lama 60 detik agar perubahan
+// RTC/drift millis() tetap terkejar. Event terlambat <= 5 menit tetap dijalankan.
+const unsigned long SCHEDULE_MAX_SLEEP_MS = 60000UL;
+const uint32_t SCHEDULE_CATCH_UP_SEC = 300;
+ScheduleTable<MAX_SCHEDULES> scheduleTable(SCHEDULE_CATCH_UP_SEC); // Hanya diakses valveTask
+Scheduler<>::Handle scheduleJob = 0;
+
+// --- PENGAMAN VALVE ---
+// Timer pengaman berjalan di task esp_timer (prioritas tertinggi aplikasi),
+// terpisah dari networkTask & valveTask. valveTask diberi 500 ms untuk
+// menutup zona yang melanggar batas; setelah itu, atau jika valveTask tidak
+// berputar 3 detik, output diputus langsung. Latensi tutup <= 100 + 500 ms.
+// Tanpa kontak server 90 detik (3 ping SSE / 18 polling) zona manual ditutup.
+const unsigned long SAFETY_TICK_MS = 100;
+const unsigned long VALVE_HEARTBEAT_MS = 1000;      // valveTask bangun minimal tiap 1 detik
+const uint32_t VALVE_WDT_TIMEOUT_S = 10;            // Task watchdog: valveTask macet = reset (relay mati)
+const ValveSafetyConfig SAFETY_CONFIG = {
+    VALVE_MAX_OPEN_MS, VALVE_MANUAL_MAX_MS, 90000UL, 500, 3000,
+#ifdef FLOW_SENSOR_PIN
+    1.0f, 0.5f, 30000UL,   // Tersumbat < 1 L/menit, bocor > 0,5 L/menit, bertahan 30 detik
+#else
+    0, 0, 30000UL,
+#endif
+#ifdef VALVE_CURRENT_PIN
+    50.0f, 1500.0f,        // Koil putus < 50 mA, hubung singkat > 1,5 A
+#else
+    0, 0,
+#endif
+};
+ValveSafety<VALVE_ZONES> safety(SAFETY_CONFIG);
+portMUX_TYPE safetyMux = portMUX_INITIALIZER_UNLOCKED; // safety dipakai timer, valveTask & networkTask
+esp_timer_handle_t safetyTimer = nullptr;
+uint32_t safetyLatchedZones = 0; // Zona manual yang ditutup pengaman (hanya valveTask)
+#ifdef FLOW_SENSOR_PIN
+volatile uint32_t flowPulses = 0;
+#endif
+
+// --- UPDATE OTA ---
+// Manifest dicek tiap jam; unduhan dijalankan per potongan di sela job lain
+// networkTask. Image baru menjalani boot trial: dikonfirmasi setelah WiFi,
+// API dan valveTask sehat, atau rollback setelah 3 boot gagal / 10 menit
+// tanpa health check lulus.
+const unsigned long OTA_CHECK_INTERVAL_MS = 3600000UL;
+const unsigned long OTA_STEP_INTERVAL_MS = 20;
+const unsigned long OTA_HEALTH_CHECK_MS = 10000UL;
+const uint8_t OTA_TRIAL_MAX_BOOTS = 3;
+const unsigned long OTA_HEALTH_TIMEOUT_MS = 600000UL;
+EspOtaClient ota;                                   // Hanya diakses networkTask
+EspOtaTrial otaTrial(OTA_TRIAL_MAX_BOOTS, OTA_HEALTH_TIMEOUT_MS);
+Scheduler<>::Handle otaStepJob = 0;
+Scheduler<>::Handle otaHealthJob = 0;
+volatile bool apiResponded = false;                 // Ada response API sukses sejak boot (health check)
+
+// --- CLOSED-LOOP KELEMBAPAN TANAH ---
+// Histeresis 40-60 %: di atas 60 % jadwal dilewati sampai tanah turun di bawah 40 %.
+// Bacaan lebih tua dari 15 menit diabaikan (kembali ke durasi tetap).
+const MoistureControllerConfig MOISTURE_CONFIG = {40.0f, 60.0f, 0.25f, 2.0f, 900000UL};
+const unsigned long MOISTURE_FETCH_INTERVAL = 60000UL;
+MoistureController moisture(MOISTURE_CONFIG); // Hanya diakses valveTask
+// Zona yang bed-nya diukur sensor soil (bit 0 = zona 1). Hanya zona ini yang
+// memakai rencana & cutoff closed-loop; zona lain tetap durasi tetap.
+// Override: -DMOISTURE_ZONES=0x03
+#ifndef MOISTURE_ZONES
+#define MOISTURE_ZONES 0x01UL
+#endif
+// Selama frame link lokal datang (sensor kirim tiap 30 detik), bacaan dari
+// server tidak diambil; 3 frame hilang berturut-turut = kembali ke server.
+const unsigned long LOCAL_LINK_FRESH_MS = 95000UL;
+
+// --- METRICS & TRACE ---
+// Counter/histogram di RAM, dibaca lewat GET /metrics (format Prometheus) dan
+// GET /trace (event terakhir). Selalu aktif: biaya per event hanya beberapa
+// increment, total ~2 KB RAM statis.
+#define METRICS_PORT 80
+#define TRACE_EVENTS 64
+
+enum TraceCode : uint16_t {
+    TRACE_BOOT,             // arg = esp_reset_reason()
+    TRACE_WIFI_CONNECTED,   // value = lama putus (ms)
+    TRACE_WIFI_FAILED,      // value = jeda sebelum percobaan berikutnya (ms)
+    TRACE_HTTP_ERROR,       // arg = kode HTTP, value = ms
+    TRACE_NTP_SYNC,         // arg = TimeService::Result, value = offset jam terhadap NTP (ms)
+    TRACE_NTP_FAILED,
+    TRACE_VALVE_OPEN,       // arg = zona, value = 1 jika manual
+    TRACE_VALVE_CLOSE,      // arg = zona, value = detik terbuka
+    TRACE_SCHEDULE_SYNC,    // value = jumlah jadwal
+    TRACE_WIFI_LOST,
+    TRACE_OTA_START,        // arg = 1 jika patch delta, value = byte payload
+    TRACE_OTA_DONE,         // value = lama unduhan (ms)
+    TRACE_OTA_FAILED,       // value = byte payload diterima
+    TRACE_OTA_CONFIRMED,    // arg = jumlah boot trial
+    TRACE_OTA_ROLLBACK,     // arg = jumlah boot trial
+    TRACE_SAFETY_CLOSE,     // arg = zona, value = ValveFault
+    TRACE_SAFETY_CUT,       // arg = zona, value = ValveFault (output diputus langsung)
+    TRACE_SAFETY_ALARM,     // arg = ValveFault (task_stall, leak)
+};
+const char* const TRACE_NAMES[] = {
+    "boot", "wifi_connected", "wifi_failed", "http_error", "ntp_sync", "ntp_failed",
+    "valve_open", "valve_close", "schedule_sync", "wifi_lost",
+    "ota_start", "ota_done", "ota_failed", "ota_confirmed", "ota_rollback",
+    "safety_close", "safety_cut", "safety_alarm",
+};
+
+const uint32_t HTTP_LATENCY_BOUNDS_MS[] = {10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000};
+const uint32_t VALVE_DURATION_BOUNDS_SEC[] = {30, 60, 120, 300, 600, 900, 1800, 3600};
+const uint32_t NTP_DRIFT_BOUNDS_SEC[] = {0, 1, 2, 5, 10, 30, 60, 300};
+const uint32_t SAFETY_CLOSE_BOUNDS_MS[] = {10, 50, 100, 200, 300, 500, 600, 1000, 5000};
+#define BOUNDS(b) b, sizeof(b) / sizeof(b[0])
+
+// Latensi & kegagalan per endpoint; entri terakhir menampung path lain
+struct EndpointMetrics {
+    const char* path;
+    const char* labels;
+    MetricHistogram latency;
+    MetricCounter failures;
+};
+EndpointMetrics endpointMetrics[] = {
+    {apiEndpoint, "endpoint=\"water-status\"", {BOUNDS(HTTP_LATENCY_BOUNDS_MS)}, {}},
+    {apiScheduleEndpoint, "endpoint=\"schedules\"", {BOUNDS(HTTP_LATENCY_BOUNDS_MS)}, {}},
+    {apiMoistureEndpoint, "endpoint=\"sensor-latest\"", {BOUNDS(HTTP_LATENCY_BOUNDS_MS)}, {}},
+    {nullptr, "endpoint=\"other\"", {BOUNDS(HTTP_LATENCY_BOUNDS_MS)}, {}},
+};
+const size_t ENDPOINT_METRICS_COUNT = sizeof(endpointMetrics) / sizeof(endpointMetrics[0]);
+
+MetricCounter wifiReconnects;
+MetricCounter wifiConnectFailures;
+MetricGauge wifiConnected;                           // 1 saat terhubung
+MetricCounter ntpSyncs;
+MetricCounter ntpFailures;
+MetricGauge ntpDriftSeconds;                         // Drift terakhir (RTC - NTP)
+MetricHistogram ntpDriftAbs(BOUNDS(NTP_DRIFT_BOUNDS_SEC));
+MetricGauge clockOffsetMs;                           // Diisi dari TimeService saat /metrics dibaca
+MetricGauge clockFrequencyPpb;
+MetricGauge clockSlewPendingMs;
+MetricGauge clockSteps;
+MetricGauge rtcDriftPpb;
+MetricHistogram valveOpenScheduled(BOUNDS(VALVE_DURATION_BOUNDS_SEC)); // Ditulis valveTask
+MetricHistogram valveOpenManual(BOUNDS(VALVE_DURATION_BOUNDS_SEC));
+MetricCounter netLoopIterations;
+MetricCounter valveLoopIterations;
+MetricGauge heapFree;                                // Diisi saat /metrics dibaca
+MetricGauge heapMinFree;
+MetricGauge heapMaxBlock;
+MetricGauge uptimeSeconds;
+MetricGauge logDroppedLines;
+MetricGauge localLinkFrames;                         // Diisi dari statistik LocalLink saat /metrics dibaca
+MetricGauge localLinkLost;
+MetricGauge localLinkStale;
+MetricGauge localLinkForeign;                        // Frame sensor node pasangan lain
+MetricGauge localLinkAgeSeconds;
+MetricGauge otaUpdates;                              // Diisi dari statistik OtaClient saat /metrics dibaca
+MetricGauge otaFailures;
+MetricGauge otaResumes;
+MetricGauge otaProgressPct;
+MetricGauge otaTrialPending;
+MetricHistogram safetyCloseLatency(BOUNDS(SAFETY_CLOSE_BOUNDS_MS)); // Batas dilanggar -> output mati
+MetricGauge safetyFaults[VALVE_FAULT_CURRENT + 1];   // Diisi dari ValveSafety saat /metrics dibaca
+MetricGauge safetyCuts;
+MetricGauge safetyStalls;
+MetricGauge safetyLinkAgeSeconds;
+
+MetricsRegistry metrics;
+TraceRing<TRACE_EVENTS> trace;
+WebServer metricsServer(METRICS_PORT); // Dilayani networkTask
 
 // =========================================================
 // ================ DEFINISI FUNGSI ==========================
 // =========================================================
 
-// --- FUNGSI HELPER & EEPROM ---
+// --- FUNGSI METRICS & TRACE ---
+void traceEvent(TraceCode code, int16_t arg = 0, int32_t value = 0) {
+    trace.record(millis(), code, arg, value);
+}
+
+// Observer HttpTransport (dipanggil di networkTask setiap request)
+void onHttpRequest(const char* path, int code, uint32_t elapsedMs, void* ctx) {
+    EndpointMetrics* m = &endpointMetrics[ENDPOINT_METRICS_COUNT - 1];
+    for (size_t i = 0; i + 1 < ENDPOINT_METRICS_COUNT; i++) {
+        if (strcmp(path, endpointMetrics[i].path) == 0) {
+            m = &endpointMetrics[i];
+            break;
+        }
+    }
+    m->latency.observe(elapsedMs);
+    if (code > 0 && code < 400) apiResponded = true;
+    if (code < 0 || code >= 400) {
+        m->failures.inc();
+        traceEvent(TRACE_HTTP_ERROR, code, elapsedMs);
+    }
+}
+
+void sendMetricsChunk(const char* text, size_t length, void* ctx) {
+    static_cast<WebServer*>(ctx)->sendContent(text, length);
+}
+
+void handleMetrics() {
+    heapFree.set(ESP.getFreeHeap());
+    heapMinFree.set(ESP.getMinFreeHeap());
+    heapMaxBlock.set(ESP.getMaxAllocHeap());
+    uptimeSeconds.set(millis() / 1000);
+    logDroppedLines.set(asyncLog().droppedLines());
+    const LocalLinkReceiver::Stats& link = localLink.receiver().stats();
+    localLinkFrames.set(link.received);
+    localLinkLost.set(link.lost);
+    localLinkStale.set(link.stale);
+    localLinkForeign.set(link.foreign);
+    localLinkAgeSeconds.set(link.received ? (int32_t)((millis() - localLink.receiver().lastAt()) / 1000) : -1);
+    portENTER_CRITICAL(&timeMux);
+    TimeService::Stats clock = timeService.stats();
+    int64_t slewPendingUs = timeService.pendingSlewUs(esp_timer_get_time());
+    portEXIT_CRITICAL(&timeMux);
+    clockOffsetMs.set(clock.lastOffsetMs);
+    clockFrequencyPpb.set(clock.freqPpb);
+    clockSlewPendingMs.set((int32_t)(slewPendingUs / 1000));
+    clockSteps.set(clock.steps);
+    rtcDriftPpb.set(clock.rtcDriftPpb);
+    const OtaClient::Stats& otaStats = ota.stats();
+    otaUpdates.set(otaStats.updates);
+    otaFailures.set(otaStats.failures);
+    otaResumes.set(otaStats.resumes);
+    otaProgressPct.set(ota.status() == OtaClient::RUNNING ? ota.progressPct() : -1);
+    otaTrialPending.set(otaTrial.pending());
+    portENTER_CRITICAL(&safetyMux);
+    for (uint8_t f = VALVE_FAULT_MAX_OPEN; f <= VALVE_FAULT_CURRENT; f++) {
+        safetyFaults[f].set(f == VALVE_FAULT_LEAK ? safety.leaks() : safety.faults((ValveFault)f));
+    }
+    safetyCuts.set(safety.cuts());
+    safetyStalls.set(safety.stalls());
+    safetyLinkAgeSeconds.set(safety.linkAgeMs(millis()) / 1000);
+    portEXIT_CRITICAL(&safetyMux);
+
+    metricsServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    metricsServer.send(200, "text/plain; version=0.0.4", "");
+    metrics.write(sendMetricsChunk, &metricsServer);
+    metricsServer.sendContent("");
+}
+
+// Satu baris per event: "<ms> <nama> <arg> <nilai>", tertua lebih dulu
+void handleTrace() {
+    metricsServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    metricsServer.send(200, "text/plain", "");
+    trace.write(sendMetricsChunk, &metricsServer, TRACE_NAMES, sizeof(TRACE_NAMES) / sizeof(TRACE_NAMES[0]));
+    metricsServer.sendContent("");
+}
+
+#if !LOG_TO_UART
+// Log terakhir dari ring AsyncLog (LOG_TO_UART=0: log tidak dikirim ke UART)
+void handleLog() {
+    metricsServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    metricsServer.send(200, "text/plain; charset=utf-8", "");
+    asyncLog().dump([](const char* text, size_t length) { metricsServer.sendContent(text, length); });
+    metricsServer.sendContent("");
+}
+#endif
+
+void setupMetrics() {
+    const char* httpLatencyHelp = "Waktu request HTTP sampai header response (ms)";
+    for (size_t i = 0; i < ENDPOINT_METRICS_COUNT; i++) {
+        metrics.add("prokon_http_request_ms", httpLatencyHelp, endpointMetrics[i].latency, endpointMetrics[i].labels);
+    }
+    for (size_t i = 0; i < ENDPOINT_METRICS_COUNT; i++) {
+        metrics.add("prokon_http_failures_total", "Request HTTP gagal (error transport atau kode >= 400)",
+                    endpointMetrics[i].failures, endpointMetrics[i].labels);
+    }
+    metrics.add("prokon_wifi_reconnects_total", "Koneksi WiFi berhasil dibuat ulang", wifiReconnects);
+    metrics.add("prokon_wifi_connect_failures_total", "Percobaan koneksi WiFi gagal", wifiConnectFailures);
+    metrics.add("prokon_wifi_connected", "Status koneksi WiFi (1 = terhubung)", wifiConnected);
+    metrics.add("prokon_ntp_syncs_total", "Sinkronisasi RTC dari NTP berhasil", ntpSyncs);
+    metrics.add("prokon_ntp_failures_total", "Sinkronisasi RTC dari NTP gagal", ntpFailures);
+    metrics.add("prokon_ntp_drift_seconds", "Drift RTC terhadap NTP saat sync terakhir", ntpDriftSeconds);
+    metrics.add("prokon_ntp_drift_abs_seconds", "Besar drift RTC per sync", ntpDriftAbs);
+    metrics.add("prokon_clock_offset_ms", "Offset jam terhadap NTP/RTC pada sampel terakhir", clockOffsetMs);
+    metrics.add("prokon_clock_frequency_ppb", "Koreksi frekuensi esp_timer dari sampel NTP", clockFrequencyPpb);
+    metrics.add("prokon_clock_slew_pending_ms", "Sisa offset yang sedang di-slew", clockSlewPendingMs);
+    metrics.add("prokon_clock_steps", "Jam di-step (boot, offset besar, set manual)", clockSteps);
+    metrics.add("prokon_rtc_drift_ppb", "Estimasi drift DS3231 terhadap NTP", rtcDriftPpb);
+    metrics.add("prokon_valve_open_seconds", "Lama zona terbuka per penyiraman", valveOpenScheduled,
+                "source=\"schedule\"");
+    metrics.add("prokon_valve_open_seconds", "Lama zona terbuka per penyiraman", valveOpenManual,
+                "source=\"manual\"");
+    metrics.add("prokon_loop_iterations_total", "Iterasi loop task", netLoopIterations, "task=\"network\"");
+    metrics.add("prokon_loop_iterations_total", "Iterasi loop task", valveLoopIterations, "task=\"valve\"");
+    metrics.add("prokon_heap_free_bytes", "Heap bebas", heapFree);
+    metrics.add("prokon_heap_min_free_bytes", "Heap bebas terendah sejak boot", heapMinFree);
+    metrics.add("prokon_heap_max_block_bytes", "Blok heap terbesar yang bisa dialokasikan", heapMaxBlock);
+    metrics.add("prokon_uptime_seconds", "Waktu sejak boot", uptimeSeconds);
+    metrics.add("prokon_log_dropped_lines", "Baris log dibuang karena buffer penuh", logDroppedLines);
+    metrics.add("prokon_local_link_frames", "Frame sensor node diterima lewat link lokal", localLinkFrames);
+    metrics.add("prokon_local_link_lost_frames", "Frame link lokal yang tidak sampai (lompatan seq)", localLinkLost);
+    metrics.add("prokon_local_link_stale_frames", "Frame link lokal duplikat/terlambat", localLinkStale);
+    metrics.add("prokon_local_link_foreign_frames", "Frame link lokal dari sensor node lain (diabaikan)",
+                localLinkForeign);
+    metrics.add("prokon_local_link_age_seconds", "Umur frame link lokal terakhir (-1 = belum ada)",
+                localLinkAgeSeconds);
+    metrics.add("prokon_ota_updates", "Firmware baru terverifikasi & siap di-boot", otaUpdates);
+    metrics.add("prokon_ota_failures", "Unduhan firmware gagal (transport, hash, patch)", otaFailures);
+    metrics.add("prokon_ota_resumes", "Unduhan firmware dilanjutkan dengan Range", otaResumes);
+    metrics.add("prokon_ota_progress_percent", "Progres unduhan firmware (-1 = tidak ada)", otaProgressPct);
+    metrics.add("prokon_ota_trial", "Firmware dalam boot trial (1 = belum dikonfirmasi)", otaTrialPending);
+    static const char* const SAFETY_FAULT_LABELS[] = {
+        "", "fault=\"max_open\"", "fault=\"manual_max\"", "fault=\"link_lost\"",
+        "fault=\"task_stall\"", "fault=\"no_flow\"", "fault=\"leak\"", "fault=\"current\"",
+    };
+    for (uint8_t f = VALVE_FAULT_MAX_OPEN; f <= VALVE_FAULT_CURRENT; f++) {
+        metrics.add("prokon_valve_safety_faults", "Pelanggaran batas pengaman valve per jenis", safetyFaults[f],
+                    SAFETY_FAULT_LABELS[f]);
+    }
+    metrics.add("prokon_valve_safety_cuts", "Output zona diputus langsung oleh timer pengaman", safetyCuts);
+    metrics.add("prokon_valve_safety_stalls", "valveTask tidak berputar saat ada zona terbuka", safetyStalls);
+    metrics.add("prokon_valve_safety_close_ms", "Batas pengaman dilanggar sampai output mati", safetyCloseLatency);
+    metrics.add("prokon_valve_safety_link_age_seconds", "Sejak kontak terakhir dengan server (failsafe link)",
+                safetyLinkAgeSeconds);
+    if (metrics.rejected()) {
+        LOG_E("❌ %u metrik tidak terdaftar: naikkan METRICS_MAX_ENTRIES (%u, terdaftar %u).",
+              (unsigned)metrics.rejected(), (unsigned)METRICS_MAX_ENTRIES, (unsigned)metrics.size());
+    }
+
+    api.onRequest(onHttpRequest);
+    metricsServer.on("/metrics", HTTP_GET, handleMetrics);
+    metricsServer.on("/trace", HTTP_GET, handleTrace);
+#if !LOG_TO_UART
+    metricsServer.on("/log", HTTP_GET, handleLog);
+#endif
+    metricsServer.begin();
+}
+
+// --- FUNGSI HELPER & CONFIG ---
 void blinkError() {
     for (int i = 0; i < 10; i++) {
         digitalWrite(LED_PIN, HIGH);
@@ -127,130 +593,497 @@ void blinkError() {
     }
 }
 
-void displayConfig() {
-    Serial.println("📋 KONFIGURASI SISTEM:");
-    Serial.println("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━");
+void displayConfig(const Config& cfg) {
+    LOG_I("📋 KONFIGURASI SISTEM:");
+    LOG_I("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━");
     
-    for (int i = 0; i < 3; i++) {
-        Serial.printf("    Jadwal %d: %02d:%02d (%s)\n", 
+    for (int i = 0; i < cfg.scheduleCount; i++) {
+        const ScheduleEntry& s = cfg.schedules[i];
+        char days[8] = "MSSRKJS"; // Minggu..Sabtu, '-' = tidak aktif hari itu
+        for (int d = 0; d < 7; d++) {
+            if (!(s.weekdays & (1 << d))) days[d] = '-';
+        }
+        LOG_I("    Jadwal %d: %02d:%02d [%s] zona %d, %d detik (%s)\n", 
             i+1, 
-            config.schedules[i].hour, 
-            config.schedules[i].minute,
-            config.schedules[i].enabled ? "AKTIF" : "NONAKTIF");
+            s.minuteOfDay / 60, 
+            s.minuteOfDay % 60,
+            days, s.zone + 1, s.durationSec,
+            s.enabled ? "AKTIF" : "NONAKTIF");
     }
     
-    Serial.printf("    Durasi: %d detik\n", config.duration);
-    Serial.printf("    Total Penyiraman: %d kali\n", config.wateringCount);
-    Serial.println("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
+    LOG_I("    Total Penyiraman: %d kali\n", cfg.wateringCount);
+    LOG_I("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
+}
+
+// Salinan config yang konsisten (dipakai lintas task)
+Config readConfig() {
+    xSemaphoreTake(configMutex, portMAX_DELAY);
+    Config copy = config;
+    xSemaphoreGive(configMutex);
+    return copy;
+}
+
+// --- FUNGSI RTC (akses I2C diserialisasi antar task) ---
+DateTime rtcNow() {
+    xSemaphoreTake(rtcMutex, portMAX_DELAY);
+    DateTime now = rtc.now();
+    xSemaphoreGive(rtcMutex);
+    return now;
+}
+
+void rtcAdjust(const DateTime& time) {
+    xSemaphoreTake(rtcMutex, portMAX_DELAY);
+    rtc.adjust(time);
+    xSemaphoreGive(rtcMutex);
 }
 
+// Waktu dinding (epoch lokal) untuk hot path: tanpa I2C, tidak pernah mundur
+// kecuali saat jam di-step (diikuti muat ulang jadwal)
+uint32_t timeNow() {
+    portENTER_CRITICAL(&timeMux);
+    uint32_t now = timeService.now(esp_timer_get_time());
+    portEXIT_CRITICAL(&timeMux);
+    return now;
+}
+
+// Semua fungsi di bawah dipanggil dengan configMutex dipegang (kecuali saat boot)
 void saveConfig() {
-    EEPROM.put(0, config);
+    if (configLogReady) {
+        if (!configLog.append(LOG_CONFIG_SNAPSHOT, &config, sizeof(config))) {
+            LOG_W("⚠️ Gagal menulis snapshot config ke log flash.");
+        }
+        return;
+    }
+    EEPROM.put(0, config); // Fallback: partisi log tidak ada
     EEPROM.commit();
 }
 
+void addWateringHistory(const WateringEvent& event) {
+    if (wateringHistoryCount == WATERING_HISTORY_SIZE) {
+        memmove(wateringHistory, wateringHistory + 1, sizeof(WateringEvent) * (WATERING_HISTORY_SIZE - 1));
+        wateringHistoryCount--;
+    }
+    wateringHistory[wateringHistoryCount++] = event;
+    if (event.source == WATERING_SCHEDULED) config.wateringCount++;
+}
+
+// Catat satu penyiraman: satu record 16 byte, tanpa erase sektor.
+// Append sebelum wateringCount naik: jika append pindah sektor, snapshot
+// rollover belum memuat event ini sehingga replay tidak menghitungnya dua kali.
+void recordWatering(const WateringEvent& event) {
+    xSemaphoreTake(configMutex, portMAX_DELAY);
+    if (configLogReady) configLog.append(LOG_WATERING, &event, sizeof(event));
+    addWateringHistory(event);
+    if (!configLogReady && event.source == WATERING_SCHEDULED) saveConfig();
+    xSemaphoreGive(configMutex);
+}
+
+// Sektor log baru: tulis state lengkap dulu agar sektor tertua aman di-erase
+void onConfigLogRollover(LogStore& store, void* ctx) {
+    store.append(LOG_CONFIG_SNAPSHOT, &config, sizeof(config));
+}
+
+void onConfigLogRecord(uint8_t type, const uint8_t* payload, size_t length, void* ctx) {
+    bool* hasSnapshot = (bool*)ctx;
+    if (type == LOG_CONFIG_SNAPSHOT && length == sizeof(Config)) {
+        Config snapshot;
+        memcpy(&snapshot, payload, sizeof(snapshot));
+        if (snapshot.magicNumber != MAGIC_NUMBER) return;
+        config = snapshot;
+        *hasSnapshot = true;
+    } else if (type == LOG_WATERING && length == sizeof(WateringEvent)) {
+        WateringEvent event;
+        memcpy(&event, payload, sizeof(event));
+        addWateringHistory(event);
+    }
+}
+
 void loadConfig() {
+    bool hasSnapshot = false;
+    configLogReady = configFlash.begin(CONFIG_LOG_PARTITION);
+    
+    if (configLogReady) {
+        unsigned long start = micros();
+        configLog.begin();
+        configLog.onRollover(onConfigLogRollover, nullptr);
+        configLog.replay(onConfigLogRecord, &hasSnapshot);
+        
+        const LogStoreStats& stats = configLog.stats();
+        LOG_I("💾 Log config: %u record dibaca (%u rusak) dalam %lu us, sektor %u/%u, rotasi #%u\n",
+                      stats.replayed, stats.corrupt, micros() - start,
+                      configLog.activeSector() + 1, configLog.sectorCount(), stats.sequence);
+    } else {
+        LOG_W("⚠️ Partisi log '" CONFIG_LOG_PARTITION "' tidak ada, config disimpan di EEPROM.");
+    }
+    
+    if (hasSnapshot) {
+        LOG_I("✅ Konfigurasi loaded dari log flash");
+        return;
+    }
+    
+    // Log kosong: migrasi config EEPROM (jika layout cocok) atau default
     EEPROM.get(0, config);
     
     if (config.magicNumber != MAGIC_NUMBER) {
-        Serial.println("⚙️  Inisialisasi konfigurasi default...");
+        LOG_I("⚙️  Inisialisasi konfigurasi default...");
         
-        config.schedules[0] = {6, 0, true};  
-        config.schedules[1] = {18, 0, true}; 
-        config.schedules[2] = {12, 0, false}; 
-        config.duration = 30; 
+        config.schedules[0] = {6 * 60, 30, WEEKDAYS_ALL, 0, true, 0};  
+        config.schedules[1] = {18 * 60, 30, WEEKDAYS_ALL, 0, true, 0}; 
+        config.schedules[2] = {12 * 60, 30, WEEKDAYS_ALL, 0, false, 0}; 
+        config.scheduleCount = 3;
         config.wateringCount = 0;
         config.magicNumber = MAGIC_NUMBER;
-        
-        saveConfig();
     } else {
-        Serial.println("✅ Konfigurasi loaded dari EEPROM");
+        LOG_I("✅ Konfigurasi loaded dari EEPROM");
+    }
+    
+    saveConfig();
+}
+
+// Serial 'H': riwayat penyiraman terakhir dari log flash
+void printWateringHistory() {
+    xSemaphoreTake(configMutex, portMAX_DELAY);
+    Serial.printf("\n📜 RIWAYAT PENYIRAMAN (%u terakhir, total terjadwal %d):\n",
+                  wateringHistoryCount, config.wateringCount);
+    for (size_t i = 0; i < wateringHistoryCount; i++) {
+        const WateringEvent& e = wateringHistory[i];
+        DateTime at(e.at);
+        Serial.printf("    %02d/%02d/%04d %02d:%02d  zona %d  %s  %u detik\n",
+                      at.day(), at.month(), at.year(), at.hour(), at.minute(),
+                      e.zone + 1, e.source == WATERING_MANUAL ? "manual" : "jadwal",
+                      e.durationSec);
     }
+    xSemaphoreGive(configMutex);
 }
 
 // --- FUNGSI VALVE ---
-void closeValve(); 
-
-void openValve() {
-    if (!valveOpen) {
-        digitalWrite(RELAY_PIN, HIGH); 
-        digitalWrite(LED_PIN, HIGH); 
-        valveOpen = true;
-        isWatering = true;
-        valveOpenTime = millis();
-        
-        DateTime now = rtc.now();
-        Serial.printf("[%02d:%02d:%02d] 💧 VALVE DIBUKA\n", 
-                        now.hour(), now.minute(), now.second());
+// Relay hanya disentuh lewat `valves` di valveTask. Auto-close & urutan zona
+// ditangani ValveBank::update(), dipanggil dari loop valveTask. Satu-satunya
+// pengecualian: timer pengaman memutus output lewat guardedOutput.cut().
+void onZoneChange(uint8_t zone, bool open, unsigned long openMs, bool manual);
+
+const ValveBankConfig VALVE_BANK_CONFIG = {VALVE_MAX_CONCURRENT, VALVE_STAGGER_MS};
+SpinlockValveOutput guardedOutput(valveOutput);
+ValveBank<VALVE_ZONES> valves(guardedOutput, VALVE_BANK_CONFIG, onZoneChange);
+
+void onZoneChange(uint8_t zone, bool open, unsigned long openMs, bool manual) {
+    digitalWrite(LED_PIN, valves.anyOpen() ? HIGH : LOW);
+
+    long safetyLatencyMs = -1;
+    portENTER_CRITICAL(&safetyMux);
+    if (open) safety.opened(zone, manual, millis());
+    else safetyLatencyMs = safety.closed(zone, millis());
+    portEXIT_CRITICAL(&safetyMux);
+    if (safetyLatencyMs >= 0) safetyCloseLatency.observe(safetyLatencyMs);
+    
+    DateTime now(timeNow());
+    if (open) {
+        traceEvent(TRACE_VALVE_OPEN, zone, manual);
+        LOG_I("[%02d:%02d:%02d] 💧 ZONA %d DIBUKA (%s)\n", 
+                        now.hour(), now.minute(), now.second(), zone + 1,
+                        manual ? "manual" : "jadwal");
+    } else {
+        unsigned long duration = openMs / 1000;
+        wateredSecondsTotal += duration;
+        (manual ? valveOpenManual : valveOpenScheduled).observe(duration);
+        traceEvent(TRACE_VALVE_CLOSE, zone, duration);
+        LOG_I("[%02d:%02d:%02d] 🔒 ZONA %d DITUTUP - Durasi: %lu detik\n", 
+                        now.hour(), now.minute(), now.second(), zone + 1, duration);
     }
 }
 
-void closeValve() {
-    if (valveOpen) {
-        digitalWrite(RELAY_PIN, LOW); 
-        digitalWrite(LED_PIN, LOW); 
-        
-        unsigned long duration = (millis() - valveOpenTime) / 1000;
-        
-        valveOpen = false;
-        isWatering = false;
-        manualMode = false; 
-        
-        DateTime now = rtc.now();
-        Serial.printf("[%02d:%02d:%02d] 🔒 VALVE DITUTUP - Durasi: %lu detik\n", 
-                        now.hour(), now.minute(), now.second(), duration);
+// Timer pengaman (task esp_timer, tiap SAFETY_TICK_MS). Tidak blocking dan
+// tidak menunggu task lain: perintah tutup lewat valveQueue tanpa timeout,
+// pemutusan langsung lewat guardedOutput.
+void safetyTick(void* arg) {
+    unsigned long now = millis();
+#ifdef FLOW_SENSOR_PIN
+    static unsigned long flowAt = 0;
+    if (now - flowAt >= 1000) {
+        uint32_t pulses = __atomic_exchange_n(&flowPulses, 0, __ATOMIC_RELAXED);
+        float lpm = pulses / FLOW_PULSES_PER_LITER * 60000.0f / (now - flowAt);
+        flowAt = now;
+        portENTER_CRITICAL(&safetyMux);
+        safety.reportFlow(lpm, now);
+        portEXIT_CRITICAL(&safetyMux);
+    }
+#endif
+#ifdef VALVE_CURRENT_PIN
+    float ma = analogReadMilliVolts(VALVE_CURRENT_PIN) * VALVE_CURRENT_MA_PER_MV;
+#endif
+
+    portENTER_CRITICAL(&safetyMux);
+#ifdef VALVE_CURRENT_PIN
+    safety.reportCurrent(ma, now);
+#endif
+    ValveSafetyAction action = safety.check(now);
+    ValveFault faults[VALVE_ZONES];
+    for (uint8_t z = 0; z < VALVE_ZONES; z++) faults[z] = safety.fault(z);
+    portEXIT_CRITICAL(&safetyMux);
+
+    if (action.cut) guardedOutput.cut(action.cut);
+    if (action.alarm != VALVE_FAULT_NONE) traceEvent(TRACE_SAFETY_ALARM, action.alarm);
+    for (uint8_t z = 0; z < VALVE_ZONES; z++) {
+        uint32_t bit = 1UL << z;
+        if (action.cut & bit) traceEvent(TRACE_SAFETY_CUT, z, faults[z]);
+        if (!(action.close & bit)) continue;
+        traceEvent(TRACE_SAFETY_CLOSE, z, faults[z]);
+        ValveCommand cmd;
+        cmd.type = VALVE_CMD_SAFETY_CLOSE;
+        cmd.issuedAt = now;
+        cmd.value = faults[z];
+        cmd.zone = z;
+        xQueueSend(valveQueue, &cmd, 0); // Queue penuh: pemutusan setelah graceMs tetap berlaku
     }
 }
 
+#ifdef FLOW_SENSOR_PIN
+void IRAM_ATTR onFlowPulse() {
+    flowPulses++;
+}
+#endif
+
+// Kontak sukses dengan server (stream SSE hidup atau response polling)
+void safetyLinkOk() {
+    portENTER_CRITICAL(&safetyMux);
+    safety.linkOk(millis());
+    portEXIT_CRITICAL(&safetyMux);
+}
+
+void setupSafety() {
+    portENTER_CRITICAL(&safetyMux);
+    safety.begin(millis());
+    portEXIT_CRITICAL(&safetyMux);
+#ifdef FLOW_SENSOR_PIN
+    pinMode(FLOW_SENSOR_PIN, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(FLOW_SENSOR_PIN), onFlowPulse, FALLING);
+#endif
+#ifdef VALVE_CURRENT_PIN
+    analogSetPinAttenuation(VALVE_CURRENT_PIN, ADC_11db);
+#endif
+    esp_task_wdt_init(VALVE_WDT_TIMEOUT_S, true); // Panic = reset; semua GPIO relay kembali mati
+
+    esp_timer_create_args_t args = {};
+    args.callback = safetyTick;
+    args.name = "safety";
+    esp_timer_create(&args, &safetyTimer);
+    esp_timer_start_periodic(safetyTimer, SAFETY_TICK_MS * 1000ULL);
+    LOG_I("🛡️  Pengaman valve: maks. %lu menit (manual %lu menit), failsafe link %lu detik.",
+          VALVE_MAX_OPEN_MS / 60000, VALVE_MANUAL_MAX_MS / 60000, SAFETY_CONFIG.linkLossMs / 1000);
+}
+
 // --- FUNGSI JADWAL & TIME SYNC ---
-void coreRTCSyncLogic() {
-    struct tm timeinfo;
+// Klien SNTP lwIP berjalan di latar (configTime); tidak ada getLocalTime()
+// yang menunggu. Callback dipanggil dari task lwIP saat jam sistem diset:
+// waktu NTP dipasangkan dengan esp_timer saat itu, lalu diteruskan ke networkTask.
+struct NtpSample {
+    int64_t epochUs;    // Epoch lokal (UTC + zona waktu), basis yang sama dengan RTC
+    int64_t monoUs;     // esp_timer_get_time() saat sampel diambil
+};
+
+void onNtpTimeSync(struct timeval* tv) {
+    NtpSample sample;
+    sample.epochUs = ((int64_t)tv->tv_sec + gmtOffset_sec + daylightOffset_sec) * 1000000LL + tv->tv_usec;
+    sample.monoUs = esp_timer_get_time();
+    xQueueOverwrite(ntpQueue, &sample);
+}
+
+void requestScheduleReload();
+
+void applyTimeResult(TimeService::Result result) {
+    if (result == TimeService::STEPPED) requestScheduleReload(); // Event berikutnya dihitung ulang dari waktu baru
+}
+
+// Job networkTask: terapkan sampel NTP terbaru (slew/step + estimasi
+// frekuensi), lalu bandingkan dengan DS3231 (satu baca I2C per sync). RTC
+// hanya ditulis ulang jika selisihnya >= 2 detik.
+void applyNtpSample() {
+    NtpSample sample;
+    if (xQueueReceive(ntpQueue, &sample, 0) != pdTRUE) return;
+
+    portENTER_CRITICAL(&timeMux);
+    TimeService::Result result = timeService.ntpSample(sample.epochUs, sample.monoUs);
+    portEXIT_CRITICAL(&timeMux);
+    applyTimeResult(result);
+
+    uint32_t rtcEpoch = rtcNow().unixtime();
+    portENTER_CRITICAL(&timeMux);
+    bool rewrite = timeService.rtcCheck(rtcEpoch, esp_timer_get_time());
+    int64_t referenceUs = timeService.referenceUs(esp_timer_get_time());
+    TimeService::Stats stats = timeService.stats();
+    portEXIT_CRITICAL(&timeMux);
+    if (rewrite) rtcAdjust(DateTime((uint32_t)((referenceUs + 500000) / 1000000)));
+
+    int32_t drift = stats.rtcOffsetMs / 1000; // Positif = RTC lebih cepat
+    ntpSyncs.inc();
+    ntpDriftSeconds.set(drift);
+    ntpDriftAbs.observe(drift < 0 ? -drift : drift);
+    traceEvent(TRACE_NTP_SYNC, result, stats.lastOffsetMs);
+
+    DateTime now(timeNow());
+    LOG_I("✅ NTP %04d-%02d-%02d %02d:%02d:%02d: offset %ld ms (%s), frekuensi %+ld ppb, RTC %+ld ms%s\n",
+          now.year(), now.month(), now.day(), now.hour(), now.minute(), now.second(),
+          (long)stats.lastOffsetMs, result == TimeService::STEPPED ? "step" : "slew", (long)stats.freqPpb,
+          (long)stats.rtcOffsetMs, rewrite ? " -> RTC ditulis ulang" : "");
+}
+
+// Job networkTask tiap 15 menit: tanpa sampel NTP selama NTP_STALE_MS (WiFi
+// atau server NTP mati), jam didisiplinkan dari DS3231 (dikoreksi estimasi drift).
+void checkTimeSources() {
+    int64_t mono = esp_timer_get_time();
+    portENTER_CRITICAL(&timeMux);
+    bool synced = timeService.ntpSynced();
+    int64_t sinceNtpMs = (mono - (int64_t)timeService.lastNtpMono()) / 1000;
+    portEXIT_CRITICAL(&timeMux);
+    if (synced && sinceNtpMs <= (int64_t)NTP_STALE_MS) return;
+
+    if (wifi.connected()) {
+        ntpFailures.inc();
+        traceEvent(TRACE_NTP_FAILED);
+        LOG_W("⚠️ Belum ada sampel NTP %s. Periksa server NTP.", synced ? "dalam 1 jam terakhir" : "sejak boot");
+    }
+
+    uint32_t rtcEpoch = rtcNow().unixtime();
+    portENTER_CRITICAL(&timeMux);
+    TimeService::Result result = timeService.rtcSample(rtcEpoch, esp_timer_get_time());
+    int32_t offsetMs = timeService.stats().lastOffsetMs;
+    portEXIT_CRITICAL(&timeMux);
+    applyTimeResult(result);
+    if (result != TimeService::IGNORED) {
+        LOG_I("🕒 Jam dikoreksi dari RTC: offset %ld ms (%s)", (long)offsetMs,
+              result == TimeService::STEPPED ? "step" : "slew");
+    }
+}
+
+void checkSchedule();
+
+// Jadwalkan checkSchedule berikutnya: tepat saat event berikutnya jatuh tempo
+// (dibatasi SCHEDULE_MAX_SLEEP_MS agar koreksi jam tetap terkejar).
+void armScheduleCheck(uint32_t now) {
+    valveTimer.cancel(scheduleJob);
+    scheduleJob = valveTimer.after(scheduleTable.sleepMs(now, SCHEDULE_MAX_SLEEP_MS), checkSchedule);
+}
+
+void runScheduledWatering(const ScheduleTable<MAX_SCHEDULES>::Event& event, uint32_t now) {
+    const ScheduleEntry& entry = scheduleTable.entry(event.index);
+    ScheduledRun run = startScheduledRun(entry, &moisture, MOISTURE_ZONES, valves, millis());
+    const MoistureController::Plan& plan = run.plan;
     
-    if (getLocalTime(&timeinfo, 5000)) { 
-        time_t now = mktime(&timeinfo); 
-        rtc.adjust(DateTime(now)); 
-        
-        DateTime newTime = rtc.now();
-        Serial.printf("✅ Waktu RTC diupdate dari NTP: %04d-%02d-%02d %02d:%02d:%02d\n", 
-                        newTime.year(), newTime.month(), newTime.day(),
-                        newTime.hour(), newTime.minute(), newTime.second());
-        
-        lastRTCSync = millis();
+    if (plan.action == MoistureController::SKIP) {
+        LOG_I("🌧️ JADWAL #%d dilewati: tanah masih basah (%.0f%%)\n", event.index+1, plan.moisture);
+        return;
+    }
+
+    if (!run.started) {
+        LOG_W("⚠️ JADWAL #%d dilewati: zona %d tidak ada atau masih aktif\n",
+                      event.index+1, entry.zone + 1);
+        return;
+    }
+
+    recordWatering(wateringEvent(entry, run, now));
+    
+    LOG_I("⏰ JADWAL #%d AKTIF (%02d:%02d, zona %d%s, terlambat %lu detik)\n", 
+                  event.index+1, entry.minuteOfDay / 60, entry.minuteOfDay % 60,
+                  entry.zone + 1, valves.isQueued(entry.zone) ? " antri" : "",
+                  (unsigned long)(now - event.at));
+    if (plan.action == MoistureController::RUN) {
+        LOG_I("🌱 Tanah %.0f%% -> durasi %lu detik (dasar %d detik)\n",
+                      plan.moisture, plan.durationSec, entry.durationSec);
+    }
+}
+
+// Job valveTask: serahkan event jadwal yang jatuh tempo ke sequencer zona lalu
+// tidur sampai event berikutnya. Hanya tunggu batas pompa/stagger yang diantri
+// ValveBank; event untuk zona yang masih terbuka/antri dilewati (log ⚠️).
+void checkSchedule() {
+    scheduleJob = 0;
+    uint32_t now = timeNow();
+
+    ScheduleTable<MAX_SCHEDULES>::Event event;
+    while (scheduleTable.poll(now, event)) runScheduledWatering(event, now);
+    armScheduleCheck(now);
+}
+
+// Muat ulang tabel dari config (valveTask)
+void reloadSchedules() {
+    Config cfg = readConfig();
+    uint32_t now = timeNow();
+    scheduleTable.load(cfg.schedules, cfg.scheduleCount, now);
+    armScheduleCheck(now);
+
+    if (scheduleTable.hasNext()) {
+        DateTime next(scheduleTable.next().at);
+        LOG_I("📅 Jadwal berikutnya: #%d pada %02d/%02d %02d:%02d\n",
+                      scheduleTable.next().index + 1, next.day(), next.month(),
+                      next.hour(), next.minute());
     } else {
-        Serial.println("⚠️ Gagal mendapatkan waktu dari server NTP. Periksa koneksi WiFi.");
+        LOG_I("📅 Tidak ada jadwal aktif.");
     }
 }
 
-void syncRTCFromNTP() {
-    if (lastRTCSync == 0 || millis() - lastRTCSync > 900000L) { 
-        Serial.println("🔄 Memulai sinkronisasi RTC (Otomatis 15m interval)...");
-        coreRTCSyncLogic();
+void requestScheduleReload() {
+    ValveCommand cmd;
+    cmd.type = VALVE_CMD_RELOAD_SCHEDULES;
+    cmd.issuedAt = millis();
+    if (xQueueSend(valveQueue, &cmd, 0) != pdTRUE) {
+        LOG_W("⚠️ Antrian perintah valve penuh, reload jadwal dibuang.");
     }
 }
 
-void checkSchedule() {
-    if (manualMode || isWatering) return;
-    
-    DateTime now = rtc.now();
-    
-    for (int i = 0; i < 3; i++) {
-        if (!config.schedules[i].enabled) continue;
-        
-        bool matchSchedule = (now.hour() == config.schedules[i].hour && 
-                              now.minute() == config.schedules[i].minute && 
-                              now.second() == 0);
-        
-        if (matchSchedule && !lastScheduleCheck[i]) {
-            openValve();
-            config.wateringCount++;
-            saveConfig();
-            
-            Serial.printf("⏰ JADWAL #%d AKTIF (%02d:%02d)\n", 
-                          i+1, config.schedules[i].hour, config.schedules[i].minute);
-        }
-        
-        lastScheduleCheck[i] = matchSchedule;
+// LED heartbeat (berkedip pelan saat idle) - Non-aktifkan saat menyiram
+void heartbeatLED() {
+    if (!valves.anyOpen()) {
+        digitalWrite(LED_PIN, !digitalRead(LED_PIN)); 
+    }
+}
+
+// Statistik networkTask (iterasi & persen tidur) dan batas jitter valveTask
+#if ENABLE_PROFILING
+// Probe jaringan diisi networkTask, probe valve diisi valveTask
+ProfileProbe profileNetTimer("netTimer.run");
+ProfileProbe profileRemoteStatus("checkRemoteStatus");
+ProfileProbe profileScheduleSync("syncSchedulesFromAPI");
+ProfileProbe profileMoistureFetch("fetchMoisture");
+ProfileProbe profileValveTimer("valveTimer.run");
+
+// Satu baris JSON per probe + satu baris heap/stack; ambil dengan
+// `grep '^PROFILE '` dari log serial untuk dibandingkan antar versi firmware.
+void printProfile() {
+    char line[256];
+    const ProfileProbe* probes[] = {&profileNetTimer, &profileRemoteStatus, &profileScheduleSync,
+                                    &profileMoistureFetch, &profileValveTimer};
+    for (const ProfileProbe* probe : probes) {
+        probe->formatJson(line, sizeof(line), "us");
+        LOG_I("PROFILE %s\n", line);
     }
+    LOG_I("PROFILE {\"heap_free\":%u,\"heap_min\":%u,\"heap_max_block\":%u,"
+                  "\"stack_free_network\":%u,\"stack_free_valve\":%u}\n",
+                  ESP.getFreeHeap(), ESP.getMinFreeHeap(), ESP.getMaxAllocHeap(),
+                  (unsigned)uxTaskGetStackHighWaterMark(netTaskHandle),
+                  (unsigned)uxTaskGetStackHighWaterMark(valveTaskHandle));
+}
+#endif
+
+void reportLoopStats() {
+    static unsigned long lastReport = 0;
+    unsigned long elapsed = millis() - lastReport;
+    LOG_I("🔁 Net task: %lu iterasi, idle %lu%% | Valve: jitter auto-close maks %lu ms, perintah->relay maks %lu ms\n",
+                  loopIterations, elapsed ? loopSleepMs * 100UL / elapsed : 0UL,
+                  valves.maxCloseLateMs(), commandLatencyMaxMs);
+    if (configLogReady) {
+        const LogStoreStats& log = configLog.stats();
+        LOG_I("💾 Log config: %u record / %u byte ditulis, %u erase sejak boot\n",
+                      log.appends, log.bytesWritten, log.erases);
+    }
+    LOG_I("🌱 Soil: %s | Total air: %lu detik valve terbuka\n",
+                  moisture.hasReading() ? String(moisture.moisture(), 0).c_str() : "-",
+                  wateredSecondsTotal);
+#if ENABLE_PROFILING
+    printProfile();
+#endif
+    loopIterations = 0;
+    loopSleepMs = 0;
+    lastReport = millis();
 }
 
 // Fungsi set waktu manual (serial monitor)
@@ -275,7 +1108,11 @@ void setRTCFromSerial() {
         newHour >= 0 && newHour <= 23 && newMinute >= 0 && newMinute <= 59) {
         
         DateTime newTime(newYear, newMonth, newDay, newHour, newMinute, 0);
-        rtc.adjust(newTime);
+        rtcAdjust(newTime);
+        portENTER_CRITICAL(&timeMux);
+        timeService.set(newTime.unixtime(), esp_timer_get_time());
+        portEXIT_CRITICAL(&timeMux);
+        requestScheduleReload(); // Event berikutnya dihitung ulang dari waktu baru
         
         Serial.printf("✅ RTC berhasil disetel ke: %02d/%02d/%04d %02d:%02d\n", 
                          newDay, newMonth, newYear, newHour, newMinute);
@@ -286,240 +1123,494 @@ void setRTCFromSerial() {
 
 // --- FUNGSI KOMUNIKASI API LOKAL ---
 
-void connectWiFi() {
-    Serial.print("📡 Menghubungkan ke WiFi ");
-    Serial.println(ssid);
-    WiFi.begin(ssid, pass);
-    
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-        delay(500);
-        Serial.print(".");
-        attempts++;
-    }
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.println("\n✅ WiFi Terhubung!");
-        Serial.print("Alamat IP ESP32: ");
-        Serial.println(WiFi.localIP());
+// Perubahan status WiFi dari WifiManager (dipanggil di networkTask lewat
+// wifi.update()). Koneksi dibuat ulang di latar; job jaringan cukup memeriksa
+// wifi.connected() dan melewati gilirannya saat putus.
+void onWifiEvent(WifiStateMachine::Event event, unsigned long value, void* ctx) {
+    if (event == WifiStateMachine::CONNECTED_EVENT) {
+        wifiReconnects.inc();
+        wifiConnected.set(1);
+        traceEvent(TRACE_WIFI_CONNECTED, 0, value);
+        LOG_I("✅ WiFi Terhubung! Alamat IP ESP32: %s (putus %lu ms)", WiFi.localIP().toString().c_str(), value);
+        LOG_I("📈 Metrics: http://%s:%d/metrics & /trace", WiFi.localIP().toString().c_str(), METRICS_PORT);
+        if (!localLink.listen()) LOG_W("⚠️ Gagal join grup multicast link lokal.");
+    } else if (event == WifiStateMachine::DISCONNECTED_EVENT) {
+        wifiConnected.set(0);
+        localLink.stop();
+        statusStream.drop();
+        api.reset();
+        traceEvent(TRACE_WIFI_LOST);
+        LOG_W("⚠️ WiFi terputus, menghubungkan ulang di latar...");
     } else {
-        Serial.println("\n❌ Gagal terhubung ke WiFi.");
+        wifiConnectFailures.inc();
+        traceEvent(TRACE_WIFI_FAILED, 0, value);
+        LOG_E("❌ Gagal terhubung ke WiFi %s, coba lagi dalam %lu ms.", ssid, value);
+    }
+}
+
+// Job valveTask setelah VALVE_CMD_RESTART: penyiraman yang sedang berjalan
+// diselesaikan dulu, restart hanya saat semua zona tertutup
+void restartWhenIdle() {
+    if (valves.anyOpen() || valves.queuedCount() > 0) return;
+    LOG_I("🔄 Restart ke firmware baru...");
+    delay(200); // Beri waktu log terakhir keluar
+    ESP.restart();
+}
+
+// Tutup zona atas permintaan timer pengaman (valveTask). Zona manual dikunci
+// sampai server mengirim OFF: status di server masih "ON", jadi polling
+// berikutnya akan membukanya lagi.
+void safetyCloseZone(uint8_t zone) {
+    if (!valves.isOpen(zone)) return;
+    portENTER_CRITICAL(&safetyMux);
+    ValveFault fault = safety.fault(zone);
+    portEXIT_CRITICAL(&safetyMux);
+    bool cut = guardedOutput.cutZones() & (1UL << zone);
+    bool manual = valves.isManual(zone);
+    if (manual) safetyLatchedZones |= 1UL << zone;
+
+    valves.close(zone, millis());
+    LOG_W("🛡️  Pengaman: ZONA %d DITUTUP (%s)%s%s.", zone + 1, valveFaultName(fault),
+          cut ? ", output sudah diputus timer" : "", manual ? ", remote ON diabaikan sampai OFF" : "");
+}
+
+// Eksekusi perintah remote di valveTask (satu-satunya task yang menyentuh relay)
+void handleValveCommand(const ValveCommand& cmd) {
+    if (cmd.type == VALVE_CMD_REMOTE_ON) {
+        if (safetyLatchedZones & (1UL << cmd.zone)) return; // Ditutup pengaman, tunggu OFF
+        if (valves.request(cmd.zone, 0, true, millis())) {
+            LOG_I("👤 Kontrol Remote: ZONA %d DIBUKA dari Laravel%s.\n", cmd.zone + 1,
+                          valves.isQueued(cmd.zone) ? " (antri, batas pompa)" : "");
+            recordWatering({timeNow(), 0, cmd.zone, WATERING_MANUAL});
+        }
+    } else if (cmd.type == VALVE_CMD_REMOTE_OFF) {
+        safetyLatchedZones &= ~(1UL << cmd.zone);
+        if (valves.isManual(cmd.zone) && valves.close(cmd.zone, millis())) {
+            LOG_I("👤 Kontrol Remote: ZONA %d DITUTUP dari Laravel.\n", cmd.zone + 1);
+        }
+    } else if (cmd.type == VALVE_CMD_MOISTURE) {
+        // Cutoff closed-loop: hentikan penyiraman terjadwal jika tanah sudah basah
+        if (applyMoisture(moisture, valves, MOISTURE_ZONES, cmd.value, cmd.issuedAt, millis()) > 0) {
+            LOG_I("🌱 Tanah sudah %.0f%%, penyiraman dihentikan lebih awal.\n", moisture.moisture());
+        }
+        return;
+    } else if (cmd.type == VALVE_CMD_RELOAD_SCHEDULES) {
+        reloadSchedules();
+        return;
+    } else if (cmd.type == VALVE_CMD_RESTART) {
+        if (valves.anyOpen()) LOG_I("⏳ Restart firmware menunggu penyiraman selesai.");
+        valveTimer.every(1000L, restartWhenIdle);
+        return;
+    } else if (cmd.type == VALVE_CMD_SAFETY_CLOSE) {
+        safetyCloseZone(cmd.zone);
+        return;
+    }
+
+    unsigned long latencyMs = millis() - cmd.issuedAt;
+    if (latencyMs > commandLatencyMaxMs) commandLatencyMaxMs = latencyMs;
+}
+
+// Teruskan valve_status dari Laravel (stream SSE / polling) ke valveTask.
+// zone mulai 1 (default 1 untuk server lama tanpa field "zone").
+void applyRemoteValveStatus(const RemoteValveStatus& status) {
+    int zone = status.zone;
+    if (zone < 1 || zone > VALVE_ZONES) return;
+
+    ValveCommand cmd;
+    cmd.type = status.on ? VALVE_CMD_REMOTE_ON : VALVE_CMD_REMOTE_OFF;
+    cmd.issuedAt = millis();
+    cmd.zone = zone - 1;
+
+    if (xQueueSend(valveQueue, &cmd, 0) != pdTRUE) {
+        LOG_W("⚠️ Antrian perintah valve penuh, perintah dibuang.");
     }
 }
 
+// Handler event SSE: payload sama dengan response /api/water-status
+void onValveStatusEvent(const char* data) {
+    RemoteValveStatus status;
+    if (parseValveStatus(data, status)) applyRemoteValveStatus(status);
+}
+
 // 📌 FUNGSI UTAMA: CEK STATUS VALVE DARI LARAVEL
+// Saat stream SSE aktif, perintah datang lewat push sehingga polling dilewati.
+// Polling hanya berjalan sebagai fallback selama stream putus.
 void checkRemoteStatus() {
-    if (WiFi.status() != WL_CONNECTED) {
-        connectWiFi(); 
-        if (WiFi.status() != WL_CONNECTED) return;
+    PROFILE_SCOPE_HEAP(profileRemoteStatus, micros, esp_get_free_heap_size);
+
+    if (!wifi.connected()) return; // Stream & koneksi API sudah ditutup di onWifiEvent
+
+    if (statusStream.connected()) { // Ping SSE terakhir < 30 detik
+        safetyLinkOk();
+        return;
     }
+    statusStream.connect();
 
-    HTTPClient http;
-    String serverPath = "http://" + String(apiHost) + ":" + String(apiPort) + String(apiEndpoint);
-    
-    http.begin(serverPath.c_str());
-    int httpResponseCode = http.GET();
-    
-    if (httpResponseCode > 0) {
-        String payload = http.getString();
+    // Di-parse langsung dari stream HTTP, field lain dibuang oleh filter
+    // (RemoteApi.h, jalur yang sama diukur di --bench). Error: silent fail
+    // untuk menghindari spam.
+    ValveStatusPoll poll = pollValveStatus(api, apiEndpoint);
+    if (poll.code > 0) safetyLinkOk();
+    if (poll.parsed) applyRemoteValveStatus(poll.status);
+}
 
-        // Response dari Laravel SensorController:
-        // {"id":1,"valve_status":"ON","duration":30,"created_at":"...","updated_at":"..."}
-        StaticJsonDocument<300> doc; 
-        DeserializationError error = deserializeJson(doc, payload);
+// Ambil bacaan soil terbaru (dikirim sensor node ke Laravel) dan teruskan ke
+// valveTask. Response: {"soil":42,"age_seconds":12,...}; field lain dibuang.
+// Fallback saja: dilewati selama link lokal menerima frame dari sensor node.
+void fetchMoisture() {
+    if (!wifi.connected()) return;
+    if (localLink.receiver().fresh(millis(), LOCAL_LINK_FRESH_MS)) return;
+    PROFILE_SCOPE_HEAP(profileMoistureFetch, micros, esp_get_free_heap_size);
 
-        if (error) {
-            http.end();
-            return;
-        }
+    int httpResponseCode = api.get(apiMoistureEndpoint);
+    if (httpResponseCode != HTTP_CODE_OK) {
+        api.end();
+        return;
+    }
 
-        // ⚠️ PENTING: Parse field "valve_status" (bukan "status")
-        const char* status = doc["valve_status"] | ""; 
-
-        if (strcmp(status, "ON") == 0) {
-            if (!isWatering) {
-                manualMode = true; 
-                openValve();
-                Serial.println("👤 Kontrol Remote: VALVE DIBUKA dari Laravel.");
-            }
-        } else if (strcmp(status, "OFF") == 0) {
-            if (isWatering && manualMode) {
-                closeValve();
-                Serial.println("👤 Kontrol Remote: VALVE DITUTUP dari Laravel.");
-            }
-        } 
+    RemoteMoisture reading;
+    bool parsed = parseMoisture(api.bodyStream(), reading);
+    api.end();
+    if (!parsed) return;
 
-    } else {
-        // Silent fail untuk menghindari spam
+    // Umur bacaan di server dikurangkan agar kesegaran dihitung dari waktu sampling
+    ValveCommand cmd;
+    cmd.type = VALVE_CMD_MOISTURE;
+    cmd.issuedAt = millis() - reading.ageSeconds * 1000UL;
+    cmd.value = reading.soil;
+
+    if (xQueueSend(valveQueue, &cmd, 0) != pdTRUE) {
+        LOG_W("⚠️ Antrian perintah valve penuh, bacaan soil dibuang.");
     }
-    
-    http.end();
+}
+
+// Frame dari sensor node (UDP multicast) langsung ke valveTask, tanpa server.
+// Dipanggil tiap iterasi networkTask (maks. 20 ms setelah frame masuk).
+void pollLocalLink() {
+    static bool sourceLogged = false;
+    TelemetryRecord record;
+    while (localLink.poll(millis(), record)) {
+        if (!sourceLogged) {
+            char source[NODE_ID_SIZE];
+            nodeIdFromMac(localLink.receiver().source(), source);
+            LOG_I("🔗 Link lokal: menerima sensor node %s", source);
+            sourceLogged = true;
+        }
+        ValveCommand cmd;
+        cmd.type = VALVE_CMD_MOISTURE;
+        cmd.issuedAt = millis(); // Sensor mengirim tepat setelah sampling
+        cmd.value = record.soil;
+        if (xQueueSend(valveQueue, &cmd, 0) != pdTRUE) {
+            LOG_W("⚠️ Antrian perintah valve penuh, bacaan soil dibuang.");
+        }
+        LOG_D("📡 Link lokal: soil %u%%, T %.1f, H %.1f\n", record.soil, record.tempX10 / 10.0,
+                      record.humidX10 / 10.0);
+    }
+}
+
+void logScheduleEntry(int number, const ScheduleFields& fields, bool) {
+    LOG_I("   Jadwal %d: %s %s (%s) - %d menit, zona %d, hari 0x%02X\n",
+                 number, fields.scheduleType, fields.scheduleTime, 
+                 fields.active ? "AKTIF" : "NONAKTIF", fields.durationMinutes, fields.zone, fields.weekdays);
 }
 
 // 📌 FUNGSI BARU: SINKRONISASI JADWAL DARI API LARAVEL
-// Di main.cpp, ubah syncSchedulesFromAPI() untuk handle format Laravel yang benar
+// Sinkronisasi kondisional: ETag jadwal terakhir dikirim sebagai If-None-Match,
+// server membalas 304 tanpa body jika jadwal tidak berubah. Jika berubah (200),
+// JSON di-parse langsung dari stream HTTP dengan filter field yang dipakai saja
+// (syncScheduleTable() di RemoteApi.h, jalur yang sama diukur di --bench).
 void syncSchedulesFromAPI() {
-    Serial.printf("🧠 Free Heap: %d bytes\n", ESP.getFreeHeap());
-    
-    if (WiFi.status() != WL_CONNECTED) {
-        connectWiFi(); 
-        if (WiFi.status() != WL_CONNECTED) return;
-    }
+    PROFILE_SCOPE_HEAP(profileScheduleSync, micros, esp_get_free_heap_size);
 
-    HTTPClient http;
-    String serverPath = "http://" + String(apiHost) + ":" + String(apiPort) + String(apiScheduleEndpoint);
+    LOG_D("🧠 Free Heap: %d bytes (terendah %d bytes)\n", ESP.getFreeHeap(), ESP.getMinFreeHeap());
+    if (LOG_ENABLED(LOG_LEVEL_DEBUG)) api.printStats(asyncLog());
     
-    Serial.println("\n🔄 Meminta jadwal baru dari Laravel API...");
-    http.begin(serverPath.c_str());
+    if (!wifi.connected()) return;
+
+    LOG_I("\n🔄 Meminta jadwal baru dari Laravel API...");
     
-    int httpResponseCode = http.GET();
+    // Jadwal hanya diubah task ini, jadi config tidak perlu terkunci selama request/parsing/log
+    Config updated = readConfig();
+    ScheduleEntry current[MAX_SCHEDULES];
+    memcpy(current, updated.schedules, sizeof(current));
+    ScheduleSync sync = syncScheduleTable(api, apiScheduleEndpoint, scheduleEtag, sizeof(scheduleEtag), current,
+                                          updated.scheduleCount, updated.schedules, MAX_SCHEDULES,
+                                          logScheduleEntry);
     
-    if (httpResponseCode > 0) {
-        String payload = http.getString();
-        Serial.println("📥 Response dari Laravel:");
-        Serial.println(payload);
-        
-        DynamicJsonDocument doc(4096);
-        DeserializationError error = deserializeJson(doc, payload);
-
-        if (error) {
-            Serial.printf("❌ Gagal parsing JSON: %s\n", error.f_str());
-            Serial.printf("   Ukuran payload: %d bytes\n", payload.length());
-            http.end();
-            return;
+    if (sync.status == ScheduleSync::NOT_MODIFIED) {
+        LOG_D("ℹ️  Tidak ada perubahan jadwal (304).");
+        return;
+    }
+    if (sync.status == ScheduleSync::HTTP_ERROR) {
+        LOG_E("❌ HTTP Error %d saat sync jadwal\n", sync.code);
+        return;
+    }
+    if (sync.status == ScheduleSync::PARSE_FAILED) {
+        if (sync.parse.status == ScheduleParseResult::NOT_ARRAY) {
+            LOG_E("❌ Gagal parsing JSON: response bukan array");
+        } else if (sync.parse.status == ScheduleParseResult::BAD_JSON) {
+            LOG_E("❌ Gagal parsing JSON: %s\n", sync.parse.error.f_str());
+        } else {
+            LOG_E("❌ Gagal parsing JSON: array jadwal terpotong");
         }
+        return;
+    }
 
-        bool configChanged = false;
-        
-        if (doc.is<JsonArray>()) {
-            JsonArray schedules = doc.as<JsonArray>();
-            Serial.printf("📊 Ditemukan %d jadwal dari server\n", schedules.size());
-            
-            int scheduleIndex = 0;
-            for (JsonObject schedule : schedules) {
-                if (scheduleIndex >= 3) break;
-                
-                const char* scheduleType = schedule["schedule_type"] | "";
-                const char* scheduleTime = schedule["schedule_time"] | "";
-                
-                // 🔥 FIX: Parse is_active sebagai integer dulu, baru convert ke bool
-                int isActiveInt = schedule["is_active"] | 0;
-                bool isActive = (isActiveInt == 1 || isActiveInt == true);
-                
-                int duration = schedule["duration_minutes"] | 30;
-                
-                Serial.printf("   RAW: type=%s, time=%s, is_active_raw=%d, duration=%d\n",
-                             scheduleType, scheduleTime, isActiveInt, duration);
-                
-                Serial.printf("   Jadwal %d: %s %s (%s) - %d menit\n",
-                             scheduleIndex+1, scheduleType, scheduleTime, 
-                             isActive ? "AKTIF" : "NONAKTIF", duration);
-                
-                if (strlen(scheduleTime) >= 5) {
-                    int hour = (scheduleTime[0] - '0') * 10 + (scheduleTime[1] - '0');
-                    int minute = (scheduleTime[3] - '0') * 10 + (scheduleTime[4] - '0');
-                    
-                    if (hour != config.schedules[scheduleIndex].hour || 
-                        minute != config.schedules[scheduleIndex].minute || 
-                        isActive != config.schedules[scheduleIndex].enabled) {
-                        
-                        config.schedules[scheduleIndex].hour = hour;
-                        config.schedules[scheduleIndex].minute = minute;
-                        config.schedules[scheduleIndex].enabled = isActive;
-                        
-                        configChanged = true;
-                        Serial.printf("   ➡️ UPDATE Jadwal #%d: %02d:%02d (%s)\n", 
-                                        scheduleIndex+1, hour, minute, 
-                                        isActive ? "AKTIF" : "NONAKTIF");
-                    }
-                    
-                    int newDuration = duration * 60;
-                    if (config.duration != newDuration) {
-                        config.duration = newDuration;
-                        configChanged = true;
-                        Serial.printf("   ➡️ UPDATE Durasi: %d detik\n", newDuration);
-                    }
-                }
-                
-                scheduleIndex++;
-            }
-            
-            // Nonaktifkan jadwal yang tidak ada di server
-            for (int i = scheduleIndex; i < 3; i++) {
-                if (config.schedules[i].enabled) {
-                    config.schedules[i].enabled = false;
-                    configChanged = true;
-                    Serial.printf("   ➡️ Jadwal #%d dinonaktifkan (tidak ada di server)\n", i+1);
-                }
-            }
+    LOG_I("📥 Jadwal dari Laravel (ETag: %s): ditemukan %d jadwal\n", scheduleEtag[0] ? scheduleEtag : "-",
+          sync.parse.total);
+    if (sync.parse.total > MAX_SCHEDULES) {
+        LOG_W("⚠️ Jadwal dari server melebihi %d entri, sisanya diabaikan.\n", MAX_SCHEDULES);
+    }
+
+    if (sync.status == ScheduleSync::CHANGED) {
+        xSemaphoreTake(configMutex, portMAX_DELAY);
+        memcpy(config.schedules, updated.schedules, sizeof(config.schedules));
+        config.scheduleCount = sync.parse.count;
+        saveConfig();
+        updated = config;
+        xSemaphoreGive(configMutex);
+
+        requestScheduleReload();
+        traceEvent(TRACE_SCHEDULE_SYNC, 0, updated.scheduleCount);
+        displayConfig(updated); 
+        LOG_I("✅ Konfigurasi Jadwal disinkronkan dari Laravel.");
+    } else {
+        LOG_D("ℹ️  Tidak ada perubahan jadwal.");
+    }
+}
+
+// --- FUNGSI UPDATE OTA ---
+
+void stepFirmwareUpdate();
+
+// Cek manifest firmware di server (tiap jam). Unduhan dimulai jika server
+// menawarkan versi lain dan node ini termasuk persen rollout.
+void checkFirmwareUpdate() {
+    // DONE: image baru sudah jadi partisi boot, tinggal menunggu restart
+    if (!wifi.connected() || otaTrial.pending()) return;
+    if (ota.status() == OtaClient::RUNNING || ota.status() == OtaClient::DONE) return;
+
+    OtaManifest manifest;
+    OtaClient::Check result = ota.check(apiFirmwareEndpoint, FIRMWARE_VERSION, manifest);
+    if (result == OtaClient::NOT_IN_ROLLOUT) {
+        LOG_D("ℹ️  Firmware %s tersedia, node ini belum termasuk rollout %u%%.", manifest.version,
+              manifest.rollout);
+    }
+    if (result != OtaClient::UPDATE) return;
+
+    if (!ota.start(manifest)) {
+        traceEvent(TRACE_OTA_FAILED);
+        LOG_E("❌ Update firmware %s tidak bisa dimulai (%s).", manifest.version, ota.lastError());
+        return;
+    }
+    traceEvent(TRACE_OTA_START, ota.delta(), ota.payloadSize());
+    LOG_I("⬇️  Firmware %s -> %s: mengunduh %s %lu byte.", FIRMWARE_VERSION, manifest.version,
+          ota.delta() ? "patch delta" : "image penuh", (unsigned long)ota.payloadSize());
+    otaStepJob = netTimer.every(OTA_STEP_INTERVAL_MS, stepFirmwareUpdate);
+}
+
+// Satu potongan unduhan; job lain networkTask tetap berjalan di sela-selanya
+void stepFirmwareUpdate() {
+    OtaClient::Status status = ota.step();
+    if (status == OtaClient::RUNNING) return;
+    netTimer.cancel(otaStepJob);
+
+    if (status == OtaClient::DONE) {
+        traceEvent(TRACE_OTA_DONE, 0, ota.stats().lastMs);
+        LOG_I("✅ Firmware %s terverifikasi (%lu ms), restart setelah valve tertutup.", ota.manifest().version,
+              (unsigned long)ota.stats().lastMs);
+        otaTrial.arm();
+        ValveCommand cmd;
+        cmd.type = VALVE_CMD_RESTART;
+        cmd.issuedAt = millis();
+        xQueueSend(valveQueue, &cmd, portMAX_DELAY);
+    } else {
+        traceEvent(TRACE_OTA_FAILED, 0, ota.received());
+        LOG_E("❌ Update firmware %s gagal: %s.", ota.manifest().version, ota.lastError());
+    }
+}
+
+// Health check boot trial: WiFi terhubung, API pernah merespons, valveTask
+// berputar. Lulus = image dikonfirmasi; tidak lulus sampai batas = rollback.
+void checkFirmwareHealth() {
+    bool healthy = wifi.connected() && apiResponded && valveLoopIterations.value() > 0;
+    OtaTrial::Verdict verdict = otaTrial.check(healthy, millis());
+    if (verdict == OtaTrial::WAIT) return;
+
+    netTimer.cancel(otaHealthJob);
+    if (verdict == OtaTrial::CONFIRM) {
+        traceEvent(TRACE_OTA_CONFIRMED, otaTrial.boots());
+        LOG_I("✅ Firmware %s dikonfirmasi setelah %u boot.", FIRMWARE_VERSION, otaTrial.boots());
+        otaTrial.confirm();
+    } else {
+        traceEvent(TRACE_OTA_ROLLBACK, otaTrial.boots());
+        LOG_E("❌ Firmware %s tidak lulus health check, kembali ke firmware lama.", FIRMWARE_VERSION);
+        otaTrial.rollback(); // Tidak kembali
+    }
+}
+
+// ==================== TASK FREERTOS ====================
+
+// Core 0: semua I/O jaringan. Blocking di sini (HTTP timeout, NTP) tidak lagi
+// menunda jadwal maupun auto-close valve; reconnect WiFi tidak pernah blocking.
+void networkTask(void* param) {
+    for (;;) {
+        unsigned long untilNextJob;
+        {
+            PROFILE_SCOPE(profileNetTimer, micros);
+            untilNextJob = netTimer.run();
         }
-        
-        if (configChanged) {
-            saveConfig();
-            displayConfig(); 
-            Serial.println("✅ Konfigurasi Jadwal disinkronkan dari Laravel.");
-        } else {
-            Serial.println("ℹ️  Tidak ada perubahan jadwal.");
+        unsigned long untilWifi = wifi.update(); // Timeout/backoff reconnect, tanpa menunggu
+        if (untilWifi < untilNextJob) untilNextJob = untilWifi;
+        statusStream.poll(); // Non-blocking: proses event SSE yang sudah masuk
+        pollLocalLink();     // Non-blocking: frame sensor node yang sudah masuk
+        metricsServer.handleClient();
+
+        loopIterations++;
+        netLoopIterations.inc();
+        unsigned long sleepMs = untilNextJob < LOOP_MAX_SLEEP_MS ? untilNextJob : LOOP_MAX_SLEEP_MS;
+        if (sleepMs > 0) {
+            vTaskDelay(pdMS_TO_TICKS(sleepMs));
+            loopSleepMs += sleepMs;
         }
+    }
+}
 
-    } else {
-        Serial.printf("❌ HTTP Error %d saat sync jadwal\n", httpResponseCode);
+// Core 1: pemilik tunggal relay. Tidur sampai deadline job/zona berikutnya atau
+// sampai perintah remote masuk ke valveQueue, mana yang lebih dulu, paling
+// lama VALVE_HEARTBEAT_MS agar heartbeat pengaman & task watchdog terus jalan.
+void valveTask(void* param) {
+    esp_task_wdt_add(nullptr);
+    ValveCommand cmd;
+    for (;;) {
+        esp_task_wdt_reset();
+        portENTER_CRITICAL(&safetyMux);
+        safety.heartbeat(millis());
+        portEXIT_CRITICAL(&safetyMux);
+
+        unsigned long untilNextJob;
+        {
+            PROFILE_SCOPE(profileValveTimer, micros);
+            untilNextJob = valveTimer.run();
+        }
+        // Zona yang outputnya diputus timer (mis. perintah tutup tidak masuk
+        // karena queue penuh) ikut ditutup di ValveBank agar slot pompa lepas
+        uint32_t cut = guardedOutput.cutZones();
+        for (uint8_t z = 0; cut && z < VALVE_ZONES; z++) {
+            if (cut & (1UL << z)) safetyCloseZone(z);
+        }
+        unsigned long untilZone = valves.update(millis()); // Auto-close & zona antrian
+        if (untilZone < untilNextJob) untilNextJob = untilZone;
+        if (untilNextJob > VALVE_HEARTBEAT_MS) untilNextJob = VALVE_HEARTBEAT_MS;
+        TickType_t wait = pdMS_TO_TICKS(untilNextJob);
+
+        if (xQueueReceive(valveQueue, &cmd, wait) == pdTRUE) {
+            handleValveCommand(cmd);
+        }
+        valveLoopIterations.inc();
     }
-    
-    http.end();
+}
+
+// ID node dari MAC STA; endpoint per node jika NODE_SCOPED_API.
+// Dipanggil setelah wifi.begin() (mode STA aktif).
+void setupNodeIdentity() {
+    uint8_t mac[NODE_MAC_SIZE];
+    WiFi.macAddress(mac);
+    nodeIdFromMac(mac, nodeId);
+#if NODE_SCOPED_API
+    nodePath(apiEndpoint, sizeof(apiEndpoint), nodeId, "/water-status");
+    nodePath(apiScheduleEndpoint, sizeof(apiScheduleEndpoint), nodeId, "/schedules");
+    nodePath(apiStreamEndpoint, sizeof(apiStreamEndpoint), nodeId, "/water-status/stream");
+    nodePath(apiMoistureEndpoint, sizeof(apiMoistureEndpoint), nodeId, "/sensor/latest");
+    nodePath(apiFirmwareEndpoint, sizeof(apiFirmwareEndpoint), nodeId, "/firmware?version=" FIRMWARE_VERSION);
+#endif
+    api.setNodeId(nodeId);
+    statusStream.setNodeId(nodeId);
+
+    uint8_t paired[NODE_MAC_SIZE];
+    if (nodeIdToMac(PAIRED_SENSOR_ID, paired)) localLink.pairWith(paired);
+    LOG_I("🆔 Node ID: %s (sensor pasangan: %s)", nodeId, PAIRED_SENSOR_ID[0] ? PAIRED_SENSOR_ID : "otomatis");
 }
 
 // ==================== SETUP ====================
 void setup() {
     Serial.begin(9600);
-    Serial.println("\n╔══════════════════════════════════════════╗");
-    Serial.println("║  Sistem Penyiraman - Mode Lokal API      ║");
-    Serial.println("║          ESP32 + RTC + Laravel           ║");
-    Serial.println("╚══════════════════════════════════════════╝\n");
+    asyncLog().begin(Serial); // Semua LOG_* di-drain oleh task "log", bukan task pemanggil
+    traceEvent(TRACE_BOOT, esp_reset_reason());
+    if (otaTrial.begin() == OtaTrial::TRIAL) { // Crash loop di image baru = rollback di sini
+        LOG_W("🧪 Firmware %s dalam boot trial (boot ke-%u).", FIRMWARE_VERSION, otaTrial.boots());
+    }
+    LOG_I("\n╔══════════════════════════════════════════╗");
+    LOG_I("║  Sistem Penyiraman - Mode Lokal API      ║");
+    LOG_I("║          ESP32 + RTC + Laravel           ║");
+    LOG_I("╚══════════════════════════════════════════╝\n");
+    
+    configMutex = xSemaphoreCreateMutex();
+    rtcMutex = xSemaphoreCreateMutex();
+    valveQueue = xQueueCreate(VALVE_QUEUE_LENGTH, sizeof(ValveCommand));
+    ntpQueue = xQueueCreate(1, sizeof(NtpSample));
     
     EEPROM.begin(EEPROM_SIZE);
     loadConfig();
     
-    pinMode(RELAY_PIN, OUTPUT);
+    valves.begin(); // Semua zona tertutup
     pinMode(LED_PIN, OUTPUT);
-    digitalWrite(RELAY_PIN, LOW); 
     digitalWrite(LED_PIN, LOW);
     
     Wire.begin(SDA_PIN, SCL_PIN);
     
     if (!rtc.begin()) {
-        Serial.println("❌ ERROR: RTC DS3231 tidak ditemukan!");
+        LOG_E("❌ ERROR: RTC DS3231 tidak ditemukan!");
         blinkError();
         while (1) delay(1000);
     }
     
     if (rtc.lostPower()) {
-        Serial.println("⚠️  RTC kehilangan daya, waktu akan diatur dari NTP.");
+        LOG_W("⚠️  RTC kehilangan daya, waktu akan diatur dari NTP.");
     }
     
     DateTime now = rtc.now();
-    Serial.printf("⏰ Waktu RTC Awal: %04d-%02d-%02d %02d:%02d:%02d\n\n", 
+    timeService.begin(now.unixtime(), esp_timer_get_time()); // Satu-satunya baca RTC di jalur jadwal
+    LOG_I("⏰ Waktu RTC Awal: %04d-%02d-%02d %02d:%02d:%02d\n\n", 
                     now.year(), now.month(), now.day(),
                     now.hour(), now.minute(), now.second());
     
-    displayConfig();
+    displayConfig(config);
     
-    connectWiFi();
+    // Tidak menunggu WiFi: sistem (jadwal dari flash, RTC) langsung berjalan,
+    // sync NTP & stream dimulai begitu koneksi tersambung
+    LOG_I("📡 Menghubungkan ke WiFi %s di latar...", ssid);
+    wifi.onEvent(onWifiEvent);
+    wifi.begin(ssid, pass);
+    WiFi.setSleep(false); // Tanpa modem sleep, multicast link lokal tidak menunggu beacon DTIM
+    setupNodeIdentity();
     
-    configTime(gmtOffset_sec, daylightOffset_sec, ntpServer);
-    
-    syncRTCFromNTP(); 
+    sntp_set_time_sync_notification_cb(onNtpTimeSync);
+    sntp_set_sync_interval(NTP_SYNC_INTERVAL_MS);
+    configTime(gmtOffset_sec, daylightOffset_sec, ntpServer); // Klien SNTP di latar, mencoba ulang sendiri
+
+    api.begin(apiHost, apiPort);
+    ota.begin(apiHost, apiPort, nodeId);
+    setupMetrics();
+    statusStream.begin(apiHost, apiPort, apiStreamEndpoint, onValveStatusEvent);
 
     // Setup Timers
-    timer.setInterval(1000L, checkSchedule); // Cek jadwal setiap 1 detik
-    timer.setInterval(REMOTE_CHECK_INTERVAL, checkRemoteStatus); // Cek status dari Laravel setiap 5 detik
-    timer.setInterval(60000L, syncSchedulesFromAPI); // Sync Jadwal dari Laravel setiap 1 menit
-    timer.setInterval(900000L, syncRTCFromNTP); // Sync RTC dari NTP setiap 15 menit
+    requestScheduleReload(); // valveTask memuat tabel jadwal & menjadwalkan checkSchedule
+    valveTimer.every(2000L, heartbeatLED); // LED heartbeat saat idle
+    netTimer.every(REMOTE_CHECK_INTERVAL, checkRemoteStatus); // Cek status dari Laravel setiap 5 detik
+    netTimer.every(60000L, syncSchedulesFromAPI); // Sync Jadwal dari Laravel setiap 1 menit
+    netTimer.every(MOISTURE_FETCH_INTERVAL, fetchMoisture); // Bacaan soil untuk closed-loop setiap 1 menit
+    netTimer.every(10000L, applyNtpSample); // Sampel NTP dari klien SNTP (tiap 15 menit) ke TimeService
+    netTimer.every(NTP_SYNC_INTERVAL_MS, checkTimeSources); // Cadangan DS3231 saat NTP tidak tersedia
+    netTimer.every(60000L, reportLoopStats); // Statistik task setiap 1 menit
+    netTimer.every(OTA_CHECK_INTERVAL_MS, checkFirmwareUpdate); // Manifest firmware OTA setiap 1 jam
+    if (otaTrial.pending()) otaHealthJob = netTimer.every(OTA_HEALTH_CHECK_MS, checkFirmwareHealth);
     
-    Serial.println("✅ Sistem siap!");
-    Serial.println("🔔 Untuk set waktu manual, ketik 'T' di Serial Monitor lalu Enter.");
-    Serial.printf("🌐 Target API: http://%s:%d\n", apiHost, apiPort);
-    Serial.println();
+    LOG_I("✅ Sistem siap!");
+    LOG_I("🔔 Untuk set waktu manual, ketik 'T' di Serial Monitor lalu Enter.");
+    LOG_I("📜 Ketik 'H' untuk riwayat penyiraman.");
+    LOG_I("🌐 Target API: http://%s:%d%s\n\n", apiHost, apiPort, NODE_SCOPED_API ? NODE_API_PREFIX "<id>/..." : "");
+    LOG_I("📦 Firmware %s", FIRMWARE_VERSION);
     
     for (int i = 0; i < 3; i++) {
         digitalWrite(LED_PIN, HIGH);
@@ -527,37 +1618,28 @@ void setup() {
         digitalWrite(LED_PIN, LOW);
         delay(200);
     }
+
+    setupSafety(); // Timer pengaman & task watchdog sebelum valveTask membuka zona
+    xTaskCreatePinnedToCore(valveTask, "valve", VALVE_TASK_STACK, nullptr,
+                            VALVE_TASK_PRIORITY, &valveTaskHandle, VALVE_TASK_CORE);
+    xTaskCreatePinnedToCore(networkTask, "network", NET_TASK_STACK, nullptr,
+                            NET_TASK_PRIORITY, &netTaskHandle, NET_TASK_CORE);
 }
 
 // ==================== LOOP ====================
+// Jaringan & valve berjalan di task masing-masing; loop() hanya melayani Serial.
 void loop() {
-    timer.run();
-    
     // 💡 PENANGANAN INPUT SERIAL UNTUK MENGATUR WAKTU
     if (Serial.available()) {
         char command = Serial.read();
         if (command == 'T' || command == 't') {
             setRTCFromSerial();
-        } 
+        } else if (command == 'H' || command == 'h') {
+            printWateringHistory();
+        }
         
         while (Serial.available()) Serial.read();
     }
     
-    // Auto-close valve setelah durasi jika BUKAN mode manual/remote
-    // Jika sedang menyiram dan BUKAN karena perintah manual/remote, jalankan timer durasi
-    if (isWatering && !manualMode) {
-        if (millis() - valveOpenTime >= (unsigned long)config.duration * 1000UL) {
-            closeValve();
-            Serial.println("⏱️  Auto-close: Durasi penyiraman selesai (Jadwal RTC)");
-        }
-    }
-    
-    // LED heartbeat (berkedip pelan saat idle) - Non-aktifkan saat menyiram
-    static unsigned long lastBlink = 0;
-    if (!isWatering) {
-        if (millis() - lastBlink >= 2000) { 
-            digitalWrite(LED_PIN, !digitalRead(LED_PIN)); 
-            lastBlink = millis();
-        }
-    }
+    delay(50);
 }
\ No newline at end of file
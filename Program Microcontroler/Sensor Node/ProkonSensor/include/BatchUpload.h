@@ -0,0 +1,73 @@
+/*
+ * BatchUpload - Satu upload batch pembacaan dari ReadingBuffer
+ *
+ * Encode pembacaan tertua (maks. batchSize) dengan TelemetryEncoder (biner)
+ * atau TelemetryJsonEncoder (JSON), kirim lewat callback post(), lalu buang
+ * dari buffer hanya jika server menjawab 2xx, sehingga kegagalan tidak
+ * menghilangkan data. Encoder yang penuh / di luar rentang waktu batch
+ * menghentikan batch; sisanya ikut batch berikutnya.
+ *
+ * Dipakai sendSensorData() firmware (HttpTransport) dan simulasi host
+ * (server tiruan). Tidak bergantung pada Arduino.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ReadingBuffer.h"
+#include "Deadband.h"
+#include <TelemetryCodec.h>
+
+// Kirim body; mengembalikan kode HTTP (<= 0 = koneksi gagal)
+typedef int (*BatchPostFn)(const uint8_t* body, size_t length, size_t count, void* ctx);
+
+struct BatchUploadResult {
+    size_t count;               // Pembacaan di batch
+    size_t length;              // Byte payload
+    unsigned long encodeUs;     // 0 jika tanpa sumber micros()
+    int code;
+    bool ok;                    // 2xx: pembacaan sudah dibuang dari buffer
+};
+
+// Epoch UTC sebuah pembacaan, 0 jika waktu sampling tidak diketahui.
+// epochNow = 0 jika jam belum sinkron.
+inline uint32_t readingEpoch(const SensorReading& r, uint32_t epochNow, unsigned long nowMs) {
+    if (r.flags & SensorReading::TS_EPOCH) return r.timestamp;
+    if (epochNow && r.timestamp != 0) {
+        // Sampel diambil sebelum NTP sinkron: hitung mundur dari millis()
+        return epochNow - (uint32_t)((nowMs - r.timestamp) / 1000);
+    }
+    return 0;
+}
+
+// Parameter deadband untuk server: jarak sampling & heartbeat dalam detik
+inline TelemetryDeadband deadbandInfo(const DeadbandConfig& c, unsigned long sampleIntervalMs) {
+    uint16_t intervalSec = (uint16_t)(sampleIntervalMs / 1000);
+    TelemetryDeadband info = {intervalSec, (uint16_t)(intervalSec * (c.maxSilentSamples + 1)),
+                              (uint8_t)c.tempX10, (uint8_t)c.humidX10, c.soil};
+    return info;
+}
+
+// encoder sudah diberi setNode()/setDeadband() oleh pemanggil; body = buffer encoder
+template <typename TEncoder, size_t CAPACITY>
+BatchUploadResult uploadBatch(ReadingBuffer<CAPACITY>& readings, TEncoder& encoder, const void* body,
+                              size_t batchSize, uint32_t epochNow, unsigned long nowMs,
+                              BatchPostFn post, void* ctx, unsigned long (*micros)() = nullptr) {
+    BatchUploadResult result = {};
+    size_t maxCount = readings.size() < batchSize ? readings.size() : batchSize;
+
+    unsigned long encodeStart = micros ? micros() : 0;
+    for (; result.count < maxCount; result.count++) {
+        const SensorReading& r = readings.at(result.count);
+        TelemetryRecord record = {readingEpoch(r, epochNow, nowMs), r.tempX10, r.humidX10, r.soil,
+                                  r.reason, r.skipped};
+        if (!encoder.add(record)) break;
+    }
+    result.length = encoder.finish();
+    if (micros) result.encodeUs = micros() - encodeStart;
+
+    result.code = post((const uint8_t*)body, result.length, result.count, ctx);
+    result.ok = result.code >= 200 && result.code < 300;
+    if (result.ok) readings.pop(result.count);
+    return result;
+}
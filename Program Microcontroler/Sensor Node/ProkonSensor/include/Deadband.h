@@ -0,0 +1,88 @@
+/*
+ * Deadband - Kirim pembacaan hanya saat berubah (report by exception)
+ *
+ * Setiap sampel dibandingkan dengan pembacaan terakhir yang DIKIRIM, per
+ * kanal. Sampel diteruskan ke buffer upload jika salah satu kanal bergeser
+ * melewati ambangnya, atau jika sudah maxSilentSamples sampel berturut-turut
+ * ditahan (heartbeat, tanda node masih hidup). Sampel lain dibuang.
+ *
+ * Pembacaan yang diteruskan membawa:
+ *   reason  : bit TELEMETRY_REASON_* (kanal yang berubah, heartbeat, dst.)
+ *   skipped : jumlah sampel yang ditahan tepat sebelum pembacaan ini
+ * Server merekonstruksi deret dengan menahan nilai baris terakhir
+ * (sample-and-hold): sampel yang ditahan berada dalam ambang terhadap baris
+ * sebelumnya, jadi error rekonstruksi per kanal <= ambang kanal itu.
+ *
+ * DeadbandState POD (bisa di RTC slow memory untuk mode deep sleep, seperti
+ * DutyCycleState). Heartbeat dihitung dalam sampel, bukan millis(), agar
+ * tetap benar setelah deep sleep. Tidak bergantung pada Arduino.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "ReadingBuffer.h"
+#include <TelemetryCodec.h>
+
+struct DeadbandConfig {
+    uint16_t tempX10;           // Ambang suhu (°C x10)
+    uint16_t humidX10;          // Ambang kelembapan (%RH x10)
+    uint8_t soil;               // Ambang soil (%)
+    uint8_t maxSilentSamples;   // Heartbeat; 0 = filter mati (semua sampel dikirim)
+};
+
+struct DeadbandState {
+    bool hasReference;
+    bool gap;                   // Ada sampel hilang (DHT gagal) sejak pembacaan terakhir
+    uint8_t silent;             // Sampel ditahan sejak pembacaan terakhir dikirim
+    SensorReading reference;    // Pembacaan terakhir yang diteruskan
+    uint32_t admitted;
+    uint32_t suppressed;
+};
+
+class DeadbandFilter {
+public:
+    explicit DeadbandFilter(const DeadbandConfig& config) : _config(config) {}
+
+    // Isi reason/skipped pada reading. Mengembalikan bit reason, 0 jika
+    // sampel ditahan (tidak perlu masuk buffer).
+    uint8_t admit(DeadbandState& state, SensorReading& reading) const {
+        uint8_t reason = 0;
+        if (!state.hasReference) {
+            reason = TELEMETRY_REASON_FIRST;
+        } else {
+            const SensorReading& ref = state.reference;
+            if (absDiff(reading.tempX10, ref.tempX10) > _config.tempX10) reason |= TELEMETRY_REASON_TEMP;
+            if (absDiff(reading.humidX10, ref.humidX10) > _config.humidX10) reason |= TELEMETRY_REASON_HUMID;
+            if (absDiff(reading.soil, ref.soil) > _config.soil) reason |= TELEMETRY_REASON_SOIL;
+            if (state.silent >= _config.maxSilentSamples) reason |= TELEMETRY_REASON_HEARTBEAT;
+        }
+        if (state.gap) reason |= TELEMETRY_REASON_GAP;
+
+        if (!reason) {
+            state.silent++;
+            state.suppressed++;
+            return 0;
+        }
+        reading.reason = reason;
+        reading.skipped = state.silent;
+        state.reference = reading;
+        state.hasReference = true;
+        state.silent = 0;
+        state.gap = false;
+        state.admitted++;
+        return reason;
+    }
+
+    // Sampel tidak bisa diambil: pembacaan berikutnya dikirim dengan bit GAP
+    // agar server tidak menahan nilai lama melewati celah ini
+    void markGap(DeadbandState& state) const {
+        if (state.hasReference) state.gap = true;
+    }
+
+    const DeadbandConfig& config() const { return _config; }
+
+private:
+    static uint32_t absDiff(int32_t a, int32_t b) { return a > b ? a - b : b - a; }
+
+    DeadbandConfig _config;
+};
@@ -0,0 +1,132 @@
+/*
+ * DutyCycle - Keputusan siklus bangun/tidur sensor node (mode deep sleep)
+ *
+ * Setiap bangun: ambil satu pembacaan terfilter, simpan di buffer RTC, lalu
+ * tentukan apakah WiFi perlu dinyalakan:
+ *   - buffer mencapai uploadBatch pembacaan, atau
+ *   - pembacaan terbaru berubah melewati ambang terhadap pembacaan terakhir
+ *     yang sudah terkirim (mis. penyiraman dimulai, soil naik > 5%), atau
+ *   - belum ada referensi sama sekali (bangun pertama setelah cold boot)
+ * Setelah upload gagal, WiFi tidak dicoba tiap bangun: jeda 1, 2, 4 .. 16
+ * siklus (baterai tidak habis untuk AP yang mati).
+ *
+ * DutyCycleState harus POD: disimpan di RTC slow memory (RTC_DATA_ATTR) dan
+ * tidak boleh punya konstruktor yang berjalan ulang setiap bangun. Image
+ * baru (OTA) yang bangun dari deep sleep hanya memakai isi RTC image lama jika
+ * tag layout-nya sama (dutyLayoutTag()). Tidak bergantung pada Arduino
+ * (dipakai juga oleh simulasi host).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ReadingBuffer.h"
+
+struct DutyCycleConfig {
+    unsigned long periodMs;     // Jarak antar bangun (awal ke awal)
+    unsigned long minSleepMs;   // Tidur minimum walau siklus melebihi periode
+    uint8_t uploadBatch;        // Upload saat buffer berisi sebanyak ini
+    uint8_t soilDelta;          // Ambang perubahan soil (%)
+    uint16_t tempDeltaX10;      // Ambang perubahan suhu (°C x10)
+    uint16_t humidDeltaX10;     // Ambang perubahan kelembapan (%RH x10)
+    uint8_t maxHoldoffCycles;   // Batas jeda upload setelah gagal
+};
+
+struct DutyCycleState {
+    uint32_t magic;             // DUTY_CYCLE_MAGIC jika isi valid (bukan cold boot)
+    uint32_t layout;            // dutyLayoutTag() image yang menulis isi RTC
+    uint32_t wakes;
+    uint32_t uploads;           // Siklus dengan WiFi dinyalakan
+    uint32_t uploadFailures;    // Berturut-turut
+    uint8_t holdoff;            // Siklus tersisa sebelum boleh mencoba WiFi lagi
+    bool hasReference;
+    SensorReading reference;    // Pembacaan terakhir yang terkirim
+    float soilRaw;              // EMA soil (lanjut antar tidur)
+    bool soilReady;
+    unsigned long lastAwakeMs;  // Lama bangun siklus sebelumnya
+    uint64_t awakeMsTotal;
+};
+
+const uint32_t DUTY_CYCLE_MAGIC = 0x44435931; // "DCY1"
+
+// FNV-1a atas angka yang menentukan layout RTC: alamat & ukuran variabel
+// RTC_DATA_ATTR, offset field, versi layout manual. Layout lain = tag lain.
+inline uint32_t dutyLayoutTag(const uint32_t* words, size_t count) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < count; i++) {
+        for (uint8_t shift = 0; shift < 32; shift += 8) {
+            hash ^= (words[i] >> shift) & 0xFF;
+            hash *= 16777619u;
+        }
+    }
+    return hash;
+}
+
+class DutyCyclePolicy {
+public:
+    enum Reason : uint8_t { HOLD, BATCH_FULL, CHANGED, FIRST };
+
+    explicit DutyCyclePolicy(const DutyCycleConfig& config) : _config(config) {}
+
+    // Isi state saat cold boot (magic tidak cocok) atau saat isi RTC ditulis
+    // image dengan layout lain (tag tidak cocok); true jika state baru
+    static bool init(DutyCycleState& state, uint32_t layout = 0) {
+        if (state.magic == DUTY_CYCLE_MAGIC && state.layout == layout) return false;
+        state = DutyCycleState();
+        state.magic = DUTY_CYCLE_MAGIC;
+        state.layout = layout;
+        return true;
+    }
+
+    // Dipanggil sekali per bangun setelah pembacaan masuk buffer
+    Reason decide(DutyCycleState& state, const SensorReading& latest, size_t buffered) const {
+        if (state.holdoff > 0) {
+            state.holdoff--;
+            return HOLD;
+        }
+        if (!state.hasReference) return FIRST;
+        if (buffered >= _config.uploadBatch) return BATCH_FULL;
+        if (changed(state.reference, latest)) return CHANGED;
+        return HOLD;
+    }
+
+    // Hasil upload: sukses menggeser referensi, gagal menambah jeda
+    void uploaded(DutyCycleState& state, const SensorReading& latest, bool ok) const {
+        state.uploads++;
+        if (ok) {
+            state.uploadFailures = 0;
+            state.holdoff = 0;
+            state.reference = latest;
+            state.hasReference = true;
+            return;
+        }
+        state.uploadFailures++;
+        uint32_t wait = 1;
+        for (uint32_t i = 1; i < state.uploadFailures && wait < _config.maxHoldoffCycles; i++) wait *= 2;
+        state.holdoff = wait < _config.maxHoldoffCycles ? wait : _config.maxHoldoffCycles;
+    }
+
+    bool changed(const SensorReading& a, const SensorReading& b) const {
+        return absDiff(a.soil, b.soil) > _config.soilDelta ||
+               absDiff(a.tempX10, b.tempX10) > _config.tempDeltaX10 ||
+               absDiff(a.humidX10, b.humidX10) > _config.humidDeltaX10;
+    }
+
+    // Lama tidur agar bangun berikutnya tetap di grid periodMs
+    unsigned long sleepMs(unsigned long awakeMs) const {
+        if (awakeMs + _config.minSleepMs >= _config.periodMs) return _config.minSleepMs;
+        return _config.periodMs - awakeMs;
+    }
+
+    // Akhir siklus, tepat sebelum tidur
+    void finish(DutyCycleState& state, unsigned long awakeMs) const {
+        state.wakes++;
+        state.lastAwakeMs = awakeMs;
+        state.awakeMsTotal += awakeMs;
+    }
+
+private:
+    static uint32_t absDiff(int32_t a, int32_t b) { return a > b ? a - b : b - a; }
+
+    DutyCycleConfig _config;
+};
@@ -0,0 +1,64 @@
+/*
+ * ReadingBuffer - Ring buffer pembacaan sensor berukuran tetap
+ *
+ * Pembacaan disimpan dalam format fixed-point (12 byte per record) agar
+ * ratusan sampel muat di RAM. Jika buffer penuh, record tertua ditimpa dan
+ * dicatat di dropped(). Tidak bergantung pada Arduino sehingga bisa diuji
+ * di host.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct SensorReading {
+    uint32_t timestamp;   // Epoch detik (UTC) jika TS_EPOCH, selain itu millis() saat sampling
+    int16_t tempX10;      // Suhu °C x10
+    uint16_t humidX10;    // Kelembapan %RH x10
+    uint8_t soil;         // Kelembapan tanah 0-100 %
+    uint8_t flags;
+    uint8_t reason;       // Bit TELEMETRY_REASON_* (Deadband.h), 0 = tanpa filter
+    uint8_t skipped;      // Sampel ditahan deadband sebelum pembacaan ini
+
+    static const uint8_t TS_EPOCH = 0x01;
+    static const uint8_t DHT_CACHED = 0x02;  // Suhu/kelembapan dari cache (DHT gagal dibaca)
+};
+
+template <size_t CAPACITY>
+class ReadingBuffer {
+public:
+    // Tambah record; jika penuh, record tertua dibuang
+    void push(const SensorReading& reading) {
+        if (_count == CAPACITY) {
+            _head = (_head + 1) % CAPACITY;
+            _count--;
+            _dropped++;
+        }
+        _items[(_head + _count) % CAPACITY] = reading;
+        _count++;
+    }
+
+    // Record ke-i dari yang tertua (0 = tertua)
+    const SensorReading& at(size_t i) const {
+        return _items[(_head + i) % CAPACITY];
+    }
+
+    // Buang n record tertua (setelah berhasil di-upload)
+    void pop(size_t n) {
+        if (n > _count) n = _count;
+        _head = (_head + n) % CAPACITY;
+        _count -= n;
+    }
+
+    size_t size() const { return _count; }
+    bool empty() const { return _count == 0; }
+    bool full() const { return _count == CAPACITY; }
+    size_t capacity() const { return CAPACITY; }
+    uint32_t dropped() const { return _dropped; }
+
+private:
+    SensorReading _items[CAPACITY];
+    size_t _head = 0;
+    size_t _count = 0;
+    uint32_t _dropped = 0;
+};
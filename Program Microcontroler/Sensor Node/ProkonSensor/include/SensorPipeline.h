@@ -0,0 +1,211 @@
+/*
+ * SensorPipeline - Akuisisi & filter sinyal sensor (soil + DHT)
+ *
+ * Alur soil moisture:
+ *   burst oversampling ADC -> median burst -> tolak outlier -> EMA -> kurva kalibrasi
+ * Alur DHT:
+ *   baca dengan retry -> validasi rentang -> cache nilai terakhir yang valid
+ *
+ * Semua sumber data (ADC, DHT, jam mikrodetik) diberikan lewat pointer fungsi,
+ * sehingga pipeline bisa diuji di host dengan sinyal sintetis. Tidak
+ * bergantung pada Arduino.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+// ==================== FILTER DASAR ====================
+
+// Median in-place (insertion sort; n kecil, mis. 16 sampel)
+inline uint16_t medianOf(uint16_t* samples, size_t n) {
+    for (size_t i = 1; i < n; i++) {
+        uint16_t v = samples[i];
+        size_t j = i;
+        while (j > 0 && samples[j - 1] > v) {
+            samples[j] = samples[j - 1];
+            j--;
+        }
+        samples[j] = v;
+    }
+    return (n & 1) ? samples[n / 2] : (uint16_t)((samples[n / 2 - 1] + samples[n / 2]) / 2);
+}
+
+class Ema {
+public:
+    explicit Ema(float alpha) : _alpha(alpha) {}
+
+    float update(float x) {
+        _value = _ready ? _value + _alpha * (x - _value) : x;
+        _ready = true;
+        return _value;
+    }
+
+    float value() const { return _value; }
+    bool ready() const { return _ready; }
+    void reset() { _ready = false; }
+
+    // Lanjutkan dari nilai tersimpan (mis. RTC memory setelah deep sleep)
+    void seed(float x) {
+        _value = x;
+        _ready = true;
+    }
+
+private:
+    float _alpha;
+    float _value = 0;
+    bool _ready = false;
+};
+
+// Kurva kalibrasi piecewise-linear: titik (raw, nilai) urut berdasarkan raw
+// (boleh naik atau turun). Di luar rentang tabel nilai di-clamp ke ujung kurva.
+struct CalibrationPoint {
+    float raw;
+    float value;
+};
+
+inline float applyCalibration(const CalibrationPoint* points, size_t n, float raw) {
+    if (n == 0) return raw;
+    if (n == 1) return points[0].value;
+
+    bool ascending = points[n - 1].raw > points[0].raw;
+    size_t i = 0;
+    while (i + 2 < n && (ascending ? raw > points[i + 1].raw : raw < points[i + 1].raw)) i++;
+
+    const CalibrationPoint& a = points[i];
+    const CalibrationPoint& b = points[i + 1];
+    float t = (raw - a.raw) / (b.raw - a.raw);
+    if (t < 0) t = 0;
+    if (t > 1) t = 1;
+    return a.value + t * (b.value - a.value);
+}
+
+// ==================== SOIL SAMPLER ====================
+
+struct SoilSamplerConfig {
+    uint8_t burstSize;        // Sampel ADC per burst (maks. 32)
+    float emaAlpha;           // Bobot EMA antar burst
+    uint16_t maxJump;         // Median burst yang melompat > maxJump dari EMA ditolak
+    uint8_t maxRejects;       // Setelah n penolakan berturut-turut, terima (sinyal memang berubah)
+};
+
+class SoilSampler {
+public:
+    typedef uint16_t (*AdcRead)();
+    typedef unsigned long (*MicrosClock)();
+
+    SoilSampler(const SoilSamplerConfig& config, AdcRead read, MicrosClock clock)
+        : _config(config), _read(read), _clock(clock), _ema(config.emaAlpha) {}
+
+    // Satu burst oversampling; dipanggil periodik (mis. tiap 1 detik)
+    void sample() {
+        uint16_t samples[32];
+        size_t n = _config.burstSize > 32 ? 32 : _config.burstSize;
+
+        unsigned long t0 = _clock();
+        for (size_t i = 0; i < n; i++) samples[i] = _read();
+        unsigned long t1 = _clock();
+
+        uint16_t median = medianOf(samples, n);
+        bool outlier = _ema.ready() &&
+                       fabsf((float)median - _ema.value()) > _config.maxJump &&
+                       _rejectStreak < _config.maxRejects;
+        if (outlier) {
+            _rejectStreak++;
+            _rejected++;
+        } else {
+            _rejectStreak = 0;
+            _ema.update(median);
+        }
+        unsigned long t2 = _clock();
+
+        _acquireUs = t1 - t0;
+        _filterUs = t2 - t1;
+        _bursts++;
+    }
+
+    bool ready() const { return _ema.ready(); }
+    float raw() const { return _ema.value(); }    // Nilai ADC terfilter
+    void seed(float raw) { _ema.seed(raw); }      // Lanjutkan filter setelah deep sleep
+
+    uint32_t bursts() const { return _bursts; }
+    uint32_t rejected() const { return _rejected; }
+    unsigned long acquireUs() const { return _acquireUs; }
+    unsigned long filterUs() const { return _filterUs; }
+
+private:
+    SoilSamplerConfig _config;
+    AdcRead _read;
+    MicrosClock _clock;
+    Ema _ema;
+    uint8_t _rejectStreak = 0;
+    uint32_t _bursts = 0;
+    uint32_t _rejected = 0;
+    unsigned long _acquireUs = 0;
+    unsigned long _filterUs = 0;
+};
+
+// ==================== DHT READER ====================
+
+struct ClimateReading {
+    float temperature;
+    float humidity;
+    bool cached;              // true = nilai terakhir yang valid, bukan bacaan baru
+};
+
+class DhtReader {
+public:
+    // Mengembalikan false / NaN jika sensor tidak merespons
+    typedef bool (*ReadFn)(float& temperature, float& humidity);
+    typedef unsigned long (*MillisClock)();
+    typedef void (*SleepFn)(unsigned long ms);
+
+    DhtReader(ReadFn read, MillisClock clock, SleepFn sleep,
+              uint8_t retries, unsigned long retryDelayMs, unsigned long maxCacheAgeMs)
+        : _read(read), _clock(clock), _sleep(sleep), _retries(retries),
+          _retryDelayMs(retryDelayMs), _maxCacheAgeMs(maxCacheAgeMs) {}
+
+    // false jika tidak ada bacaan baru maupun cache yang masih berlaku
+    bool read(ClimateReading& out) {
+        for (uint8_t attempt = 0; attempt <= _retries; attempt++) {
+            if (attempt > 0 && _sleep) _sleep(_retryDelayMs);
+            float t, h;
+            if (_read(t, h) && valid(t, h)) {
+                _lastTemp = t;
+                _lastHumid = h;
+                _lastGoodAt = _clock();
+                _hasGood = true;
+                out = {t, h, false};
+                return true;
+            }
+            _failures++;
+        }
+
+        if (_hasGood && _clock() - _lastGoodAt <= _maxCacheAgeMs) {
+            out = {_lastTemp, _lastHumid, true};
+            return true;
+        }
+        return false;
+    }
+
+    uint32_t failures() const { return _failures; }
+
+    // Rentang wajar DHT11/DHT22; di luar ini dianggap bacaan sampah
+    static bool valid(float t, float h) {
+        return !isnan(t) && !isnan(h) && t >= -10 && t <= 60 && h >= 0 && h <= 100;
+    }
+
+private:
+    ReadFn _read;
+    MillisClock _clock;
+    SleepFn _sleep;
+    uint8_t _retries;
+    unsigned long _retryDelayMs;
+    unsigned long _maxCacheAgeMs;
+    float _lastTemp = 0;
+    float _lastHumid = 0;
+    unsigned long _lastGoodAt = 0;
+    bool _hasGood = false;
+    uint32_t _failures = 0;
+};
@@ -2,23 +2,120 @@
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
 #include <DHT.h>
+#include <time.h>
+#include "ReadingBuffer.h"
+#include "SensorPipeline.h"
+#include "DutyCycle.h"
+#include "Deadband.h"
+#include "BatchUpload.h"
+#include <new>
+
+#define HTTP_TRANSPORT_BODY_SIZE 256 // Response receive-sensor hanya status singkat
+#include <HttpTransport.h>
+#include <TelemetryCodec.h>
+#include <TelemetryJson.h>
+#include <Metrics.h>
+#include <WebServer.h>
+#include <AsyncLog.h> // LOG_E/W/I/D; level lewat -DLOG_LEVEL, -DLOG_TO_UART=0 untuk /log saja
+#include <WifiManager.h>
+#include <LocalLink.h>
+#include <NodeId.h>
+#include <EspOta.h>
+
+// Format upload: 0 = JSON, 1 = biner ringkas (TelemetryCodec, 9 byte/pembacaan)
+// Aktifkan lewat build_flags: -DTELEMETRY_BINARY=1
+#ifndef TELEMETRY_BINARY
+#define TELEMETRY_BINARY 0
+#endif
+
+// Simpan buffer ke flash (LittleFS) saat RAM penuh; isi flash (lebih tua)
+// di-upload lebih dulu daripada isi RAM.
+// Aktifkan lewat build_flags: -DENABLE_FLASH_SPILL=1
+#ifndef ENABLE_FLASH_SPILL
+#define ENABLE_FLASH_SPILL 0
+#endif
+
+#if ENABLE_FLASH_SPILL
+#include <LittleFS.h>
+#endif
+
+// Profiling hot path: latensi & pertumbuhan heap per fungsi, stack loopTask.
+// Laporan JSON (awalan "PROFILE ") tiap 1 menit di log.
+// Aktifkan lewat build_flags: -DENABLE_PROFILING=1
+#ifndef ENABLE_PROFILING
+#define ENABLE_PROFILING 0
+#endif
+#include <Profiler.h>
+
+// Mode deep sleep untuk baterai/surya: bangun tiap SENSOR_SAMPLE_INTERVAL,
+// satu pembacaan terfilter ke buffer RTC, WiFi hanya saat batch penuh atau
+// nilai berubah melewati ambang (DutyCycle.h). loop() tidak pernah berjalan;
+// server metrics tidak aktif. Aktifkan lewat build_flags: -DSENSOR_DEEP_SLEEP=1
+#ifndef SENSOR_DEEP_SLEEP
+#define SENSOR_DEEP_SLEEP 0
+#endif
+
+#if SENSOR_DEEP_SLEEP
+#include <esp_sleep.h>
+#endif
 
 // =================================================================
 // 0. FUNCTION PROTOTYPES
 // =================================================================
-void setupWiFi();
-void sendSensorData();
+void onWifiEvent(WifiStateMachine::Event event, unsigned long value, void* ctx);
+void sampleSensors();
+bool sendSensorData();
+#if ENABLE_PROFILING
+void printProfile();
+#endif
+void setupMetrics();
+void setupNodeIdentity();
+#if SENSOR_DEEP_SLEEP
+void runDutyCycle();
+#endif
+void traceEvent(uint16_t code, int16_t arg = 0, int32_t value = 0);
+void checkFirmwareUpdate();
+void stepFirmwareUpdate();
+void checkFirmwareHealth(bool healthy);
 
 // =================================================================
 // 1. KONFIGURASI JARINGAN & SERVER
 // =================================================================
 const char* ssid = "Galaxy A33 5G D004"; 
 const char* password = "gahya123";      
-const char* apiHost = "10.163.159.210";   // Pastikan ini IP Laptop kamu
-const int apiPort = 8000;                // Laravel default port adalah 8000
+// Per node lewat build_flags: -DAPI_HOST=\"10.0.0.5\" -DAPI_PORT=8000
+#ifndef API_HOST
+#define API_HOST "10.163.159.210"
+#endif
+#ifndef API_PORT
+#define API_PORT 8000
+#endif
+const char* apiHost = API_HOST;   // Pastikan ini IP Laptop kamu
+const int apiPort = API_PORT;     // Laravel default port adalah 8000
+
+// Endpoint per node /api/nodes/<id>/telemetry (id = MAC, NodeId.h) agar
+// beberapa pasangan node bisa memakai satu server. 0 = endpoint global.
+#ifndef NODE_SCOPED_API
+#define NODE_SCOPED_API 0
+#endif
+
+// Versi firmware ini, dibandingkan dengan manifest OTA dari server.
+// Naikkan setiap rilis: -DFIRMWARE_VERSION=\"1.1.0\"
+#ifndef FIRMWARE_VERSION
+#define FIRMWARE_VERSION "1.0.0"
+#endif
 
 // Endpoint Laravel API
 const char* apiReceiveSensorEndpoint = "/api/receive-sensor";
+char apiReceiveSensorBatchEndpoint[48] = "/api/receive-sensor/batch"; // Diisi ulang oleh setupNodeIdentity()
+char apiFirmwareEndpoint[64] = "/api/firmware/prokon-sensor?version=" FIRMWARE_VERSION; // Manifest OTA
+char nodeId[NODE_ID_SIZE] = "";
+
+const char* ntpServer = "id.pool.ntp.org"; // Timestamp pembacaan dalam UTC
+
+HttpTransport api; // Koneksi keep-alive ke server Laravel
+WifiManager wifi;  // Reconnect di latar dengan backoff, tanpa restart
+LocalLink localLink; // Setiap sampel langsung ke control node (UDP multicast), tanpa server
 
 // =================================================================
 // 2. KONFIGURASI PIN HARDWARE
@@ -32,41 +129,260 @@ DHT dht(DHT_PIN, DHT_TYPE);
 // =================================================================
 // 3. KONFIGURASI INTERVAL & KALIBRASI
 // =================================================================
-const long SENSOR_REPORT_INTERVAL = 30000; // Testing: kirim setiap 30 detik
-unsigned long lastSensorReport = 0;
+const long SENSOR_SAMPLE_INTERVAL = 30000;  // Ambil sampel setiap 30 detik
+const long UPLOAD_INTERVAL = 300000;        // Upload batch setiap 5 menit
+const long UPLOAD_RETRY_INTERVAL = 60000;   // Jeda ulang jika upload gagal
+const int UPLOAD_BATCH_SIZE = 20;           // Maks. pembacaan per POST
+const int MAX_BATCHES_PER_CYCLE = 5;        // Batas drain backlog per putaran loop
+
+// Deadband: sampel masuk buffer hanya jika suhu bergeser > 1 °C, kelembapan
+// > 5%RH (resolusi/akurasi DHT11) atau soil > 2% dari pembacaan terakhir yang
+// dikirim, dan paling lambat setelah 19 sampel ditahan (heartbeat 10 menit).
+// {0, 0, 0, 0} = kirim semua sampel seperti sebelumnya.
+const DeadbandConfig DEADBAND_CONFIG = {10, 50, 2, 19};
+const long SOIL_BURST_INTERVAL = 1000;      // Oversampling ADC soil setiap 1 detik
+unsigned long lastSensorSample = 0;
+unsigned long lastSoilBurst = 0;
+unsigned long nextUploadAt = 0;
+
+// Update OTA: manifest dicek tiap jam (deep sleep: tiap 12 siklus upload),
+// unduhan berjalan per potongan di loop(). Image baru dikonfirmasi setelah
+// upload pertama berhasil; tanpa itu rollback setelah batas boot/waktu.
+// Di mode deep sleep setiap bangun dihitung sebagai boot.
+const unsigned long OTA_CHECK_INTERVAL_MS = 3600000UL;
+const uint32_t OTA_CHECK_EVERY_UPLOADS = 12;
+const unsigned long OTA_HEALTH_CHECK_MS = 10000UL;
+const unsigned long OTA_HEALTH_TIMEOUT_MS = 600000UL;
+#if SENSOR_DEEP_SLEEP
+const uint8_t OTA_TRIAL_MAX_BOOTS = 10;
+#else
+const uint8_t OTA_TRIAL_MAX_BOOTS = 3;
+#endif
+EspOtaClient ota;
+EspOtaTrial otaTrial(OTA_TRIAL_MAX_BOOTS, OTA_HEALTH_TIMEOUT_MS);
+unsigned long lastFirmwareCheck = 0;
+unsigned long lastHealthCheck = 0;
+bool otaRestartPending = false;             // Image baru siap, restart setelah buffer terkirim
+
+#if ENABLE_PROFILING
+const long PROFILE_REPORT_INTERVAL = 60000;
+unsigned long lastProfileReport = 0;
+ProfileProbe profileSoilBurst("sampleSoil");
+ProfileProbe profileSample("sampleSensors");
+ProfileProbe profileUpload("sendSensorData");
+#endif
+
+#if SENSOR_DEEP_SLEEP
+// Buffer di RTC slow memory (8 KB, bertahan saat deep sleep): 120 x 12 byte =
+// 1.4 KB, 1 jam tanpa koneksi. Dikonstruksi hanya saat cold boot
+// (runDutyCycle), konstruktor global akan mengosongkannya setiap bangun.
+#define READING_BUFFER_CAPACITY 120
+typedef ReadingBuffer<READING_BUFFER_CAPACITY> SensorReadingBuffer;
+RTC_DATA_ATTR uint8_t rtcReadingStorage[sizeof(SensorReadingBuffer)] __attribute__((aligned(4)));
+SensorReadingBuffer& readings = *reinterpret_cast<SensorReadingBuffer*>(rtcReadingStorage);
+
+// Ambang upload: soil 5%, suhu 2 °C, kelembapan 10%RH (tidak lebih kecil dari
+// akurasi DHT11, agar noise tidak menyalakan WiFi); jeda WiFi maks. 16 siklus setelah gagal
+const DutyCycleConfig DUTY_CYCLE_CONFIG = {SENSOR_SAMPLE_INTERVAL, 1000, UPLOAD_BATCH_SIZE, 5, 20, 100, 16};
+const uint8_t DUTY_SOIL_BURSTS = 4;                 // Burst soil per bangun (EMA lanjut dari RTC)
+const unsigned long DUTY_WIFI_TIMEOUT_MS = 10000;   // Batas tunggu WiFi per siklus upload
+const unsigned long DUTY_NTP_WAIT_MS = 3000;        // Hanya sampai jam RTC pertama kali tersinkron
+DutyCyclePolicy dutyPolicy(DUTY_CYCLE_CONFIG);
+RTC_DATA_ATTR DutyCycleState dutyState;
+RTC_DATA_ATTR DeadbandState deadbandState;  // Direset bersama dutyState saat cold boot
+// Naikkan jika isi RTC berubah tanpa mengubah ukuran/alamat (mis. arti field)
+const uint32_t RTC_LAYOUT_VERSION = 1;
+#else
+// Buffer pembacaan: 480 x 12 byte = ~5.6 KB, cukup untuk 4 jam tanpa koneksi
+#define READING_BUFFER_CAPACITY 480
+ReadingBuffer<READING_BUFFER_CAPACITY> readings;
+DeadbandState deadbandState;
+#endif
+DeadbandFilter deadband(DEADBAND_CONFIG);
+
+#if ENABLE_FLASH_SPILL
+const char* SPILL_FILE = "/spill.bin";
+const char* SPILL_TMP_FILE = "/spill.tmp";
+const size_t SPILL_MAX_RECORDS = 5000;      // ~60 KB di partisi LittleFS
+const uint8_t SPILL_BOOT_MARK = 0x80;       // flags: penanda boot di file, timestamp = id boot
+uint32_t spillBootId = 0;                   // Acak per boot, diisi setup()
+// File spill lebih tua dari isi RAM, jadi dikirim lebih dulu lewat batch ini
+ReadingBuffer<UPLOAD_BATCH_SIZE> spillBatch;
+#endif
+
+// Buffer payload batch (dipakai ulang setiap upload)
+#if TELEMETRY_BINARY
+uint8_t uploadBuffer[telemetryEncodedSize(UPLOAD_BATCH_SIZE, true)];
+#else
+char uploadBuffer[UPLOAD_BATCH_SIZE * 100 + 128];
+#endif
 
 // KALIBRASI SOIL MOISTURE
 // Sensor Kapasitif biasanya: Kering (nilai besar), Basah (nilai kecil)
 const int SOIL_DRY = 3500; 
 const int SOIL_WET = 1200; 
 
+// Kurva kalibrasi (raw ADC -> %). Tambahkan titik tengah hasil pengukuran
+// gravimetri jika respons sensor tidak linear.
+const CalibrationPoint SOIL_CALIBRATION[] = {
+    {SOIL_DRY, 0},
+    {SOIL_WET, 100},
+};
+const size_t SOIL_CALIBRATION_POINTS = sizeof(SOIL_CALIBRATION) / sizeof(SOIL_CALIBRATION[0]);
+
+// Filter soil: 16 sampel/burst, median, tolak lompatan > 400 count (maks. 5x berturut-turut)
+const SoilSamplerConfig SOIL_SAMPLER_CONFIG = {16, 0.2f, 400, 5};
+
+// DHT: 2x retry berjeda 1 detik, pakai nilai terakhir hingga 5 menit jika tetap gagal
+const uint8_t DHT_RETRIES = 2;
+const unsigned long DHT_RETRY_DELAY_MS = 1000;
+const unsigned long DHT_CACHE_MAX_AGE = 300000;
+
+// METRICS & TRACE: GET /metrics (Prometheus) dan GET /trace (event terakhir).
+// Selalu aktif; counter/histogram statis, dilayani dari loop().
+#define METRICS_PORT 80
+#define TRACE_EVENTS 32
+
+enum TraceCode : uint16_t {
+    TRACE_BOOT,             // arg = esp_reset_reason()
+    TRACE_WIFI_CONNECTED,   // value = lama putus (ms)
+    TRACE_WIFI_FAILED,      // value = jeda sebelum percobaan berikutnya (ms)
+    TRACE_HTTP_ERROR,       // arg = kode HTTP, value = ms
+    TRACE_UPLOAD,           // arg = jumlah pembacaan, value = byte payload
+    TRACE_DHT_FAILED,       // value = total kegagalan
+    TRACE_WIFI_LOST,
+    TRACE_OTA_START,        // arg = 1 jika patch delta, value = byte payload
+    TRACE_OTA_DONE,         // value = lama unduhan (ms)
+    TRACE_OTA_FAILED,       // value = byte payload diterima
+    TRACE_OTA_CONFIRMED,    // arg = jumlah boot trial
+    TRACE_OTA_ROLLBACK,     // arg = jumlah boot trial
+};
+const char* const TRACE_NAMES[] = {
+    "boot", "wifi_connected", "wifi_failed", "http_error", "upload", "dht_failed", "wifi_lost",
+    "ota_start", "ota_done", "ota_failed", "ota_confirmed", "ota_rollback",
+};
+
+const uint32_t HTTP_LATENCY_BOUNDS_MS[] = {10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000};
+MetricHistogram httpLatency(HTTP_LATENCY_BOUNDS_MS, sizeof(HTTP_LATENCY_BOUNDS_MS) / sizeof(HTTP_LATENCY_BOUNDS_MS[0]));
+MetricCounter httpFailures;
+MetricCounter wifiReconnects;
+MetricCounter wifiConnectFailures;
+MetricGauge wifiConnected;          // 1 saat terhubung
+MetricCounter uploadedReadings;
+MetricCounter suppressedReadings;   // Ditahan deadband
+MetricCounter localLinkFrames;      // Terkirim lewat link lokal
+MetricCounter loopIterations;
+MetricGauge bufferedReadings;       // Gauge diisi saat /metrics dibaca
+MetricGauge droppedReadings;
+MetricGauge dhtFailures;
+MetricGauge heapFree;
+MetricGauge heapMinFree;
+MetricGauge uptimeSeconds;
+MetricGauge logDroppedLines;
+MetricGauge otaUpdates;
+MetricGauge otaFailures;
+MetricGauge otaProgressPct;
+MetricGauge otaTrialPending;
+
+MetricsRegistry metrics;
+TraceRing<TRACE_EVENTS> trace;
+WebServer metricsServer(METRICS_PORT);
+
 // =================================================================
 // 4. SETUP & LOOP
 // =================================================================
 
 void setup() {
     Serial.begin(115200); // Baudrate standar ESP32
-    
+    asyncLog().begin(Serial); // LOG_* di-drain oleh task "log", loop() tidak menunggu UART
+    if (otaTrial.begin() == OtaTrial::TRIAL) { // Crash loop di image baru = rollback di sini
+        LOG_W("🧪 Firmware %s dalam boot trial (boot ke-%u).", FIRMWARE_VERSION, otaTrial.boots());
+    }
+
     dht.begin();
     pinMode(SOIL_PIN, INPUT); 
 
-    setupWiFi(); 
-    
-    // Kirim data pertama kali saat startup
-    if (WiFi.status() == WL_CONNECTED) {
-        sendSensorData();
+#if ENABLE_FLASH_SPILL
+    if (!LittleFS.begin(true)) {
+        LOG_W("⚠️ LittleFS gagal di-mount, spill ke flash nonaktif.");
     }
+    spillBootId = esp_random() | 1; // Tidak pernah 0 (= file tanpa penanda)
+#endif
+
+#if SENSOR_DEEP_SLEEP
+    runDutyCycle(); // Tidak kembali: diakhiri esp_deep_sleep_start()
+#endif
+
+    traceEvent(TRACE_BOOT, esp_reset_reason());
+    LOG_I("📦 Firmware %s", FIRMWARE_VERSION);
+    LOG_I("Connecting to %s ...", ssid);
+    wifi.onEvent(onWifiEvent);
+    wifi.begin(ssid, password); // Tidak menunggu; sampling langsung berjalan
+    setupNodeIdentity();
+    api.begin(apiHost, apiPort);
+    ota.begin(apiHost, apiPort, nodeId);
+    setupMetrics();
+    configTime(0, 0, ntpServer);
+
+    // Ambil sampel pertama kali saat startup
+    sampleSensors();
+    lastSensorSample = millis();
+    nextUploadAt = millis();
 }
 
 void loop() {
-    if (WiFi.status() != WL_CONNECTED) {
-        setupWiFi(); 
-        return;
+    loopIterations.inc();
+
+    if (millis() - lastSoilBurst >= SOIL_BURST_INTERVAL) {
+        sampleSoil();
+        lastSoilBurst = millis();
     }
 
-    if (millis() - lastSensorReport >= SENSOR_REPORT_INTERVAL) {
-        sendSensorData(); 
-        lastSensorReport = millis();
+    // Sampling tetap berjalan walau WiFi/server mati; data ditampung di buffer
+    if (millis() - lastSensorSample >= SENSOR_SAMPLE_INTERVAL) {
+        sampleSensors();
+        lastSensorSample = millis();
+    }
+
+#if ENABLE_PROFILING
+    if (millis() - lastProfileReport >= PROFILE_REPORT_INTERVAL) {
+        printProfile();
+        lastProfileReport = millis();
+    }
+#endif
+
+    // Health check boot trial juga saat WiFi putus (batas waktu tetap berjalan)
+    if (otaTrial.pending() && millis() - lastHealthCheck >= OTA_HEALTH_CHECK_MS) {
+        checkFirmwareHealth(wifi.connected() && uploadedReadings.value() > 0);
+        lastHealthCheck = millis();
+    }
+
+    wifi.update(); // Timeout/backoff reconnect, tanpa menunggu
+    if (!wifi.connected()) return;
+    metricsServer.handleClient();
+
+    if (ota.status() == OtaClient::RUNNING) {
+        stepFirmwareUpdate(); // Paling banyak OTA_STEP_BYTES per putaran, tanpa menunggu
+    } else if (millis() - lastFirmwareCheck >= OTA_CHECK_INTERVAL_MS) {
+        checkFirmwareUpdate();
+        lastFirmwareCheck = millis();
+    }
+
+    bool batchReady = readings.size() >= UPLOAD_BATCH_SIZE;
+    if (!readings.empty() && (batchReady || (long)(millis() - nextUploadAt) >= 0)) {
+        // Kuras backlog beberapa batch sekaligus setelah gangguan koneksi
+        bool ok = true;
+        for (int i = 0; i < MAX_BATCHES_PER_CYCLE && ok && !readings.empty(); i++) {
+            ok = sendSensorData();
+        }
+        nextUploadAt = millis() + (ok ? UPLOAD_INTERVAL : UPLOAD_RETRY_INTERVAL);
+    }
+
+    // Restart ke firmware baru setelah semua pembacaan di buffer terkirim
+    if (otaRestartPending && readings.empty()) {
+        LOG_I("🔄 Restart ke firmware baru...");
+        asyncLog().flush();
+        ESP.restart();
     }
 }
 
@@ -74,81 +390,585 @@ void loop() {
 // 5. FUNGSI WiFi 
 // =================================================================
 
-void setupWiFi() {
-    Serial.printf("\nConnecting to %s ", ssid);
-    WiFi.begin(ssid, password);
-    
-    int attempts = 0;
-    while (WiFi.status() != WL_CONNECTED && attempts < 20) { 
-        delay(500); 
-        Serial.print(".");
-        attempts++;
-    }
-    
-    if (WiFi.status() == WL_CONNECTED) {
-        Serial.println("\n✅ WiFi Connected!");
-        Serial.print("IP ESP32: ");
-        Serial.println(WiFi.localIP());
+// Dipanggil dari wifi.update() di loop(). AP mati tidak lagi memicu restart:
+// pembacaan tetap ditampung di buffer sampai koneksi kembali.
+void onWifiEvent(WifiStateMachine::Event event, unsigned long value, void* ctx) {
+    if (event == WifiStateMachine::CONNECTED_EVENT) {
+        wifiReconnects.inc();
+        wifiConnected.set(1);
+        traceEvent(TRACE_WIFI_CONNECTED, 0, value);
+        LOG_I("✅ WiFi Connected! IP ESP32: %s (down %lu ms)", WiFi.localIP().toString().c_str(), value);
+    } else if (event == WifiStateMachine::DISCONNECTED_EVENT) {
+        wifiConnected.set(0);
+        api.reset();
+        traceEvent(TRACE_WIFI_LOST);
+        LOG_W("⚠️ WiFi lost, reconnecting in background...");
     } else {
-        Serial.println("\n❌ WiFi Failed. Restarting...");
-        delay(3000);
-        ESP.restart(); 
+        wifiConnectFailures.inc();
+        traceEvent(TRACE_WIFI_FAILED, 0, value);
+        LOG_E("❌ WiFi Failed. Retrying in %lu ms", value);
     }
 }
 
+// ID node dari MAC STA (dipakai control node: -DPAIRED_SENSOR_ID), endpoint
+// per node jika NODE_SCOPED_API. Dipanggil setelah wifi.begin() (mode STA aktif).
+void setupNodeIdentity() {
+    uint8_t mac[NODE_MAC_SIZE];
+    WiFi.macAddress(mac);
+    nodeIdFromMac(mac, nodeId);
+#if NODE_SCOPED_API
+    nodePath(apiReceiveSensorBatchEndpoint, sizeof(apiReceiveSensorBatchEndpoint), nodeId, "/telemetry");
+    nodePath(apiFirmwareEndpoint, sizeof(apiFirmwareEndpoint), nodeId, "/firmware?version=" FIRMWARE_VERSION);
+#endif
+    api.setNodeId(nodeId);
+    localLink.begin(mac); // Frame link lokal membawa MAC ini
+    LOG_I("🆔 Node ID: %s", nodeId);
+}
+
 // =================================================================
-// 6. FUNGSI KIRIM DATA SENSOR
+// 6. FUNGSI SAMPLING & BUFFER
 // =================================================================
 
-void sendSensorData() {
-    if (WiFi.status() != WL_CONNECTED) return; 
+#if ENABLE_FLASH_SPILL
+// Posisi di file spill setelah satu record batch
+struct SpillPos {
+    size_t end;         // Offset file setelah record
+    uint32_t boot;      // Id boot yang menulis record
+};
+
+// Pindahkan seluruh isi buffer RAM ke file spill (append), diawali penanda
+// boot agar timestamp millis() bisa dinilai saat dibaca kembali
+void spillToFlash() {
+    if (readings.empty()) return;
+
+    File file = LittleFS.open(SPILL_FILE, FILE_APPEND);
+    if (!file) return;
+
+    if (file.size() / sizeof(SensorReading) + readings.size() + 1 > SPILL_MAX_RECORDS) {
+        LOG_W("⚠️ File spill penuh, pembacaan tertua di RAM akan ditimpa.");
+        file.close();
+        return;
+    }
+
+    SensorReading mark = {spillBootId, 0, 0, 0, SPILL_BOOT_MARK, 0, 0};
+    file.write((const uint8_t*)&mark, sizeof(mark));
+    size_t count = readings.size();
+    for (size_t i = 0; i < count; i++) {
+        file.write((const uint8_t*)&readings.at(i), sizeof(SensorReading));
+    }
+    file.close();
+    readings.pop(count);
+    LOG_I("💾 %u pembacaan dipindah ke flash\n", (unsigned)count);
+}
+
+// Muat record tertua file spill ke spillBatch. Timestamp millis() dari boot
+// lain tidak lagi bermakna (dinolkan); dari boot ini tetap dipakai.
+bool loadSpillBatch(SpillPos pos[]) {
+    spillBatch.pop(spillBatch.size());
+    if (!LittleFS.exists(SPILL_FILE)) return false;
+
+    File file = LittleFS.open(SPILL_FILE, FILE_READ);
+    if (!file) return false;
+
+    uint32_t boot = 0; // File tanpa penanda = boot sebelumnya
+    SensorReading r;
+    while (!spillBatch.full() && file.read((uint8_t*)&r, sizeof(r)) == sizeof(r)) {
+        if (r.flags & SPILL_BOOT_MARK) {
+            boot = r.timestamp;
+            continue;
+        }
+        if (!(r.flags & SensorReading::TS_EPOCH) && boot != spillBootId) r.timestamp = 0;
+        pos[spillBatch.size()] = {file.position(), boot};
+        spillBatch.push(r);
+    }
+    file.close();
+    if (spillBatch.empty()) LittleFS.remove(SPILL_FILE); // Hanya penanda / record terpotong
+    return !spillBatch.empty();
+}
+
+// Buang record yang sudah terkirim dari awal file spill. Sisa record ditulis
+// ulang ke file baru, diawali penanda boot record pertamanya.
+void dropSpill(const SpillPos& cut) {
+    File file = LittleFS.open(SPILL_FILE, FILE_READ);
+    if (!file) return;
+
+    file.seek(cut.end);
+    if (file.available() < (int)sizeof(SensorReading)) {
+        file.close();
+        LittleFS.remove(SPILL_FILE);
+        return;
+    }
 
-    // Baca Sensor
-    float t = dht.readTemperature(); 
-    float h = dht.readHumidity();    
-    int soil_analog = analogRead(SOIL_PIN); 
-    
-    // Konversi ke persen
-    float soil_percent = map(soil_analog, SOIL_DRY, SOIL_WET, 0, 100);
-    soil_percent = constrain(soil_percent, 0, 100); 
-    
-    // VALIDASI PEMBACAAN DHT (DIUBAH DI SINI)
-    // nan = Not a Number (sensor tidak terdeteksi)
-    // t < -10 atau t > 60 = Filter untuk pembacaan sampah/error
-    if (isnan(h) || isnan(t) || t < -10 || t > 60) {
-        Serial.printf("❌ DHT Error! Bacaan: T=%.1f H=%.1f (Data tidak dikirim)\n", t, h);
-        return; 
+    File rest = LittleFS.open(SPILL_TMP_FILE, FILE_WRITE);
+    SensorReading mark = {cut.boot, 0, 0, 0, SPILL_BOOT_MARK, 0, 0};
+    if (rest) rest.write((const uint8_t*)&mark, sizeof(mark));
+    uint8_t chunk[sizeof(SensorReading) * 16];
+    int n;
+    while (rest && (n = file.read(chunk, sizeof(chunk))) > 0) {
+        rest.write(chunk, n);
     }
+    rest.close();
+    file.close();
+    LittleFS.remove(SPILL_FILE);
+    LittleFS.rename(SPILL_TMP_FILE, SPILL_FILE);
+}
+#endif
+
+// Waktu epoch (UTC) jika NTP sudah sinkron, 0 jika belum
+time_t epochNow() {
+    time_t now = time(nullptr);
+    return now > 1600000000 ? now : 0;
+}
 
-    HTTPClient http;
-    String url = "http://" + String(apiHost) + ":" + String(apiPort) + String(apiReceiveSensorEndpoint);
-    
-    JsonDocument doc; 
-    doc["temp"] = t;
-    doc["humid"] = h;
-    doc["soil"] = (int)soil_percent; 
+// Adapter hardware untuk SensorPipeline
+uint16_t readSoilAdc() {
+    return analogRead(SOIL_PIN);
+}
+
+bool readDht(float& t, float& h) {
+    t = dht.readTemperature(false, true); // force: jangan pakai cache 2 detik library
+    h = dht.readHumidity(false);
+    return !isnan(t) && !isnan(h);
+}
+
+void sleepMs(unsigned long ms) {
+    delay(ms);
+}
+
+SoilSampler soilSampler(SOIL_SAMPLER_CONFIG, readSoilAdc, micros);
+DhtReader dhtReader(readDht, millis, sleepMs, DHT_RETRIES, DHT_RETRY_DELAY_MS, DHT_CACHE_MAX_AGE);
+
+// Satu burst oversampling ADC soil (dipanggil tiap SOIL_BURST_INTERVAL)
+void sampleSoil() {
+    PROFILE_SCOPE(profileSoilBurst, micros);
+    soilSampler.sample();
+}
 
-    String payload;
-    serializeJson(doc, payload);
+void sampleSensors() {
+    PROFILE_SCOPE_HEAP(profileSample, micros, esp_get_free_heap_size);
 
-    http.begin(url);
-    http.addHeader("Content-Type", "application/json");
-    
-    Serial.print("⬆️ Sending to Laravel: ");
-    Serial.println(payload);
+    // Tahap 1: DHT dengan retry, fallback ke nilai valid terakhir
+    unsigned long t0 = micros();
+    ClimateReading climate;
+    bool climateOk = dhtReader.read(climate);
+    unsigned long t1 = micros();
 
-    http.addHeader("Content-Type", "application/json");
+    // Tahap 2: soil terfilter (EMA dari burst) -> kurva kalibrasi
+    if (!soilSampler.ready()) soilSampler.sample();
+    float soil_percent = applyCalibration(SOIL_CALIBRATION, SOIL_CALIBRATION_POINTS, soilSampler.raw());
+    unsigned long t2 = micros();
+
+    if (!climateOk) {
+        deadband.markGap(deadbandState);
+        traceEvent(TRACE_DHT_FAILED, 0, dhtReader.failures());
+        LOG_E("❌ DHT Error! %lu kegagalan, cache kedaluwarsa (Data tidak disimpan)\n",
+                      (unsigned long)dhtReader.failures());
+        return;
+    }
+
+    SensorReading reading = {};
+    time_t epoch = epochNow();
+    if (epoch) {
+        reading.timestamp = (uint32_t)epoch;
+        reading.flags |= SensorReading::TS_EPOCH;
+    } else {
+        // millis() mulai dari 0 setiap bangun dari deep sleep: biarkan 0
+        // (server memakai waktu terima) sampai jam RTC tersinkron NTP
+        reading.timestamp = SENSOR_DEEP_SLEEP ? 0 : millis();
+    }
+    if (climate.cached) reading.flags |= SensorReading::DHT_CACHED;
+    reading.tempX10 = (int16_t)lroundf(climate.temperature * 10);
+    reading.humidX10 = (uint16_t)lroundf(climate.humidity * 10);
+    reading.soil = (uint8_t)lroundf(soil_percent);
+
+    // Link lokal menerima setiap sampel (tidak disimpan di mana pun, jadi
+    // tidak dikenai deadband); gagal diam-diam saat WiFi putus
+    TelemetryRecord local = {epoch ? (uint32_t)epoch : 0, reading.tempX10, reading.humidX10, reading.soil, 0};
+    if (localLink.send(local)) localLinkFrames.inc();
+
+    if (!deadband.admit(deadbandState, reading)) {
+        suppressedReadings.inc();
+        LOG_D("📏 T=%.1f H=%.1f Soil=%.1f%% dalam deadband (%u sampel ditahan)\n",
+                      climate.temperature, climate.humidity, soil_percent, (unsigned)deadbandState.silent);
+        return;
+    }
+
+#if ENABLE_FLASH_SPILL
+    if (readings.full()) spillToFlash();
+#endif
+    readings.push(reading);
+
+    LOG_I("📏 T=%.1f H=%.1f%s Soil=%.1f%% (raw %.0f) (buffer %u/%u, hilang %lu)\n",
+                  climate.temperature, climate.humidity, climate.cached ? " [cache]" : "",
+                  soil_percent, soilSampler.raw(), (unsigned)readings.size(),
+                  (unsigned)readings.capacity(), (unsigned long)readings.dropped());
+    LOG_D("⏱️ Soil akuisisi %lu us, filter %lu us (%lu burst, %lu outlier) | DHT %lu us | kalibrasi %lu us\n",
+                  soilSampler.acquireUs(), soilSampler.filterUs(),
+                  (unsigned long)soilSampler.bursts(), (unsigned long)soilSampler.rejected(),
+                  t1 - t0, t2 - t1);
+}
+
+// =================================================================
+// 7. FUNGSI KIRIM DATA SENSOR (BATCH)
+// =================================================================
+
+// Kirim body batch ke Laravel (callback BatchUpload.h)
+int postBatch(const uint8_t* body, size_t length, size_t count, void* ctx) {
+    LOG_I("⬆️ Sending %u readings to Laravel (%u bytes)\n", (unsigned)count, (unsigned)length);
+
+#if TELEMETRY_BINARY
+    const char* contentType = TELEMETRY_CONTENT_TYPE;
+#else
+    const char* contentType = "application/json";
+#endif
+    int httpResponseCode = api.post(apiReceiveSensorBatchEndpoint, contentType, body, length);
 
-    int httpResponseCode = http.POST(payload);
-    
     if (httpResponseCode > 0) {
-        Serial.printf("✅ Response: %d\n", httpResponseCode);
-        if(httpResponseCode == 200) {
-             Serial.println("   Data saved successfully!");
+        api.readBody(); // Kosongkan body agar socket bisa dipakai ulang
+        LOG_I("%s Response: %d\n", httpResponseCode >= 200 && httpResponseCode < 300 ? "✅" : "❌",
+              httpResponseCode);
+    } else {
+        LOG_E("❌ Error: %s\n", HTTPClient::errorToString(httpResponseCode).c_str());
+    }
+
+    api.end();
+    return httpResponseCode;
+}
+
+// Upload satu batch pembacaan tertua. Record baru dibuang dari buffer
+// setelah server mengonfirmasi (2xx), sehingga kegagalan tidak menghilangkan data.
+bool sendSensorData() {
+    if (!wifi.connected()) return false;
+    PROFILE_SCOPE_HEAP(profileUpload, micros, esp_get_free_heap_size);
+
+#if TELEMETRY_BINARY
+    TelemetryEncoder encoder(uploadBuffer, sizeof(uploadBuffer)); // Format TelemetryCodec v2
+#else
+    TelemetryJsonEncoder encoder(uploadBuffer, sizeof(uploadBuffer)); // Lihat TelemetryJson.h
+    encoder.setNode(nodeId);
+#endif
+    encoder.setDeadband(deadbandInfo(deadband.config(), SENSOR_SAMPLE_INTERVAL));
+    BatchUploadResult batch;
+#if ENABLE_FLASH_SPILL
+    SpillPos spillPos[UPLOAD_BATCH_SIZE];
+    if (loadSpillBatch(spillPos)) {
+        // Backlog di flash lebih dulu agar server menerima pembacaan berurutan
+        batch = uploadBatch(spillBatch, encoder, uploadBuffer, UPLOAD_BATCH_SIZE, (uint32_t)epochNow(),
+                            millis(), postBatch, nullptr, micros);
+        if (batch.ok && batch.count > 0) dropSpill(spillPos[batch.count - 1]);
+    } else
+#endif
+    {
+        if (readings.empty()) return true;
+        batch = uploadBatch(readings, encoder, uploadBuffer, UPLOAD_BATCH_SIZE, (uint32_t)epochNow(), millis(),
+                            postBatch, nullptr, micros);
+    }
+
+    if (batch.ok) {
+        uploadedReadings.inc(batch.count);
+        traceEvent(TRACE_UPLOAD, batch.count, batch.length);
+        LOG_I("   %u readings saved, %u pending (encode %lu us)\n", (unsigned)batch.count,
+                      (unsigned)readings.size(), batch.encodeUs);
+    }
+    if (LOG_ENABLED(LOG_LEVEL_DEBUG)) api.printStats(asyncLog());
+    return batch.ok;
+}
+
+#if ENABLE_PROFILING
+// =================================================================
+// 8. PROFILING
+// =================================================================
+
+// Satu baris JSON per probe + satu baris heap/stack; ambil dengan
+// `grep '^PROFILE '` dari log serial untuk dibandingkan antar versi firmware.
+void printProfile() {
+    char line[256];
+    const ProfileProbe* probes[] = {&profileSoilBurst, &profileSample, &profileUpload};
+    for (const ProfileProbe* probe : probes) {
+        probe->formatJson(line, sizeof(line), "us");
+        LOG_I("PROFILE %s\n", line);
+    }
+    LOG_I("PROFILE {\"heap_free\":%u,\"heap_min\":%u,\"heap_max_block\":%u,\"stack_free_loop\":%u}\n",
+                  ESP.getFreeHeap(), ESP.getMinFreeHeap(), ESP.getMaxAllocHeap(),
+                  (unsigned)uxTaskGetStackHighWaterMark(nullptr));
+}
+#endif
+
+// =================================================================
+// 9. METRICS & TRACE
+// =================================================================
+
+void traceEvent(uint16_t code, int16_t arg, int32_t value) {
+    trace.record(millis(), code, arg, value);
+}
+
+// Observer HttpTransport; semua request sensor node ke endpoint batch
+void onHttpRequest(const char* path, int code, uint32_t elapsedMs, void* ctx) {
+    httpLatency.observe(elapsedMs);
+    if (code < 0 || code >= 400) {
+        httpFailures.inc();
+        traceEvent(TRACE_HTTP_ERROR, code, elapsedMs);
+    }
+}
+
+void sendMetricsChunk(const char* text, size_t length, void* ctx) {
+    static_cast<WebServer*>(ctx)->sendContent(text, length);
+}
+
+void handleMetrics() {
+    bufferedReadings.set(readings.size());
+    droppedReadings.set(readings.dropped());
+    dhtFailures.set(dhtReader.failures());
+    heapFree.set(ESP.getFreeHeap());
+    heapMinFree.set(ESP.getMinFreeHeap());
+    uptimeSeconds.set(millis() / 1000);
+    logDroppedLines.set(asyncLog().droppedLines());
+    otaUpdates.set(ota.stats().updates);
+    otaFailures.set(ota.stats().failures);
+    otaProgressPct.set(ota.status() == OtaClient::RUNNING ? ota.progressPct() : -1);
+    otaTrialPending.set(otaTrial.pending());
+
+    metricsServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    metricsServer.send(200, "text/plain; version=0.0.4", "");
+    metrics.write(sendMetricsChunk, &metricsServer);
+    metricsServer.sendContent("");
+}
+
+// Satu baris per event: "<ms> <nama> <arg> <nilai>", tertua lebih dulu
+void handleTrace() {
+    metricsServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    metricsServer.send(200, "text/plain", "");
+    trace.write(sendMetricsChunk, &metricsServer, TRACE_NAMES, sizeof(TRACE_NAMES) / sizeof(TRACE_NAMES[0]));
+    metricsServer.sendContent("");
+}
+
+#if !LOG_TO_UART
+// Log terakhir dari ring AsyncLog (LOG_TO_UART=0: log tidak dikirim ke UART)
+void handleLog() {
+    metricsServer.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    metricsServer.send(200, "text/plain; charset=utf-8", "");
+    asyncLog().dump([](const char* text, size_t length) { metricsServer.sendContent(text, length); });
+    metricsServer.sendContent("");
+}
+#endif
+
+void setupMetrics() {
+    metrics.add("prokon_sensor_http_request_ms", "Waktu request HTTP sampai header response (ms)", httpLatency,
+                "endpoint=\"receive-sensor-batch\"");
+    metrics.add("prokon_sensor_http_failures_total", "Request HTTP gagal (error transport atau kode >= 400)",
+                httpFailures);
+    metrics.add("prokon_sensor_wifi_reconnects_total", "Koneksi WiFi berhasil dibuat", wifiReconnects);
+    metrics.add("prokon_sensor_wifi_connect_failures_total", "Percobaan koneksi WiFi gagal", wifiConnectFailures);
+    metrics.add("prokon_sensor_wifi_connected", "Status koneksi WiFi (1 = terhubung)", wifiConnected);
+    metrics.add("prokon_sensor_uploaded_readings_total", "Pembacaan terkonfirmasi server", uploadedReadings);
+    metrics.add("prokon_sensor_suppressed_readings_total", "Sampel tidak dikirim karena dalam deadband",
+                suppressedReadings);
+    metrics.add("prokon_sensor_local_link_frames_total", "Frame terkirim ke control node lewat link lokal",
+                localLinkFrames);
+    metrics.add("prokon_sensor_loop_iterations_total", "Iterasi loop()", loopIterations);
+    metrics.add("prokon_sensor_buffered_readings", "Pembacaan menunggu upload", bufferedReadings);
+    metrics.add("prokon_sensor_dropped_readings", "Pembacaan dibuang karena buffer penuh", droppedReadings);
+    metrics.add("prokon_sensor_dht_failures", "Kegagalan baca DHT sejak boot", dhtFailures);
+    metrics.add("prokon_sensor_heap_free_bytes", "Heap bebas", heapFree);
+    metrics.add("prokon_sensor_heap_min_free_bytes", "Heap bebas terendah sejak boot", heapMinFree);
+    metrics.add("prokon_sensor_uptime_seconds", "Waktu sejak boot", uptimeSeconds);
+    metrics.add("prokon_sensor_log_dropped_lines", "Baris log dibuang karena buffer penuh", logDroppedLines);
+    metrics.add("prokon_sensor_ota_updates", "Firmware baru terverifikasi & siap di-boot", otaUpdates);
+    metrics.add("prokon_sensor_ota_failures", "Unduhan firmware gagal (transport, hash, patch)", otaFailures);
+    metrics.add("prokon_sensor_ota_progress_percent", "Progres unduhan firmware (-1 = tidak ada)", otaProgressPct);
+    metrics.add("prokon_sensor_ota_trial", "Firmware dalam boot trial (1 = belum dikonfirmasi)", otaTrialPending);
+    if (metrics.rejected()) {
+        LOG_E("❌ %u metrik tidak terdaftar: naikkan METRICS_MAX_ENTRIES (%u, terdaftar %u).",
+              (unsigned)metrics.rejected(), (unsigned)METRICS_MAX_ENTRIES, (unsigned)metrics.size());
+    }
+
+    api.onRequest(onHttpRequest);
+    metricsServer.on("/metrics", HTTP_GET, handleMetrics);
+    metricsServer.on("/trace", HTTP_GET, handleTrace);
+#if !LOG_TO_UART
+    metricsServer.on("/log", HTTP_GET, handleLog);
+#endif
+    metricsServer.begin();
+}
+
+#if SENSOR_DEEP_SLEEP
+// =================================================================
+// 10. DEEP SLEEP (DUTY CYCLE)
+// =================================================================
+
+// Nyalakan WiFi (batas DUTY_WIFI_TIMEOUT_MS), kuras buffer, matikan lagi.
+// Menunggu di sini wajar: tidak ada pekerjaan lain sebelum tidur.
+bool uploadDutyCycle() {
+    wifi.onEvent(onWifiEvent);
+    wifi.begin(ssid, password);
+    setupNodeIdentity();
+    unsigned long start = millis();
+    while (!wifi.connected() && millis() - start < DUTY_WIFI_TIMEOUT_MS) {
+        wifi.update();
+        delay(10);
+    }
+
+    bool ok = wifi.connected();
+    if (ok) {
+        unsigned long wifiMs = millis() - start;
+        configTime(0, 0, ntpServer);
+        if (!epochNow()) {
+            struct tm timeinfo;
+            getLocalTime(&timeinfo, DUTY_NTP_WAIT_MS); // Jam RTC tetap jalan saat deep sleep
+        }
+        const SensorReading& latest = readings.at(readings.size() - 1);
+        TelemetryRecord local = {latest.flags & SensorReading::TS_EPOCH ? latest.timestamp : 0,
+                                 latest.tempX10, latest.humidX10, latest.soil, 0};
+        localLink.send(local); // Bacaan saat WiFi dinyalakan (pemicu upload) juga ke control node
+        api.begin(apiHost, apiPort);
+        for (int i = 0; i < MAX_BATCHES_PER_CYCLE && ok && !readings.empty(); i++) {
+            ok = sendSensorData();
+        }
+        LOG_I("📶 WiFi %lu ms, upload %s (%u pending)\n", wifiMs, ok ? "ok" : "gagal",
+                      (unsigned)readings.size());
+
+        // Boot trial: upload berhasil = image sehat. Cek firmware baru tiap
+        // OTA_CHECK_EVERY_UPLOADS siklus; unduhan menunggu sampai selesai.
+        if (otaTrial.pending()) checkFirmwareHealth(ok);
+        if (ok && !otaTrial.pending() && dutyState.uploads % OTA_CHECK_EVERY_UPLOADS == 0) {
+            ota.begin(apiHost, apiPort, nodeId);
+            checkFirmwareUpdate();
+            while (ota.status() == OtaClient::RUNNING) {
+                stepFirmwareUpdate();
+                delay(1);
+            }
         }
     } else {
-        Serial.printf("❌ Error: %s\n", http.errorToString(httpResponseCode).c_str());
+        LOG_W("⚠️ WiFi tidak tersambung dalam %lu ms\n", DUTY_WIFI_TIMEOUT_MS);
+    }
+
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_OFF);
+    // ESP.restart() bukan bangun dari deep sleep: buffer RTC dimulai ulang, jadi
+    // hanya saat buffer sudah kosong. Jika masih ada sisa, cukup tidur; bangun
+    // berikutnya boot dari partisi baru dan mengirim sisa buffer jika layout
+    // RTC-nya sama (rtcLayoutTag()), selain itu buffer dimulai ulang.
+    if (otaRestartPending && readings.empty()) {
+        LOG_I("🔄 Restart ke firmware baru...");
+        asyncLog().flush();
+        ESP.restart();
+    }
+    return ok;
+}
+
+// Layout data RTC image ini. Image lain (OTA) dengan struct, kapasitas atau
+// urutan variabel RTC berbeda menghasilkan tag lain.
+uint32_t rtcLayoutTag() {
+    const uint32_t words[] = {
+        RTC_LAYOUT_VERSION,
+        (uint32_t)(uintptr_t)rtcReadingStorage, (uint32_t)sizeof(rtcReadingStorage),
+        (uint32_t)(uintptr_t)&dutyState, (uint32_t)sizeof(dutyState),
+        (uint32_t)(uintptr_t)&deadbandState, (uint32_t)sizeof(deadbandState),
+        (uint32_t)sizeof(SensorReading), (uint32_t)offsetof(SensorReading, tempX10),
+        (uint32_t)offsetof(SensorReading, humidX10), (uint32_t)offsetof(SensorReading, soil),
+        (uint32_t)offsetof(SensorReading, flags), (uint32_t)offsetof(SensorReading, reason),
+        (uint32_t)offsetof(SensorReading, skipped),
+    };
+    return dutyLayoutTag(words, sizeof(words) / sizeof(words[0]));
+}
+
+// Satu siklus: bangun -> soil + DHT -> (upload) -> deep sleep
+void runDutyCycle() {
+    if (esp_reset_reason() != ESP_RST_DEEPSLEEP) dutyState.magic = 0;
+    if (DutyCyclePolicy::init(dutyState, rtcLayoutTag())) {
+        new (rtcReadingStorage) SensorReadingBuffer();
+        deadbandState = DeadbandState();
+        LOG_I("🔋 Mode deep sleep: bangun tiap %lu ms, upload per %u pembacaan atau saat berubah\n",
+                      DUTY_CYCLE_CONFIG.periodMs, DUTY_CYCLE_CONFIG.uploadBatch);
+    }
+
+    // Filter soil lanjut dari EMA sebelum tidur, beberapa burst per bangun
+    if (dutyState.soilReady) soilSampler.seed(dutyState.soilRaw);
+    for (uint8_t i = 0; i < DUTY_SOIL_BURSTS; i++) sampleSoil();
+    dutyState.soilRaw = soilSampler.raw();
+    dutyState.soilReady = soilSampler.ready();
+
+    sampleSensors();
+
+    DutyCyclePolicy::Reason reason = DutyCyclePolicy::HOLD;
+    if (!readings.empty()) {
+        SensorReading latest = readings.at(readings.size() - 1);
+        reason = dutyPolicy.decide(dutyState, latest, readings.size());
+        if (reason != DutyCyclePolicy::HOLD || otaTrial.pending()) { // Trial: upload tiap bangun
+            dutyPolicy.uploaded(dutyState, latest, uploadDutyCycle());
+        }
+    }
+
+    // Latensi bangun -> tidur (tanpa bootloader ROM, ~100-300 ms sebelum setup())
+    unsigned long awakeMs = millis();
+    dutyPolicy.finish(dutyState, awakeMs);
+    unsigned long sleepMs = dutyPolicy.sleepMs(awakeMs);
+    static const char* const REASONS[] = {"-", "batch", "berubah", "pertama"};
+    LOG_I("😴 Bangun #%lu: aktif %lu ms, upload %s, tidur %lu ms (rata-rata aktif %lu ms)\n",
+                  (unsigned long)dutyState.wakes, awakeMs, REASONS[reason], sleepMs,
+                  (unsigned long)(dutyState.awakeMsTotal / (dutyState.wakes ? dutyState.wakes : 1)));
+    asyncLog().flush();
+
+    esp_sleep_enable_timer_wakeup((uint64_t)sleepMs * 1000ULL);
+    esp_deep_sleep_start();
+}
+#endif
+
+// =================================================================
+// 11. UPDATE OTA
+// =================================================================
+
+// Cek manifest firmware; unduhan dimulai jika server menawarkan versi lain
+// dan node ini termasuk persen rollout
+void checkFirmwareUpdate() {
+    if (otaTrial.pending() || otaRestartPending) return;
+
+    OtaManifest manifest;
+    OtaClient::Check result = ota.check(apiFirmwareEndpoint, FIRMWARE_VERSION, manifest);
+    if (result == OtaClient::NOT_IN_ROLLOUT) {
+        LOG_D("ℹ️  Firmware %s tersedia, node ini belum termasuk rollout %u%%.", manifest.version,
+              manifest.rollout);
+    }
+    if (result != OtaClient::UPDATE) return;
+
+    if (!ota.start(manifest)) {
+        traceEvent(TRACE_OTA_FAILED);
+        LOG_E("❌ Update firmware %s tidak bisa dimulai (%s).", manifest.version, ota.lastError());
+        return;
+    }
+    traceEvent(TRACE_OTA_START, ota.delta(), ota.payloadSize());
+    LOG_I("⬇️  Firmware %s -> %s: mengunduh %s %lu byte.", FIRMWARE_VERSION, manifest.version,
+          ota.delta() ? "patch delta" : "image penuh", (unsigned long)ota.payloadSize());
+}
+
+void stepFirmwareUpdate() {
+    OtaClient::Status status = ota.step();
+    if (status == OtaClient::DONE) {
+        traceEvent(TRACE_OTA_DONE, 0, ota.stats().lastMs);
+        LOG_I("✅ Firmware %s terverifikasi (%lu ms), restart setelah buffer terkirim.", ota.manifest().version,
+              (unsigned long)ota.stats().lastMs);
+        otaTrial.arm();
+        otaRestartPending = true;
+        nextUploadAt = millis(); // Kuras buffer sekarang, tidak menunggu interval upload
+    } else if (status == OtaClient::FAILED) {
+        traceEvent(TRACE_OTA_FAILED, 0, ota.received());
+        LOG_E("❌ Update firmware %s gagal: %s.", ota.manifest().version, ota.lastError());
+        ota.cancel(); // Kembali IDLE, dicoba lagi pada cek berikutnya
+    }
+}
+
+// Boot trial: sehat = upload ke server berhasil sejak boot. Tidak sehat
+// sampai batas waktu = kembali ke firmware lama.
+void checkFirmwareHealth(bool healthy) {
+    OtaTrial::Verdict verdict = otaTrial.check(healthy, millis());
+    if (verdict == OtaTrial::CONFIRM) {
+        traceEvent(TRACE_OTA_CONFIRMED, otaTrial.boots());
+        LOG_I("✅ Firmware %s dikonfirmasi setelah %u boot.", FIRMWARE_VERSION, otaTrial.boots());
+        otaTrial.confirm();
+    } else if (verdict == OtaTrial::FAIL) {
+        traceEvent(TRACE_OTA_ROLLBACK, otaTrial.boots());
+        LOG_E("❌ Firmware %s tidak lulus health check, kembali ke firmware lama.", FIRMWARE_VERSION);
+        asyncLog().flush();
+        otaTrial.rollback(); // Tidak kembali
     }
-    
-    http.end();
 }
\ No newline at end of file
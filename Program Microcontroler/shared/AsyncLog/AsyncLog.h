@@ -0,0 +1,207 @@
+/*
+ * AsyncLog - Log Serial non-blocking dengan level saat kompilasi
+ *
+ *   LOG_E / LOG_W / LOG_I / LOG_D (format printf, satu baris per panggilan)
+ *
+ * Level di bawah LOG_LEVEL hilang saat kompilasi (argumen tidak dievaluasi).
+ * Baris diformat di stack pemanggil lalu disalin ke LogRing statis dalam
+ * critical section singkat; task drain berprioritas rendah menulisnya ke
+ * UART. Task jaringan/valve tidak pernah menunggu UART yang penuh. Jika ring
+ * penuh, baris baru dibuang dan jumlahnya dilaporkan oleh task drain.
+ *
+ * LOG_TO_UART 0: log tidak dikirim ke UART sama sekali; ring menyimpan
+ * ASYNC_LOG_RING_SIZE byte log terakhir (baris lama ditimpa) untuk dibaca
+ * lewat endpoint metrics (GET /log).
+ *
+ * Build flags:
+ *   -DLOG_LEVEL=LOG_LEVEL_DEBUG   (default INFO)
+ *   -DLOG_TO_UART=0               (default 1)
+ *   -DASYNC_LOG_RING_SIZE=8192    (default 4096)
+ */
+#pragma once
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include "LogRing.h"
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#ifndef LOG_TO_UART
+#define LOG_TO_UART 1
+#endif
+
+#ifndef ASYNC_LOG_RING_SIZE
+#define ASYNC_LOG_RING_SIZE 4096
+#endif
+
+#define ASYNC_LOG_LINE_MAX 192
+#define ASYNC_LOG_TASK_STACK 2560
+#define ASYNC_LOG_TASK_PRIORITY 1
+
+class AsyncLog : public Print {
+public:
+    AsyncLog() : _ring(!LOG_TO_UART) {}
+
+    // Mulai task drain ke `out` (biasanya Serial). Baris yang ditulis sebelum
+    // begin() tetap di ring dan dikirim setelah task berjalan.
+    void begin(Print& out) {
+        _out = &out;
+#if LOG_TO_UART
+        if (!_task) {
+            xTaskCreate(drainTask, "log", ASYNC_LOG_TASK_STACK, this, ASYNC_LOG_TASK_PRIORITY, &_task);
+        }
+#endif
+    }
+
+    void logf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char line[ASYNC_LOG_LINE_MAX];
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(line, sizeof(line), format, args);
+        va_end(args);
+        if (n < 0) return;
+
+        size_t length = (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1;
+        if (length == 0 || line[length - 1] != '\n') {
+            if (length == sizeof(line) - 1) length--; // Baris terpotong: ganti karakter terakhir
+            line[length++] = '\n';
+        }
+        append(line, length);
+    }
+
+    // Print: untuk fungsi yang menulis ke Print& (mis. HttpTransport::printStats).
+    // Setiap panggilan write dianggap satu potongan utuh.
+    size_t write(uint8_t c) override {
+        char ch = (char)c;
+        append(&ch, 1);
+        return 1;
+    }
+
+    size_t write(const uint8_t* data, size_t size) override {
+        return append((const char*)data, size) ? size : 0;
+    }
+
+    // Salin isi ring ke sink per potongan (untuk GET /log). Aman dipanggil
+    // saat task lain menulis; data yang tertimpa di tengah jalan dilewati.
+    template <typename Sink>
+    void dump(Sink sink) {
+        char chunk[128];
+        portENTER_CRITICAL(&_lock);
+        uint32_t pos = _ring.tail();
+        portEXIT_CRITICAL(&_lock);
+        for (;;) {
+            portENTER_CRITICAL(&_lock);
+            size_t n = _ring.read(pos, chunk, sizeof(chunk));
+            portEXIT_CRITICAL(&_lock);
+            if (n == 0) break;
+            sink(chunk, n);
+        }
+    }
+
+    // Tunggu task drain mengosongkan ring (mis. sebelum deep sleep/restart).
+    // false jika masih ada sisa setelah timeout.
+    bool flush(unsigned long timeoutMs = 200) {
+#if LOG_TO_UART
+        unsigned long start = millis();
+        while (_task && !_ring.empty() && millis() - start < timeoutMs) {
+            xTaskNotifyGive(_task);
+            delay(1);
+        }
+        if (_out) _out->flush();
+        return _ring.empty();
+#else
+        return true;
+#endif
+    }
+
+    uint32_t droppedLines() const { return _ring.droppedLines(); }
+    uint32_t overwrittenLines() const { return _ring.overwrittenLines(); }
+
+private:
+    bool append(const char* data, size_t length) {
+        portENTER_CRITICAL(&_lock);
+        bool ok = _ring.write(data, length);
+        portEXIT_CRITICAL(&_lock);
+        if (ok && _task) xTaskNotifyGive(_task);
+        return ok;
+    }
+
+    static void drainTask(void* param) {
+        static_cast<AsyncLog*>(param)->drain();
+    }
+
+    // Satu-satunya pembaca: salin potongan dari ring, tulis ke UART (boleh
+    // blocking), baru kemudian bebaskan ruangnya.
+    void drain() {
+        char chunk[128];
+        uint32_t reportedDrops = 0;
+        for (;;) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+
+            uint32_t drops = _ring.droppedLines();
+            if (drops != reportedDrops) {
+                _out->printf("⚠️ %u baris log dibuang (buffer penuh)\n", (unsigned)(drops - reportedDrops));
+                reportedDrops = drops;
+            }
+
+            for (;;) {
+                portENTER_CRITICAL(&_lock);
+                uint32_t pos = _ring.tail();
+                size_t n = _ring.read(pos, chunk, sizeof(chunk));
+                portEXIT_CRITICAL(&_lock);
+                if (n == 0) break;
+
+                _out->write((const uint8_t*)chunk, n);
+
+                portENTER_CRITICAL(&_lock);
+                _ring.consume(n);
+                portEXIT_CRITICAL(&_lock);
+            }
+        }
+    }
+
+    LogRing<ASYNC_LOG_RING_SIZE> _ring;
+    portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED;
+    Print* _out = nullptr;
+    TaskHandle_t _task = nullptr;
+};
+
+// Satu instance per firmware (static lokal: aman untuk banyak translation unit)
+inline AsyncLog& asyncLog() {
+    static AsyncLog log;
+    return log;
+}
+
+#define LOG_ENABLED(level) (LOG_LEVEL >= (level))
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_E(...) asyncLog().logf(__VA_ARGS__)
+#else
+#define LOG_E(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_W(...) asyncLog().logf(__VA_ARGS__)
+#else
+#define LOG_W(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_I(...) asyncLog().logf(__VA_ARGS__)
+#else
+#define LOG_I(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_D(...) asyncLog().logf(__VA_ARGS__)
+#else
+#define LOG_D(...) ((void)0)
+#endif
@@ -0,0 +1,96 @@
+/*
+ * LogRing - Ring buffer byte untuk baris log, tanpa alokasi & tanpa Arduino
+ *
+ * Posisi disimpan sebagai counter absolut (total byte yang pernah ditulis /
+ * dibuang), indeks fisik = posisi % CAPACITY. Dengan begitu pembaca yang
+ * tertinggal (mis. dump /log yang lambat) bisa mendeteksi data yang sudah
+ * tertimpa dan melompat ke baris tertua yang masih ada.
+ *
+ * Dua mode saat penuh:
+ *   - drop      : baris baru dibuang (dihitung), dipakai bersama task drain
+ *                 yang mengosongkan ring ke UART
+ *   - overwrite : baris tertua dibuang sampai muat, ring berisi N KB log
+ *                 terakhir untuk dibaca sewaktu-waktu
+ *
+ * Setiap baris ditulis utuh atau tidak sama sekali, dan harus diakhiri '\n'
+ * agar mode overwrite bisa membuang per baris. Penguncian antar task menjadi
+ * tanggung jawab pemanggil (lihat AsyncLog.h).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+template <size_t CAPACITY>
+class LogRing {
+public:
+    explicit LogRing(bool overwrite = false) : _overwrite(overwrite) {}
+
+    // false jika baris dibuang (mode drop & ring penuh, atau baris > CAPACITY)
+    bool write(const char* data, size_t length) {
+        if (length == 0) return true;
+        if (length > CAPACITY) {
+            _droppedLines++;
+            return false;
+        }
+        if (CAPACITY - size() < length) {
+            if (!_overwrite) {
+                _droppedLines++;
+                return false;
+            }
+            while (CAPACITY - size() < length) discardLine();
+        }
+
+        size_t index = _head % CAPACITY;
+        size_t first = CAPACITY - index < length ? CAPACITY - index : length;
+        memcpy(_buf + index, data, first);
+        memcpy(_buf, data + first, length - first);
+        _head += length;
+        return true;
+    }
+
+    // Salin data mulai posisi absolut `pos` (dimajukan). Jika `pos` sudah
+    // tertimpa, pembacaan dimulai dari data tertua yang masih ada.
+    size_t read(uint32_t& pos, char* out, size_t max) const {
+        if ((int32_t)(pos - _tail) < 0) pos = _tail;
+        size_t available = _head - pos;
+        size_t n = available < max ? available : max;
+        size_t index = pos % CAPACITY;
+        size_t first = CAPACITY - index < n ? CAPACITY - index : n;
+        memcpy(out, _buf + index, first);
+        memcpy(out + first, _buf, n - first);
+        pos += n;
+        return n;
+    }
+
+    // Buang n byte tertua (setelah task drain selesai menulisnya)
+    void consume(size_t n) {
+        if (n > size()) n = size();
+        _tail += n;
+    }
+
+    size_t size() const { return _head - _tail; }
+    bool empty() const { return _head == _tail; }
+    uint32_t head() const { return _head; }
+    uint32_t tail() const { return _tail; }
+    uint32_t droppedLines() const { return _droppedLines; }
+    uint32_t overwrittenLines() const { return _overwrittenLines; }
+
+private:
+    void discardLine() {
+        while (_tail != _head) {
+            char c = _buf[_tail % CAPACITY];
+            _tail++;
+            if (c == '\n') break;
+        }
+        _overwrittenLines++;
+    }
+
+    char _buf[CAPACITY];
+    uint32_t _head = 0;         // Total byte ditulis
+    uint32_t _tail = 0;         // Posisi byte tertua yang masih ada
+    uint32_t _droppedLines = 0;
+    uint32_t _overwrittenLines = 0;
+    bool _overwrite;
+};
@@ -0,0 +1,350 @@
+/*
+ * HttpTransport - Transport HTTP keep-alive bersama untuk Control & Sensor Node
+ *
+ * Satu instance = satu koneksi TCP persisten ke satu host (apiHost:apiPort).
+ * Semua request memakai ulang socket yang sama selama server mengizinkan
+ * keep-alive, sehingga handshake TCP hanya terjadi saat koneksi pertama
+ * kali dibuka atau setelah server menutupnya.
+ *
+ * Endpoint dikirim sebagai path (const char*), bukan URL hasil gabungan
+ * String, jadi tidak ada alokasi heap per request untuk membangun URL.
+ * Body response dibaca ke buffer statis milik transport (readBody()), atau
+ * langsung di-stream dari socket (bodyStream()) untuk parser streaming.
+ *
+ * Alur pemakaian:
+ *   int code = transport.get("/api/water-status");
+ *   if (code > 0) { int n = transport.readBody(); ... transport.body() ... }
+ *   transport.end();   // selesai request, socket tetap terbuka
+ *
+ * Parse streaming (tanpa salinan body ke String):
+ *   deserializeJson(doc, transport.bodyStream(), DeserializationOption::Filter(f));
+ *
+ * Identitas node (NodeId.h) dikirim di setiap request sebagai header
+ * X-Node-Id setelah setNodeId(), agar server bisa membedakan banyak node.
+ *
+ * Request kondisional (ETag):
+ *   transport.setIfNoneMatch(etag);
+ *   int code = transport.get(path);     // 304 = tidak ada perubahan
+ *   transport.header("ETag");           // ETag versi baru jika 200
+ *
+ * Lanjutkan unduhan yang terputus (mis. image OTA):
+ *   transport.setRange(received);
+ *   int code = transport.get(path);     // 206 = body mulai dari byte received
+ */
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <HTTPClient.h>
+
+#ifndef HTTP_TRANSPORT_BODY_SIZE
+#define HTTP_TRANSPORT_BODY_SIZE 1024
+#endif
+
+class HttpTransport {
+public:
+    struct Stats {
+        uint32_t requests;
+        uint32_t reused;          // Request yang memakai socket keep-alive
+        uint32_t handshakes;      // Koneksi TCP baru
+        uint32_t failures;        // Kode HTTP negatif (error transport)
+        uint32_t handshakeMsTotal;
+        uint32_t handshakeMsMax;
+        uint32_t bytesSent;       // Body request
+        uint32_t bytesReceived;   // Body response
+    };
+
+    // Dipanggil setiap request selesai: kode HTTP (negatif = error transport)
+    // dan waktu sampai header response diterima, termasuk handshake/retry.
+    typedef void (*RequestObserver)(const char* path, int code, uint32_t elapsedMs, void* ctx);
+
+    static const uint16_t TIMEOUT_MS = 5000;
+
+    void begin(const char* host, uint16_t port) {
+        _host = host;
+        _port = port;
+        _http.setReuse(true);
+        _http.setTimeout(TIMEOUT_MS);
+
+        static const char* collected[] = {"ETag", "Transfer-Encoding"};
+        _http.collectHeaders(collected, 2);
+    }
+
+    void onRequest(RequestObserver observer, void* ctx = nullptr) {
+        _observer = observer;
+        _observerCtx = ctx;
+    }
+
+    // Header X-Node-Id untuk semua request (string harus tetap hidup)
+    void setNodeId(const char* id) {
+        _nodeId = id;
+    }
+
+    // Header If-None-Match untuk request berikutnya saja (nullptr/"" = tanpa)
+    void setIfNoneMatch(const char* etag) {
+        _ifNoneMatch = etag;
+    }
+
+    // Header Range: bytes=<from>- untuk request berikutnya saja (0 = tanpa)
+    void setRange(uint32_t from) {
+        _rangeFrom = from;
+    }
+
+    // Nilai header response yang dikumpulkan ("ETag", "Transfer-Encoding")
+    String header(const char* name) {
+        return _http.header(name);
+    }
+
+    int get(const char* path) {
+        return request(path, nullptr, nullptr, 0);
+    }
+
+    int post(const char* path, const char* contentType, const uint8_t* body, size_t len) {
+        return request(path, contentType, body, len);
+    }
+
+    // Baca seluruh body ke buffer internal (null-terminated).
+    // Mengembalikan panjang body, atau -1 jika gagal/terlalu besar.
+    int readBody() {
+        BufferWriter writer(_body, sizeof(_body) - 1);
+        int written = _http.writeToStream(&writer);
+        _bodyLen = writer.length();
+        _body[_bodyLen] = '\0';
+
+        if (written < 0 || writer.overflow()) return -1;
+        _stats.bytesReceived += _bodyLen;
+        return (int)_bodyLen;
+    }
+
+    char* body() { return _body; }
+    size_t bodyLength() const { return _bodyLen; }
+
+    // Stream body untuk parser streaming (mis. deserializeJson dengan filter,
+    // RemoteApi.h). Body dengan Content-Length atau yang dibatasi penutupan
+    // koneksi dibaca langsung dari socket tanpa salinan; peek()/read()
+    // menunggu data hingga TIMEOUT_MS seperti Stream::timedRead. Hanya
+    // chunked encoding yang lebih dulu dikumpulkan ke buffer internal lalu
+    // dibaca dari sana.
+    Stream& bodyStream() {
+        int size = _http.getSize();
+        if (_http.header("Transfer-Encoding").equalsIgnoreCase("chunked")) {
+            int n = readBody();
+            _bodyReader.attachBuffer(_body, n < 0 ? 0 : (size_t)n);
+        } else {
+            _bodyReader.attachSocket(_http.getStreamPtr(),
+                                     size >= 0 ? (size_t)size : BodyReader::UNTIL_CLOSE);
+        }
+        _bodyReader.setTimeout(TIMEOUT_MS);
+        return _bodyReader;
+    }
+
+    HTTPClient& http() { return _http; }
+
+    // Selesai request. Socket dibiarkan terbuka jika server mengizinkan reuse.
+    // Sisa body yang belum dibaca parser dibuang agar tidak tercampur dengan
+    // response request berikutnya di socket yang sama.
+    void end() {
+        _stats.bytesReceived += _bodyReader.consumed();
+        if (!_bodyReader.drain()) _socket.stop();
+        _bodyReader.detach();
+        _http.end();
+    }
+
+    // Tutup paksa koneksi (mis. saat WiFi putus)
+    void reset() {
+        _http.end();
+        _socket.stop();
+    }
+
+    const Stats& stats() const { return _stats; }
+
+    void printStats(Print& out) const {
+        uint32_t avgHandshake = _stats.handshakes ? _stats.handshakeMsTotal / _stats.handshakes : 0;
+        uint32_t avgBytes = _stats.requests ? (_stats.bytesSent + _stats.bytesReceived) / _stats.requests : 0;
+        out.printf("🔌 HTTP %s:%u req=%lu reuse=%lu handshake=%lu (avg %lu ms, max %lu ms) gagal=%lu byte/req=%lu\n",
+                   _host, _port,
+                   (unsigned long)_stats.requests, (unsigned long)_stats.reused,
+                   (unsigned long)_stats.handshakes, (unsigned long)avgHandshake,
+                   (unsigned long)_stats.handshakeMsMax, (unsigned long)_stats.failures,
+                   (unsigned long)avgBytes);
+    }
+
+private:
+    // Print ke buffer tetap, dipakai writeToStream() (menangani chunked encoding)
+    class BufferWriter : public Print {
+    public:
+        BufferWriter(char* buf, size_t cap) : _buf(buf), _cap(cap) {}
+        size_t write(uint8_t c) override {
+            if (_len >= _cap) { _overflow = true; return 0; }
+            _buf[_len++] = (char)c;
+            return 1;
+        }
+        size_t write(const uint8_t* data, size_t size) override {
+            size_t room = _cap - _len;
+            if (size > room) { _overflow = true; size = room; }
+            memcpy(_buf + _len, data, size);
+            _len += size;
+            return size;
+        }
+        size_t length() const { return _len; }
+        bool overflow() const { return _overflow; }
+    private:
+        char* _buf;
+        size_t _cap;
+        size_t _len = 0;
+        bool _overflow = false;
+    };
+
+    // Stream body berbatas: dari socket (sebanyak Content-Length) atau buffer
+    class BodyReader : public Stream {
+    public:
+        static const size_t UNTIL_CLOSE = (size_t)-1;
+
+        void attachSocket(WiFiClient* socket, size_t length) {
+            _socket = socket; _buf = nullptr; _remaining = length; _consumed = 0;
+        }
+        void attachBuffer(const char* buf, size_t length) {
+            _socket = nullptr; _buf = buf; _remaining = length; _consumed = 0;
+        }
+        void detach() { _socket = nullptr; _buf = nullptr; _remaining = 0; _consumed = 0; }
+
+        int available() override {
+            if (_remaining == 0) return 0;
+            if (_buf) return (int)_remaining;
+            if (!_socket) return 0;
+            int n = _socket->available();
+            return (size_t)n > _remaining ? (int)_remaining : n;
+        }
+        int read() override {
+            if (_remaining == 0) return -1;
+            int c = _buf ? (uint8_t)*_buf++ : (waitForData() ? _socket->read() : -1);
+            if (c >= 0) { _remaining--; if (_socket) _consumed++; }
+            return c;
+        }
+        int peek() override {
+            if (_remaining == 0) return -1;
+            if (_buf) return (uint8_t)*_buf;
+            return waitForData() ? _socket->peek() : -1;
+        }
+        size_t write(uint8_t) override { return 0; }
+
+        // Byte yang dibaca langsung dari socket (untuk statistik)
+        size_t consumed() const { return _consumed; }
+
+        // Buang sisa body dari socket; false jika gagal dalam batas waktu
+        bool drain() {
+            if (!_socket) return true;
+            if (_remaining == UNTIL_CLOSE) return false; // Server akan menutup koneksi
+            unsigned long start = millis();
+            while (_remaining > 0 && millis() - start < TIMEOUT_MS) {
+                if (_socket->read() >= 0) _remaining--;
+                else delay(1);
+            }
+            return _remaining == 0;
+        }
+    private:
+        // Byte berikutnya sudah ada di socket; false jika koneksi ditutup atau
+        // data tidak datang dalam batas waktu
+        bool waitForData() {
+            if (!_socket) return false;
+            unsigned long start = millis();
+            while (_socket->available() <= 0) {
+                if (!_socket->connected() || millis() - start >= TIMEOUT_MS) return false;
+                delay(1);
+            }
+            return true;
+        }
+
+        WiFiClient* _socket = nullptr;
+        const char* _buf = nullptr;
+        size_t _remaining = 0;
+        size_t _consumed = 0;
+    };
+
+    bool ensureConnected() {
+        if (_socket.connected()) {
+            _stats.reused++;
+            return true;
+        }
+
+        unsigned long start = millis();
+        if (!_socket.connect(_host, _port, TIMEOUT_MS)) return false;
+
+        uint32_t elapsed = millis() - start;
+        _stats.handshakes++;
+        _stats.handshakeMsTotal += elapsed;
+        if (elapsed > _stats.handshakeMsMax) _stats.handshakeMsMax = elapsed;
+        return true;
+    }
+
+    int send(const char* path, const char* contentType, const uint8_t* body, size_t len) {
+        if (!_http.begin(_socket, _host, _port, path)) return HTTPC_ERROR_CONNECTION_REFUSED;
+        if (_nodeId) _http.addHeader("X-Node-Id", _nodeId);
+        if (_ifNoneMatch && _ifNoneMatch[0]) _http.addHeader("If-None-Match", _ifNoneMatch);
+        if (_rangeFrom) {
+            char range[24];
+            snprintf(range, sizeof(range), "bytes=%lu-", (unsigned long)_rangeFrom);
+            _http.addHeader("Range", range);
+        }
+        if (contentType) {
+            _http.addHeader("Content-Type", contentType);
+            return _http.POST((uint8_t*)body, len);
+        }
+        return _http.GET();
+    }
+
+    int request(const char* path, const char* contentType, const uint8_t* body, size_t len) {
+        unsigned long start = millis();
+        _stats.requests++;
+        _bodyLen = 0;
+
+        bool reused = _socket.connected();
+        if (!ensureConnected()) {
+            _stats.failures++;
+            _ifNoneMatch = nullptr;
+            _rangeFrom = 0;
+            notify(path, HTTPC_ERROR_CONNECTION_REFUSED, start);
+            return HTTPC_ERROR_CONNECTION_REFUSED;
+        }
+
+        int code = send(path, contentType, body, len);
+
+        // Socket keep-alive bisa sudah ditutup server tanpa kita ketahui;
+        // ulangi sekali dengan koneksi baru.
+        if (code < 0 && reused) {
+            reset();
+            if (ensureConnected()) code = send(path, contentType, body, len);
+        }
+
+        _ifNoneMatch = nullptr;
+        _rangeFrom = 0;
+
+        if (code < 0) {
+            _stats.failures++;
+            reset();
+        } else {
+            _stats.bytesSent += len;
+        }
+        notify(path, code, start);
+        return code;
+    }
+
+    void notify(const char* path, int code, unsigned long start) {
+        if (_observer) _observer(path, code, millis() - start, _observerCtx);
+    }
+
+    const char* _host = nullptr;
+    uint16_t _port = 0;
+    WiFiClient _socket;
+    HTTPClient _http;
+    Stats _stats = {};
+    const char* _ifNoneMatch = nullptr;
+    uint32_t _rangeFrom = 0;
+    const char* _nodeId = nullptr;
+    BodyReader _bodyReader;
+    RequestObserver _observer = nullptr;
+    void* _observerCtx = nullptr;
+
+    char _body[HTTP_TRANSPORT_BODY_SIZE];
+    size_t _bodyLen = 0;
+};
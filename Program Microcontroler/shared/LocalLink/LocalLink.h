@@ -0,0 +1,88 @@
+/*
+ * LocalLink - Link langsung sensor node -> control node lewat UDP multicast
+ *
+ *   // Sensor node
+ *   LocalLink link;
+ *   link.begin(mac);                       // setup(): MAC = identitas pengirim
+ *   link.send(record);                     // Setelah setiap sampel, tanpa menunggu
+ *
+ *   // Control node (networkTask)
+ *   link.pairWith(sensorMac);              // Opsional; tanpa ini = sensor pertama
+ *   link.listen();                         // Setelah WiFi tersambung (join grup)
+ *   while (link.poll(millis(), record)) { ... }
+ *
+ * Kedua node sudah berada di AP yang sama, jadi multicast UDP dipakai alih-alih
+ * ESP-NOW (ESP-NOW harus satu kanal dengan AP dan tidak bisa diuji di host).
+ * Datagram 34 byte, TTL 1: tidak keluar dari LAN. Frame & validasi ada di
+ * LocalLinkProtocol.h. Server Laravel tidak terlibat, jadi bacaan soil tetap
+ * sampai ke control node saat server mati.
+ */
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <esp_random.h>
+#include "LocalLinkProtocol.h"
+
+#ifndef LOCAL_LINK_GROUP
+#define LOCAL_LINK_GROUP 239, 255, 80, 75
+#endif
+#ifndef LOCAL_LINK_PORT
+#define LOCAL_LINK_PORT 4275
+#endif
+
+class LocalLink {
+public:
+    LocalLink() : _sender(0, nullptr), _group(LOCAL_LINK_GROUP) {}
+
+    void begin(const uint8_t mac[LOCAL_LINK_SOURCE_SIZE]) {
+        _sender = LocalLinkSender((uint16_t)esp_random(), mac);
+    }
+
+    void pairWith(const uint8_t source[LOCAL_LINK_SOURCE_SIZE]) { _receiver.setSource(source); }
+
+    // Kirim satu record (non-blocking; gagal diam-diam jika WiFi putus)
+    bool send(const TelemetryRecord& record) {
+        if (WiFi.status() != WL_CONNECTED) return false;
+        uint8_t frame[LOCAL_LINK_FRAME_SIZE];
+        size_t length = _sender.frame(frame, sizeof(frame), record);
+        if (!length || !_udp.beginPacket(_group, LOCAL_LINK_PORT)) return false;
+        _udp.write(frame, length);
+        return _udp.endPacket() == 1;
+    }
+
+    // Join grup multicast; ulangi setiap WiFi tersambung kembali
+    bool listen() {
+        _udp.stop();
+        _listening = _udp.beginMulticast(_group, LOCAL_LINK_PORT) == 1;
+        return _listening;
+    }
+
+    void stop() {
+        _udp.stop();
+        _listening = false;
+    }
+
+    // Ambil satu frame yang sudah masuk; false jika tidak ada (tidak menunggu)
+    bool poll(unsigned long now, TelemetryRecord& record) {
+        if (!_listening) return false;
+        for (;;) {
+            int size = _udp.parsePacket();
+            if (size <= 0) return false;
+            uint8_t frame[LOCAL_LINK_FRAME_SIZE + 4];
+            int length = _udp.read(frame, sizeof(frame));
+            if (length > 0 && _receiver.accept(frame, (size_t)length, now, record)) return true;
+        }
+    }
+
+    bool listening() const { return _listening; }
+    const LocalLinkReceiver& receiver() const { return _receiver; }
+
+private:
+    WiFiUDP _udp;
+    LocalLinkSender _sender;
+    LocalLinkReceiver _receiver;
+    IPAddress _group;
+    bool _listening = false;
+};
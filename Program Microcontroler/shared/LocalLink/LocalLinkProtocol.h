@@ -0,0 +1,151 @@
+/*
+ * LocalLinkProtocol - Frame pembacaan sensor node -> control node tanpa server
+ *
+ * Satu datagram UDP per pembacaan, dikirim ke grup multicast LAN. Isi record
+ * memakai TelemetryCodec (satu record, format v1) sehingga decoder yang sama
+ * dipakai di server, control node dan simulasi. Semua angka little-endian.
+ *
+ *   Frame (34 byte)
+ *     0  'P' 'L'        magic
+ *     2  uint8  version (LOCAL_LINK_VERSION)
+ *     3  uint8  type    (LOCAL_LINK_READING)
+ *     4  uint16 bootId  acak per boot sensor node; berubah = seq mulai dari 0
+ *     6  uint32 seq     naik satu per frame
+ *    10  uint8[6] source MAC sensor node (NodeId.h)
+ *    16  ...    payload TelemetryCodec (header 10 byte + 1 record 8 byte)
+ *
+ * UDP tidak menjamin urutan maupun sampai: receiver menolak frame yang lebih
+ * tua dari yang terakhir diterima (duplikat/urutan terbalik) dan menghitung
+ * frame yang hilang dari lompatan seq. Beberapa pasangan node bisa berbagi
+ * grup multicast: receiver hanya menerima satu sensor node (setSource(), atau
+ * sensor pertama yang terdengar). Tidak ada autentikasi; siapa pun di LAN
+ * yang sama bisa mengirim frame (sama seperti endpoint HTTP server).
+ *
+ * Tidak bergantung pada Arduino (dipakai juga oleh simulasi host).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <TelemetryCodec.h>
+
+static const uint8_t LOCAL_LINK_VERSION = 2;
+static const uint8_t LOCAL_LINK_READING = 1;
+static const size_t LOCAL_LINK_SOURCE_SIZE = 6;
+static const size_t LOCAL_LINK_HEADER_SIZE = 16;
+static const size_t LOCAL_LINK_FRAME_SIZE = LOCAL_LINK_HEADER_SIZE + telemetryEncodedSize(1);
+
+class LocalLinkSender {
+public:
+    // source = MAC sensor node (nullptr = nol, sebelum MAC diketahui)
+    LocalLinkSender(uint16_t bootId, const uint8_t source[LOCAL_LINK_SOURCE_SIZE]) : _bootId(bootId) {
+        if (source) memcpy(_source, source, LOCAL_LINK_SOURCE_SIZE);
+        else memset(_source, 0, LOCAL_LINK_SOURCE_SIZE);
+    }
+
+    // Tulis satu frame ke buf; 0 jika buf terlalu kecil atau record ditolak
+    size_t frame(uint8_t* buf, size_t capacity, const TelemetryRecord& record) {
+        if (capacity < LOCAL_LINK_FRAME_SIZE) return 0;
+        TelemetryEncoder encoder(buf + LOCAL_LINK_HEADER_SIZE, capacity - LOCAL_LINK_HEADER_SIZE);
+        if (!encoder.add(record)) return 0;
+        size_t length = LOCAL_LINK_HEADER_SIZE + encoder.finish();
+
+        buf[0] = 'P';
+        buf[1] = 'L';
+        buf[2] = LOCAL_LINK_VERSION;
+        buf[3] = LOCAL_LINK_READING;
+        buf[4] = (uint8_t)_bootId;
+        buf[5] = (uint8_t)(_bootId >> 8);
+        for (int i = 0; i < 4; i++) buf[6 + i] = (uint8_t)(_seq >> (8 * i));
+        memcpy(buf + 10, _source, LOCAL_LINK_SOURCE_SIZE);
+        _seq++;
+        return length;
+    }
+
+    uint32_t seq() const { return _seq; }
+
+private:
+    uint16_t _bootId;
+    uint8_t _source[LOCAL_LINK_SOURCE_SIZE];
+    uint32_t _seq = 0;
+};
+
+class LocalLinkReceiver {
+public:
+    struct Stats {
+        uint32_t received;      // Frame diterima & dipakai
+        uint32_t invalid;       // Bukan frame LocalLink / payload rusak
+        uint32_t stale;         // Duplikat atau datang setelah frame yang lebih baru
+        uint32_t lost;          // Lompatan seq (frame tidak pernah sampai)
+        uint32_t restarts;      // bootId berganti (sensor node reboot)
+        uint32_t foreign;       // Dari sensor node lain (pasangan lain di LAN yang sama)
+    };
+
+    // Hanya terima frame dari MAC ini. Tanpa setSource(), receiver mengunci
+    // ke sensor node pertama yang terdengar.
+    void setSource(const uint8_t source[LOCAL_LINK_SOURCE_SIZE]) {
+        memcpy(_source, source, LOCAL_LINK_SOURCE_SIZE);
+        _hasSource = true;
+    }
+
+    // true jika frame valid & lebih baru dari frame terakhir; record terisi
+    bool accept(const uint8_t* data, size_t length, unsigned long now, TelemetryRecord& record) {
+        if (length < LOCAL_LINK_HEADER_SIZE || data[0] != 'P' || data[1] != 'L' ||
+            data[2] != LOCAL_LINK_VERSION || data[3] != LOCAL_LINK_READING) {
+            _stats.invalid++;
+            return false;
+        }
+        TelemetryDecoder decoder(data + LOCAL_LINK_HEADER_SIZE, length - LOCAL_LINK_HEADER_SIZE);
+        if (!decoder.valid() || !decoder.next(record)) {
+            _stats.invalid++;
+            return false;
+        }
+
+        if (_hasSource && memcmp(data + 10, _source, LOCAL_LINK_SOURCE_SIZE) != 0) {
+            _stats.foreign++;
+            return false;
+        }
+        if (!_hasSource) setSource(data + 10);
+
+        uint16_t bootId = (uint16_t)(data[4] | (data[5] << 8));
+        uint32_t seq = 0;
+        for (int i = 0; i < 4; i++) seq |= (uint32_t)data[6 + i] << (8 * i);
+
+        if (_hasFrame && bootId == _bootId) {
+            if ((int32_t)(seq - _seq) <= 0) {
+                _stats.stale++;
+                return false;
+            }
+            _stats.lost += seq - _seq - 1;
+        } else if (_hasFrame) {
+            _stats.restarts++;
+        }
+
+        _hasFrame = true;
+        _bootId = bootId;
+        _seq = seq;
+        _lastAt = now;
+        _stats.received++;
+        return true;
+    }
+
+    // Ada frame yang diterima dalam maxAgeMs terakhir
+    bool fresh(unsigned long now, unsigned long maxAgeMs) const {
+        return _hasFrame && now - _lastAt <= maxAgeMs;
+    }
+
+    unsigned long lastAt() const { return _lastAt; }
+    const Stats& stats() const { return _stats; }
+    bool hasSource() const { return _hasSource; }
+    const uint8_t* source() const { return _source; }
+
+private:
+    bool _hasSource = false;
+    uint8_t _source[LOCAL_LINK_SOURCE_SIZE] = {};
+    bool _hasFrame = false;
+    uint16_t _bootId = 0;
+    uint32_t _seq = 0;
+    unsigned long _lastAt = 0;
+    Stats _stats = {};
+};
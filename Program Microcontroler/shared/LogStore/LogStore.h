@@ -0,0 +1,277 @@
+/*
+ * LogStore - Log append-only ber-CRC di atas region flash (ring sektor)
+ *
+ * Pengganti "tulis ulang seluruh struct + erase sektor" untuk data yang
+ * sering berubah. Record ditambahkan ke sektor aktif; sektor baru dipakai
+ * bergiliran (wear levelling alami), sehingga setiap sektor di-erase sekali
+ * per putaran ring, bukan sekali per perubahan.
+ *
+ *   Sektor : [magic 'PLOG' u32][seq u32][record][record]...[0xFF...]
+ *   Record : [length u16][type u8][0xFF][crc32 u32][payload][pad ke 4 byte]
+ *
+ * CRC mencakup length, type dan payload. Record dengan CRC salah (tulis
+ * terputus saat listrik mati) mengakhiri sektor itu saat replay, dan append
+ * berikutnya pindah ke sektor baru. Saat pindah sektor, callback rollover
+ * dipanggil agar pemilik menulis snapshot state lengkap di awal sektor baru;
+ * dengan begitu sektor tertua boleh di-erase tanpa kehilangan state.
+ *
+ * Tidak bergantung pada Arduino; RamFlashRegion mensimulasikan NOR flash
+ * (tulis hanya 1 -> 0, erase per sektor) lengkap dengan hitungan erase.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// ==================== FLASH REGION ====================
+
+class FlashRegion {
+public:
+    virtual ~FlashRegion() {}
+    virtual size_t size() const = 0;
+    virtual size_t sectorSize() const { return 4096; }
+    virtual bool read(size_t offset, void* dst, size_t length) = 0;
+    virtual bool write(size_t offset, const void* src, size_t length) = 0; // Hanya bit 1 -> 0
+    virtual bool erase(size_t offset) = 0;                                 // Satu sektor
+};
+
+// Flash tiruan di RAM untuk host/simulasi
+class RamFlashRegion : public FlashRegion {
+public:
+    RamFlashRegion(uint8_t* memory, size_t size, uint32_t* eraseCounts, size_t sectorSize = 4096)
+        : _memory(memory), _size(size), _sectorSize(sectorSize), _eraseCounts(eraseCounts) {
+        memset(_memory, 0xFF, _size);
+        memset(_eraseCounts, 0, sizeof(uint32_t) * (_size / _sectorSize));
+    }
+
+    size_t size() const override { return _size; }
+    size_t sectorSize() const override { return _sectorSize; }
+
+    bool read(size_t offset, void* dst, size_t length) override {
+        if (offset + length > _size) return false;
+        memcpy(dst, _memory + offset, length);
+        return true;
+    }
+
+    bool write(size_t offset, const void* src, size_t length) override {
+        if (offset + length > _size) return false;
+        const uint8_t* p = (const uint8_t*)src;
+        for (size_t i = 0; i < length; i++) _memory[offset + i] &= p[i];
+        return true;
+    }
+
+    bool erase(size_t offset) override {
+        if (offset % _sectorSize || offset >= _size) return false;
+        memset(_memory + offset, 0xFF, _sectorSize);
+        _eraseCounts[offset / _sectorSize]++;
+        return true;
+    }
+
+    uint32_t eraseCount(size_t sector) const { return _eraseCounts[sector]; }
+
+private:
+    uint8_t* _memory;
+    size_t _size;
+    size_t _sectorSize;
+    uint32_t* _eraseCounts;
+};
+
+// ==================== LOG STORE ====================
+
+inline uint32_t logCrc32(uint32_t crc, const void* data, size_t length) {
+    const uint8_t* p = (const uint8_t*)data;
+    crc = ~crc;
+    while (length--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+#ifndef LOG_STORE_MAX_PAYLOAD
+#define LOG_STORE_MAX_PAYLOAD 512
+#endif
+
+struct LogStoreStats {
+    uint32_t appends;       // Record ditulis sejak boot
+    uint32_t bytesWritten;
+    uint32_t erases;        // Sektor di-erase sejak boot
+    uint32_t replayed;      // Record valid saat replay
+    uint32_t corrupt;       // Record rusak (CRC) yang ditemukan saat replay
+    uint32_t sequence;      // Nomor urut sektor aktif (total rotasi sepanjang umur flash)
+};
+
+class LogStore {
+public:
+    typedef void (*RecordFn)(uint8_t type, const uint8_t* payload, size_t length, void* ctx);
+    typedef void (*RolloverFn)(LogStore& store, void* ctx);
+
+    static const uint32_t SECTOR_MAGIC = 0x474F4C50; // "PLOG"
+
+    explicit LogStore(FlashRegion& flash) : _flash(flash) {}
+
+    // Cari sektor aktif & posisi tulis. Flash kosong/asing diformat (false).
+    bool begin() {
+        _sectors = _flash.size() / _flash.sectorSize();
+        if (_sectors < 2) return false;
+
+        bool found = false;
+        for (size_t s = 0; s < _sectors; s++) {
+            uint32_t seq;
+            if (!sectorSeq(s, seq)) continue;
+            if (!found || seq > _seq) {
+                _seq = seq;
+                _active = s;
+                found = true;
+            }
+        }
+
+        if (!found) {
+            _seq = 0;
+            startSector(0);
+            return false;
+        }
+
+        _stats.sequence = _seq;
+        _writePos = scan(_active, nullptr, nullptr, _sealed);
+        return true;
+    }
+
+    // Panggil fn untuk setiap record valid, dari sektor tertua ke terbaru
+    void replay(RecordFn fn, void* ctx) {
+        for (size_t i = 1; i <= _sectors; i++) {
+            size_t s = (_active + i) % _sectors;
+            uint32_t seq;
+            if (!sectorSeq(s, seq) || seq > _seq) continue;
+            bool sealed;
+            scan(s, fn, ctx, sealed);
+        }
+    }
+
+    // Dipanggil setelah pindah ke sektor baru (untuk menulis snapshot)
+    void onRollover(RolloverFn fn, void* ctx) {
+        _rollover = fn;
+        _rolloverCtx = ctx;
+    }
+
+    bool append(uint8_t type, const void* payload, size_t length) {
+        if (length > LOG_STORE_MAX_PAYLOAD || _sectors == 0) return false;
+        size_t need = recordSize(length);
+        if (need > _flash.sectorSize() - HEADER_SIZE) return false;
+
+        if (_sealed || _writePos + need > _flash.sectorSize()) {
+            if (_inRollover) return false; // Snapshot tidak muat di sektor baru
+            startSector((_active + 1) % _sectors);
+            if (_rollover) {
+                _inRollover = true;
+                _rollover(*this, _rolloverCtx);
+                _inRollover = false;
+            }
+            if (_writePos + need > _flash.sectorSize()) return false;
+        }
+
+        uint8_t head[RECORD_HEADER_SIZE];
+        head[0] = (uint8_t)length;
+        head[1] = (uint8_t)(length >> 8);
+        head[2] = type;
+        head[3] = 0xFF;
+        uint32_t crc = logCrc32(logCrc32(0, head, 3), payload, length);
+        memcpy(head + 4, &crc, 4);
+
+        size_t base = _active * _flash.sectorSize() + _writePos;
+        bool ok = _flash.write(base, head, RECORD_HEADER_SIZE) &&
+                  (length == 0 || _flash.write(base + RECORD_HEADER_SIZE, payload, length));
+        _writePos += need;
+        if (!ok) {
+            _sealed = true;
+            return false;
+        }
+
+        _stats.appends++;
+        _stats.bytesWritten += need;
+        return true;
+    }
+
+    const LogStoreStats& stats() const { return _stats; }
+
+    size_t sectorCount() const { return _sectors; }
+    size_t activeSector() const { return _active; }
+    size_t writeOffset() const { return _writePos; }
+
+private:
+    static const size_t HEADER_SIZE = 8;
+    static const size_t RECORD_HEADER_SIZE = 8;
+
+    static size_t recordSize(size_t length) {
+        return (RECORD_HEADER_SIZE + length + 3) & ~(size_t)3;
+    }
+
+    bool sectorSeq(size_t sector, uint32_t& seq) {
+        uint32_t header[2];
+        if (!_flash.read(sector * _flash.sectorSize(), header, sizeof(header))) return false;
+        if (header[0] != SECTOR_MAGIC || header[1] == 0xFFFFFFFF) return false;
+        seq = header[1];
+        return true;
+    }
+
+    void startSector(size_t sector) {
+        size_t base = sector * _flash.sectorSize();
+        _flash.erase(base);
+        _seq++;
+        _stats.sequence = _seq;
+        uint32_t header[2] = {SECTOR_MAGIC, _seq};
+        _flash.write(base, header, sizeof(header));
+
+        _active = sector;
+        _writePos = HEADER_SIZE;
+        _sealed = false;
+        _stats.erases++;
+    }
+
+    // Telusuri record sektor; mengembalikan offset setelah record valid terakhir.
+    // sealed = true jika ditemukan record rusak (sektor tidak boleh ditulisi lagi).
+    size_t scan(size_t sector, RecordFn fn, void* ctx, bool& sealed) {
+        size_t base = sector * _flash.sectorSize();
+        size_t pos = HEADER_SIZE;
+        sealed = false;
+
+        while (pos + RECORD_HEADER_SIZE <= _flash.sectorSize()) {
+            uint8_t head[RECORD_HEADER_SIZE];
+            if (!_flash.read(base + pos, head, sizeof(head))) break;
+            size_t length = head[0] | (head[1] << 8);
+            if (length == 0xFFFF && head[2] == 0xFF) break; // Area kosong
+
+            uint32_t crc;
+            memcpy(&crc, head + 4, 4);
+            bool ok = length <= LOG_STORE_MAX_PAYLOAD &&
+                      pos + recordSize(length) <= _flash.sectorSize() &&
+                      _flash.read(base + pos + RECORD_HEADER_SIZE, _buffer, length) &&
+                      logCrc32(logCrc32(0, head, 3), _buffer, length) == crc;
+            if (!ok) {
+                sealed = true;
+                if (fn) _stats.corrupt++;
+                break;
+            }
+
+            if (fn) {
+                _stats.replayed++;
+                fn(head[2], _buffer, length, ctx);
+            }
+            pos += recordSize(length);
+        }
+        return pos;
+    }
+
+    FlashRegion& _flash;
+    size_t _sectors = 0;
+    size_t _active = 0;
+    size_t _writePos = HEADER_SIZE;
+    uint32_t _seq = 0;
+    bool _sealed = false;
+    bool _inRollover = false;
+    RolloverFn _rollover = nullptr;
+    void* _rolloverCtx = nullptr;
+    uint8_t _buffer[LOG_STORE_MAX_PAYLOAD];
+    LogStoreStats _stats = {};
+};
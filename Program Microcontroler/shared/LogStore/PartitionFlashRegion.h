@@ -0,0 +1,39 @@
+/*
+ * PartitionFlashRegion - FlashRegion di atas partisi data ESP32 (esp_partition)
+ *
+ * Partisi dicari berdasarkan label di partitions.csv proyek, mis.
+ *   wlog, data, 0x40, , 0x10000
+ */
+#pragma once
+
+#include <esp_partition.h>
+#include <esp_spi_flash.h> // SPI_FLASH_SEC_SIZE
+#include "LogStore.h"
+
+class PartitionFlashRegion : public FlashRegion {
+public:
+    // false jika partisi tidak ada di tabel partisi yang ter-flash
+    bool begin(const char* label) {
+        _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                              ESP_PARTITION_SUBTYPE_ANY, label);
+        return _partition != nullptr;
+    }
+
+    size_t size() const override { return _partition ? _partition->size : 0; }
+    size_t sectorSize() const override { return SPI_FLASH_SEC_SIZE; }
+
+    bool read(size_t offset, void* dst, size_t length) override {
+        return _partition && esp_partition_read(_partition, offset, dst, length) == ESP_OK;
+    }
+
+    bool write(size_t offset, const void* src, size_t length) override {
+        return _partition && esp_partition_write(_partition, offset, src, length) == ESP_OK;
+    }
+
+    bool erase(size_t offset) override {
+        return _partition && esp_partition_erase_range(_partition, offset, SPI_FLASH_SEC_SIZE) == ESP_OK;
+    }
+
+private:
+    const esp_partition_t* _partition = nullptr;
+};
@@ -0,0 +1,241 @@
+/*
+ * Metrics - Counter, gauge, histogram & trace ring untuk diagnosis di lapangan
+ *
+ * Dirancang untuk tetap aktif di produksi:
+ *   - Semua metrik berukuran tetap & dialokasikan statis (tanpa heap)
+ *   - Counter/gauge memakai operasi atomik relaxed (aman dari dua task)
+ *   - Histogram: bucket tetap ala Prometheus; satu penulis per histogram
+ *     (mis. semua latensi HTTP dari networkTask), pembaca boleh dari task lain
+ *   - TraceRing: N event terakhir {ms, kode, arg, nilai}, slot diklaim atomik
+ *
+ * Registry menulis format teks Prometheus (untuk endpoint /metrics) lewat
+ * sink callback, jadi tidak bergantung pada Arduino/WebServer:
+ *
+ *   MetricsRegistry registry;
+ *   registry.add("http_failures_total", "Request HTTP gagal", httpFailures, "endpoint=\"status\"");
+ *   registry.write(sink, ctx);   // sink(text, len, ctx) dipanggil per baris
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#ifndef METRICS_MAX_ENTRIES
+#define METRICS_MAX_ENTRIES 40
+#endif
+
+#define METRICS_MAX_BUCKETS 12
+
+typedef void (*MetricsSink)(const char* text, size_t length, void* ctx);
+
+class MetricCounter {
+public:
+    void inc(uint32_t n = 1) { __atomic_fetch_add(&_value, n, __ATOMIC_RELAXED); }
+    uint32_t value() const { return __atomic_load_n(&_value, __ATOMIC_RELAXED); }
+
+private:
+    uint32_t _value = 0;
+};
+
+class MetricGauge {
+public:
+    void set(int32_t value) { __atomic_store_n(&_value, value, __ATOMIC_RELAXED); }
+    int32_t value() const { return __atomic_load_n(&_value, __ATOMIC_RELAXED); }
+
+private:
+    int32_t _value = 0;
+};
+
+// Batas bucket (inklusif, naik) diberikan pemanggil; nilai di atas batas
+// terakhir hanya masuk ke +Inf (count).
+class MetricHistogram {
+public:
+    MetricHistogram(const uint32_t* bounds, uint8_t boundCount)
+        : _bounds(bounds), _boundCount(boundCount > METRICS_MAX_BUCKETS ? METRICS_MAX_BUCKETS : boundCount) {}
+
+    void observe(uint32_t value) {
+        for (uint8_t i = 0; i < _boundCount; i++) {
+            if (value <= _bounds[i]) {
+                _buckets[i]++;
+                break;
+            }
+        }
+        _sum += value;
+        _count++;
+    }
+
+    uint8_t boundCount() const { return _boundCount; }
+    uint32_t bound(uint8_t i) const { return _bounds[i]; }
+    uint32_t bucket(uint8_t i) const { return _buckets[i]; }
+    uint32_t count() const { return _count; }
+    uint64_t sum() const { return _sum; }
+
+private:
+    const uint32_t* _bounds;
+    uint8_t _boundCount;
+    uint32_t _buckets[METRICS_MAX_BUCKETS] = {};
+    uint32_t _count = 0;
+    uint64_t _sum = 0;
+};
+
+// ==================== TRACE RING ====================
+
+struct TraceEvent {
+    uint32_t ms;        // millis() saat event
+    uint16_t code;      // Kode event (enum milik firmware)
+    int16_t arg;        // Argumen kecil, mis. zona atau kode HTTP
+    int32_t value;      // Nilai, mis. durasi atau drift
+};
+
+template <size_t N>
+class TraceRing {
+public:
+    void record(uint32_t ms, uint16_t code, int16_t arg = 0, int32_t value = 0) {
+        uint32_t seq = __atomic_fetch_add(&_next, 1, __ATOMIC_RELAXED);
+        TraceEvent& e = _events[seq % N];
+        e.ms = ms;
+        e.code = code;
+        e.arg = arg;
+        e.value = value;
+    }
+
+    size_t size() const {
+        uint32_t next = total();
+        return next < N ? next : N;
+    }
+
+    uint32_t total() const { return __atomic_load_n(&_next, __ATOMIC_RELAXED); }
+
+    // Event ke-i dari yang tertua (0) ke terbaru (size()-1)
+    const TraceEvent& at(size_t i) const {
+        uint32_t next = total();
+        uint32_t first = next < N ? 0 : next - N;
+        return _events[(first + i) % N];
+    }
+
+    // Satu baris per event: "<ms> <nama> <arg> <nilai>"; names[code] atau angka
+    void write(MetricsSink sink, void* ctx, const char* const* names, size_t nameCount) const {
+        char line[64];
+        size_t count = size();
+        for (size_t i = 0; i < count; i++) {
+            TraceEvent e = at(i);
+            int n;
+            if (e.code < nameCount) {
+                n = snprintf(line, sizeof(line), "%lu %s %d %ld\n", (unsigned long)e.ms,
+                             names[e.code], e.arg, (long)e.value);
+            } else {
+                n = snprintf(line, sizeof(line), "%lu %u %d %ld\n", (unsigned long)e.ms,
+                             e.code, e.arg, (long)e.value);
+            }
+            if (n > 0) sink(line, (size_t)n < sizeof(line) ? (size_t)n : sizeof(line) - 1, ctx);
+        }
+    }
+
+private:
+    TraceEvent _events[N] = {};
+    uint32_t _next = 0;
+};
+
+// ==================== REGISTRY ====================
+
+class MetricsRegistry {
+public:
+    enum Type : uint8_t { COUNTER, GAUGE, HISTOGRAM };
+
+    // labels: teks label Prometheus tanpa kurung kurawal, mis. "endpoint=\"status\"".
+    // Metrik dengan nama sama didaftarkan berurutan agar HELP/TYPE ditulis sekali.
+    bool add(const char* name, const char* help, MetricCounter& m, const char* labels = nullptr) {
+        return add(name, help, COUNTER, &m, labels);
+    }
+    bool add(const char* name, const char* help, MetricGauge& m, const char* labels = nullptr) {
+        return add(name, help, GAUGE, &m, labels);
+    }
+    bool add(const char* name, const char* help, MetricHistogram& m, const char* labels = nullptr) {
+        return add(name, help, HISTOGRAM, &m, labels);
+    }
+
+    size_t size() const { return _count; }
+    // add() yang ditolak karena METRICS_MAX_ENTRIES penuh
+    size_t rejected() const { return _rejected; }
+
+    // Format teks Prometheus 0.0.4
+    void write(MetricsSink sink, void* ctx) const {
+        char line[160];
+        for (size_t i = 0; i < _count; i++) {
+            const Entry& e = _entries[i];
+            if (i == 0 || strcmp(_entries[i - 1].name, e.name) != 0) {
+                static const char* typeNames[] = {"counter", "gauge", "histogram"};
+                emit(sink, ctx, line, sizeof(line), "# HELP %s %s\n# TYPE %s %s\n",
+                     e.name, e.help, e.name, typeNames[e.type]);
+            }
+
+            const char* labels = e.labels ? e.labels : "";
+            const char* open = e.labels ? "{" : "";
+            const char* close = e.labels ? "}" : "";
+            if (e.type == COUNTER) {
+                emit(sink, ctx, line, sizeof(line), "%s%s%s%s %lu\n", e.name, open, labels, close,
+                     (unsigned long)((const MetricCounter*)e.metric)->value());
+            } else if (e.type == GAUGE) {
+                emit(sink, ctx, line, sizeof(line), "%s%s%s%s %ld\n", e.name, open, labels, close,
+                     (long)((const MetricGauge*)e.metric)->value());
+            } else {
+                writeHistogram(sink, ctx, line, sizeof(line), e);
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        const char* name;
+        const char* help;
+        const char* labels;
+        Type type;
+        void* metric;
+    };
+
+    bool add(const char* name, const char* help, Type type, void* metric, const char* labels) {
+        if (_count >= METRICS_MAX_ENTRIES) {
+            _rejected++;
+            return false;
+        }
+        _entries[_count++] = {name, help, labels, type, metric};
+        return true;
+    }
+
+    // Format satu baris ke buffer lalu kirim; baris terlalu panjang dipotong
+    static void emit(MetricsSink sink, void* ctx, char* line, size_t size, const char* format, ...)
+        __attribute__((format(printf, 5, 6))) {
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(line, size, format, args);
+        va_end(args);
+        if (n > 0) sink(line, (size_t)n < size ? (size_t)n : size - 1, ctx);
+    }
+
+    static void writeHistogram(MetricsSink sink, void* ctx, char* line, size_t size, const Entry& e) {
+        const MetricHistogram& h = *(const MetricHistogram*)e.metric;
+        const char* labels = e.labels ? e.labels : "";
+        const char* sep = e.labels ? "," : "";
+        const char* open = e.labels ? "{" : "";
+        const char* close = e.labels ? "}" : "";
+        uint32_t cumulative = 0;
+        for (uint8_t b = 0; b < h.boundCount(); b++) {
+            cumulative += h.bucket(b);
+            emit(sink, ctx, line, size, "%s_bucket{%s%sle=\"%lu\"} %lu\n", e.name, labels, sep,
+                 (unsigned long)h.bound(b), (unsigned long)cumulative);
+        }
+        emit(sink, ctx, line, size, "%s_bucket{%s%sle=\"+Inf\"} %lu\n", e.name, labels, sep,
+             (unsigned long)h.count());
+        emit(sink, ctx, line, size, "%s_sum%s%s%s %llu\n", e.name, open, labels, close,
+             (unsigned long long)h.sum());
+        emit(sink, ctx, line, size, "%s_count%s%s%s %lu\n", e.name, open, labels, close,
+             (unsigned long)h.count());
+    }
+
+    Entry _entries[METRICS_MAX_ENTRIES];
+    size_t _count = 0;
+    size_t _rejected = 0;
+};
@@ -0,0 +1,82 @@
+/*
+ * NodeId - Identitas node dari MAC & path API per node
+ *
+ * ID = 12 digit hex huruf kecil dari MAC STA, mis. "a4cf12b3c4d5". Stabil
+ * selama chip sama (tidak tersimpan di flash, tidak berubah saat reflash),
+ * unik per perangkat, dan aman dipakai di path URL.
+ *
+ *   uint8_t mac[6];
+ *   WiFi.macAddress(mac);
+ *   char id[NODE_ID_SIZE];
+ *   nodeIdFromMac(mac, id);
+ *   nodePath(path, sizeof(path), id, "/telemetry");   // "/api/nodes/<id>/telemetry"
+ *
+ * Tidak bergantung pada Arduino (dipakai juga oleh simulasi & load generator).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+static const size_t NODE_ID_SIZE = 13; // 12 hex + '\0'
+static const size_t NODE_MAC_SIZE = 6;
+
+#define NODE_API_PREFIX "/api/nodes/"
+
+inline void nodeIdFromMac(const uint8_t mac[NODE_MAC_SIZE], char out[NODE_ID_SIZE]) {
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+    for (size_t i = 0; i < NODE_MAC_SIZE; i++) {
+        out[i * 2] = HEX_DIGITS[mac[i] >> 4];
+        out[i * 2 + 1] = HEX_DIGITS[mac[i] & 0x0F];
+    }
+    out[NODE_ID_SIZE - 1] = '\0';
+}
+
+// Kebalikan nodeIdFromMac(); false jika id bukan 12 digit hex
+inline bool nodeIdToMac(const char* id, uint8_t mac[NODE_MAC_SIZE]) {
+    if (!id || strlen(id) != NODE_ID_SIZE - 1) return false;
+    for (size_t i = 0; i < NODE_ID_SIZE - 1; i++) {
+        char c = id[i];
+        uint8_t v;
+        if (c >= '0' && c <= '9') v = c - '0';
+        else if (c >= 'a' && c <= 'f') v = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') v = c - 'A' + 10;
+        else return false;
+        if (i % 2 == 0) mac[i / 2] = v << 4;
+        else mac[i / 2] |= v;
+    }
+    return true;
+}
+
+// "/api/nodes/<id><suffix>"; false jika tidak muat (out tetap berakhir '\0')
+inline bool nodePath(char* out, size_t size, const char* id, const char* suffix) {
+    size_t prefix = sizeof(NODE_API_PREFIX) - 1;
+    size_t idLen = strlen(id);
+    size_t suffixLen = strlen(suffix);
+    if (size == 0) return false;
+    if (prefix + idLen + suffixLen + 1 > size) {
+        out[0] = '\0';
+        return false;
+    }
+    memcpy(out, NODE_API_PREFIX, prefix);
+    memcpy(out + prefix, id, idLen);
+    memcpy(out + prefix + idLen, suffix, suffixLen + 1);
+    return true;
+}
+
+// Ambil <id> dari path "/api/nodes/<id>/..."; mengembalikan sisa path
+// ("/telemetry") atau nullptr jika bukan path per node
+inline const char* nodePathSplit(const char* path, char id[NODE_ID_SIZE]) {
+    size_t prefix = sizeof(NODE_API_PREFIX) - 1;
+    if (strncmp(path, NODE_API_PREFIX, prefix) != 0) return nullptr;
+    const char* start = path + prefix;
+    const char* end = strchr(start, '/');
+    size_t len = end ? (size_t)(end - start) : strlen(start);
+    if (len != NODE_ID_SIZE - 1) return nullptr;
+    memcpy(id, start, len);
+    id[len] = '\0';
+    uint8_t mac[NODE_MAC_SIZE];
+    if (!nodeIdToMac(id, mac)) return nullptr;
+    return end ? end : start + len;
+}
@@ -0,0 +1,216 @@
+/*
+ * EspOta - Update firmware OTA di ESP32: unduh streaming, partisi app, boot trial
+ *
+ *   EspOtaClient ota;
+ *   EspOtaTrial otaTrial(3, 600000);
+ *
+ *   // setup()
+ *   otaTrial.begin();                           // Rollback otomatis jika crash loop
+ *   ota.begin(apiHost, apiPort, nodeId);
+ *
+ *   // Job periodik
+ *   OtaManifest m;
+ *   if (ota.check(path, FIRMWARE_VERSION, m) == OtaClient::UPDATE) ota.start(m);
+ *   ota.step();                                 // Berulang sampai DONE/FAILED
+ *   // DONE: otaTrial.arm(); ESP.restart();
+ *
+ *   // Selama trial (image baru belum dikonfirmasi)
+ *   otaTrial.check(healthy, millis());          // CONFIRM -> confirm(), FAIL -> rollback()
+ *
+ * Alur unduhan ada di OtaClient (OtaClient.h, tanpa Arduino); EspOtaClient
+ * hanya memasangnya ke HttpTransport, esp_ota_* dan millis(). Unduhan memakai
+ * koneksi HTTP sendiri (bukan koneksi keep-alive API), jadi polling status &
+ * upload tetap berjalan di sela step().
+ *
+ * Image ditulis lewat esp_ota_* (erase per sektor saat ditulis), diverifikasi
+ * SHA-256 oleh OtaSession, lalu divalidasi esp_ota_end() sebelum dijadikan
+ * partisi boot. Status trial disimpan di NVS (namespace "ota").
+ */
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <Preferences.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <HttpTransport.h>
+#include "OtaUpdate.h"
+
+#define OTA_IDLE_TIMEOUT_MS HttpTransport::TIMEOUT_MS
+#include "OtaClient.h"
+
+class EspOtaTarget : public OtaTarget {
+public:
+    bool begin(uint32_t size) override {
+        _partition = esp_ota_get_next_update_partition(nullptr);
+        if (!_partition || size > _partition->size) return false;
+        return esp_ota_begin(_partition, OTA_WITH_SEQUENTIAL_WRITES, &_handle) == ESP_OK;
+    }
+
+    bool write(const uint8_t* data, size_t length) override {
+        return esp_ota_write(_handle, data, length) == ESP_OK;
+    }
+
+    bool end() override {
+        esp_ota_handle_t handle = _handle;
+        _handle = 0;
+        return esp_ota_end(handle) == ESP_OK && esp_ota_set_boot_partition(_partition) == ESP_OK;
+    }
+
+    void abort() override {
+        if (_handle) esp_ota_abort(_handle);
+        _handle = 0;
+    }
+
+private:
+    const esp_partition_t* _partition = nullptr;
+    esp_ota_handle_t _handle = 0;
+};
+
+class RunningAppSource : public OtaSource {
+public:
+    void begin() { _partition = esp_ota_get_running_partition(); }
+
+    uint32_t size() const override { return _partition ? _partition->size : 0; }
+
+    bool read(uint32_t offset, void* dst, size_t length) override {
+        return _partition && esp_partition_read(_partition, offset, dst, length) == ESP_OK;
+    }
+
+private:
+    const esp_partition_t* _partition = nullptr;
+};
+
+class EspOtaTrial {
+public:
+    EspOtaTrial(uint8_t maxBoots, unsigned long healthTimeoutMs) : _trial(maxBoots, healthTimeoutMs) {}
+
+    // Sekali di setup(). ROLLBACK tidak kembali: restart ke image lama.
+    OtaTrial::Action begin() {
+        load();
+        OtaTrial::Action action = _trial.boot(_record);
+        if (action != OtaTrial::NORMAL) save(); // Tanpa tulis NVS di boot/bangun biasa
+        if (action == OtaTrial::ROLLBACK) rollback();
+        return action;
+    }
+
+    // Image baru sudah menjadi partisi boot; boot berikutnya = trial
+    void arm() {
+        OtaTrial::arm(_record, esp_ota_get_running_partition()->address);
+        save();
+    }
+
+    OtaTrial::Verdict check(bool healthy, unsigned long sinceBootMs) const {
+        return pending() ? _trial.check(healthy, sinceBootMs) : OtaTrial::CONFIRM;
+    }
+
+    void confirm() {
+        OtaTrial::finish(_record);
+        save();
+        esp_ota_img_states_t state;
+        if (esp_ota_get_state_partition(esp_ota_get_running_partition(), &state) == ESP_OK &&
+            state == ESP_OTA_IMG_PENDING_VERIFY) {
+            esp_ota_mark_app_valid_cancel_rollback(); // Bootloader dengan rollback aktif
+        }
+    }
+
+    // Kembali ke partisi lama lalu restart
+    void rollback() {
+        const esp_partition_t* previous = nullptr;
+        esp_partition_iterator_t it = esp_partition_find(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_ANY, nullptr);
+        for (; it; it = esp_partition_next(it)) {
+            const esp_partition_t* p = esp_partition_get(it);
+            if (p->address == _record.previous) previous = p;
+        }
+        esp_partition_iterator_release(it);
+        OtaTrial::finish(_record);
+        save();
+        if (previous) esp_ota_set_boot_partition(previous);
+        delay(100); // Beri waktu log terakhir keluar
+        esp_restart();
+    }
+
+    bool pending() const { return _record.magic == OTA_TRIAL_MAGIC && _record.pending; }
+    uint8_t boots() const { return _record.boots; }
+
+private:
+    void load() {
+        Preferences prefs;
+        prefs.begin("ota", true);
+        if (prefs.getBytes("trial", &_record, sizeof(_record)) != sizeof(_record)) _record = OtaTrialRecord();
+        prefs.end();
+    }
+
+    void save() {
+        Preferences prefs;
+        prefs.begin("ota", false);
+        prefs.putBytes("trial", &_record, sizeof(_record));
+        prefs.end();
+    }
+
+    OtaTrial _trial;
+    OtaTrialRecord _record = {};
+};
+
+// OtaTransport di atas HttpTransport; body payload dibaca langsung dari socket
+class HttpOtaTransport : public OtaTransport {
+public:
+    HttpTransport& http() { return _http; }
+
+    void setRange(uint32_t from) override { _http.setRange(from); }
+
+    int get(const char* path) override {
+        _body = nullptr;
+        return _http.get(path);
+    }
+
+    const char* readBody(size_t& length) override {
+        int n = _http.readBody();
+        if (n < 0) return nullptr;
+        length = (size_t)n;
+        return _http.body();
+    }
+
+    int available() override { return body().available(); }
+    size_t read(uint8_t* dst, size_t length) override { return body().readBytes(dst, length); }
+    bool connected() override { return _http.http().connected(); }
+
+    void end() override {
+        _http.end();
+        _body = nullptr;
+    }
+
+    void reset() override {
+        _http.reset();
+        _body = nullptr;
+    }
+
+private:
+    // bodyStream() memasang ulang pembaca body; cukup sekali per request
+    Stream& body() {
+        if (!_body) _body = &_http.bodyStream();
+        return *_body;
+    }
+
+    HttpTransport _http;
+    Stream* _body = nullptr;
+};
+
+// OtaClient dengan HttpTransport, partisi app ESP32 dan millis()
+class EspOtaClient : public OtaClient {
+public:
+    // Base hanya menyimpan referensi; anggota dibangun sebelum dipakai di begin()
+    EspOtaClient() : OtaClient(_transport, _target, _source, millis) {}
+
+    void begin(const char* host, uint16_t port, const char* nodeId) {
+        _transport.http().begin(host, port);
+        _transport.http().setNodeId(nodeId);
+        _source.begin();
+        setNodeId(nodeId);
+    }
+
+private:
+    HttpOtaTransport _transport;
+    EspOtaTarget _target;
+    RunningAppSource _source;
+};
@@ -0,0 +1,242 @@
+/*
+ * OtaClient - Unduhan OTA bertahap: manifest, Range resume, batas ulang
+ *
+ *   OtaClient ota(transport, target, running, millis);
+ *   ota.setNodeId(nodeId);
+ *
+ *   OtaManifest m;
+ *   if (ota.check(path, FIRMWARE_VERSION, m) == OtaClient::UPDATE) ota.start(m);
+ *   ota.step();                                 // Berulang sampai DONE/FAILED
+ *
+ * Setiap step() membaca paling banyak OTA_STEP_BYTES yang sudah ada di
+ * transport lalu kembali; tidak menunggu data. Koneksi putus, diam lebih
+ * dari OTA_IDLE_TIMEOUT_MS, atau error 5xx = lanjut dengan header Range dari
+ * byte terakhir yang diterima setelah jeda OTA_IDLE_TIMEOUT_MS (maks.
+ * OTA_MAX_RESUMES kali). Error 4xx = gagal tanpa mengulang.
+ *
+ * Tidak bergantung pada Arduino: HTTP lewat OtaTransport, flash lewat
+ * OtaTarget/OtaSource, waktu lewat fungsi millis yang diberikan. Firmware
+ * memakai EspOtaClient (EspOta.h), simulasi host memakai transport & flash
+ * tiruan (sim/src/ota.cpp).
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <ArduinoJson.h>
+#include "OtaUpdate.h"
+
+#ifndef OTA_STEP_BYTES
+#define OTA_STEP_BYTES 8192
+#endif
+#ifndef OTA_MAX_RESUMES
+#define OTA_MAX_RESUMES 10
+#endif
+#ifndef OTA_IDLE_TIMEOUT_MS
+#define OTA_IDLE_TIMEOUT_MS 5000    // HttpTransport::TIMEOUT_MS
+#endif
+
+// Satu koneksi HTTP untuk manifest & payload
+class OtaTransport {
+public:
+    virtual ~OtaTransport() {}
+    virtual void setRange(uint32_t from) = 0;   // Untuk get() berikutnya saja (0 = tanpa)
+    virtual int get(const char* path) = 0;      // Kode HTTP, <= 0 = error transport
+    // Seluruh body (menunggu), nullptr jika gagal/terlalu besar
+    virtual const char* readBody(size_t& length) = 0;
+    virtual int available() = 0;                // Byte body yang sudah ada, tanpa menunggu
+    virtual size_t read(uint8_t* dst, size_t length) = 0;
+    virtual bool connected() = 0;
+    virtual void end() = 0;                     // Selesai request
+    virtual void reset() = 0;                   // Tutup paksa koneksi
+};
+
+class OtaClient {
+public:
+    enum Status { IDLE, RUNNING, DONE, FAILED };
+    enum Check { NO_UPDATE, UPDATE, NOT_IN_ROLLOUT, CHECK_FAILED };
+
+    struct Stats {
+        uint32_t updates;       // Image terverifikasi & siap di-boot
+        uint32_t failures;
+        uint32_t resumes;       // Koneksi dilanjutkan dengan Range
+        uint32_t bytes;         // Payload diterima (penuh atau delta)
+        uint32_t lastMs;        // Lama unduhan terakhir yang selesai
+    };
+
+    OtaClient(OtaTransport& http, OtaTarget& target, OtaSource& running, unsigned long (*millis)())
+        : _http(http), _session(target, running), _millis(millis) {}
+
+    // Untuk pembagian rollout (string harus tetap hidup)
+    void setNodeId(const char* nodeId) { _nodeId = nodeId; }
+
+    // GET manifest. UPDATE jika server menawarkan versi lain dan node ini
+    // termasuk rollout. 204/404 = tidak ada firmware untuk node ini.
+    Check check(const char* path, const char* currentVersion, OtaManifest& m) {
+        int code = _http.get(path);
+        bool ok = code == 200 && parseManifest(m);
+        _http.end();
+        if (code == 204 || code == 404 || (ok && strcmp(m.version, currentVersion) == 0)) return NO_UPDATE;
+        if (!ok) return CHECK_FAILED;
+        return otaInRollout(_nodeId, m.version, m.rollout) ? UPDATE : NOT_IN_ROLLOUT;
+    }
+
+    // Mulai unduhan; patch delta dipakai jika ada dan lebih kecil
+    bool start(const OtaManifest& m) {
+        _manifest = m;
+        _status = RUNNING;
+        _transportError = false;
+        _connected = false;
+        _resumes = 0;
+        _retryAt = 0;
+        _startMs = _millis();
+        bool delta = m.deltaSize > 0 && m.deltaSize < m.size && m.deltaPath[0];
+        if (!_session.begin(m, delta)) {
+            fail();
+            return false;
+        }
+        return true;
+    }
+
+    // Baca data yang sudah tersedia (maks. OTA_STEP_BYTES) tanpa menunggu
+    Status step() {
+        if (_status != RUNNING) return _status;
+        if (!_connected) {
+            if ((long)(_millis() - _retryAt) < 0 || !request()) return _status;
+        }
+
+        size_t budget = OTA_STEP_BYTES;
+        while (budget > 0) {
+            int available = _http.available();
+            if (available <= 0) break;
+            size_t n = (size_t)available < sizeof(_buf) ? (size_t)available : sizeof(_buf);
+            if (n > budget) n = budget;
+            n = _http.read(_buf, n);
+            if (n == 0) break;
+            _lastDataMs = _millis();
+            _stats.bytes += n;
+            budget -= n;
+            if (!_session.feed(_buf, n)) return fail();
+        }
+
+        if (_session.received() == _session.payloadSize()) {
+            _http.end();
+            _connected = false;
+            if (!_session.finish()) return fail();
+            _status = DONE;
+            _stats.updates++;
+            _stats.lastMs = _millis() - _startMs;
+            return _status;
+        }
+
+        // Koneksi putus atau diam terlalu lama: lanjutkan dari byte terakhir
+        if (!_http.connected() || _millis() - _lastDataMs > OTA_IDLE_TIMEOUT_MS) {
+            _http.reset();
+            _connected = false;
+            retryLater();
+        }
+        return _status;
+    }
+
+    void cancel() {
+        _session.abort();
+        _http.reset();
+        _connected = false;
+        _status = IDLE;
+    }
+
+    Status status() const { return _status; }
+    bool delta() const { return _session.delta(); }
+    uint32_t received() const { return _session.received(); }
+    uint32_t payloadSize() const { return _session.payloadSize(); }
+    uint8_t progressPct() const {
+        return _session.payloadSize() ? (uint8_t)((uint64_t)_session.received() * 100 / _session.payloadSize()) : 0;
+    }
+    const OtaManifest& manifest() const { return _manifest; }
+    const char* lastError() const { return _transportError ? "transport" : OtaSession::errorName(_session.error()); }
+    const Stats& stats() const { return _stats; }
+
+private:
+    bool parseManifest(OtaManifest& m) {
+        size_t length = 0;
+        const char* body = _http.readBody(length);
+        if (!body) return false;
+#if ARDUINOJSON_VERSION_MAJOR >= 7
+        JsonDocument doc;
+#else
+        StaticJsonDocument<768> doc;
+#endif
+        if (deserializeJson(doc, body, length)) return false;
+        memset(&m, 0, sizeof(m));
+        snprintf(m.version, sizeof(m.version), "%s", doc["version"] | "");
+        snprintf(m.path, sizeof(m.path), "%s", doc["url"] | "");
+        m.size = doc["size"] | 0;
+        m.rollout = doc["rollout"] | 100;
+        snprintf(m.deltaPath, sizeof(m.deltaPath), "%s", doc["delta"]["url"] | "");
+        m.deltaSize = doc["delta"]["size"] | 0;
+        return m.version[0] && m.path[0] && m.size > 0 && otaParseHex(doc["sha256"] | "", m.sha256, SHA256_SIZE);
+    }
+
+    // GET payload mulai dari received(); 200 untuk request dengan Range
+    // (server mengabaikan Range) = ulang dari awal
+    bool request() {
+        const char* path = _session.delta() ? _manifest.deltaPath : _manifest.path;
+        uint32_t from = _session.received();
+        _http.setRange(from);
+        int code = _http.get(path);
+        _lastDataMs = _millis();
+        if (code == 200 && from > 0) {
+            if (!_session.begin(_manifest, _session.delta())) {
+                fail();
+                return false;
+            }
+        } else if (code != (from ? 206 : 200)) {
+            _http.end();
+            if (code > 0 && code < 500) {
+                _transportError = true;
+                fail(); // 404, 416, ...: tidak akan berhasil dengan mengulang
+            } else {
+                retryLater();
+            }
+            return false;
+        }
+        _connected = true;
+        return true;
+    }
+
+    void retryLater() {
+        _stats.resumes++;
+        if (++_resumes > OTA_MAX_RESUMES) {
+            _transportError = true;
+            fail();
+            return;
+        }
+        _retryAt = _millis() + OTA_IDLE_TIMEOUT_MS;
+    }
+
+    Status fail() {
+        _session.abort();
+        _http.reset();
+        _connected = false;
+        _status = FAILED;
+        _stats.failures++;
+        return _status;
+    }
+
+    OtaTransport& _http;
+    OtaSession _session;
+    unsigned long (*_millis)();
+    OtaManifest _manifest = {};
+    const char* _nodeId = "";
+    Status _status = IDLE;
+    bool _connected = false;    // Body payload sedang dibaca
+    bool _transportError = false;
+    uint8_t _resumes = 0;
+    unsigned long _retryAt = 0;
+    unsigned long _startMs = 0;
+    unsigned long _lastDataMs = 0;
+    Stats _stats = {};
+    uint8_t _buf[1024];
+};
@@ -0,0 +1,369 @@
+/*
+ * OtaUpdate - Inti update firmware OTA: manifest, patch delta, verifikasi, boot trial
+ *
+ * Image (penuh atau patch delta) diterima per potongan dan langsung ditulis
+ * ke partisi app yang tidak aktif; tidak pernah disangga utuh di RAM.
+ *
+ *   OtaSession session(target, running);
+ *   session.begin(manifest, useDelta);
+ *   session.feed(chunk, length);         // Berulang; received() = offset untuk Range
+ *   session.finish();                    // Ukuran + SHA-256 image, lalu target.end()
+ *
+ * Patch delta (".pd") terhadap image yang sedang berjalan. Semua angka
+ * little-endian.
+ *
+ *   Header (44 byte)
+ *     0  'P' 'D'         magic
+ *     2  uint8  version  (OTA_DELTA_VERSION)
+ *     3  uint8  cadangan
+ *     4  uint32 baseSize   panjang image lama yang dirujuk
+ *     8  uint32 targetSize panjang image baru (= manifest.size)
+ *    12  uint8[32] SHA-256 image lama (baseSize byte pertama partisi aktif)
+ *
+ *   Operasi, diulang sampai targetSize byte tertulis
+ *     'C' varint length, zigzag varint delta   salin dari image lama mulai
+ *                                              (akhir salinan sebelumnya + delta)
+ *     'A' varint length, <length byte>         sisipkan byte baru
+ *
+ * Offset relatif membuat salinan berurutan (kode yang hanya bergeser) cukup
+ * 2-4 byte per operasi. Image lama diverifikasi dengan SHA-256 sebelum byte
+ * pertama ditulis, jadi patch untuk versi lain ditolak tanpa merusak apa pun.
+ * Hasil akhirnya selalu diverifikasi dengan SHA-256 dari manifest, sama
+ * seperti image penuh.
+ *
+ * Boot trial (OtaTrial): image baru dianggap percobaan sampai health check
+ * firmware lolos. Terlalu banyak boot tanpa konfirmasi (crash loop) atau
+ * health check gagal sampai batas waktu = kembali ke partisi lama. Tidak
+ * bergantung pada bootloader dengan rollback aktif.
+ *
+ * Tidak bergantung pada Arduino (dipakai juga oleh simulasi host dengan flash
+ * tiruan). Implementasi ESP32: EspOta.h.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "Sha256.h"
+
+static const size_t OTA_VERSION_SIZE = 24;
+static const size_t OTA_PATH_SIZE = 96;
+static const size_t OTA_DELTA_HEADER_SIZE = 44;
+static const uint8_t OTA_DELTA_VERSION = 1;
+static const uint8_t OTA_OP_COPY = 'C';
+static const uint8_t OTA_OP_ADD = 'A';
+
+// Isi response endpoint firmware (JSON, lihat README control node)
+struct OtaManifest {
+    char version[OTA_VERSION_SIZE];
+    uint32_t size;                      // Panjang image penuh
+    uint8_t sha256[SHA256_SIZE];        // SHA-256 image penuh
+    char path[OTA_PATH_SIZE];           // Image penuh di server yang sama
+    uint32_t deltaSize;                 // 0 = tidak ada patch dari versi yang berjalan
+    char deltaPath[OTA_PATH_SIZE];
+    uint8_t rollout;                    // Persen node yang ikut (0-100)
+};
+
+// "0a1b..." -> byte; false jika panjang/karakter tidak valid
+inline bool otaParseHex(const char* hex, uint8_t* out, size_t size) {
+    if (!hex || strlen(hex) != size * 2) return false;
+    for (size_t i = 0; i < size * 2; i++) {
+        char c = hex[i];
+        uint8_t v;
+        if (c >= '0' && c <= '9') v = c - '0';
+        else if (c >= 'a' && c <= 'f') v = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') v = c - 'A' + 10;
+        else return false;
+        if (i % 2 == 0) out[i / 2] = v << 4;
+        else out[i / 2] |= v;
+    }
+    return true;
+}
+
+// Bucket 0-99 per node & versi (FNV-1a). Node dengan bucket < rollout ikut
+// update; menaikkan rollout tidak mengeluarkan node yang sudah ikut, dan
+// versi berikutnya memilih kelompok awal yang berbeda.
+inline uint8_t otaRolloutBucket(const char* nodeId, const char* version) {
+    uint32_t hash = 2166136261u;
+    for (const char* p = nodeId; *p; p++) hash = (hash ^ (uint8_t)*p) * 16777619u;
+    hash = (hash ^ '/') * 16777619u;
+    for (const char* p = version; *p; p++) hash = (hash ^ (uint8_t)*p) * 16777619u;
+    return (uint8_t)(hash % 100);
+}
+
+inline bool otaInRollout(const char* nodeId, const char* version, uint8_t percent) {
+    return otaRolloutBucket(nodeId, version) < percent;
+}
+
+// Partisi app tujuan (tidak aktif); ditulis berurutan dari offset 0
+class OtaTarget {
+public:
+    virtual ~OtaTarget() {}
+    virtual bool begin(uint32_t size) = 0;
+    virtual bool write(const uint8_t* data, size_t length) = 0;
+    virtual bool end() = 0;             // Image lengkap: validasi & jadikan partisi boot
+    virtual void abort() = 0;
+};
+
+// Image yang sedang berjalan (basis patch delta)
+class OtaSource {
+public:
+    virtual ~OtaSource() {}
+    virtual uint32_t size() const = 0;
+    virtual bool read(uint32_t offset, void* dst, size_t length) = 0;
+};
+
+class OtaSession {
+public:
+    enum Error { NONE, TARGET_FAILED, SIZE_MISMATCH, HASH_MISMATCH, BAD_DELTA, WRONG_BASE, SOURCE_FAILED };
+
+    OtaSession(OtaTarget& target, OtaSource& running) : _target(target), _running(running) {}
+
+    // delta = payload berupa patch terhadap image yang berjalan
+    bool begin(const OtaManifest& manifest, bool delta) {
+        abort();
+        _error = NONE;
+        _delta = delta;
+        _imageSize = manifest.size;
+        _payloadSize = delta ? manifest.deltaSize : manifest.size;
+        memcpy(_expected, manifest.sha256, SHA256_SIZE);
+        _received = 0;
+        _written = 0;
+        _sha.reset();
+        _state = HEADER;
+        _headerUsed = 0;
+        _copyEnd = 0;
+        _active = true;
+        if (!_target.begin(_imageSize)) return fail(TARGET_FAILED);
+        return true;
+    }
+
+    // Potongan payload berikutnya (urut, mulai dari received())
+    bool feed(const uint8_t* data, size_t length) {
+        if (!_active) return false;
+        if (length > _payloadSize - _received) return fail(SIZE_MISMATCH);
+        _received += length;
+        if (!_delta) return emit(data, length);
+
+        while (length > 0) {
+            if (_state == LITERAL) {
+                size_t take = length < _remaining ? length : (size_t)_remaining;
+                if (!emit(data, take)) return false;
+                data += take;
+                length -= take;
+                _remaining -= take;
+                if (_remaining == 0) _state = OP;
+                continue;
+            }
+            if (!step(*data++)) return false;
+            length--;
+        }
+        return true;
+    }
+
+    bool finish() {
+        if (!_active) return false;
+        if (_received != _payloadSize || _written != _imageSize || (_delta && _state != OP)) {
+            return fail(SIZE_MISMATCH);
+        }
+        uint8_t digest[SHA256_SIZE];
+        _sha.finish(digest);
+        if (memcmp(digest, _expected, SHA256_SIZE) != 0) return fail(HASH_MISMATCH);
+        _active = false;
+        if (!_target.end()) {
+            _error = TARGET_FAILED;
+            return false;
+        }
+        return true;
+    }
+
+    void abort() {
+        if (_active) _target.abort();
+        _active = false;
+    }
+
+    bool active() const { return _active; }
+    bool delta() const { return _delta; }
+    uint32_t received() const { return _received; }
+    uint32_t payloadSize() const { return _payloadSize; }
+    uint32_t written() const { return _written; }
+    Error error() const { return _error; }
+
+    static const char* errorName(Error error) {
+        static const char* const NAMES[] = {"ok", "target", "size", "hash", "delta", "base", "source"};
+        return NAMES[error];
+    }
+
+private:
+    enum State : uint8_t { HEADER, OP, LENGTH, OFFSET, LITERAL };
+
+    bool fail(Error error) {
+        _error = error;
+        abort();
+        return false;
+    }
+
+    bool emit(const uint8_t* data, size_t length) {
+        if (length > _imageSize - _written) return fail(SIZE_MISMATCH);
+        _sha.update(data, length);
+        if (!_target.write(data, length)) return fail(TARGET_FAILED);
+        _written += length;
+        return true;
+    }
+
+    // Satu byte header/opcode/varint patch
+    bool step(uint8_t b) {
+        switch (_state) {
+        case HEADER:
+            _header[_headerUsed++] = b;
+            return _headerUsed < OTA_DELTA_HEADER_SIZE || parseHeader();
+        case OP:
+            if (b != OTA_OP_COPY && b != OTA_OP_ADD) return fail(BAD_DELTA);
+            _op = b;
+            _varint = 0;
+            _shift = 0;
+            _state = LENGTH;
+            return true;
+        case LENGTH:
+        case OFFSET:
+            if (_shift > 28) return fail(BAD_DELTA);
+            _varint |= (uint32_t)(b & 0x7F) << _shift;
+            _shift += 7;
+            if (b & 0x80) return true;
+            return _state == LENGTH ? lengthDone() : copy();
+        default:
+            return fail(BAD_DELTA);
+        }
+    }
+
+    bool lengthDone() {
+        _remaining = _varint;
+        _varint = 0;
+        _shift = 0;
+        if (_op == OTA_OP_COPY) {
+            _state = OFFSET;
+        } else {
+            _state = _remaining ? LITERAL : OP;
+        }
+        return true;
+    }
+
+    bool copy() {
+        int64_t delta = (int64_t)(_varint >> 1) ^ -(int64_t)(_varint & 1);
+        int64_t offset = (int64_t)_copyEnd + delta;
+        if (offset < 0 || offset + _remaining > _baseSize) return fail(BAD_DELTA);
+        uint8_t buf[256];
+        uint32_t from = (uint32_t)offset;
+        uint32_t left = _remaining;
+        while (left > 0) {
+            size_t n = left < sizeof(buf) ? left : sizeof(buf);
+            if (!_running.read(from, buf, n)) return fail(SOURCE_FAILED);
+            if (!emit(buf, n)) return false;
+            from += n;
+            left -= n;
+        }
+        _copyEnd = from;
+        _state = OP;
+        return true;
+    }
+
+    static uint32_t readU32(const uint8_t* p) {
+        return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+    }
+
+    // Header lengkap: cocokkan dengan manifest & image yang berjalan
+    bool parseHeader() {
+        if (_header[0] != 'P' || _header[1] != 'D' || _header[2] != OTA_DELTA_VERSION) return fail(BAD_DELTA);
+        _baseSize = readU32(_header + 4);
+        if (readU32(_header + 8) != _imageSize) return fail(BAD_DELTA);
+        if (_baseSize > _running.size()) return fail(WRONG_BASE);
+
+        Sha256 base;
+        uint8_t buf[256];
+        for (uint32_t offset = 0; offset < _baseSize;) {
+            size_t n = _baseSize - offset < sizeof(buf) ? _baseSize - offset : sizeof(buf);
+            if (!_running.read(offset, buf, n)) return fail(SOURCE_FAILED);
+            base.update(buf, n);
+            offset += n;
+        }
+        uint8_t digest[SHA256_SIZE];
+        base.finish(digest);
+        if (memcmp(digest, _header + 12, SHA256_SIZE) != 0) return fail(WRONG_BASE);
+        _state = OP;
+        return true;
+    }
+
+    OtaTarget& _target;
+    OtaSource& _running;
+    bool _active = false;
+    bool _delta = false;
+    Error _error = NONE;
+    uint32_t _imageSize = 0;
+    uint32_t _payloadSize = 0;
+    uint32_t _received = 0;
+    uint32_t _written = 0;
+    uint8_t _expected[SHA256_SIZE];
+    Sha256 _sha;
+
+    State _state = HEADER;
+    uint8_t _header[OTA_DELTA_HEADER_SIZE];
+    size_t _headerUsed = 0;
+    uint32_t _baseSize = 0;
+    uint8_t _op = 0;
+    uint32_t _varint = 0;
+    uint8_t _shift = 0;
+    uint32_t _remaining = 0;
+    uint32_t _copyEnd = 0;
+};
+
+// ==================== BOOT TRIAL ====================
+
+const uint8_t OTA_TRIAL_MAGIC = 0xA7;
+
+// Disimpan pemanggil di memori non-volatil (NVS), 8 byte
+struct OtaTrialRecord {
+    uint8_t magic;          // OTA_TRIAL_MAGIC jika isi valid
+    uint8_t pending;        // 1 = image baru belum dikonfirmasi sehat
+    uint8_t boots;          // Boot sejak image baru diaktifkan
+    uint8_t reserved;
+    uint32_t previous;      // Alamat partisi image lama (tujuan rollback)
+};
+
+class OtaTrial {
+public:
+    enum Action { NORMAL, TRIAL, ROLLBACK };
+    enum Verdict { WAIT, CONFIRM, FAIL };
+
+    OtaTrial(uint8_t maxBoots, unsigned long healthTimeoutMs)
+        : _maxBoots(maxBoots), _healthTimeoutMs(healthTimeoutMs) {}
+
+    // Sebelum restart ke image baru
+    static void arm(OtaTrialRecord& record, uint32_t previous) {
+        record.magic = OTA_TRIAL_MAGIC;
+        record.pending = 1;
+        record.boots = 0;
+        record.reserved = 0;
+        record.previous = previous;
+    }
+
+    // Setiap boot (record lalu disimpan lagi oleh pemanggil)
+    Action boot(OtaTrialRecord& record) const {
+        if (record.magic != OTA_TRIAL_MAGIC || !record.pending) return NORMAL;
+        if (record.boots < 255) record.boots++;
+        return record.boots > _maxBoots ? ROLLBACK : TRIAL;
+    }
+
+    // Health check periodik selama TRIAL: sehat = konfirmasi, batas waktu
+    // terlewat = rollback
+    Verdict check(bool healthy, unsigned long sinceBootMs) const {
+        if (healthy) return CONFIRM;
+        return sinceBootMs >= _healthTimeoutMs ? FAIL : WAIT;
+    }
+
+    // Dikonfirmasi atau sudah di-rollback
+    static void finish(OtaTrialRecord& record) { record.pending = 0; }
+
+private:
+    uint8_t _maxBoots;
+    unsigned long _healthTimeoutMs;
+};
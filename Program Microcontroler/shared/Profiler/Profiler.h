@@ -0,0 +1,151 @@
+/*
+ * Profiler - Histogram latensi ringan untuk hot path firmware & benchmark host
+ *
+ * LatencyHistogram memakai bucket log-linear (4 sub-bucket per oktaf), jadi
+ * ukurannya tetap (~500 byte) berapa pun jumlah sampelnya dan persentil bisa
+ * dihitung tanpa menyimpan sampel. Error persentil maks. ~25% (lebar bucket),
+ * cukup untuk melihat regresi antar versi firmware. Nilai 0-7 disimpan
+ * persis; min/max/rata-rata selalu persis.
+ *
+ * Satuan ditentukan pemanggil (us di ESP32, ns di host). Keluaran JSON satu
+ * baris per probe agar mudah dibandingkan antar versi (grep/jq).
+ *
+ * Di perangkat, PROFILE_SCOPE_HEAP juga mencatat pertumbuhan heap terbesar
+ * per panggilan (free heap sebelum - sesudah), untuk menangkap kebocoran
+ * atau buffer yang tertinggal. Semua makro kosong jika ENABLE_PROFILING 0.
+ *
+ * Tidak bergantung pada Arduino.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+class LatencyHistogram {
+public:
+    static const size_t BUCKETS = 8 + 29 * 4; // 0-7 persis, lalu oktaf 2^3 .. 2^31
+
+    void record(uint32_t value) {
+        uint32_t& bucket = _buckets[indexOf(value)];
+        if (bucket != 0xFFFFFFFF) bucket++;
+        if (_count == 0 || value < _min) _min = value;
+        if (value > _max) _max = value;
+        _sum += value;
+        _count++;
+    }
+
+    // Batas atas bucket yang memuat persentil p (0-100)
+    uint32_t percentile(float p) const {
+        if (_count == 0) return 0;
+        uint64_t rank = (uint64_t)(p / 100.0f * _count + 0.5f);
+        if (rank < 1) rank = 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; i++) {
+            seen += _buckets[i];
+            if (seen >= rank) {
+                uint32_t upper = upperBound(i);
+                return upper > _max ? _max : upper;
+            }
+        }
+        return _max;
+    }
+
+    void reset() {
+        for (size_t i = 0; i < BUCKETS; i++) _buckets[i] = 0;
+        _count = 0;
+        _sum = 0;
+        _min = 0;
+        _max = 0;
+    }
+
+    uint32_t count() const { return _count; }
+    uint32_t min() const { return _min; }
+    uint32_t max() const { return _max; }
+    uint32_t mean() const { return _count ? (uint32_t)(_sum / _count) : 0; }
+
+private:
+    static size_t indexOf(uint32_t v) {
+        if (v < 8) return v;
+        int exp = 31 - __builtin_clz(v);            // >= 3
+        return 8 + (exp - 3) * 4 + ((v >> (exp - 2)) & 3);
+    }
+
+    static uint32_t upperBound(size_t i) {
+        if (i < 8) return (uint32_t)i;
+        size_t exp = (i - 8) / 4 + 3;
+        size_t sub = (i - 8) % 4;
+        uint64_t upper = (1ULL << exp) + (uint64_t)(sub + 1) * (1ULL << (exp - 2)) - 1;
+        return upper > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t)upper;
+    }
+
+    uint32_t _buckets[BUCKETS] = {};
+    uint32_t _count = 0;
+    uint64_t _sum = 0;
+    uint32_t _min = 0;
+    uint32_t _max = 0;
+};
+
+// Probe bernama: satu histogram per fungsi yang diukur
+struct ProfileProbe {
+    const char* name;
+    LatencyHistogram histogram;
+    int32_t heapGrowthMax = 0;  // Byte heap terbesar yang tidak kembali setelah satu panggilan
+
+    explicit ProfileProbe(const char* probeName) : name(probeName) {}
+
+    void reset() {
+        histogram.reset();
+        heapGrowthMax = 0;
+    }
+
+    // {"probe":"...","unit":"us","n":..,"min":..,"p50":..,"p90":..,"p99":..,"max":..,"mean":..,"heap_growth_max":..}
+    int formatJson(char* buf, size_t size, const char* unit) const {
+        const LatencyHistogram& h = histogram;
+        return snprintf(buf, size,
+                        "{\"probe\":\"%s\",\"unit\":\"%s\",\"n\":%lu,\"min\":%lu,\"p50\":%lu,"
+                        "\"p90\":%lu,\"p99\":%lu,\"max\":%lu,\"mean\":%lu,\"heap_growth_max\":%ld}",
+                        name, unit, (unsigned long)h.count(), (unsigned long)h.min(),
+                        (unsigned long)h.percentile(50), (unsigned long)h.percentile(90),
+                        (unsigned long)h.percentile(99), (unsigned long)h.max(),
+                        (unsigned long)h.mean(), (long)heapGrowthMax);
+    }
+};
+
+// Ukur durasi (dan opsional pertumbuhan heap) satu scope ke probe
+class ProfileScope {
+public:
+    typedef unsigned long (*Clock)();
+    typedef uint32_t (*HeapFree)();
+
+    ProfileScope(ProfileProbe& probe, Clock clock, HeapFree heapFree = nullptr)
+        : _probe(probe), _clock(clock), _heapFree(heapFree),
+          _heapStart(heapFree ? heapFree() : 0), _start(clock()) {}
+
+    ~ProfileScope() {
+        _probe.histogram.record((uint32_t)(_clock() - _start));
+        if (_heapFree) {
+            int32_t growth = (int32_t)(_heapStart - _heapFree());
+            if (growth > _probe.heapGrowthMax) _probe.heapGrowthMax = growth;
+        }
+    }
+
+private:
+    ProfileProbe& _probe;
+    Clock _clock;
+    HeapFree _heapFree;
+    uint32_t _heapStart;
+    unsigned long _start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#if ENABLE_PROFILING
+#define PROFILE_SCOPE(probe, clock) ProfileScope PROFILE_CONCAT(_profileScope, __LINE__)(probe, clock)
+#define PROFILE_SCOPE_HEAP(probe, clock, heapFree) \
+    ProfileScope PROFILE_CONCAT(_profileScope, __LINE__)(probe, clock, heapFree)
+#else
+#define PROFILE_SCOPE(probe, clock) do {} while (0)
+#define PROFILE_SCOPE_HEAP(probe, clock, heapFree) do {} while (0)
+#endif
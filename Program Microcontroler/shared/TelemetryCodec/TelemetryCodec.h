@@ -0,0 +1,216 @@
+/*
+ * TelemetryCodec - Format biner ringkas untuk telemetri sensor
+ *
+ * Alternatif JSON untuk upload tunggal maupun batch. Semua angka little-endian.
+ *
+ *   Header (10 byte)
+ *     0  'P' 'K'        magic
+ *     2  uint8  version (1, atau 2 jika ada ekstensi deadband)
+ *     3  uint8  flags   (bit 0 = TELEMETRY_FLAG_DEADBAND)
+ *     4  uint16 count   jumlah record
+ *     6  uint32 baseTs  epoch detik UTC record bertimestamp pertama (0 = tidak ada)
+ *
+ *   Ekstensi deadband (8 byte, hanya jika TELEMETRY_FLAG_DEADBAND)
+ *     0  uint16 intervalSec   jarak sampling sensor
+ *     2  uint16 heartbeatSec  jarak maksimum antar record dari node yang hidup
+ *     4  uint8  tempX10       ambang suhu °C x10
+ *     5  uint8  humidX10      ambang kelembapan %RH x10
+ *     6  uint8  soil          ambang soil %
+ *     7  uint8  cadangan
+ *
+ *   Record (8 byte; 9 byte jika ada ekstensi deadband)
+ *     0  uint16 tsOffset  detik sejak baseTs (0xFFFF = waktu tidak diketahui)
+ *     2  int16  tempX10   suhu °C x10
+ *     4  uint16 humidX10  kelembapan %RH x10
+ *     6  uint8  soil      kelembapan tanah 0-100 %
+ *     7  uint8  flags     bit TELEMETRY_REASON_* (0 = tanpa filter, v1)
+ *     8  uint8  skipped   sampel ditahan deadband sebelum record ini
+ *
+ * Satu batch hanya bisa mencakup rentang ~18 jam (offset 16 bit) dan tidak
+ * boleh memuat record yang lebih tua dari baseTs; Encoder::add() menolak
+ * record seperti itu agar pemanggil memulai batch baru.
+ *
+ * Tidak bergantung pada Arduino: decoder yang sama bisa dipakai server
+ * tiruan di host.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TELEMETRY_CONTENT_TYPE "application/x-prokon-telemetry"
+
+static const uint8_t TELEMETRY_VERSION = 1;
+static const uint8_t TELEMETRY_VERSION_DEADBAND = 2;
+static const size_t TELEMETRY_HEADER_SIZE = 10;
+static const size_t TELEMETRY_DEADBAND_SIZE = 8;
+static const size_t TELEMETRY_RECORD_SIZE = 8;
+static const size_t TELEMETRY_RECORD_DEADBAND_SIZE = 9;
+static const uint16_t TELEMETRY_NO_TIMESTAMP = 0xFFFF;
+
+static const uint8_t TELEMETRY_FLAG_DEADBAND = 0x01;
+
+// Alasan record dikirim (TelemetryRecord::flags)
+static const uint8_t TELEMETRY_REASON_FIRST = 0x01;      // Pertama sejak boot/cold boot
+static const uint8_t TELEMETRY_REASON_TEMP = 0x02;       // Suhu melewati ambang
+static const uint8_t TELEMETRY_REASON_HUMID = 0x04;      // Kelembapan melewati ambang
+static const uint8_t TELEMETRY_REASON_SOIL = 0x08;       // Soil melewati ambang
+static const uint8_t TELEMETRY_REASON_HEARTBEAT = 0x10;  // Batas diam habis
+static const uint8_t TELEMETRY_REASON_GAP = 0x20;        // Ada sampel hilang sebelum record ini
+
+struct TelemetryRecord {
+    uint32_t timestamp;   // Epoch detik UTC, 0 = tidak diketahui
+    int16_t tempX10;
+    uint16_t humidX10;
+    uint8_t soil;
+    uint8_t flags;        // TELEMETRY_REASON_*
+    uint8_t skipped;
+};
+
+// Parameter filter node, agar server bisa merekonstruksi deret
+struct TelemetryDeadband {
+    uint16_t intervalSec;
+    uint16_t heartbeatSec;
+    uint8_t tempX10;
+    uint8_t humidX10;
+    uint8_t soil;
+};
+
+inline constexpr size_t telemetryEncodedSize(size_t count, bool deadband = false) {
+    return deadband ? TELEMETRY_HEADER_SIZE + TELEMETRY_DEADBAND_SIZE + count * TELEMETRY_RECORD_DEADBAND_SIZE
+                    : TELEMETRY_HEADER_SIZE + count * TELEMETRY_RECORD_SIZE;
+}
+
+class TelemetryEncoder {
+public:
+    TelemetryEncoder(uint8_t* buf, size_t capacity) : _buf(buf), _capacity(capacity) {}
+
+    // Tulis ekstensi deadband (format v2); panggil sebelum add() pertama
+    void setDeadband(const TelemetryDeadband& deadband) {
+        if (_count != 0 || _capacity < telemetryEncodedSize(0, true)) return;
+        uint8_t* p = _buf + TELEMETRY_HEADER_SIZE;
+        put16(p, deadband.intervalSec);
+        put16(p + 2, deadband.heartbeatSec);
+        p[4] = deadband.tempX10;
+        p[5] = deadband.humidX10;
+        p[6] = deadband.soil;
+        p[7] = 0;
+        _deadband = true;
+    }
+
+    // false jika buffer penuh atau timestamp di luar rentang batch ini
+    bool add(const TelemetryRecord& record) {
+        if (telemetryEncodedSize(_count + 1, _deadband) > _capacity || _count == 0xFFFF) return false;
+
+        uint16_t offset = TELEMETRY_NO_TIMESTAMP;
+        if (record.timestamp != 0) {
+            if (_baseTs == 0) _baseTs = record.timestamp;
+            if (record.timestamp < _baseTs) return false;
+            uint32_t delta = record.timestamp - _baseTs;
+            if (delta >= TELEMETRY_NO_TIMESTAMP) return false;
+            offset = (uint16_t)delta;
+        }
+
+        uint8_t* p = _buf + telemetryEncodedSize(_count, _deadband);
+        put16(p, offset);
+        put16(p + 2, (uint16_t)record.tempX10);
+        put16(p + 4, record.humidX10);
+        p[6] = record.soil;
+        p[7] = record.flags;
+        if (_deadband) p[8] = record.skipped;
+        _count++;
+        return true;
+    }
+
+    // Tulis header; mengembalikan total byte payload
+    size_t finish() {
+        _buf[0] = 'P';
+        _buf[1] = 'K';
+        _buf[2] = _deadband ? TELEMETRY_VERSION_DEADBAND : TELEMETRY_VERSION;
+        _buf[3] = _deadband ? TELEMETRY_FLAG_DEADBAND : 0;
+        put16(_buf + 4, (uint16_t)_count);
+        put32(_buf + 6, _baseTs);
+        return telemetryEncodedSize(_count, _deadband);
+    }
+
+    size_t count() const { return _count; }
+
+private:
+    static void put16(uint8_t* p, uint16_t v) {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+    }
+    static void put32(uint8_t* p, uint32_t v) {
+        put16(p, (uint16_t)v);
+        put16(p + 2, (uint16_t)(v >> 16));
+    }
+
+    uint8_t* _buf;
+    size_t _capacity;
+    size_t _count = 0;
+    uint32_t _baseTs = 0;
+    bool _deadband = false;
+};
+
+class TelemetryDecoder {
+public:
+    TelemetryDecoder(const uint8_t* data, size_t length) : _data(data), _length(length) {
+        _valid = length >= TELEMETRY_HEADER_SIZE &&
+                 data[0] == 'P' && data[1] == 'K' &&
+                 (data[2] == TELEMETRY_VERSION || data[2] == TELEMETRY_VERSION_DEADBAND);
+        if (!_valid) return;
+
+        _hasDeadband = data[2] >= TELEMETRY_VERSION_DEADBAND && (data[3] & TELEMETRY_FLAG_DEADBAND);
+        _valid = length >= telemetryEncodedSize(get16(data + 4), _hasDeadband);
+        if (_valid) {
+            _count = get16(data + 4);
+            _baseTs = get32(data + 6);
+        }
+        if (_valid && _hasDeadband) {
+            const uint8_t* p = data + TELEMETRY_HEADER_SIZE;
+            _deadband.intervalSec = get16(p);
+            _deadband.heartbeatSec = get16(p + 2);
+            _deadband.tempX10 = p[4];
+            _deadband.humidX10 = p[5];
+            _deadband.soil = p[6];
+        }
+    }
+
+    bool valid() const { return _valid; }
+    uint8_t version() const { return _length > 2 ? _data[2] : 0; }
+    size_t count() const { return _count; }
+    bool hasDeadband() const { return _hasDeadband; }
+    const TelemetryDeadband& deadband() const { return _deadband; }
+
+    bool next(TelemetryRecord& record) {
+        if (!_valid || _index >= _count) return false;
+
+        const uint8_t* p = _data + telemetryEncodedSize(_index, _hasDeadband);
+        uint16_t offset = get16(p);
+        record.timestamp = (offset == TELEMETRY_NO_TIMESTAMP) ? 0 : _baseTs + offset;
+        record.tempX10 = (int16_t)get16(p + 2);
+        record.humidX10 = get16(p + 4);
+        record.soil = p[6];
+        record.flags = p[7];
+        record.skipped = _hasDeadband ? p[8] : 0;
+        _index++;
+        return true;
+    }
+
+private:
+    static uint16_t get16(const uint8_t* p) {
+        return (uint16_t)(p[0] | (p[1] << 8));
+    }
+    static uint32_t get32(const uint8_t* p) {
+        return (uint32_t)get16(p) | ((uint32_t)get16(p + 2) << 16);
+    }
+
+    const uint8_t* _data;
+    size_t _length;
+    bool _valid = false;
+    size_t _count = 0;
+    uint32_t _baseTs = 0;
+    size_t _index = 0;
+    bool _hasDeadband = false;
+    TelemetryDeadband _deadband = {};
+};
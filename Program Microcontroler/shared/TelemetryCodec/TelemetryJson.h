@@ -0,0 +1,103 @@
+/*
+ * TelemetryJson - Format JSON telemetri sensor (default, tanpa TELEMETRY_BINARY)
+ *
+ * API sama dengan TelemetryEncoder sehingga encodeBatch() firmware dan
+ * benchmark host memakai kode yang sama untuk kedua format:
+ *
+ * {"node":"a4cf12b3c4d5","deadband":{"interval":30,"heartbeat":600,"temp":0.5,"humid":2.0,"soil":2},
+ *  "readings":[{"ts":1700000000,"temp":27.3,"humid":61.0,"soil":42,"reason":8,"skipped":3}, ...]}
+ *
+ * "ts" dihilangkan jika waktu sampling tidak diketahui (server pakai waktu
+ * terima), "skipped" jika 0.
+ *
+ * ArduinoJson 7 (sensor node) memakai JsonDocument di heap; ArduinoJson 6
+ * (simulasi host) memakai dokumen tetap TELEMETRY_JSON_V6_DOC_SIZE.
+ * Tidak bergantung pada Arduino.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ArduinoJson.h>
+#include "TelemetryCodec.h"
+
+#if ARDUINOJSON_VERSION_MAJOR < 7
+static const size_t TELEMETRY_JSON_V6_MAX_RECORDS = 32;
+static const size_t TELEMETRY_JSON_V6_DOC_SIZE =
+    JSON_OBJECT_SIZE(3) + JSON_OBJECT_SIZE(5) + JSON_ARRAY_SIZE(TELEMETRY_JSON_V6_MAX_RECORDS) +
+    TELEMETRY_JSON_V6_MAX_RECORDS * JSON_OBJECT_SIZE(6);
+#endif
+
+class TelemetryJsonEncoder {
+public:
+    TelemetryJsonEncoder(char* buf, size_t capacity) : _buf(buf), _capacity(capacity) {}
+
+    // id node (harus tetap hidup sampai finish()); panggil sebelum add() pertama
+    void setNode(const char* node) {
+        _doc["node"] = node;
+    }
+
+    // Parameter filter node; panggil sebelum add() pertama
+    void setDeadband(const TelemetryDeadband& deadband) {
+#if ARDUINOJSON_VERSION_MAJOR >= 7
+        JsonObject band = _doc["deadband"].to<JsonObject>();
+#else
+        JsonObject band = _doc.createNestedObject("deadband");
+#endif
+        band["interval"] = deadband.intervalSec;
+        band["heartbeat"] = deadband.heartbeatSec;
+        band["temp"] = deadband.tempX10 / 10.0;
+        band["humid"] = deadband.humidX10 / 10.0;
+        band["soil"] = deadband.soil;
+    }
+
+    // false jika dokumen penuh (record dikirim di batch berikutnya)
+    bool add(const TelemetryRecord& record) {
+        if (_items.isNull()) createItems();
+#if ARDUINOJSON_VERSION_MAJOR >= 7
+        JsonObject item = _items.add<JsonObject>();
+#else
+        JsonObject item = _items.createNestedObject();
+#endif
+        if (record.timestamp) item["ts"] = record.timestamp;
+        item["temp"] = record.tempX10 / 10.0;
+        item["humid"] = record.humidX10 / 10.0;
+        item["soil"] = record.soil;
+        item["reason"] = record.flags;
+        if (record.skipped) item["skipped"] = record.skipped;
+
+        if (_doc.overflowed()) {
+            _items.remove(_items.size() - 1);
+            return false;
+        }
+        _count++;
+        return true;
+    }
+
+    // Serialisasi ke buffer; mengembalikan total byte payload
+    size_t finish() {
+        if (_items.isNull()) createItems();
+        return serializeJson(_doc, _buf, _capacity);
+    }
+
+    size_t count() const { return _count; }
+
+private:
+    void createItems() {
+#if ARDUINOJSON_VERSION_MAJOR >= 7
+        _items = _doc["readings"].to<JsonArray>();
+#else
+        _items = _doc.createNestedArray("readings");
+#endif
+    }
+
+    char* _buf;
+    size_t _capacity;
+    size_t _count = 0;
+#if ARDUINOJSON_VERSION_MAJOR >= 7
+    JsonDocument _doc;
+#else
+    StaticJsonDocument<TELEMETRY_JSON_V6_DOC_SIZE> _doc;
+#endif
+    JsonArray _items;
+};
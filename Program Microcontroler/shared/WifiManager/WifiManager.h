@@ -0,0 +1,107 @@
+/*
+ * WifiManager - Koneksi WiFi berbasis event untuk ESP32 (tanpa blocking)
+ *
+ *   WifiManager wifi;
+ *   wifi.begin(ssid, pass);          // Langsung kembali, koneksi berjalan di latar
+ *   ...
+ *   wifi.update();                   // Dari loop/task jaringan, O(1)
+ *   if (!wifi.connected()) return;   // Pengganti while (...) { delay(500); }
+ *
+ * Event STA_DISCONNECTED datang dari task event ESP-IDF; handler hanya
+ * menyalakan flag atomik. State machine (WifiStateMachine.h) dijalankan di
+ * update() oleh pemanggil, yang juga membaca WiFi.status() (WL_CONNECTED
+ * setelah GOT_IP). Auto-reconnect bawaan dimatikan agar
+ * percobaan ulang mengikuti backoff eksponensial berjitter, bukan retry
+ * terus-menerus dari driver.
+ */
+#pragma once
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_random.h>
+#include "WifiStateMachine.h"
+
+// Timeout satu percobaan sama dengan loop lama (20 x 500 ms); jeda 2 s .. 1 menit
+const WifiBackoffConfig WIFI_DEFAULT_BACKOFF = {10000UL, 2000UL, 60000UL};
+
+class WifiManager {
+public:
+    explicit WifiManager(const WifiBackoffConfig& config = WIFI_DEFAULT_BACKOFF)
+        : _machine(config, startAttempt, esp_random, this) {
+        _machine.onEvent(machineEvent);
+    }
+
+    // Handler dipanggil dari update() (konteks pemanggil, bukan task event WiFi)
+    void onEvent(WifiStateMachine::EventFn handler, void* ctx = nullptr) {
+        _handler = handler;
+        _handlerCtx = ctx;
+    }
+
+    void begin(const char* ssid, const char* pass) {
+        _ssid = ssid;
+        _pass = pass;
+        instance() = this;
+        WiFi.mode(WIFI_STA);
+        WiFi.persistent(false);
+        WiFi.setAutoReconnect(false);
+        WiFi.onEvent(wifiEvent, ARDUINO_EVENT_WIFI_STA_DISCONNECTED);
+        _machine.start(millis());
+    }
+
+    // Terapkan event yang masuk & jalankan timeout/backoff. Mengembalikan ms
+    // sampai update() perlu dipanggil lagi (NO_DEADLINE jika terhubung).
+    unsigned long update() {
+        unsigned long now = millis();
+        bool lost = __atomic_exchange_n(&_lost, false, __ATOMIC_RELAXED);
+
+        // Status akhir menentukan: putus lalu tersambung lagi sebelum update()
+        // berikutnya tidak dihitung sebagai putus.
+        if (WiFi.status() == WL_CONNECTED) {
+            if (!_machine.connected()) _machine.onConnected(now);
+        } else if (lost || _machine.connected()) {
+            _machine.onDisconnected(now);
+        }
+        return _machine.update(now);
+    }
+
+    bool connected() const { return _machine.connected(); }
+    WifiStateMachine::State state() const { return _machine.state(); }
+    const WifiStateMachine::Stats& stats() const { return _machine.stats(); }
+
+private:
+    static void startAttempt(void* ctx) {
+        WifiManager* self = static_cast<WifiManager*>(ctx);
+        WiFi.begin(self->_ssid, self->_pass); // Non-blocking; hasil lewat event
+    }
+
+    static void machineEvent(WifiStateMachine::Event event, unsigned long value, void* ctx) {
+        WifiManager* self = static_cast<WifiManager*>(ctx);
+        if (event == WifiStateMachine::ATTEMPT_FAILED_EVENT) {
+            // Hentikan percobaan yang masih berjalan (timeout); event putus yang
+            // ditimbulkannya jatuh di state BACKOFF dan diabaikan
+            WiFi.disconnect();
+        }
+        if (self->_handler) self->_handler(event, value, self->_handlerCtx);
+    }
+
+    // Berjalan di task event ESP-IDF: hanya set flag. Putus karena
+    // WiFi.disconnect()/begin() milik kita sendiri (ASSOC_LEAVE) diabaikan.
+    static void wifiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+        WifiManager* self = instance();
+        if (!self || info.wifi_sta_disconnected.reason == WIFI_REASON_ASSOC_LEAVE) return;
+        __atomic_store_n(&self->_lost, true, __ATOMIC_RELAXED);
+    }
+
+    // Handler event WiFi tidak membawa konteks; satu instance per firmware
+    static WifiManager*& instance() {
+        static WifiManager* self = nullptr;
+        return self;
+    }
+
+    WifiStateMachine _machine;
+    const char* _ssid = nullptr;
+    const char* _pass = nullptr;
+    WifiStateMachine::EventFn _handler = nullptr;
+    void* _handlerCtx = nullptr;
+    bool _lost = false;
+};
@@ -0,0 +1,147 @@
+/*
+ * WifiStateMachine - Logika koneksi WiFi tanpa blocking, tanpa Arduino
+ *
+ *   IDLE ──start()──> CONNECTING ──onConnected()──> CONNECTED
+ *                        │  ▲                            │
+ *        timeout/putus   │  │ backoff habis              │ onDisconnected()
+ *                        ▼  │                            ▼
+ *                       BACKOFF <────────────────────────┘ (langsung CONNECTING
+ *                                                           untuk percobaan pertama)
+ *
+ * Tidak pernah menunggu: update(now) hanya memeriksa deadline dan memanggil
+ * StartFn (mis. WiFi.begin(), non-blocking) saat percobaan berikutnya jatuh
+ * tempo. Hasil koneksi datang lewat onConnected()/onDisconnected() (event
+ * WiFi di ESP32, model AP di simulasi).
+ *
+ * Backoff eksponensial dengan jitter ("equal jitter"): jeda ke-n adalah
+ * separuh dari min(max, min * 2^n) ditambah acak hingga separuh lainnya,
+ * sehingga banyak node tidak menyerbu AP bersamaan setelah AP pulih.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+struct WifiBackoffConfig {
+    unsigned long connectTimeoutMs;   // Batas satu percobaan sebelum dianggap gagal
+    unsigned long backoffMinMs;       // Jeda setelah kegagalan pertama
+    unsigned long backoffMaxMs;       // Batas atas jeda
+};
+
+class WifiStateMachine {
+public:
+    enum State : uint8_t { IDLE, CONNECTING, CONNECTED, BACKOFF };
+    enum Event : uint8_t { CONNECTED_EVENT, DISCONNECTED_EVENT, ATTEMPT_FAILED_EVENT };
+
+    static const unsigned long NO_DEADLINE = 0xFFFFFFFFUL;
+
+    typedef void (*StartFn)(void* ctx);            // Mulai satu percobaan (non-blocking)
+    typedef uint32_t (*RandomFn)();                // Sumber jitter
+    // CONNECTED: value = lama putus (ms); ATTEMPT_FAILED: value = jeda berikutnya (ms)
+    typedef void (*EventFn)(Event event, unsigned long value, void* ctx);
+
+    struct Stats {
+        uint32_t attempts;
+        uint32_t failures;          // Percobaan yang timeout/ditolak
+        uint32_t connects;
+        uint32_t disconnects;
+        unsigned long downtimeMs;   // Total waktu tidak terhubung (selesai)
+    };
+
+    WifiStateMachine(const WifiBackoffConfig& config, StartFn start, RandomFn random, void* ctx = nullptr)
+        : _config(config), _start(start), _random(random), _ctx(ctx) {}
+
+    void onEvent(EventFn handler) { _onEvent = handler; }
+
+    void start(unsigned long now) {
+        _downSince = now;
+        attempt(now);
+    }
+
+    // Event dari radio. Aman dipanggil berulang (event ganda diabaikan).
+    void onConnected(unsigned long now) {
+        if (_state == CONNECTED || _state == IDLE) return;
+        _state = CONNECTED;
+        _failures = 0;
+        _stats.connects++;
+        unsigned long down = now - _downSince;
+        _stats.downtimeMs += down;
+        if (_onEvent) _onEvent(CONNECTED_EVENT, down, _ctx);
+    }
+
+    void onDisconnected(unsigned long now) {
+        if (_state == CONNECTED) {
+            _stats.disconnects++;
+            _downSince = now;
+            if (_onEvent) _onEvent(DISCONNECTED_EVENT, 0, _ctx);
+            attempt(now); // Percobaan pertama setelah putus langsung, tanpa jeda
+        } else if (_state == CONNECTING) {
+            fail(now);
+        }
+    }
+
+    // Sisa ms sampai update() perlu dipanggil lagi (NO_DEADLINE jika terhubung)
+    unsigned long update(unsigned long now) {
+        if (_state == CONNECTING) {
+            unsigned long elapsed = now - _since;
+            if (elapsed >= _config.connectTimeoutMs) {
+                fail(now);
+            } else {
+                return _config.connectTimeoutMs - elapsed;
+            }
+        }
+        if (_state == BACKOFF) {
+            unsigned long elapsed = now - _since;
+            if (elapsed >= _wait) {
+                attempt(now);
+                return _config.connectTimeoutMs;
+            }
+            return _wait - elapsed;
+        }
+        return NO_DEADLINE;
+    }
+
+    bool connected() const { return _state == CONNECTED; }
+    State state() const { return _state; }
+    const Stats& stats() const { return _stats; }
+    uint8_t consecutiveFailures() const { return _failures; }
+
+    // Jeda backoff untuk kegagalan ke-n (n >= 1), sebelum jitter
+    unsigned long backoffCeiling(uint8_t failures) const {
+        unsigned long wait = _config.backoffMinMs;
+        for (uint8_t i = 1; i < failures && wait < _config.backoffMaxMs; i++) wait *= 2;
+        return wait < _config.backoffMaxMs ? wait : _config.backoffMaxMs;
+    }
+
+private:
+    void attempt(unsigned long now) {
+        _state = CONNECTING;
+        _since = now;
+        _stats.attempts++;
+        if (_start) _start(_ctx);
+    }
+
+    void fail(unsigned long now) {
+        _stats.failures++;
+        if (_failures < 255) _failures++;
+        unsigned long ceiling = backoffCeiling(_failures);
+        unsigned long half = ceiling / 2;
+        _wait = half + (half && _random ? _random() % (half + 1) : half);
+        _state = BACKOFF;
+        _since = now;
+        if (_onEvent) _onEvent(ATTEMPT_FAILED_EVENT, _wait, _ctx);
+    }
+
+    WifiBackoffConfig _config;
+    StartFn _start;
+    RandomFn _random;
+    void* _ctx;
+    EventFn _onEvent = nullptr;
+
+    State _state = IDLE;
+    unsigned long _since = 0;       // Awal percobaan / awal backoff
+    unsigned long _wait = 0;        // Lama backoff saat ini
+    unsigned long _downSince = 0;
+    uint8_t _failures = 0;
+    Stats _stats = {};
+};
@@ -0,0 +1,208 @@
+/*
+ * FileServer - Server file HTTP/1.1 tiruan di loopback untuk uji OTA
+ *
+ *   FileServer server;
+ *   server.put("/api/firmware/prokon", manifestJson);
+ *   server.put("/firmware/prokon-1.1.0.bin", image);
+ *   server.dropAt("/firmware/prokon-1.1.0.bin", {300000});  // Putus sekali di byte ini
+ *   server.start();
+ *
+ * Mendukung GET dengan "Range: bytes=N-" (206 + Content-Range) seperti server
+ * file statis biasa; ignoreRange(true) meniru server yang selalu membalas
+ * 200 penuh. Satu request per koneksi (Connection: close), satu thread per
+ * koneksi. Path lain -> 404. Hanya Linux/POSIX.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct FileServerStats {
+    uint32_t requests;
+    uint32_t ranged;        // Request dengan Range yang dilayani 206
+    uint32_t drops;         // Koneksi diputus di tengah body (dropAt)
+    uint64_t bytesOut;      // Byte body terkirim
+};
+
+class FileServer {
+public:
+    ~FileServer() { stop(); }
+
+    void put(const std::string& path, const std::vector<uint8_t>& data) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _files[path] = data;
+    }
+
+    void put(const std::string& path, const std::string& text) {
+        put(path, std::vector<uint8_t>(text.begin(), text.end()));
+    }
+
+    // Putus koneksi sekali saat body path mencapai offset ini
+    void dropAt(const std::string& path, const std::vector<uint32_t>& offsets) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _drops[path].insert(offsets.begin(), offsets.end());
+    }
+
+    void ignoreRange(bool ignore) { _ignoreRange = ignore; }
+
+    bool start() {
+        _listen = socket(AF_INET, SOCK_STREAM, 0);
+        if (_listen < 0) return false;
+        int yes = 1;
+        setsockopt(_listen, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (bind(_listen, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(_listen, 64) < 0 ||
+            getsockname(_listen, (sockaddr*)&addr, &len) < 0) {
+            close(_listen);
+            _listen = -1;
+            return false;
+        }
+        _port = ntohs(addr.sin_port);
+        _running = true;
+        _acceptor = std::thread([this] { acceptLoop(); });
+        return true;
+    }
+
+    void stop() {
+        if (!_running.exchange(false)) return;
+        shutdown(_listen, SHUT_RDWR);
+        close(_listen);
+        _acceptor.join();
+        std::vector<std::thread> workers;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            workers.swap(_workers);
+        }
+        for (std::thread& t : workers) t.join();
+    }
+
+    uint16_t port() const { return _port; }
+
+    FileServerStats stats() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+
+private:
+    void acceptLoop() {
+        while (_running) {
+            int fd = accept(_listen, nullptr, nullptr);
+            if (fd < 0) continue;
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_running) {
+                close(fd);
+                break;
+            }
+            _workers.emplace_back([this, fd] { serve(fd); });
+        }
+    }
+
+    void serve(int fd) {
+        std::string request;
+        char chunk[1024];
+        while (request.find("\r\n\r\n") == std::string::npos) {
+            ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                close(fd);
+                return;
+            }
+            request.append(chunk, (size_t)n);
+        }
+
+        char method[8] = "", path[128] = "";
+        sscanf(request.c_str(), "%7s %127s", method, path);
+        uint32_t from = 0;
+        const char* range = strcasestr(request.c_str(), "\r\nRange: bytes=");
+        if (range) from = (uint32_t)strtoul(range + 15, nullptr, 10);
+
+        std::vector<uint8_t> body;
+        bool found;
+        uint32_t drop = 0;
+        bool dropping = false;
+        bool ranged = range && !_ignoreRange;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stats.requests++;
+            auto it = _files.find(path);
+            found = it != _files.end() && strcmp(method, "GET") == 0;
+            if (found) body = it->second;
+            if (!ranged) from = 0;
+            std::set<uint32_t>& drops = _drops[path];
+            auto d = drops.upper_bound(from);
+            if (found && d != drops.end() && *d < body.size()) {
+                drop = *d;
+                dropping = true;
+                drops.erase(d);
+                _stats.drops++;
+            }
+            if (found && ranged && from > 0 && from < body.size()) _stats.ranged++;
+        }
+
+        char header[256];
+        if (!found) {
+            snprintf(header, sizeof(header), "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+            sendAll(fd, header, strlen(header));
+        } else if (from >= body.size() && from > 0) {
+            snprintf(header, sizeof(header),
+                     "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+            sendAll(fd, header, strlen(header));
+        } else {
+            size_t length = body.size() - from;
+            if (ranged && from > 0) {
+                snprintf(header, sizeof(header),
+                         "HTTP/1.1 206 Partial Content\r\nContent-Length: %zu\r\nContent-Range: bytes %u-%zu/%zu\r\n"
+                         "Connection: close\r\n\r\n",
+                         length, from, body.size() - 1, body.size());
+            } else {
+                snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+                         length);
+            }
+            size_t send = dropping ? drop - from : length;
+            if (sendAll(fd, header, strlen(header)) && sendAll(fd, body.data() + from, send)) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stats.bytesOut += send;
+            }
+        }
+        shutdown(fd, SHUT_RDWR);
+        close(fd);
+    }
+
+    static bool sendAll(int fd, const void* data, size_t length) {
+        const char* p = (const char*)data;
+        while (length > 0) {
+            ssize_t n = ::send(fd, p, length, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            p += n;
+            length -= (size_t)n;
+        }
+        return true;
+    }
+
+    int _listen = -1;
+    uint16_t _port = 0;
+    std::atomic<bool> _running{false};
+    std::atomic<bool> _ignoreRange{false};
+    std::thread _acceptor;
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::map<std::string, std::vector<uint8_t>> _files;
+    std::map<std::string, std::set<uint32_t>> _drops;
+    FileServerStats _stats = {};
+};
@@ -0,0 +1,330 @@
+/*
+ * IngestServer - Server HTTP tiruan untuk banyak node (endpoint per node)
+ *
+ * Menyajikan endpoint /api/nodes/<id>/... (NodeId.h) lewat socket TCP
+ * sungguhan di loopback, satu thread per koneksi keep-alive seperti worker
+ * PHP yang memegang satu koneksi. Dipakai load generator fleet.cpp untuk
+ * mengukur throughput sisi server dan latensi sisi node sebelum server
+ * Laravel yang sebenarnya diskalakan.
+ *
+ *   POST /api/nodes/<id>/telemetry      batch biner TelemetryCodec -> 201
+ *   GET  /api/nodes/<id>/water-status   {"valve_status":"off","zone":1}
+ *   GET  /api/nodes/<id>/schedules      array jadwal + ETag; If-None-Match -> 304
+ *   GET  /api/nodes/<id>/sensor/latest  soil terakhir sensor node pasangan (pair())
+ *
+ * Path global lama (/api/receive-sensor/batch, /api/water-status,
+ * /api/schedules/esp32, /api/sensor/latest) juga diterima jika request membawa
+ * header X-Node-Id (firmware dengan NODE_SCOPED_API=0). Path lain -> 404.
+ *
+ * State per node di satu map dengan satu mutex (setara satu tabel database
+ * tanpa sharding), jadi kontensi ikut terukur. Hanya Linux/POSIX.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <NodeId.h>
+#include <TelemetryCodec.h>
+
+struct IngestStats {
+    uint64_t requests;
+    uint64_t telemetry;     // POST telemetry diterima
+    uint64_t records;       // Record telemetri di-decode
+    uint64_t notModified;   // Jadwal 304
+    uint64_t rejected;      // 400/404
+    uint64_t bytesIn;
+    uint32_t nodes;         // Node berbeda yang pernah terlihat
+    uint32_t peakConnections;
+    std::vector<uint32_t> handleUs; // Waktu proses per request (tanpa jaringan)
+};
+
+class IngestServer {
+public:
+    ~IngestServer() { stop(); }
+
+    // port 0 = port acak; port sebenarnya lewat port()
+    bool start(uint16_t port = 0) {
+        _listen = socket(AF_INET, SOCK_STREAM, 0);
+        if (_listen < 0) return false;
+        int yes = 1;
+        setsockopt(_listen, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (bind(_listen, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(_listen, 1024) < 0 ||
+            getsockname(_listen, (sockaddr*)&addr, &len) < 0) {
+            close(_listen);
+            _listen = -1;
+            return false;
+        }
+        _port = ntohs(addr.sin_port);
+        _running = true;
+        _acceptor = std::thread([this] { acceptLoop(); });
+        return true;
+    }
+
+    void stop() {
+        if (!_running.exchange(false)) return;
+        shutdown(_listen, SHUT_RDWR);
+        close(_listen);
+        _acceptor.join();
+        std::vector<std::thread> workers;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (int fd : _clients) shutdown(fd, SHUT_RDWR);
+            workers.swap(_workers);
+        }
+        for (std::thread& t : workers) t.join();
+    }
+
+    // Control node <control> membaca soil dari sensor node <sensor>
+    void pair(const char* control, const char* sensor) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _nodes[control].paired = sensor;
+    }
+
+    uint16_t port() const { return _port; }
+
+    IngestStats stats() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        IngestStats s = _stats;
+        s.nodes = (uint32_t)_nodes.size();
+        return s;
+    }
+
+private:
+    struct NodeState {
+        std::string paired;
+        bool hasLatest = false;
+        uint32_t latestTs = 0;
+        uint8_t latestSoil = 0;
+        uint32_t records = 0;
+    };
+
+    struct Request {
+        char method[8];
+        char path[96];
+        char etag[40];
+        char nodeHeader[NODE_ID_SIZE];
+        size_t contentLength;
+        bool close;
+    };
+
+    void acceptLoop() {
+        while (_running) {
+            int fd = accept(_listen, nullptr, nullptr);
+            if (fd < 0) continue;
+            int yes = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (!_running) {
+                close(fd);
+                break;
+            }
+            _clients.push_back(fd);
+            if (_clients.size() > _stats.peakConnections) _stats.peakConnections = (uint32_t)_clients.size();
+            _workers.emplace_back([this, fd] { serve(fd); });
+        }
+    }
+
+    // Satu koneksi keep-alive: baca request, jawab, ulangi sampai ditutup
+    void serve(int fd) {
+        std::string buf;
+        std::string out;
+        char chunk[4096];
+        for (;;) {
+            size_t headerEnd;
+            while ((headerEnd = buf.find("\r\n\r\n")) == std::string::npos) {
+                ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+                if (n <= 0) return closeClient(fd);
+                buf.append(chunk, (size_t)n);
+            }
+            Request req;
+            if (!parseHeader(buf.c_str(), headerEnd, req)) return closeClient(fd);
+            size_t total = headerEnd + 4 + req.contentLength;
+            while (buf.size() < total) {
+                ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+                if (n <= 0) return closeClient(fd);
+                buf.append(chunk, (size_t)n);
+            }
+
+            long long start = nowUs();
+            handle(req, (const uint8_t*)buf.data() + headerEnd + 4, out);
+            uint32_t elapsed = (uint32_t)(nowUs() - start);
+            buf.erase(0, total);
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _stats.handleUs.push_back(elapsed);
+            }
+
+            if (!sendAll(fd, out.data(), out.size()) || req.close) return closeClient(fd);
+        }
+    }
+
+    void handle(const Request& req, const uint8_t* body, std::string& out) {
+        char id[NODE_ID_SIZE];
+        const char* rest = nodePathSplit(req.path, id);
+        if (!rest && req.nodeHeader[0]) {
+            rest = legacyPath(req.path);
+            memcpy(id, req.nodeHeader, NODE_ID_SIZE);
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stats.requests++;
+        _stats.bytesIn += req.contentLength;
+        if (!rest) return reject(404, out);
+        NodeState& node = _nodes[id];
+
+        if (strcmp(req.method, "POST") == 0 && strcmp(rest, "/telemetry") == 0) {
+            TelemetryDecoder decoder(body, req.contentLength);
+            if (!decoder.valid()) return reject(400, out);
+            TelemetryRecord record;
+            while (decoder.next(record)) {
+                if (record.timestamp >= node.latestTs) {
+                    node.latestTs = record.timestamp;
+                    node.latestSoil = record.soil;
+                    node.hasLatest = true;
+                }
+                node.records++;
+                _stats.records++;
+            }
+            _stats.telemetry++;
+            return respond(201, nullptr, "{\"status\":\"ok\"}", out);
+        }
+        if (strcmp(req.method, "GET") != 0) return reject(404, out);
+
+        if (strcmp(rest, "/water-status") == 0) {
+            return respond(200, nullptr, "{\"valve_status\":\"off\",\"zone\":1}", out);
+        }
+        if (strcmp(rest, "/schedules") == 0) {
+            static const char* ETAG = "\"v1\"";
+            if (strcmp(req.etag, ETAG) == 0) {
+                _stats.notModified++;
+                return respond(304, ETAG, nullptr, out);
+            }
+            return respond(200, ETAG,
+                           "[{\"schedule_type\":\"daily\",\"schedule_time\":\"06:00\",\"is_active\":true,"
+                           "\"duration_minutes\":10,\"zone\":1},"
+                           "{\"schedule_type\":\"daily\",\"schedule_time\":\"17:00\",\"is_active\":true,"
+                           "\"duration_minutes\":10,\"zone\":1}]",
+                           out);
+        }
+        if (strcmp(rest, "/sensor/latest") == 0) {
+            auto sensor = _nodes.find(node.paired);
+            if (sensor == _nodes.end() || !sensor->second.hasLatest) return reject(404, out);
+            char json[64];
+            snprintf(json, sizeof(json), "{\"soil\":%u,\"age_seconds\":0}", sensor->second.latestSoil);
+            return respond(200, nullptr, json, out);
+        }
+        reject(404, out);
+    }
+
+    // Path global lama -> sisa path per node; nullptr jika tidak dikenal
+    static const char* legacyPath(const char* path) {
+        static const char* const MAP[][2] = {
+            {"/api/receive-sensor/batch", "/telemetry"},
+            {"/api/water-status", "/water-status"},
+            {"/api/schedules/esp32", "/schedules"},
+            {"/api/sensor/latest", "/sensor/latest"},
+        };
+        for (const auto& m : MAP) {
+            if (strcmp(path, m[0]) == 0) return m[1];
+        }
+        return nullptr;
+    }
+
+    // Dipanggil dengan _mutex terkunci
+    void reject(int code, std::string& out) {
+        _stats.rejected++;
+        respond(code, nullptr, "{\"error\":\"not found\"}", out);
+    }
+
+    static void respond(int code, const char* etag, const char* body, std::string& out) {
+        const char* reason = code == 200 ? "OK" : code == 201 ? "Created" : code == 304 ? "Not Modified"
+                           : code == 400 ? "Bad Request" : "Not Found";
+        size_t length = body ? strlen(body) : 0;
+        char header[192];
+        int n = snprintf(header, sizeof(header),
+                         "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %u\r\n%s%s%s"
+                         "Connection: keep-alive\r\n\r\n",
+                         code, reason, (unsigned)length, etag ? "ETag: " : "", etag ? etag : "",
+                         etag ? "\r\n" : "");
+        out.assign(header, (size_t)n);
+        if (body) out.append(body, length);
+    }
+
+    static bool parseHeader(const char* data, size_t length, Request& req) {
+        memset(&req, 0, sizeof(req));
+        if (sscanf(data, "%7s %95s", req.method, req.path) != 2) return false;
+        const char* line = strstr(data, "\r\n");
+        const char* end = data + length;
+        while (line && line < end) {
+            line += 2;
+            if (strncasecmp(line, "Content-Length:", 15) == 0) {
+                req.contentLength = (size_t)strtoul(line + 15, nullptr, 10);
+            } else if (strncasecmp(line, "If-None-Match:", 14) == 0) {
+                sscanf(line + 14, " %39s", req.etag);
+            } else if (strncasecmp(line, "X-Node-Id:", 10) == 0) {
+                sscanf(line + 10, " %12s", req.nodeHeader);
+            } else if (strncasecmp(line, "Connection: close", 17) == 0) {
+                req.close = true;
+            }
+            line = strstr(line, "\r\n");
+        }
+        return req.contentLength <= 64 * 1024;
+    }
+
+    static bool sendAll(int fd, const char* data, size_t length) {
+        while (length) {
+            ssize_t n = send(fd, data, length, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            data += n;
+            length -= (size_t)n;
+        }
+        return true;
+    }
+
+    void closeClient(int fd) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (size_t i = 0; i < _clients.size(); i++) {
+            if (_clients[i] == fd) {
+                _clients.erase(_clients.begin() + i);
+                break;
+            }
+        }
+        close(fd);
+    }
+
+    static long long nowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    int _listen = -1;
+    uint16_t _port = 0;
+    std::atomic<bool> _running{false};
+    std::thread _acceptor;
+    std::mutex _mutex;
+    std::vector<std::thread> _workers;
+    std::vector<int> _clients;
+    std::map<std::string, NodeState> _nodes;
+    IngestStats _stats = {};
+};
@@ -0,0 +1,52 @@
+/*
+ * MinimalTimer - Timer job firmware control node sebelum Scheduler
+ *
+ * Kode dari main.cpp firmware lama apa adanya; hanya millis() diganti sumber
+ * waktu yang diberikan di konstruktor (jam tiruan di host). Dipakai sebagai
+ * pembanding Scheduler di --scheduler dan --bench.
+ */
+#pragma once
+
+class MinimalTimer {
+private:
+    struct TimerJob {
+        long interval;
+        unsigned long prevMillis;
+        void (*callback)();
+        bool enabled;
+        int id;
+    };
+    TimerJob jobs[5];
+    int jobCount = 0;
+    unsigned long (*millis)();
+
+public:
+    explicit MinimalTimer(unsigned long (*clock)()) : millis(clock) {}
+
+    int setInterval(long interval, void (*callback)()) {
+        if (jobCount >= 5) return -1;
+        jobs[jobCount].interval = interval;
+        jobs[jobCount].prevMillis = millis();
+        jobs[jobCount].callback = callback;
+        jobs[jobCount].enabled = true;
+        jobs[jobCount].id = jobCount;
+        return jobCount++;
+    }
+
+    void run() {
+        for (int i = 0; i < jobCount; i++) {
+            if (jobs[i].enabled) {
+                if (millis() - jobs[i].prevMillis >= (unsigned long)jobs[i].interval) {
+                    jobs[i].prevMillis = millis();
+                    jobs[i].callback();
+                }
+            }
+        }
+    }
+
+    void disable(int id) {
+        if (id >= 0 && id < jobCount) {
+            jobs[id].enabled = false;
+        }
+    }
+};
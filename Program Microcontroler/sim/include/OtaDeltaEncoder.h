@@ -0,0 +1,126 @@
+/*
+ * OtaDeltaEncoder - Pembuat patch delta OTA (format di OtaUpdate.h), hanya host
+ *
+ *   std::vector<uint8_t> patch = otaMakeDelta(oldImage, newImage);
+ *
+ * Dipakai simulasi ota.cpp dan untuk menyiapkan patch di server
+ * (`program --ota --make-delta lama.bin baru.bin keluar.pd`).
+ *
+ * Greedy satu lintasan: di setiap posisi image baru, pertama dicoba
+ * melanjutkan pergeseran salinan sebelumnya (kode yang sama setelah beberapa
+ * byte berubah, mis. alamat yang ikut bergeser), lalu blok 32 byte dicari di
+ * indeks hash image lama. Salinan diperpanjang sejauh mungkin; sisanya
+ * menjadi operasi sisip. Tanpa kompresi, jadi patch hanya sekecil bagian yang
+ * benar-benar berubah.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+
+#include <OtaUpdate.h>
+
+namespace ota_delta {
+
+const size_t BLOCK = 32;         // Panjang blok indeks hash
+const size_t MIN_CONTINUE = 8;   // Kecocokan minimum untuk melanjutkan pergeseran lama
+
+inline uint64_t blockHash(const uint8_t* p) {
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < BLOCK; i++) h = (h ^ p[i]) * 1099511628211ull;
+    return h;
+}
+
+inline void putVarint(std::vector<uint8_t>& out, uint32_t v) {
+    while (v >= 0x80) {
+        out.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t)v);
+}
+
+inline void putU32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) out.push_back((uint8_t)(v >> (8 * i)));
+}
+
+inline size_t matchLength(const std::vector<uint8_t>& a, size_t ai, const std::vector<uint8_t>& b, size_t bi) {
+    size_t n = 0;
+    while (ai + n < a.size() && bi + n < b.size() && a[ai + n] == b[bi + n]) n++;
+    return n;
+}
+
+} // namespace ota_delta
+
+inline std::vector<uint8_t> otaMakeDelta(const std::vector<uint8_t>& base, const std::vector<uint8_t>& target) {
+    using namespace ota_delta;
+    std::vector<uint8_t> out;
+    out.push_back('P');
+    out.push_back('D');
+    out.push_back(OTA_DELTA_VERSION);
+    out.push_back(0);
+    putU32(out, (uint32_t)base.size());
+    putU32(out, (uint32_t)target.size());
+    Sha256 sha;
+    sha.update(base.data(), base.size());
+    uint8_t digest[SHA256_SIZE];
+    sha.finish(digest);
+    out.insert(out.end(), digest, digest + SHA256_SIZE);
+
+    // Posisi pertama setiap blok image lama
+    std::unordered_map<uint64_t, uint32_t> index;
+    index.reserve(base.size());
+    for (size_t i = 0; i + BLOCK <= base.size(); i++) index.emplace(blockHash(&base[i]), (uint32_t)i);
+
+    size_t copyEnd = 0;         // Akhir salinan terakhir di image lama
+    long long shift = 0;        // Posisi lama - posisi baru dari salinan terakhir
+    size_t literal = 0;         // Awal byte sisip yang belum ditulis
+    size_t i = 0;
+
+    auto flushLiteral = [&](size_t end) {
+        if (end <= literal) return;
+        out.push_back(OTA_OP_ADD);
+        putVarint(out, (uint32_t)(end - literal));
+        out.insert(out.end(), target.begin() + literal, target.begin() + end);
+    };
+
+    while (i < target.size()) {
+        size_t from = 0, length = 0;
+        long long candidate = (long long)i + shift;
+        if (candidate >= 0 && (size_t)candidate < base.size()) {
+            size_t n = matchLength(base, (size_t)candidate, target, i);
+            if (n >= MIN_CONTINUE) {
+                from = (size_t)candidate;
+                length = n;
+            }
+        }
+        if (!length && i + BLOCK <= target.size()) {
+            auto it = index.find(blockHash(&target[i]));
+            if (it != index.end()) {
+                size_t n = matchLength(base, it->second, target, i);
+                if (n >= BLOCK) {
+                    from = it->second;
+                    length = n;
+                }
+            }
+        }
+        if (!length) {
+            i++;
+            continue;
+        }
+
+        flushLiteral(i);
+        long long delta = (long long)from - (long long)copyEnd;
+        out.push_back(OTA_OP_COPY);
+        putVarint(out, (uint32_t)length);
+        putVarint(out, (uint32_t)((delta << 1) ^ (delta >> 63)));
+        copyEnd = from + length;
+        shift = (long long)from - (long long)i;
+        i += length;
+        literal = i;
+    }
+    flushLiteral(target.size());
+    return out;
+}
@@ -0,0 +1,108 @@
+/*
+ * PlantModel - Model iklim & kelembapan tanah sederhana untuk simulasi
+ *
+ * Bukan model agronomi; cukup untuk membandingkan strategi penyiraman:
+ *   - Suhu harian sinusoidal (min jam 05:00, maks jam 14:00)
+ *   - Evapotranspirasi sebanding suhu, lebih kecil di malam hari
+ *   - Hujan acak (deterministik per seed) menambah kelembapan
+ *   - Penyiraman menambah kelembapan dengan laju tetap per detik
+ *   - Di atas kapasitas lapang, air berlebih terbuang (drainase)
+ *   - Sensor soil: ADC mentah (kebalikan kalibrasi) + noise + spike sesekali
+ */
+#pragma once
+
+#include <math.h>
+#include "SimHardware.h"
+
+struct ClimateModel {
+    float tempMin = 23.0f;
+    float tempMax = 33.0f;
+
+    float temperature(uint32_t secOfDay) const {
+        // Kosinus dengan puncak jam 14:00
+        float phase = (secOfDay / 3600.0f - 14.0f) * (float)M_PI / 12.0f;
+        return tempMin + (tempMax - tempMin) * 0.5f * (1.0f + cosf(phase));
+    }
+
+    float humidity(uint32_t secOfDay) const {
+        float t = temperature(secOfDay);
+        return 95.0f - (t - tempMin) * 3.5f;
+    }
+};
+
+struct SoilModelConfig {
+    float initial;              // % awal
+    float fieldCapacity;        // % — di atasnya air terbuang
+    float irrigationPerSec;     // % per detik valve terbuka
+    float etPerHourAt30C;       // % per jam saat 30 °C, siang hari
+    float drainPerHour;         // Fraksi kelebihan di atas kapasitas lapang yang terbuang per jam
+    float rainChancePerDay;     // Peluang hujan per hari
+    float rainPerHour;          // % per jam selama hujan
+};
+
+class SoilModel {
+public:
+    SoilModel(const SoilModelConfig& config, uint32_t seed)
+        : _config(config), _moisture(config.initial), _prng(seed), _weather(seed ^ 0x9E3779B9) {}
+
+    // Maju dtSec detik
+    void step(float dtSec, uint32_t epoch, float tempC, bool irrigating) {
+        updateRain(epoch, dtSec);
+
+        uint32_t secOfDay = epoch % 86400;
+        bool daylight = secOfDay >= 6 * 3600 && secOfDay < 18 * 3600;
+        float et = _config.etPerHourAt30C * (tempC - 10.0f) / 20.0f * (daylight ? 1.0f : 0.3f);
+        if (et < 0) et = 0;
+
+        float delta = -et * dtSec / 3600.0f;
+        if (irrigating) delta += _config.irrigationPerSec * dtSec;
+        if (_raining) delta += _config.rainPerHour * dtSec / 3600.0f;
+        _moisture += delta;
+
+        if (_moisture > _config.fieldCapacity) {
+            _moisture -= (_moisture - _config.fieldCapacity) * _config.drainPerHour * dtSec / 3600.0f;
+        }
+        if (_moisture > 100) _moisture = 100;
+        if (_moisture < 0) _moisture = 0;
+    }
+
+    // ADC mentah seperti dibaca analogRead(): dry..wet linear, noise & spike
+    uint16_t adc(float dryRaw, float wetRaw) {
+        float raw = dryRaw + (wetRaw - dryRaw) * _moisture / 100.0f;
+        raw += _prng.gaussian() * 25.0f;
+        if (_prng.uniform() < 0.002f) raw += (_prng.uniform() < 0.5f ? -1 : 1) * 1500.0f;
+        if (raw < 0) raw = 0;
+        if (raw > 4095) raw = 4095;
+        return (uint16_t)raw;
+    }
+
+    float moisture() const { return _moisture; }
+    bool raining() const { return _raining; }
+    float rainHours() const { return _rainSeconds / 3600.0f; }
+
+private:
+    // Satu undian per hari: mulai & lama hujan (1-4 jam) di siang/sore hari
+    void updateRain(uint32_t epoch, float dtSec) {
+        uint32_t day = epoch / 86400;
+        if (day != _rainDay) {
+            _rainDay = day;
+            _rainStart = _rainEnd = 0;
+            if (_weather.uniform() < _config.rainChancePerDay) {
+                _rainStart = day * 86400 + 11 * 3600 + (uint32_t)(_weather.uniform() * 8 * 3600);
+                _rainEnd = _rainStart + 3600 + (uint32_t)(_weather.uniform() * 3 * 3600);
+            }
+        }
+        _raining = epoch >= _rainStart && epoch < _rainEnd;
+        if (_raining) _rainSeconds += dtSec;
+    }
+
+    SoilModelConfig _config;
+    float _moisture;
+    Prng _prng;             // Noise sensor
+    Prng _weather;          // Hujan; terpisah agar cuaca sama untuk semua skenario
+    uint32_t _rainDay = 0xFFFFFFFF;
+    uint32_t _rainStart = 0;
+    uint32_t _rainEnd = 0;
+    bool _raining = false;
+    float _rainSeconds = 0;
+};
@@ -0,0 +1,108 @@
+/*
+ * RecordedResponses - Body response server Laravel yang direkam, untuk benchmark
+ *
+ * Body diambil dari server Laravel apa adanya (termasuk field yang dibuang
+ * filter firmware: id, created_at, updated_at, ...) agar parse di host
+ * membaca jumlah byte yang sama dengan firmware.
+ *
+ *   MemoryStream      : stream baca dari buffer, antarmuka TStream RemoteApi.h
+ *                       (peek/read/readBytes; -1 = body habis)
+ *   RecordedTransport : pengganti HttpTransport untuk TTransport RemoteApi.h;
+ *                       setiap get() menjawab body rekaman (304 jika
+ *                       If-None-Match sama dengan ETag rekaman)
+ */
+#pragma once
+
+#include <stddef.h>
+#include <string.h>
+#include <string>
+
+// GET /api/water-status
+static const char RECORDED_WATER_STATUS[] =
+    "{\"id\":1,\"valve_status\":\"ON\",\"zone\":2,\"duration\":30,"
+    "\"created_at\":\"2025-01-06T05:58:12.000000Z\",\"updated_at\":\"2025-01-06T06:00:03.000000Z\"}";
+
+// GET /api/schedules (8 jadwal, 2 zona)
+static const char RECORDED_SCHEDULES[] =
+    "[{\"id\":1,\"schedule_type\":\"pagi\",\"schedule_time\":\"06:00:00\",\"is_active\":1,"
+    "\"duration_minutes\":5,\"days\":[1,2,3,4,5],\"zone\":1,"
+    "\"created_at\":\"2025-01-02T10:11:12.000000Z\",\"updated_at\":\"2025-01-05T08:00:00.000000Z\"},"
+    "{\"id\":2,\"schedule_type\":\"siang\",\"schedule_time\":\"12:00:00\",\"is_active\":0,"
+    "\"duration_minutes\":3,\"days\":[0,6],\"zone\":1,"
+    "\"created_at\":\"2025-01-02T10:11:12.000000Z\",\"updated_at\":\"2025-01-05T08:00:00.000000Z\"},"
+    "{\"id\":3,\"schedule_type\":\"sore\",\"schedule_time\":\"17:30:00\",\"is_active\":1,"
+    "\"duration_minutes\":5,\"days\":[0,1,2,3,4,5,6],\"zone\":1,"
+    "\"created_at\":\"2025-01-02T10:11:12.000000Z\",\"updated_at\":\"2025-01-05T08:00:00.000000Z\"},"
+    "{\"id\":4,\"schedule_type\":\"malam\",\"schedule_time\":\"21:00:00\",\"is_active\":0,"
+    "\"duration_minutes\":2,\"zone\":1,"
+    "\"created_at\":\"2025-01-02T10:11:12.000000Z\",\"updated_at\":\"2025-01-05T08:00:00.000000Z\"},"
+    "{\"id\":5,\"schedule_type\":\"pagi\",\"schedule_time\":\"06:10:00\",\"is_active\":1,"
+    "\"duration_minutes\":8,\"days\":[1,3,5],\"zone\":2,"
+    "\"created_at\":\"2025-01-03T09:00:00.000000Z\",\"updated_at\":\"2025-01-05T08:00:00.000000Z\"},"
+    "{\"id\":6,\"schedule_type\":\"siang\",\"schedule_time\":\"12:10:00\",\"is_active\":1,"
+    "\"duration_minutes\":4,\"days\":[2,4],\"zone\":2,"
+    "\"created_at\":\"2025-01-03T09:00:00.000000Z\",\"updated_at\":\"2025-01-05T08:00:00.000000Z\"},"
+    "{\"id\":7,\"schedule_type\":\"sore\",\"schedule_time\":\"17:40:00\",\"is_active\":1,"
+    "\"duration_minutes\":8,\"days\":[0,1,2,3,4,5,6],\"zone\":2,"
+    "\"created_at\":\"2025-01-03T09:00:00.000000Z\",\"updated_at\":\"2025-01-05T08:00:00.000000Z\"},"
+    "{\"id\":8,\"schedule_type\":\"malam\",\"schedule_time\":\"21:10:00\",\"is_active\":0,"
+    "\"duration_minutes\":2,\"zone\":2,"
+    "\"created_at\":\"2025-01-03T09:00:00.000000Z\",\"updated_at\":\"2025-01-05T08:00:00.000000Z\"}]";
+
+class MemoryStream {
+public:
+    MemoryStream(const char* data, size_t length) : _data(data), _length(length) {}
+
+    int peek() const { return _pos < _length ? (unsigned char)_data[_pos] : -1; }
+    int read() { return _pos < _length ? (unsigned char)_data[_pos++] : -1; }
+
+    size_t readBytes(char* buffer, size_t length) {
+        size_t n = _length - _pos < length ? _length - _pos : length;
+        memcpy(buffer, _data + _pos, n);
+        _pos += n;
+        return n;
+    }
+
+private:
+    const char* _data;
+    size_t _length;
+    size_t _pos = 0;
+};
+
+class RecordedTransport {
+public:
+    RecordedTransport(int code, const char* body, const char* etag = "")
+        : _code(code), _body(body), _length(strlen(body)), _etag(etag), _stream(body, 0) {}
+
+    void setIfNoneMatch(const char* etag) { _ifNoneMatch = etag; }
+
+    int get(const char* path) {
+        (void)path;
+        bool notModified = _ifNoneMatch && _ifNoneMatch[0] && strcmp(_ifNoneMatch, _etag) == 0;
+        _ifNoneMatch = nullptr;
+        _stream = MemoryStream(_body, notModified ? 0 : _length);
+        return notModified ? 304 : _code;
+    }
+
+    // HttpTransport::header() mengembalikan String (salinan)
+    std::string header(const char* name) const { return strcmp(name, "ETag") == 0 ? _etag : ""; }
+
+    MemoryStream& bodyStream() { return _stream; }
+
+    // http.getString() jalur lama: salinan seluruh body
+    std::string getString() {
+        std::string body(_body, _length);
+        _stream = MemoryStream(_body, 0);
+        return body;
+    }
+
+    void end() {}
+
+private:
+    int _code;
+    const char* _body;
+    size_t _length;
+    const char* _etag;
+    const char* _ifNoneMatch = nullptr;
+    MemoryStream _stream;
+};
@@ -0,0 +1,92 @@
+/*
+ * SimHardware - Pengganti hardware untuk simulasi di host
+ *
+ *   VirtualClock         : millis()/micros()/epoch RTC dalam waktu virtual
+ *   Prng                 : bilangan acak deterministik (hasil bisa diulang)
+ *   RecordingValveOutput : ValveOutput tiruan yang merekam timeline relay
+ */
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+#include "ValveBank.h"
+
+class VirtualClock {
+public:
+    explicit VirtualClock(uint32_t startEpoch) : _startEpoch(startEpoch) {}
+
+    void advance(unsigned long ms) { _ms += ms; }
+
+    unsigned long millis() const { return (unsigned long)_ms; }
+    unsigned long micros() const { return (unsigned long)(_ms * 1000); }
+    uint32_t epoch() const { return _startEpoch + (uint32_t)(_ms / 1000); } // Epoch lokal RTC
+    uint32_t secondOfDay() const { return epoch() % 86400; }
+    double hours() const { return _ms / 3600000.0; }
+
+private:
+    uint32_t _startEpoch;
+    uint64_t _ms = 0;
+};
+
+// xorshift32
+class Prng {
+public:
+    explicit Prng(uint32_t seed) : _state(seed ? seed : 1) {}
+
+    uint32_t next() {
+        _state ^= _state << 13;
+        _state ^= _state >> 17;
+        _state ^= _state << 5;
+        return _state;
+    }
+
+    float uniform() { return (next() >> 8) * (1.0f / 16777216.0f); } // [0, 1)
+
+    // Perkiraan normal standar (jumlah 4 uniform)
+    float gaussian() {
+        return (uniform() + uniform() + uniform() + uniform() - 2.0f) * 1.7320508f;
+    }
+
+private:
+    uint32_t _state;
+};
+
+#define SIM_MAX_ZONES 8
+
+class RecordingValveOutput : public ValveOutput {
+public:
+    explicit RecordingValveOutput(const VirtualClock& clock) : _clock(clock) {}
+
+    void write(uint8_t zone, bool open) override {
+        if (zone >= SIM_MAX_ZONES || open == _open[zone]) return;
+        unsigned long now = _clock.millis();
+        if (open) {
+            _openedAt[zone] = now;
+            _opens[zone]++;
+        } else {
+            _openMs[zone] += now - _openedAt[zone];
+        }
+        _open[zone] = open;
+    }
+
+    bool isOpen(uint8_t zone) const { return zone < SIM_MAX_ZONES && _open[zone]; }
+    uint32_t opens(uint8_t zone) const { return _opens[zone]; }
+
+    // Total waktu terbuka, termasuk run yang sedang berjalan
+    unsigned long openMs(uint8_t zone) const {
+        return _openMs[zone] + (_open[zone] ? _clock.millis() - _openedAt[zone] : 0);
+    }
+
+    uint8_t openCount() const {
+        uint8_t n = 0;
+        for (uint8_t z = 0; z < SIM_MAX_ZONES; z++) n += _open[z];
+        return n;
+    }
+
+private:
+    const VirtualClock& _clock;
+    bool _open[SIM_MAX_ZONES] = {};
+    unsigned long _openedAt[SIM_MAX_ZONES] = {};
+    unsigned long _openMs[SIM_MAX_ZONES] = {};
+    uint32_t _opens[SIM_MAX_ZONES] = {};
+};
@@ -0,0 +1,106 @@
+/*
+ * StandInServer - Pengganti server Laravel di dalam proses simulasi
+ *
+ * Menerima batch telemetri biner (TelemetryCodec) dari sensor node dan
+ * menyajikan bacaan soil terakhir ke control node, seperti endpoint
+ * /api/receive-sensor/batch dan /api/sensor/latest. Status valve dari
+ * dashboard disajikan seperti /api/water-status (body yang sama dengan event
+ * SSE /api/water-status/stream). Bisa dimatikan untuk mensimulasikan
+ * server/jaringan putus.
+ *
+ * Batch v2 (deadband) direkonstruksi seperti yang harus dilakukan server:
+ * setiap record mewakili dirinya dan `skipped` sampel sebelumnya yang
+ * nilainya ditahan dari record terdahulu; record ber-bit GAP menandai celah
+ * yang tidak boleh diisi.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <TelemetryCodec.h>
+
+struct ServerStats {
+    uint32_t requests;
+    uint32_t failures;      // Request saat server mati atau payload rusak
+    uint32_t records;
+    uint32_t reconstructed; // Sampel setelah rekonstruksi deadband (records + skipped)
+    uint32_t gaps;          // Record ber-bit TELEMETRY_REASON_GAP
+    uint32_t bytes;
+};
+
+class StandInServer {
+public:
+    void setDown(bool down) { _down = down; }
+    bool down() const { return _down; }
+
+    // POST /api/receive-sensor/batch; mengembalikan kode HTTP
+    int receiveBatch(const uint8_t* data, size_t length) {
+        _stats.requests++;
+        if (_down) {
+            _stats.failures++;
+            return -1; // Koneksi gagal
+        }
+
+        TelemetryDecoder decoder(data, length);
+        if (!decoder.valid()) {
+            _stats.failures++;
+            return 400;
+        }
+
+        TelemetryRecord record;
+        while (decoder.next(record)) {
+            if (record.timestamp >= _latestTs) {
+                _latestTs = record.timestamp;
+                _latestSoil = record.soil;
+                _hasLatest = true;
+            }
+            _stats.records++;
+            _stats.reconstructed += 1 + record.skipped;
+            if (record.flags & TELEMETRY_REASON_GAP) _stats.gaps++;
+        }
+        _stats.bytes += length;
+        return 201;
+    }
+
+    // GET /api/sensor/latest; panjang body JSON, 0 jika server mati, belum
+    // ada data atau buf terlalu kecil
+    size_t latest(uint32_t nowEpoch, char* buf, size_t size) {
+        _stats.requests++;
+        if (_down) {
+            _stats.failures++;
+            return 0;
+        }
+        if (!_hasLatest) return 0;
+        unsigned long ageSeconds = nowEpoch > _latestTs ? nowEpoch - _latestTs : 0;
+        int n = snprintf(buf, size, "{\"soil\":%u,\"temperature\":27.5,\"age_seconds\":%lu}",
+                         _latestSoil, ageSeconds);
+        return (n > 0 && (size_t)n < size) ? (size_t)n : 0;
+    }
+
+    // Perintah dashboard: ubah status valve satu zona (zone mulai 1)
+    void setValveStatus(int zone, bool on) {
+        _valveId++;
+        _valveZone = zone;
+        _valveOn = on;
+    }
+
+    // GET /api/water-status; panjang body JSON, 0 jika buf terlalu kecil
+    size_t waterStatus(char* buf, size_t size) const {
+        int n = snprintf(buf, size, "{\"id\":%lu,\"valve_status\":\"%s\",\"zone\":%d,\"duration\":30}",
+                         (unsigned long)_valveId, _valveOn ? "ON" : "OFF", _valveZone);
+        return (n > 0 && (size_t)n < size) ? (size_t)n : 0;
+    }
+
+    const ServerStats& stats() const { return _stats; }
+
+private:
+    bool _down = false;
+    bool _hasLatest = false;
+    uint32_t _latestTs = 0;
+    uint8_t _latestSoil = 0;
+    uint32_t _valveId = 1;
+    int _valveZone = 1;
+    bool _valveOn = false;
+    ServerStats _stats = {};
+};
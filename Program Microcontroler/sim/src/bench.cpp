@@ -0,0 +1,665 @@
+/*
+ * BENCHMARK HOST - Latensi, alokasi heap & pemakaian stack komponen firmware
+ *
+ * Setiap benchmark memanggil satu hot path berkali-kali dengan data yang
+ * mirip firmware dan melaporkan:
+ *   - latensi per panggilan (ns): min, p50, p90, p99, max, rata-rata
+ *     (LatencyHistogram dari shared/Profiler, sama dengan profiler on-device)
+ *   - jumlah & byte alokasi heap per panggilan (malloc/new dihitung)
+ *   - puncak heap selama benchmark
+ *   - stack high-water mark satu panggilan (stack thread dicat 0xA5)
+ *
+ * Keluaran: tabel (default), --json (satu objek per baris) atau --csv.
+ * Simpan keluaran per versi firmware lalu bandingkan untuk melihat regresi.
+ *
+ * Jalur HTTP firmware dijalankan dengan kode firmware di atas transport
+ * rekaman (RecordedTransport, body dari RecordedResponses.h):
+ * checkRemoteStatus -> pollValveStatus(), syncSchedulesFromAPI ->
+ * syncScheduleTable() (RemoteApi.h), sendSensorData -> uploadBatch()
+ * (BatchUpload.h); dibandingkan dengan jalur lama http.getString() lalu
+ * parse seluruh body tanpa filter. Timer lama (MinimalTimer.h) diukur
+ * berdampingan dengan Scheduler. Latensi jaringan/WiFiClient tetap diukur
+ * di perangkat lewat ENABLE_PROFILING (lihat README).
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <chrono>
+#include <new>
+#include <string>
+
+#include "SimHardware.h"
+#include "RecordedResponses.h"
+#include "MinimalTimer.h"
+
+#include "Scheduler.h"
+#include "ScheduleTable.h"
+#include "MoistureController.h"
+#include "ValveBank.h"
+#include "ReadingBuffer.h"
+#include "SensorPipeline.h"
+#include "BatchUpload.h"
+#include "RemoteApi.h"
+#include <TelemetryCodec.h>
+#include <TelemetryJson.h>
+#include <LogStore.h>
+#include <Profiler.h>
+
+// ==================== PENGHITUNG ALOKASI ====================
+// glibc: malloc/calloc/realloc/free proses ini dibungkus (__libc_malloc dkk.),
+// jadi operator new, std::string (pengganti String) dan allocator default
+// ArduinoJson ikut terhitung. Byte = malloc_usable_size(), blok yang benar-benar
+// terpakai. Platform lain: hanya operator new/delete (ukuran di header blok).
+// Pembungkus berlaku untuk seluruh program, tetapi hanya menghitung selama
+// --bench (mode lain memakai banyak thread; penghitung ini tidak atomic).
+
+struct HeapCounters {
+    uint64_t allocs;
+    uint64_t bytes;
+    int64_t inUse;
+    int64_t peak;
+};
+
+static HeapCounters heapCounters = {};
+static bool heapCounting = false;
+
+static void countAlloc(size_t size) {
+    if (!heapCounting) return;
+    heapCounters.allocs++;
+    heapCounters.bytes += size;
+    heapCounters.inUse += size;
+    if (heapCounters.inUse > heapCounters.peak) heapCounters.peak = heapCounters.inUse;
+}
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+
+static void* counted(void* ptr) {
+    if (ptr) countAlloc(malloc_usable_size(ptr));
+    return ptr;
+}
+
+void* malloc(size_t size) { return counted(__libc_malloc(size)); }
+void* calloc(size_t count, size_t size) { return counted(__libc_calloc(count, size)); }
+void* memalign(size_t alignment, size_t size) { return counted(__libc_memalign(alignment, size)); }
+void* aligned_alloc(size_t alignment, size_t size) { return counted(__libc_memalign(alignment, size)); }
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    void* ptr = counted(__libc_memalign(alignment, size));
+    if (!ptr) return ENOMEM;
+    *out = ptr;
+    return 0;
+}
+
+void* realloc(void* ptr, size_t size) {
+    size_t old = ptr ? malloc_usable_size(ptr) : 0;
+    void* grown = __libc_realloc(ptr, size);
+    if (heapCounting && (grown || size == 0)) heapCounters.inUse -= old;
+    return counted(grown);
+}
+
+void free(void* ptr) {
+    if (ptr && heapCounting) heapCounters.inUse -= malloc_usable_size(ptr);
+    __libc_free(ptr);
+}
+}
+#else
+static const size_t ALLOC_HEADER = 16;
+
+static void* countedAlloc(size_t size) {
+    unsigned char* p = (unsigned char*)malloc(size + ALLOC_HEADER);
+    if (!p) throw std::bad_alloc();
+    memcpy(p, &size, sizeof(size));
+    countAlloc(size);
+    return p + ALLOC_HEADER;
+}
+
+static void countedFree(void* ptr) {
+    if (!ptr) return;
+    unsigned char* p = (unsigned char*)ptr - ALLOC_HEADER;
+    size_t size;
+    memcpy(&size, p, sizeof(size));
+    if (heapCounting) heapCounters.inUse -= size;
+    free(p);
+}
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void operator delete(void* ptr) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr) noexcept { countedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { countedFree(ptr); }
+#endif
+
+// ==================== STACK HIGH-WATER ====================
+// Jalankan fungsi sekali di thread dengan stack milik sendiri yang sudah
+// dicat; byte yang berubah = stack terpakai (seperti uxTaskGetStackHighWaterMark).
+// Stack dipindai di thread itu sendiri sebelum thread selesai, agar teardown
+// thread (free() yang dihitung) tidak ikut terukur.
+
+static const size_t BENCH_STACK_SIZE = 256 * 1024;
+static const unsigned char STACK_PAINT = 0xA5;
+
+struct StackProbe {
+    void (*thunk)(void* ctx);
+    void* ctx;
+    const unsigned char* stack;
+    size_t used;
+};
+
+static void* stackProbeEntry(void* arg) {
+    StackProbe* probe = (StackProbe*)arg;
+    probe->thunk(probe->ctx);
+    size_t untouched = 0;
+    while (untouched < BENCH_STACK_SIZE && probe->stack[untouched] == STACK_PAINT) untouched++;
+    probe->used = BENCH_STACK_SIZE - untouched;
+    return nullptr;
+}
+
+// Byte stack terpakai; 0 jika platform menolak stack kustom
+static size_t measureStack(void (*thunk)(void*), void* ctx) {
+    unsigned char* stack = (unsigned char*)aligned_alloc(4096, BENCH_STACK_SIZE);
+    if (!stack) return 0;
+    memset(stack, STACK_PAINT, BENCH_STACK_SIZE);
+
+    StackProbe probe = {thunk, ctx, stack, 0};
+    pthread_attr_t attr;
+    pthread_t thread;
+    pthread_attr_init(&attr);
+    if (pthread_attr_setstack(&attr, stack, BENCH_STACK_SIZE) == 0 &&
+        pthread_create(&thread, &attr, stackProbeEntry, &probe) == 0) {
+        pthread_join(thread, nullptr);
+    }
+    pthread_attr_destroy(&attr);
+    free(stack);
+    return probe.used;
+}
+
+static void emptyThunk(void*) {}
+
+template <typename Fn>
+static void callThunk(void* ctx) { (*(Fn*)ctx)(); }
+
+// ==================== HARNESS ====================
+
+enum OutputFormat { FORMAT_TABLE, FORMAT_JSON, FORMAT_CSV };
+
+struct BenchOptions {
+    OutputFormat format;
+    uint32_t samples;           // Sampel histogram per benchmark
+    const char* filter;         // Hanya benchmark yang namanya memuat teks ini
+    const char* tag;            // Label versi firmware di setiap baris
+};
+
+static BenchOptions options = {FORMAT_TABLE, 20000, nullptr, nullptr};
+static size_t stackBaseline = 0;
+
+static uint64_t nowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void printHeader() {
+    if (options.format == FORMAT_CSV) {
+        printf("tag,probe,unit,n,min,p50,p90,p99,max,mean,allocs_per_call,bytes_per_call,peak_heap,stack\n");
+    } else if (options.format == FORMAT_TABLE) {
+        printf("%-28s %8s %8s %8s %8s %8s %9s %9s %9s %7s\n",
+               "benchmark (ns/panggilan)", "min", "p50", "p90", "p99", "max",
+               "alloc/pg", "byte/pg", "heap maks", "stack");
+    }
+}
+
+// Panggil fn sebanyak `batch` kali per sampel; latensi dicatat per panggilan
+// (batch > 1 untuk fungsi yang lebih cepat dari resolusi jam).
+template <typename Fn>
+static void bench(const char* name, uint32_t batch, Fn fn) {
+    if (options.filter && !strstr(name, options.filter)) return;
+
+    for (uint32_t i = 0; i < options.samples / 10; i++) fn(); // Pemanasan
+
+    ProfileProbe probe(name);
+    heapCounters.allocs = 0;
+    heapCounters.bytes = 0;
+    heapCounters.peak = heapCounters.inUse;
+    int64_t heapStart = heapCounters.inUse;
+
+    for (uint32_t s = 0; s < options.samples; s++) {
+        uint64_t t0 = nowNs();
+        for (uint32_t b = 0; b < batch; b++) fn();
+        uint64_t elapsed = nowNs() - t0;
+        probe.histogram.record((uint32_t)(elapsed / batch));
+    }
+
+    uint64_t calls = (uint64_t)options.samples * batch;
+    double allocsPerCall = (double)heapCounters.allocs / calls;
+    double bytesPerCall = (double)heapCounters.bytes / calls;
+    long peakHeap = (long)(heapCounters.peak - heapStart);
+
+    size_t stack = measureStack(callThunk<Fn>, &fn);
+    stack = stack > stackBaseline ? stack - stackBaseline : 0;
+
+    const LatencyHistogram& h = probe.histogram;
+    if (options.format == FORMAT_JSON) {
+        char line[320];
+        int n = probe.formatJson(line, sizeof(line), "ns");
+        if (n <= 0 || n >= (int)sizeof(line)) return;
+        line[n - 1] = '\0'; // Buang '}' penutup, tambah kolom host
+        printf("%s,\"allocs_per_call\":%.2f,\"bytes_per_call\":%.1f,\"peak_heap\":%ld,\"stack\":%zu",
+               line, allocsPerCall, bytesPerCall, peakHeap, stack);
+        if (options.tag) printf(",\"tag\":\"%s\"", options.tag);
+        printf("}\n");
+    } else if (options.format == FORMAT_CSV) {
+        printf("%s,%s,ns,%u,%u,%u,%u,%u,%u,%u,%.2f,%.1f,%ld,%zu\n",
+               options.tag ? options.tag : "", name, h.count(), h.min(), h.percentile(50),
+               h.percentile(90), h.percentile(99), h.max(), h.mean(),
+               allocsPerCall, bytesPerCall, peakHeap, stack);
+    } else {
+        printf("%-28s %8u %8u %8u %8u %8u %9.2f %9.1f %9ld %7zu\n",
+               name, h.min(), h.percentile(50), h.percentile(90), h.percentile(99), h.max(),
+               allocsPerCall, bytesPerCall, peakHeap, stack);
+    }
+}
+
+// Ukuran payload per format, dicetak setelah tabel latensi (tabel & --json;
+// --csv hanya berisi baris latensi)
+struct PayloadSize {
+    const char* name;
+    size_t bytes;
+    size_t readings;
+};
+
+static PayloadSize payloads[8];
+static size_t payloadCount = 0;
+
+static void payloadSize(const char* name, size_t bytes, size_t readings) {
+    if (options.filter && !strstr(name, options.filter)) return;
+    if (payloadCount < sizeof(payloads) / sizeof(payloads[0])) payloads[payloadCount++] = {name, bytes, readings};
+}
+
+static void printPayloads() {
+    if (payloadCount == 0 || options.format == FORMAT_CSV) return;
+    if (options.format == FORMAT_TABLE) printf("\n%-28s %8s %8s %12s\n", "payload", "bacaan", "byte", "byte/bacaan");
+    for (size_t i = 0; i < payloadCount; i++) {
+        const PayloadSize& p = payloads[i];
+        double perReading = p.readings ? (double)p.bytes / p.readings : 0.0;
+        if (options.format == FORMAT_JSON) {
+            printf("{\"probe\":\"%s\",\"unit\":\"byte\",\"readings\":%zu,\"bytes\":%zu,\"bytes_per_reading\":%.1f",
+                   p.name, p.readings, p.bytes, perReading);
+            if (options.tag) printf(",\"tag\":\"%s\"", options.tag);
+            printf("}\n");
+        } else {
+            printf("%-28s %8zu %8zu %12.1f\n", p.name, p.readings, p.bytes, perReading);
+        }
+    }
+}
+
+// ==================== DATA & JAM TIRUAN ====================
+
+static unsigned long benchMs = 0;
+static unsigned long benchMillis() { return benchMs; }
+static unsigned long benchMicros() { return benchMs * 1000UL; }
+
+static Prng benchPrng(12345);
+static uint16_t benchAdc() { return (uint16_t)(2300 + (benchPrng.next() & 0x3F)); }
+
+// Pembacaan sensor ke-i tiap 30 detik, nilai & alasan kirim bervariasi
+static TelemetryRecord benchRecord(uint32_t epoch, uint32_t i) {
+    TelemetryRecord record = {epoch + i * 30, (int16_t)(285 + i % 7), (uint16_t)(712 - (i % 4) * 5),
+                              (uint8_t)(48 - i / 5), (uint8_t)(i == 0 ? TELEMETRY_REASON_FIRST : TELEMETRY_REASON_SOIL),
+                              (uint8_t)(i % 3)};
+    return record;
+}
+
+static const char BENCH_NODE_ID[] = "a4cf12b3c4d5";
+static const TelemetryDeadband BENCH_DEADBAND = {30, 600, 5, 20, 2};
+
+static volatile uint32_t jobRuns = 0;
+static void benchJob() { jobRuns++; }
+
+// 32 jadwal acak (seperti tabel penuh dari server)
+static void fillSchedules(ScheduleEntry* entries, size_t count) {
+    Prng prng(7);
+    for (size_t i = 0; i < count; i++) {
+        entries[i].minuteOfDay = (uint16_t)(prng.next() % 1440);
+        entries[i].durationSec = (uint16_t)(60 + prng.next() % 900);
+        entries[i].weekdays = (uint8_t)(1 + prng.next() % WEEKDAYS_ALL);
+        entries[i].zone = (uint8_t)(prng.next() % 4);
+        entries[i].enabled = 1;
+        entries[i].reserved = 0;
+    }
+}
+
+// ==================== JALUR PARSE LAMA ====================
+// Sebelum parse dari stream: http.getString() menyalin seluruh body ke String
+// (std::string di sini), lalu parse tanpa filter. Request, konversi per entri
+// jadwal (parseScheduleEntry()) dan perbandingan jadwal sama dengan jalur
+// baru agar yang dibandingkan hanya cara membaca body.
+
+static ValveStatusPoll legacyCheckRemoteStatus(RecordedTransport& api) {
+    ValveStatusPoll poll = {};
+    poll.code = api.get("/api/water-status");
+    if (poll.code > 0) {
+        std::string payload = api.getString();
+        StaticJsonDocument<300> doc;
+        if (!deserializeJson(doc, payload)) {
+            const char* status = doc["valve_status"] | "";
+            poll.parsed = strcmp(status, "ON") == 0 || strcmp(status, "OFF") == 0;
+            poll.status.on = strcmp(status, "ON") == 0;
+            poll.status.zone = doc["zone"] | 1;
+        }
+    }
+    api.end();
+    return poll;
+}
+
+static ScheduleSync legacySyncSchedules(RecordedTransport& api, const ScheduleEntry* current, uint8_t currentCount,
+                                        ScheduleEntry* out, uint8_t capacity) {
+    ScheduleSync sync = {};
+    sync.code = api.get("/api/schedules");
+    sync.status = ScheduleSync::HTTP_ERROR;
+    if (sync.code > 0) {
+        std::string payload = api.getString();
+        DynamicJsonDocument doc(4096);
+        sync.status = ScheduleSync::PARSE_FAILED;
+        if (!deserializeJson(doc, payload)) {
+            for (JsonObject schedule : doc.as<JsonArray>()) {
+                if (sync.parse.count >= capacity) break;
+                ScheduleFields fields;
+                if (parseScheduleEntry(schedule, fields, out[sync.parse.count])) sync.parse.count++;
+            }
+            bool changed = sync.parse.count != currentCount ||
+                           memcmp(out, current, sync.parse.count * sizeof(ScheduleEntry)) != 0;
+            sync.status = changed ? ScheduleSync::CHANGED : ScheduleSync::UNCHANGED;
+        }
+    }
+    api.end();
+    return sync;
+}
+
+// ==================== SENSOR NODE ====================
+
+static ReadingBuffer<480> uploadReadings;
+
+// Pembacaan baru setiap 30 detik, seperti sampling sensor node
+static void pushReadings(uint32_t epoch, uint32_t count) {
+    static uint32_t n = 0;
+    for (uint32_t i = 0; i < count; i++, n++) {
+        TelemetryRecord record = benchRecord(epoch, n % 20);
+        SensorReading r = {};
+        r.timestamp = epoch + n * 30;
+        r.flags = SensorReading::TS_EPOCH;
+        r.tempX10 = record.tempX10;
+        r.humidX10 = record.humidX10;
+        r.soil = record.soil;
+        r.reason = record.flags;
+        r.skipped = record.skipped;
+        uploadReadings.push(r);
+    }
+}
+
+// Server menerima batch (201); body tidak disalin (socket di firmware)
+static int acceptBatch(const uint8_t* body, size_t length, size_t count, void* ctx) {
+    (void)body;
+    (void)length;
+    (void)count;
+    (void)ctx;
+    return 201;
+}
+
+// ==================== BENCHMARK ====================
+
+static void runAll() {
+    const uint32_t EPOCH = 1736121600;
+
+    // Scheduler::run() - 16 job periodik, jam maju 10 ms per panggilan
+    {
+        static Scheduler<16> scheduler(benchMillis);
+        benchMs = 0;
+        for (int i = 0; i < 16; i++) scheduler.every(100UL * (i + 1), benchJob);
+        bench("scheduler.run", 8, [] {
+            benchMs += 10;
+            scheduler.run();
+        });
+    }
+
+    // Timer firmware lama vs Scheduler dengan 5 job yang sama (batas MinimalTimer)
+    {
+        static MinimalTimer timer(benchMillis);
+        static Scheduler<5> scheduler(benchMillis);
+        benchMs = 0;
+        for (int i = 0; i < 5; i++) {
+            timer.setInterval(100L * (i + 1), benchJob);
+            scheduler.every(100UL * (i + 1), benchJob);
+        }
+        bench("minimal_timer.run5", 8, [] {
+            benchMs += 10;
+            timer.run();
+        });
+        bench("scheduler.run5", 8, [] {
+            benchMs += 10;
+            scheduler.run();
+        });
+    }
+
+    // ScheduleTable - muat ulang 32 entri (setelah sync) & poll per detik
+    {
+        static ScheduleEntry entries[32];
+        fillSchedules(entries, 32);
+        static ScheduleTable<32> table(300);
+        static uint32_t now = EPOCH;
+        bench("schedule_table.load", 1, [] { table.load(entries, 32, now); });
+
+        table.load(entries, 32, now);
+        bench("schedule_table.poll", 16, [] {
+            ScheduleTable<32>::Event event;
+            now += 1;
+            while (table.poll(now, event)) {}
+        });
+    }
+
+    // MoistureController::plan() - per event jadwal
+    {
+        static MoistureController controller({40.0f, 60.0f, 0.25f, 2.0f, 900000UL});
+        controller.ingest(47.0f, 0);
+        bench("moisture.plan", 64, [] {
+            volatile unsigned long d = controller.plan(600, 1000).durationSec;
+            (void)d;
+        });
+    }
+
+    // ValveBank::update() - 4 zona antri, 1 pompa, stagger 5 s
+    {
+        static VirtualClock clock(EPOCH);
+        static RecordingValveOutput output(clock);
+        static ValveBank<4> valves(output, {1, 5000UL});
+        static unsigned long now = 0;
+        valves.begin();
+        bench("valve_bank.update", 16, [] {
+            now += 250;
+            if (!valves.anyOpen() && valves.queuedCount() == 0) {
+                for (uint8_t z = 0; z < 4; z++) valves.request(z, 2000, false, now);
+            }
+            valves.update(now);
+        });
+    }
+
+    // SoilSampler::sample() - burst 16 sampel, median + EMA
+    {
+        static SoilSampler sampler({16, 0.2f, 400, 5}, benchAdc, benchMicros);
+        bench("soil_sampler.sample", 4, [] { sampler.sample(); });
+    }
+
+    // ReadingBuffer push + baca batch + pop (alur sampling -> upload)
+    {
+        static ReadingBuffer<480> buffer;
+        static uint32_t ts = EPOCH;
+        bench("reading_buffer.cycle", 4, [] {
+            for (int i = 0; i < 20; i++) {
+                SensorReading r = {};
+                r.timestamp = ts++;
+                r.soil = 50;
+                buffer.push(r);
+            }
+            volatile uint32_t sum = 0;
+            for (size_t i = 0; i < buffer.size(); i++) sum += buffer.at(i).timestamp;
+            buffer.pop(buffer.size());
+        });
+    }
+
+    // TelemetryEncoder/Decoder - satu batch upload (20 record)
+    {
+        static uint8_t payload[TELEMETRY_HEADER_SIZE + 20 * TELEMETRY_RECORD_SIZE];
+        static size_t length = 0;
+        bench("telemetry.encode_batch20", 4, [] {
+            TelemetryEncoder encoder(payload, sizeof(payload));
+            for (uint32_t i = 0; i < 20; i++) encoder.add(benchRecord(EPOCH, i));
+            length = encoder.finish();
+        });
+        bench("telemetry.decode_batch20", 4, [] {
+            TelemetryDecoder decoder(payload, length);
+            TelemetryRecord record;
+            volatile uint32_t sum = 0;
+            while (decoder.next(record)) sum += record.soil;
+        });
+
+        // Format default sensor node (TelemetryJson.h): node + deadband + 20 record
+        static char json[20 * 100 + 128]; // uploadBuffer firmware
+        bench("telemetry.encode_json20", 1, [] {
+            TelemetryJsonEncoder encoder(json, sizeof(json));
+            encoder.setNode(BENCH_NODE_ID);
+            encoder.setDeadband(BENCH_DEADBAND);
+            for (uint32_t i = 0; i < 20; i++) encoder.add(benchRecord(EPOCH, i));
+            volatile size_t length = encoder.finish();
+            (void)length;
+        });
+
+        // Ukuran payload seperti yang dikirim firmware (dengan ekstensi deadband)
+        uint8_t binary[telemetryEncodedSize(20, true)];
+        TelemetryEncoder encoder(binary, sizeof(binary));
+        encoder.setDeadband(BENCH_DEADBAND);
+        for (uint32_t i = 0; i < 20; i++) encoder.add(benchRecord(EPOCH, i));
+        payloadSize("telemetry.binary20", encoder.finish(), 20);
+        TelemetryJsonEncoder jsonEncoder(json, sizeof(json));
+        jsonEncoder.setNode(BENCH_NODE_ID);
+        jsonEncoder.setDeadband(BENCH_DEADBAND);
+        for (uint32_t i = 0; i < 20; i++) jsonEncoder.add(benchRecord(EPOCH, i));
+        payloadSize("telemetry.json20", jsonEncoder.finish(), 20);
+    }
+
+    // checkRemoteStatus / syncSchedulesFromAPI - body rekaman lewat
+    // pollValveStatus()/syncScheduleTable() (RemoteApi.h, kode firmware),
+    // dibandingkan dengan jalur lama http.getString()
+    {
+        static RecordedTransport statusApi(200, RECORDED_WATER_STATUS);
+        static RecordedTransport schedulesApi(200, RECORDED_SCHEDULES, "\"sched-8\"");
+        static ScheduleEntry current[32];
+        static ScheduleEntry entries[32];
+        static char etag[64];
+
+        // Kedua jalur harus menghasilkan hal yang sama sebelum dibandingkan
+        ScheduleEntry oldEntries[32];
+        ValveStatusPoll oldPoll = legacyCheckRemoteStatus(statusApi);
+        ValveStatusPoll newPoll = pollValveStatus(statusApi, "/api/water-status");
+        ScheduleSync oldSync = legacySyncSchedules(schedulesApi, current, 0, oldEntries, 32);
+        ScheduleSync newSync = syncScheduleTable(schedulesApi, "/api/schedules", etag, sizeof(etag), current, 0,
+                                                 entries, 32);
+        if (!oldPoll.parsed || !newPoll.parsed || oldPoll.status.on != newPoll.status.on ||
+            oldPoll.status.zone != newPoll.status.zone || oldSync.status != ScheduleSync::CHANGED ||
+            newSync.status != ScheduleSync::CHANGED || oldSync.parse.count != newSync.parse.count ||
+            memcmp(oldEntries, entries, newSync.parse.count * sizeof(ScheduleEntry)) != 0) {
+            fprintf(stderr, "Jalur lama & RemoteApi.h tidak sama\n");
+        }
+
+        bench("check_remote_status.getstring", 4, [] {
+            volatile bool ok = legacyCheckRemoteStatus(statusApi).parsed;
+            (void)ok;
+        });
+        bench("check_remote_status", 4, [] {
+            volatile bool ok = pollValveStatus(statusApi, "/api/water-status").parsed;
+            (void)ok;
+        });
+        // Jadwal server berbeda dari config (perlu disimpan): parse + bandingkan
+        bench("sync_schedules.getstring", 1, [] {
+            volatile int count = legacySyncSchedules(schedulesApi, current, 0, entries, 32).parse.count;
+            (void)count;
+        });
+        bench("sync_schedules", 1, [] {
+            etag[0] = '\0';
+            volatile int count = syncScheduleTable(schedulesApi, "/api/schedules", etag, sizeof(etag), current, 0,
+                                                   entries, 32).parse.count;
+            (void)count;
+        });
+        // Polling berikutnya: ETag sama, server membalas 304 tanpa body
+        syncScheduleTable(schedulesApi, "/api/schedules", etag, sizeof(etag), current, 0, entries, 32);
+        bench("sync_schedules.304", 8, [] {
+            volatile int status = syncScheduleTable(schedulesApi, "/api/schedules", etag, sizeof(etag), current, 0,
+                                                    entries, 32).status;
+            (void)status;
+        });
+    }
+
+    // sendSensorData() - uploadBatch() BatchUpload.h (encode 20 pembacaan
+    // tertua, POST, pop setelah 201), termasuk push 20 pembacaan baru
+    {
+        static uint8_t binary[telemetryEncodedSize(20, true)];
+        static char json[20 * 100 + 128];
+        bench("send_sensor_data.binary20", 1, [] {
+            pushReadings(EPOCH, 20);
+            TelemetryEncoder encoder(binary, sizeof(binary));
+            encoder.setDeadband(BENCH_DEADBAND);
+            volatile bool ok = uploadBatch(uploadReadings, encoder, binary, 20, EPOCH, 0, acceptBatch, nullptr).ok;
+            (void)ok;
+        });
+        bench("send_sensor_data.json20", 1, [] {
+            pushReadings(EPOCH, 20);
+            TelemetryJsonEncoder encoder(json, sizeof(json));
+            encoder.setNode(BENCH_NODE_ID);
+            encoder.setDeadband(BENCH_DEADBAND);
+            volatile bool ok = uploadBatch(uploadReadings, encoder, json, 20, EPOCH, 0, acceptBatch, nullptr).ok;
+            (void)ok;
+        });
+    }
+
+    // LogStore::append() - event penyiraman 8 byte, termasuk rollover/erase
+    {
+        static uint8_t memory[16 * 4096];
+        static uint32_t erases[16];
+        static RamFlashRegion flash(memory, sizeof(memory), erases);
+        static LogStore log(flash);
+        log.begin();
+        bench("log_store.append", 1, [] {
+            uint8_t evt[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+            log.append(2, evt, sizeof(evt));
+        });
+    }
+}
+
+// Dipanggil dari main() untuk --bench
+int runBenchmarks(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) options.format = FORMAT_JSON;
+        else if (strcmp(argv[i], "--csv") == 0) options.format = FORMAT_CSV;
+        else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc) options.samples = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) options.filter = argv[++i];
+        else if (strcmp(argv[i], "--tag") == 0 && i + 1 < argc) options.tag = argv[++i];
+    }
+    if (options.samples == 0) options.samples = 1;
+
+    heapCounting = true;
+    stackBaseline = measureStack(emptyThunk, nullptr);
+
+    printHeader();
+    runAll();
+    printPayloads();
+    return 0;
+}
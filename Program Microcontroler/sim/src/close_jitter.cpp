@@ -0,0 +1,277 @@
+/*
+ * SIMULASI JITTER TUTUP VALVE - networkTask tertahan server lambat
+ *
+ * Server HTTP tiruan di loopback (Linux) menahan setiap response selama
+ * --delay-ms (dibatasi HTTP_TIMEOUT_MS di klien), sehingga request status
+ * selalu blocking seperti http.GET() ke server yang lambat. Sementara itu
+ * jadwal membuka zona 1-4 bergantian selama RUN_MS dan ValveBank harus
+ * menutupnya tepat waktu. Dua bentuk firmware dibandingkan dalam waktu
+ * nyata:
+ *   - satu loop  : firmware lama, cek jadwal/auto-close dan HTTP di loop()
+ *                  yang sama (tidur 20 ms antar iterasi);
+ *   - dua task   : networkTask (HTTP, commit config di bawah mutex) dan
+ *                  valveTask (jadwal + valves.update(), tidur sampai aksi
+ *                  berikutnya paling lama VALVE_HEARTBEAT_MS).
+ *
+ * Dilaporkan ValveBank::maxCloseLateMs() (yang juga dicetak firmware setiap
+ * menit) dan keterlambatan tutup yang diukur relay tiruan (p50/p99/maks).
+ * Durasi dipersingkat agar selesai dalam hitungan detik; yang diukur adalah
+ * keterlambatan, bukan durasi siram. Kode keluar 1 jika mode dua task
+ * melewati CLOSE_JITTER_BOUND_MS.
+ *
+ * Pemakaian: .pio/build/native/program --close-jitter [--runs N] [--delay-ms N]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SimHardware.h"
+#include "ValveBank.h"
+
+// ==================== KONSTANTA (sama dengan firmware) ====================
+const unsigned long LOOP_MAX_SLEEP_MS = 20;
+const unsigned long VALVE_HEARTBEAT_MS = 1000;
+const unsigned long REMOTE_CHECK_INTERVAL = 5000;
+const unsigned long HTTP_TIMEOUT_MS = 5000;
+const uint8_t VALVE_ZONES = 4;
+// Stagger 0: zona berikutnya dibuka tanpa jeda pompa agar run berdekatan
+const ValveBankConfig SIM_BANK_CONFIG = {1, 0};
+
+// Simulasi
+const unsigned long RUN_MS = 500;                   // Lama buka tiap jadwal (dipersingkat)
+const unsigned long RUN_GAP_SPREAD_MS = 300;        // Jeda acak antar jadwal
+const unsigned long CLOSE_JITTER_BOUND_MS = 100;    // Batas mode dua task (termasuk jitter thread host)
+
+typedef std::chrono::steady_clock SteadyClock;
+
+static unsigned long nowMs() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+        SteadyClock::now().time_since_epoch()).count();
+}
+
+static void sleepMs(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// ==================== RELAY TIRUAN ====================
+
+// Mencatat keterlambatan tutup dari luar ValveBank: relay mati - (buka + RUN_MS)
+class LatencyRelay : public ValveOutput {
+public:
+    void write(uint8_t zone, bool open) override {
+        if (zone >= SIM_MAX_ZONES || open == _open[zone]) return;
+        unsigned long now = nowMs();
+        _open[zone] = open;
+        if (open) {
+            _openedAt[zone] = now;
+        } else {
+            unsigned long openMs = now - _openedAt[zone];
+            lateMs.push_back(openMs > RUN_MS ? (long)(openMs - RUN_MS) : 0);
+        }
+    }
+
+    std::vector<long> lateMs;
+
+private:
+    bool _open[SIM_MAX_ZONES] = {};
+    unsigned long _openedAt[SIM_MAX_ZONES] = {};
+};
+
+// ==================== SERVER LAMBAT ====================
+
+// Satu klien pada satu waktu; setiap response ditahan delayMs
+static void serveSlowly(int listener, unsigned long delayMs, std::atomic<bool>& done) {
+    static const char RESPONSE[] =
+        "HTTP/1.0 200 OK\r\nContent-Type: application/json\r\n\r\n"
+        "{\"id\":1,\"valve_status\":\"OFF\",\"zone\":1,\"duration\":30}";
+    while (!done.load()) {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) return;
+
+        char request[512];
+        size_t length = 0;
+        while (length < sizeof(request) - 1) {
+            ssize_t n = recv(fd, request + length, sizeof(request) - 1 - length, 0);
+            if (n <= 0) break;
+            length += (size_t)n;
+            request[length] = '\0';
+            if (strstr(request, "\r\n\r\n")) break;
+        }
+        for (unsigned long waited = 0; waited < delayMs && !done.load(); waited += 10) sleepMs(10);
+        send(fd, RESPONSE, sizeof(RESPONSE) - 1, MSG_NOSIGNAL);
+        close(fd);
+    }
+}
+
+// checkRemoteStatus(): GET blocking dengan timeout HTTP_TIMEOUT_MS
+static void fetchStatus(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return;
+    timeval timeout = {(time_t)(HTTP_TIMEOUT_MS / 1000), (suseconds_t)(HTTP_TIMEOUT_MS % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0) {
+        static const char REQUEST[] = "GET /api/water-status HTTP/1.0\r\nHost: 127.0.0.1\r\n\r\n";
+        send(fd, REQUEST, sizeof(REQUEST) - 1, MSG_NOSIGNAL);
+        char buffer[256];
+        while (recv(fd, buffer, sizeof(buffer), 0) > 0) {}
+    }
+    close(fd);
+}
+
+// ==================== FIRMWARE TIRUAN ====================
+
+struct JitterNode {
+    JitterNode(int port, unsigned long runs, uint32_t seed)
+        : port(port), runs(runs), prng(seed), valves(relay, SIM_BANK_CONFIG) {}
+
+    int port;
+    unsigned long runs;
+    Prng prng;
+    LatencyRelay relay;
+    ValveBank<VALVE_ZONES> valves;
+    std::mutex configMutex;         // Dipegang checkSchedule() & commit syncSchedulesFromAPI()
+    std::atomic<bool> done{false};
+
+    unsigned long started = 0;
+    unsigned long nextRunAt = 0;
+    unsigned long nextCheckAt = 0;
+    unsigned long requests = 0;
+    unsigned long stallMaxMs = 0;
+
+    // checkSchedule() + auto-close: buka jadwal berikutnya bila jatuh tempo.
+    // Mengembalikan ms sampai aksi berikutnya.
+    unsigned long stepValves() {
+        unsigned long now = nowMs();
+        if (started < runs && now >= nextRunAt && !valves.anyOpen()) {
+            std::lock_guard<std::mutex> lock(configMutex);
+            valves.request((uint8_t)(started % VALVE_ZONES), RUN_MS, false, now);
+            started++;
+            nextRunAt = now + RUN_MS + prng.next() % RUN_GAP_SPREAD_MS;
+        }
+        unsigned long until = valves.update(nowMs());
+        if (started < runs) {
+            now = nowMs();
+            unsigned long untilRun = nextRunAt > now ? nextRunAt - now : 0;
+            if (untilRun < until) until = untilRun;
+        }
+        return until;
+    }
+
+    // checkRemoteStatus() bila jatuh tempo; blocking selama server menahan response
+    void stepNetwork() {
+        unsigned long now = nowMs();
+        if (now < nextCheckAt) return;
+        nextCheckAt = now + REMOTE_CHECK_INTERVAL;
+        fetchStatus(port);
+        unsigned long spent = nowMs() - now;
+        if (spent > stallMaxMs) stallMaxMs = spent;
+        requests++;
+        std::lock_guard<std::mutex> lock(configMutex); // Commit hasil sync: singkat
+    }
+
+    bool finished() {
+        return started >= runs && !valves.anyOpen();
+    }
+};
+
+// Firmware lama: semuanya di loop() yang sama
+static void runSingleLoop(JitterNode& node) {
+    while (!node.finished()) {
+        unsigned long until = node.stepValves();
+        node.stepNetwork();
+        sleepMs(until < LOOP_MAX_SLEEP_MS ? until : LOOP_MAX_SLEEP_MS);
+    }
+}
+
+// Firmware sekarang: networkTask dan valveTask terpisah
+static void runTwoTasks(JitterNode& node) {
+    std::thread network([&node] {
+        while (!node.done.load()) {
+            node.stepNetwork();
+            sleepMs(LOOP_MAX_SLEEP_MS);
+        }
+    });
+    while (!node.finished()) {
+        unsigned long until = node.stepValves();
+        sleepMs(until < VALVE_HEARTBEAT_MS ? until : VALVE_HEARTBEAT_MS);
+    }
+    node.done.store(true);
+    network.join(); // Menunggu request yang sedang tertahan selesai
+}
+
+static long percentile(std::vector<long> v, double p) {
+    if (v.empty()) return 0;
+    size_t i = (size_t)(p * (v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + i, v.end());
+    return v[i];
+}
+
+int runCloseJitter(int argc, char** argv) {
+    unsigned long runs = 12;
+    unsigned long delayMs = 4000;
+    uint32_t seed = 3;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--runs") == 0) runs = strtoul(argv[i + 1], nullptr, 10);
+        else if (strcmp(argv[i], "--delay-ms") == 0) delayMs = strtoul(argv[i + 1], nullptr, 10);
+        else if (strcmp(argv[i], "--seed") == 0) seed = (uint32_t)atoi(argv[i + 1]);
+    }
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLength = sizeof(addr);
+    if (listener < 0 || bind(listener, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listener, 1) < 0 ||
+        getsockname(listener, (sockaddr*)&addr, &addrLength) < 0) {
+        printf("Socket TCP loopback gagal dibuka\n");
+        return 1;
+    }
+    std::atomic<bool> serverDone{false};
+    std::thread server(serveSlowly, listener, delayMs, std::ref(serverDone));
+
+    printf("Jitter tutup valve, server menahan response %lu ms (timeout HTTP %lu ms), %lu jadwal x %lu ms\n\n",
+           delayMs, HTTP_TIMEOUT_MS, runs, RUN_MS);
+    printf("%-26s %8s %10s %13s %9s %9s %9s\n", "firmware", "request", "HTTP maks", "maxCloseLate", "p50",
+           "p99", "maks");
+
+    bool ok = true;
+    for (int mode = 0; mode < 2; mode++) {
+        JitterNode node((int)ntohs(addr.sin_port), runs, seed);
+        node.valves.begin();
+        if (mode == 0) runSingleLoop(node);
+        else runTwoTasks(node);
+
+        const std::vector<long>& late = node.relay.lateMs;
+        long max = late.empty() ? 0 : *std::max_element(late.begin(), late.end());
+        printf("%-26s %8lu %7lu ms %10lu ms %6ld ms %6ld ms %6ld ms\n",
+               mode == 0 ? "satu loop (lama)" : "networkTask + valveTask", node.requests, node.stallMaxMs,
+               node.valves.maxCloseLateMs(), percentile(late, 0.50), percentile(late, 0.99), max);
+        if (mode == 1 && (node.valves.maxCloseLateMs() > CLOSE_JITTER_BOUND_MS || late.size() != runs)) ok = false;
+    }
+
+    serverDone.store(true);
+    shutdown(listener, SHUT_RDWR); // accept() yang masih menunggu ikut selesai
+    server.join();
+    close(listener);
+
+    printf("\nmaxCloseLate = ValveBank::maxCloseLateMs(); p50/p99/maks = relay mati - (buka + %lu ms)\n", RUN_MS);
+    printf("\n%s\n", ok ? "Jitter tutup dua task dalam batas." : "JITTER TUTUP DI LUAR BATAS!");
+    return ok ? 0 : 1;
+}
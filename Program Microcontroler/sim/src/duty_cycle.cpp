@@ -0,0 +1,290 @@
+/*
+ * SIMULASI DEEP SLEEP - Energi per pembacaan & latensi bangun -> tidur
+ *
+ * Membandingkan sensor node selalu aktif (loop() + WiFi terus tersambung,
+ * upload tiap 5 menit) dengan mode SENSOR_DEEP_SLEEP: bangun tiap 30 detik,
+ * soil (EMA lanjut dari RTC) + DHT, lalu DutyCyclePolicy memutuskan kapan
+ * WiFi dinyalakan. Keputusan, buffer & filter memakai header firmware yang
+ * sama; durasi & arus tiap fase dari model daya di bawah (perkiraan datasheet
+ * ESP32 @ 3.3 V, hanya modul ESP32, tanpa sensor & regulator).
+ *
+ * Dilaporkan per skenario:
+ *   - energi per pembacaan (mJ), arus rata-rata, perkiraan umur baterai
+ *   - latensi bangun -> tidur (p50/p99/maks), dengan & tanpa WiFi
+ *   - jumlah WiFi dinyalakan, pembacaan per upload, pemicu upload
+ *   - umur data terlama saat sampai di server
+ *
+ * Pemakaian: .pio/build/native/program --duty-cycle [--days N] [--seed N]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "SimHardware.h"
+#include "PlantModel.h"
+
+#include "ReadingBuffer.h"
+#include "SensorPipeline.h"
+#include "DutyCycle.h"
+#include <Profiler.h>
+
+// ==================== KONSTANTA (sama dengan firmware) ====================
+const unsigned long SAMPLE_INTERVAL_MS = 30000;
+const unsigned long ALWAYS_ON_UPLOAD_MS = 300000;
+const int BATCH_SIZE = 20;
+const int MAX_BATCHES = 5;
+const CalibrationPoint CALIBRATION[] = {{3500, 0}, {1200, 100}};
+const SoilSamplerConfig SAMPLER_CONFIG = {16, 0.2f, 400, 5};
+const DutyCycleConfig DUTY_CONFIG = {SAMPLE_INTERVAL_MS, 1000, BATCH_SIZE, 5, 20, 100, 16};
+const uint8_t SOIL_BURSTS = 4;
+const unsigned long WIFI_TIMEOUT_MS = 10000;
+#define RTC_BUFFER_CAPACITY 120
+
+// ==================== MODEL DAYA ====================
+// Arus rata-rata (mA) & durasi (ms) per fase
+
+struct PowerModel {
+    float deepSleepMa = 0.01f;      // RTC timer + RTC slow memory
+    float bootMa = 40.0f;           // ROM + bootloader + init Arduino
+    unsigned long bootMs = 250;
+    float activeMa = 45.0f;         // CPU 240 MHz, radio mati
+    unsigned long soilBurstMs = 2;  // 16 x analogRead + median/EMA
+    unsigned long dhtReadMs = 25;   // Start 18 ms + 40 bit data
+    unsigned long dhtRetryMs = 1000;
+    float wifiConnectMa = 120.0f;   // Scan + asosiasi + DHCP
+    unsigned long wifiMinMs = 1500;
+    unsigned long wifiMaxMs = 3500;
+    float uploadMa = 150.0f;        // TX HTTP POST + tunggu response
+    unsigned long uploadMs = 300;
+    unsigned long ntpMs = 500;      // Sekali, sampai jam RTC tersinkron
+    unsigned long wifiOffMs = 20;
+    float alwaysOnMa = 80.0f;       // Selalu aktif + WiFi modem-sleep (rata-rata)
+    float volts = 3.3f;
+    float batteryMah = 2000.0f;
+};
+
+const PowerModel POWER;
+
+// ==================== DUNIA ====================
+
+struct DutyWorld {
+    VirtualClock clock;
+    ClimateModel climate;
+    SoilModel soil;
+    Prng sensorPrng;
+    Prng radioPrng;
+
+    DutyWorld(uint32_t seed, const SoilModelConfig& soilConfig)
+        : clock(1736121600), soil(soilConfig, seed), sensorPrng(seed * 31 + 7), radioPrng(seed * 17 + 3) {}
+
+    static uint16_t adc();
+    static unsigned long micros();
+};
+
+static DutyWorld* duty = nullptr;
+uint16_t DutyWorld::adc() { return duty->soil.adc(3500, 1200); }
+unsigned long DutyWorld::micros() { return duty->clock.micros(); }
+
+// Penyiraman jadwal 06:00 & 17:00 selama 10 menit (seperti simulasi utama)
+static bool irrigating(uint32_t secOfDay) {
+    return (secOfDay >= 6 * 3600 && secOfDay < 6 * 3600 + 600) ||
+           (secOfDay >= 17 * 3600 && secOfDay < 17 * 3600 + 600);
+}
+
+static void advanceWorld(DutyWorld& w, unsigned long ms) {
+    // Tanah/iklim dimajukan per detik; fase < 1 detik cukup dengan jam saja
+    unsigned long step = 1000;
+    while (ms >= step) {
+        w.soil.step(1.0f, w.clock.epoch(), w.climate.temperature(w.clock.secondOfDay()),
+                    irrigating(w.clock.secondOfDay()));
+        w.clock.advance(step);
+        ms -= step;
+    }
+    w.clock.advance(ms);
+}
+
+struct DutyResult {
+    uint32_t wakes;
+    uint32_t readings;
+    uint32_t wifiOn;
+    uint32_t wifiFailed;
+    uint32_t uploaded;
+    uint32_t triggers[4];       // Per DutyCyclePolicy::Reason
+    double energyMj;
+    LatencyHistogram awakeAll;  // ms bangun -> tidur
+    LatencyHistogram awakeWifi;
+    unsigned long maxDataAgeSec;
+};
+
+// Satu pembacaan: DHT (5% gagal per percobaan, 2x retry) + soil terkalibrasi.
+// Mengembalikan lama fase DHT (ms); false jika DHT tetap gagal.
+static bool takeReading(DutyWorld& w, const SoilSampler& sampler, SensorReading& out, unsigned long& dhtMs) {
+    dhtMs = 0;
+    bool ok = false;
+    for (int attempt = 0; attempt < 3 && !ok; attempt++) {
+        if (attempt > 0) dhtMs += POWER.dhtRetryMs;
+        dhtMs += POWER.dhtReadMs;
+        ok = w.sensorPrng.uniform() >= 0.05f;
+    }
+    if (!ok) return false;
+    uint32_t sec = w.clock.secondOfDay();
+    float temperature = w.climate.temperature(sec) + w.sensorPrng.gaussian() * 0.5f;
+    float humidity = w.climate.humidity(sec) + w.sensorPrng.gaussian() * 2.0f;
+    float soil = applyCalibration(CALIBRATION, 2, sampler.raw());
+    out = {};
+    out.timestamp = w.clock.epoch();
+    out.flags = SensorReading::TS_EPOCH;
+    out.tempX10 = (int16_t)lroundf(temperature * 10);
+    out.humidX10 = (uint16_t)lroundf(humidity * 10);
+    out.soil = (uint8_t)lroundf(soil);
+    return true;
+}
+
+// Buang hingga MAX_BATCHES x BATCH_SIZE pembacaan tertua; catat umur data
+static unsigned long drain(DutyWorld& w, ReadingBuffer<RTC_BUFFER_CAPACITY>& buffer, DutyResult& r) {
+    unsigned long ms = 0;
+    for (int b = 0; b < MAX_BATCHES && !buffer.empty(); b++) {
+        size_t count = buffer.size() < (size_t)BATCH_SIZE ? buffer.size() : BATCH_SIZE;
+        unsigned long age = w.clock.epoch() - buffer.at(0).timestamp;
+        if (age > r.maxDataAgeSec) r.maxDataAgeSec = age;
+        buffer.pop(count);
+        r.uploaded += count;
+        ms += POWER.uploadMs;
+    }
+    return ms;
+}
+
+DutyResult runDeepSleep(uint32_t days, uint32_t seed, unsigned long outageStartSec, unsigned long outageSec,
+                        const SoilModelConfig& soilConfig) {
+    DutyWorld w(seed, soilConfig);
+    duty = &w;
+    DutyResult r = {};
+    ReadingBuffer<RTC_BUFFER_CAPACITY> buffer; // RTC slow memory
+    DutyCycleState state = {};                 // RTC slow memory
+    DutyCyclePolicy policy(DUTY_CONFIG);
+    DutyCyclePolicy::init(state);
+    bool timeSynced = false;
+    unsigned long end = days * 86400000UL;
+
+    while (w.clock.millis() < end) {
+        // Bangun: boot, soil burst (EMA dari RTC), DHT
+        unsigned long awake = POWER.bootMs;
+        double mAms = POWER.bootMa * POWER.bootMs;
+
+        SoilSampler sampler(SAMPLER_CONFIG, DutyWorld::adc, DutyWorld::micros); // RAM hilang saat deep sleep
+        if (state.soilReady) sampler.seed(state.soilRaw);
+        for (uint8_t i = 0; i < SOIL_BURSTS; i++) sampler.sample();
+        state.soilRaw = sampler.raw();
+        state.soilReady = sampler.ready();
+        awake += SOIL_BURSTS * POWER.soilBurstMs;
+
+        SensorReading reading;
+        unsigned long dhtMs;
+        bool got = takeReading(w, sampler, reading, dhtMs);
+        awake += dhtMs;
+        mAms += POWER.activeMa * (SOIL_BURSTS * POWER.soilBurstMs + dhtMs);
+        if (got) {
+            buffer.push(reading);
+            r.readings++;
+        }
+
+        bool wifi = false;
+        if (!buffer.empty()) {
+            SensorReading latest = buffer.at(buffer.size() - 1);
+            DutyCyclePolicy::Reason reason = policy.decide(state, latest, buffer.size());
+            if (reason != DutyCyclePolicy::HOLD) {
+                wifi = true;
+                r.wifiOn++;
+                r.triggers[reason]++;
+                unsigned long secNow = w.clock.millis() / 1000;
+                bool apUp = secNow < outageStartSec || secNow >= outageStartSec + outageSec;
+                unsigned long connectMs = apUp ? POWER.wifiMinMs + w.radioPrng.next() %
+                                                     (POWER.wifiMaxMs - POWER.wifiMinMs + 1)
+                                               : WIFI_TIMEOUT_MS;
+                awake += connectMs;
+                mAms += POWER.wifiConnectMa * connectMs;
+                if (apUp) {
+                    if (!timeSynced) {
+                        awake += POWER.ntpMs;
+                        mAms += POWER.wifiConnectMa * POWER.ntpMs;
+                        timeSynced = true;
+                    }
+                    unsigned long uploadMs = drain(w, buffer, r);
+                    awake += uploadMs;
+                    mAms += POWER.uploadMa * uploadMs;
+                } else {
+                    r.wifiFailed++;
+                }
+                awake += POWER.wifiOffMs;
+                mAms += POWER.activeMa * POWER.wifiOffMs;
+                policy.uploaded(state, latest, apUp);
+            }
+        }
+
+        policy.finish(state, awake);
+        r.wakes++;
+        r.awakeAll.record(awake);
+        if (wifi) r.awakeWifi.record(awake);
+
+        unsigned long sleepMs = policy.sleepMs(awake);
+        mAms += POWER.deepSleepMa * sleepMs;
+        r.energyMj += mAms * POWER.volts / 1000.0; // mA x ms x V = uJ
+        advanceWorld(w, awake + sleepMs);
+    }
+    duty = nullptr;
+    return r;
+}
+
+// Firmware lama: sampel tiap 30 detik, CPU & WiFi aktif terus, upload tiap 5 menit
+// (DHT gagal ditutup cache DhtReader, jadi setiap interval menghasilkan pembacaan)
+DutyResult runAlwaysOn(uint32_t days) {
+    DutyResult r = {};
+    unsigned long end = days * 86400000UL;
+    r.readings = (uint32_t)(end / SAMPLE_INTERVAL_MS);
+    r.wifiOn = 1;
+    r.uploaded = r.readings;
+    r.maxDataAgeSec = ALWAYS_ON_UPLOAD_MS / 1000;
+    r.energyMj = POWER.alwaysOnMa * (double)end * POWER.volts / 1000.0;
+    return r;
+}
+
+static void printDutyResult(const char* name, const DutyResult& r, uint32_t days) {
+    double seconds = days * 86400.0;
+    double avgMa = r.energyMj / POWER.volts / seconds;      // mJ / V / s = mA
+    double lifeDays = POWER.batteryMah / avgMa / 24.0;
+    printf("== %s ==\n", name);
+    printf("  Energi       : %.1f mJ per pembacaan, rata-rata %.3f mA, baterai %.0f mAh ~ %.1f hari\n",
+           r.energyMj / (r.readings ? r.readings : 1), avgMa, POWER.batteryMah, lifeDays);
+    printf("  Pembacaan    : %u (%u terkirim), umur data maks %lu menit\n", r.readings, r.uploaded,
+           r.maxDataAgeSec / 60);
+    if (r.wakes == 0) {
+        printf("  WiFi         : selalu tersambung\n\n");
+        return;
+    }
+    printf("  WiFi         : %u kali (%u gagal), %.1f pembacaan per upload; pemicu batch %u, berubah %u, pertama %u\n",
+           r.wifiOn, r.wifiFailed, r.wifiOn > r.wifiFailed ? (double)r.uploaded / (r.wifiOn - r.wifiFailed) : 0.0,
+           r.triggers[DutyCyclePolicy::BATCH_FULL], r.triggers[DutyCyclePolicy::CHANGED],
+           r.triggers[DutyCyclePolicy::FIRST]);
+    printf("  Bangun->tidur: semua p50 %u / p99 %u / maks %u ms (%u bangun); dengan WiFi p50 %u / p99 %u / maks %u ms\n\n",
+           r.awakeAll.percentile(50), r.awakeAll.percentile(99), r.awakeAll.max(), r.wakes,
+           r.awakeWifi.percentile(50), r.awakeWifi.percentile(99), r.awakeWifi.max());
+}
+
+int runDutyCycleSim(int argc, char** argv) {
+    uint32_t days = 7;
+    uint32_t seed = 42;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--days") == 0) days = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--seed") == 0) seed = (uint32_t)atoi(argv[i + 1]);
+    }
+    const SoilModelConfig soilConfig = {50.0f, 75.0f, 0.02f, 1.2f, 0.5f, 0.2f, 5.0f};
+
+    printf("Deep sleep sensor node, %u hari, seed %u (model daya: lihat duty_cycle.cpp)\n\n", days, seed);
+    printDutyResult("selalu aktif (loop + WiFi)", runAlwaysOn(days), days);
+    printDutyResult("deep sleep", runDeepSleep(days, seed, 0, 0, soilConfig), days);
+    printDutyResult("deep sleep, AP mati 6 jam di hari ke-2",
+                    runDeepSleep(days, seed, 86400 + 8 * 3600, 6 * 3600, soilConfig), days);
+    return 0;
+}
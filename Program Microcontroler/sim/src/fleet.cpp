@@ -0,0 +1,386 @@
+/*
+ * SIMULASI ARMADA - Ratusan node memakai satu server lewat endpoint per node
+ *
+ * Setiap node simulasi adalah satu thread dengan satu koneksi TCP keep-alive
+ * (seperti HttpTransport) dan ID dari MAC buatan (NodeId.h). Node dibuat
+ * berpasangan:
+ *   control node : GET water-status tiap 5 s, schedules (If-None-Match) dan
+ *                  sensor/latest tiap 60 s (netTimer firmware)
+ *   sensor node  : POST batch biner 10 record tiap 5 menit
+ * Interval firmware dibagi --speed (bawaan 60: satu menit firmware = 1 detik),
+ * jadi N node dengan --speed S memberi beban request setara N x S node
+ * sungguhan. Fase awal tiap node acak, seperti node yang tidak menyala
+ * bersamaan.
+ *
+ * Dilaporkan per jumlah node: latensi sisi node per endpoint (p50/p99/maks),
+ * error, throughput server (request/s, record/s), waktu proses server
+ * p50/p99 dan koneksi puncak (hanya IngestServer bawaan).
+ *
+ * Pemakaian: .pio/build/native/program --fleet [--nodes N] [--seconds 10] [--speed 60] [--seed N]
+ *           .pio/build/native/program --fleet --host 192.168.1.10 --port 8000 --nodes 200
+ * Tanpa --nodes: 100, 200 dan 500 node. Tanpa --host: IngestServer di loopback.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SimHardware.h"
+#include "IngestServer.h"
+#include <NodeId.h>
+#include <TelemetryCodec.h>
+
+// ==================== KONSTANTA (sama dengan firmware) ====================
+const unsigned long REMOTE_CHECK_INTERVAL = 5000;     // Control node: water-status
+const unsigned long SCHEDULE_SYNC_INTERVAL = 60000;   // Control node: schedules
+const unsigned long MOISTURE_FETCH_INTERVAL = 60000;  // Control node: sensor/latest
+const unsigned long UPLOAD_INTERVAL = 300000;         // Sensor node: batch
+const unsigned long SENSOR_SAMPLE_INTERVAL = 30000;
+const int RECORDS_PER_UPLOAD = UPLOAD_INTERVAL / SENSOR_SAMPLE_INTERVAL;
+const int HTTP_TIMEOUT_MS = 5000;                     // Sama dengan HttpTransport
+
+typedef std::chrono::steady_clock SteadyClock;
+
+enum Endpoint { EP_WATER_STATUS, EP_SCHEDULES, EP_SENSOR_LATEST, EP_TELEMETRY, EP_COUNT };
+static const char* const ENDPOINT_NAMES[EP_COUNT] = {"water-status", "schedules", "sensor/latest",
+                                                     "telemetry"};
+static const char* const ENDPOINT_SUFFIX[EP_COUNT] = {"/water-status", "/schedules", "/sensor/latest",
+                                                      "/telemetry"};
+
+static long long nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now().time_since_epoch()).count();
+}
+
+struct FleetTarget {
+    in_addr_t host;
+    uint16_t port;
+};
+
+struct NodeResult {
+    std::vector<uint32_t> latencyUs[EP_COUNT];
+    uint32_t errors[EP_COUNT];
+    uint32_t reconnects;
+};
+
+// Satu koneksi keep-alive seperti HttpTransport: dibuka saat dibutuhkan,
+// ditutup dan dibuka ulang setelah error
+class FleetConnection {
+public:
+    explicit FleetConnection(const FleetTarget& target) : _target(target) {}
+    ~FleetConnection() { reset(); }
+
+    // Status HTTP, -1 jika koneksi/timeout gagal
+    int request(const char* method, const char* path, const char* nodeId, const char* etag,
+                const uint8_t* body, size_t length, char* etagOut, size_t etagSize, uint32_t& reconnects) {
+        if (_fd < 0) {
+            if (!open()) return -1;
+            reconnects++;
+        }
+        char header[320];
+        int n = snprintf(header, sizeof(header),
+                         "%s %s HTTP/1.1\r\nHost: prokon\r\nX-Node-Id: %s\r\nConnection: keep-alive\r\n"
+                         "%s%s%sContent-Type: %s\r\nContent-Length: %u\r\n\r\n",
+                         method, path, nodeId, etag ? "If-None-Match: " : "", etag ? etag : "",
+                         etag ? "\r\n" : "", body ? TELEMETRY_CONTENT_TYPE : "application/json",
+                         (unsigned)length);
+        if (!sendAll(header, (size_t)n) || (length && !sendAll((const char*)body, length))) return fail();
+        return readResponse(etagOut, etagSize);
+    }
+
+    void reset() {
+        if (_fd >= 0) close(_fd);
+        _fd = -1;
+        _buf.clear();
+    }
+
+private:
+    bool open() {
+        _fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (_fd < 0) return false;
+        timeval timeout = {HTTP_TIMEOUT_MS / 1000, (HTTP_TIMEOUT_MS % 1000) * 1000};
+        setsockopt(_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        int yes = 1;
+        setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(_target.port);
+        addr.sin_addr.s_addr = _target.host;
+        if (connect(_fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+            reset();
+            return false;
+        }
+        return true;
+    }
+
+    int fail() {
+        reset();
+        return -1;
+    }
+
+    bool sendAll(const char* data, size_t length) {
+        while (length) {
+            ssize_t n = send(_fd, data, length, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            data += n;
+            length -= (size_t)n;
+        }
+        return true;
+    }
+
+    bool fill() {
+        char chunk[2048];
+        ssize_t n = recv(_fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        _buf.append(chunk, (size_t)n);
+        return true;
+    }
+
+    // Baca status, ETag & Content-Length, buang body (seperti api.readBody())
+    int readResponse(char* etagOut, size_t etagSize) {
+        size_t headerEnd;
+        while ((headerEnd = _buf.find("\r\n\r\n")) == std::string::npos) {
+            if (!fill()) return fail();
+        }
+        int status = 0;
+        if (sscanf(_buf.c_str(), "HTTP/1.%*d %d", &status) != 1) return fail();
+        size_t contentLength = 0;
+        bool close = false;
+        const char* line = strstr(_buf.c_str(), "\r\n");
+        const char* end = _buf.c_str() + headerEnd;
+        while (line && line < end) {
+            line += 2;
+            if (strncasecmp(line, "Content-Length:", 15) == 0) {
+                contentLength = (size_t)strtoul(line + 15, nullptr, 10);
+            } else if (etagOut && strncasecmp(line, "ETag:", 5) == 0) {
+                const char* value = line + 5;
+                while (*value == ' ') value++;
+                size_t len = strcspn(value, "\r");
+                if (len >= etagSize) len = etagSize - 1;
+                memcpy(etagOut, value, len);
+                etagOut[len] = '\0';
+            } else if (strncasecmp(line, "Connection: close", 17) == 0) {
+                close = true;
+            }
+            line = strstr(line, "\r\n");
+        }
+        size_t total = headerEnd + 4 + contentLength;
+        while (_buf.size() < total) {
+            if (!fill()) return fail();
+        }
+        _buf.erase(0, total);
+        if (close) reset();
+        return status;
+    }
+
+    FleetTarget _target;
+    int _fd = -1;
+    std::string _buf;
+};
+
+struct Job {
+    Endpoint endpoint;
+    long long intervalUs;
+    long long dueUs;
+};
+
+// Satu node: jalankan job sesuai jadwal sampai deadline
+static void runNode(const FleetTarget& target, const char* nodeId, bool sensor, bool scoped, double speed,
+                    long long startUs, long long deadlineUs, uint32_t seed, NodeResult& result) {
+    Prng rng(seed);
+    FleetConnection connection(target);
+    char paths[EP_COUNT][64];
+    static const char* const LEGACY[EP_COUNT] = {"/api/water-status", "/api/schedules/esp32", "/api/sensor/latest",
+                                                 "/api/receive-sensor/batch"};
+    for (int e = 0; e < EP_COUNT; e++) {
+        if (scoped) nodePath(paths[e], sizeof(paths[e]), nodeId, ENDPOINT_SUFFIX[e]);
+        else snprintf(paths[e], sizeof(paths[e]), "%s", LEGACY[e]);
+    }
+
+    std::vector<Job> jobs;
+    if (sensor) {
+        jobs.push_back({EP_TELEMETRY, (long long)(UPLOAD_INTERVAL * 1000 / speed), 0});
+    } else {
+        jobs.push_back({EP_WATER_STATUS, (long long)(REMOTE_CHECK_INTERVAL * 1000 / speed), 0});
+        jobs.push_back({EP_SCHEDULES, (long long)(SCHEDULE_SYNC_INTERVAL * 1000 / speed), 0});
+        jobs.push_back({EP_SENSOR_LATEST, (long long)(MOISTURE_FETCH_INTERVAL * 1000 / speed), 0});
+    }
+    for (Job& job : jobs) job.dueUs = startUs + (long long)(rng.uniform() * job.intervalUs);
+
+    char etag[40] = "";
+    uint32_t timestamp = 1736121600 + rng.next() % 86400;
+    uint8_t batch[256];
+    for (;;) {
+        Job* next = &jobs[0];
+        for (Job& job : jobs) {
+            if (job.dueUs < next->dueUs) next = &job;
+        }
+        if (next->dueUs >= deadlineUs) break;
+        long long waitUs = next->dueUs - nowUs();
+        if (waitUs > 0) std::this_thread::sleep_for(std::chrono::microseconds(waitUs));
+
+        const uint8_t* body = nullptr;
+        size_t length = 0;
+        if (next->endpoint == EP_TELEMETRY) {
+            TelemetryEncoder encoder(batch, sizeof(batch));
+            for (int i = 0; i < RECORDS_PER_UPLOAD; i++) {
+                TelemetryRecord record = {timestamp, (int16_t)(250 + rng.next() % 80),
+                                          (uint16_t)(550 + rng.next() % 300), (uint8_t)(30 + rng.next() % 40), 0};
+                encoder.add(record);
+                timestamp += SENSOR_SAMPLE_INTERVAL / 1000;
+            }
+            body = batch;
+            length = encoder.finish();
+        }
+
+        char* etagOut = next->endpoint == EP_SCHEDULES ? etag : nullptr;
+        const char* ifNoneMatch = next->endpoint == EP_SCHEDULES && etag[0] ? etag : nullptr;
+        long long start = nowUs();
+        int status = connection.request(body ? "POST" : "GET", paths[next->endpoint], nodeId, ifNoneMatch,
+                                        body, length, etagOut, sizeof(etag), result.reconnects);
+        long long elapsed = nowUs() - start;
+
+        // 404 sensor/latest = sensor pasangan belum upload (bukan error)
+        bool ok = (status >= 200 && status < 300) || status == 304 ||
+                  (status == 404 && next->endpoint == EP_SENSOR_LATEST);
+        if (ok) result.latencyUs[next->endpoint].push_back((uint32_t)elapsed);
+        else result.errors[next->endpoint]++;
+        next->dueUs += next->intervalUs;
+    }
+}
+
+static uint32_t percentile(std::vector<uint32_t>& v, double p) {
+    if (v.empty()) return 0;
+    size_t i = (size_t)(p * (v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + i, v.end());
+    return v[i];
+}
+
+static bool runFleetOnce(const FleetTarget* external, uint32_t nodes, double seconds, double speed, bool scoped,
+                         uint32_t seed) {
+    IngestServer server;
+    FleetTarget target;
+    if (external) {
+        target = *external;
+    } else {
+        if (!server.start()) {
+            printf("IngestServer gagal dibuka di loopback\n");
+            return false;
+        }
+        target.host = htonl(INADDR_LOOPBACK);
+        target.port = server.port();
+    }
+
+    // ID dari MAC buatan (OUI Espressif a4:cf:12); node genap = control, ganjil = sensor
+    std::vector<std::array<char, NODE_ID_SIZE>> ids(nodes);
+    for (uint32_t i = 0; i < nodes; i++) {
+        uint8_t mac[NODE_MAC_SIZE] = {0xa4, 0xcf, 0x12, (uint8_t)(i >> 16), (uint8_t)(i >> 8), (uint8_t)i};
+        nodeIdFromMac(mac, ids[i].data());
+    }
+    if (!external) {
+        for (uint32_t i = 0; i + 1 < nodes; i += 2) server.pair(ids[i].data(), ids[i + 1].data());
+    }
+
+    std::vector<NodeResult> results(nodes);
+    std::vector<std::thread> threads;
+    threads.reserve(nodes);
+    long long startUs = nowUs() + 100000;
+    long long deadlineUs = startUs + (long long)(seconds * 1e6);
+    for (uint32_t i = 0; i < nodes; i++) {
+        results[i] = NodeResult();
+        threads.emplace_back(runNode, std::cref(target), ids[i].data(), (i % 2) == 1, scoped, speed, startUs,
+                             deadlineUs, (seed + i) * 2654435761u, std::ref(results[i])); // Seed tersebar per node
+    }
+    for (std::thread& t : threads) t.join();
+    double elapsed = (nowUs() - startUs) / 1e6;
+
+    std::vector<uint32_t> latency[EP_COUNT];
+    uint32_t errors[EP_COUNT] = {};
+    uint32_t reconnects = 0;
+    uint64_t total = 0;
+    for (NodeResult& r : results) {
+        for (int e = 0; e < EP_COUNT; e++) {
+            latency[e].insert(latency[e].end(), r.latencyUs[e].begin(), r.latencyUs[e].end());
+            errors[e] += r.errors[e];
+            total += r.latencyUs[e].size() + r.errors[e];
+        }
+        reconnects += r.reconnects;
+    }
+
+    printf("\n%u node (%u pasangan), %.1f s, speed %.0fx ~ beban %.0f node sungguhan, %.0f request/s\n", nodes,
+           nodes / 2, elapsed, speed, nodes * speed, total / elapsed);
+    printf("  %-15s %8s %7s %9s %9s %9s\n", "endpoint", "request", "error", "p50", "p99", "maks");
+    for (int e = 0; e < EP_COUNT; e++) {
+        uint32_t max = latency[e].empty() ? 0 : *std::max_element(latency[e].begin(), latency[e].end());
+        uint32_t p50 = percentile(latency[e], 0.50);
+        uint32_t p99 = percentile(latency[e], 0.99);
+        printf("  %-15s %8zu %7u %7.2fms %7.2fms %7.2fms\n", ENDPOINT_NAMES[e], latency[e].size() + errors[e],
+               errors[e], p50 / 1000.0, p99 / 1000.0, max / 1000.0);
+    }
+    printf("  koneksi dibuka: %u\n", reconnects);
+
+    if (!external) {
+        server.stop();
+        IngestStats s = server.stats();
+        printf("  server: %llu request (%.0f/s), %llu record (%.0f/s), 304 %llu, ditolak %llu, %u node, "
+               "koneksi puncak %u\n",
+               (unsigned long long)s.requests, s.requests / elapsed, (unsigned long long)s.records,
+               s.records / elapsed, (unsigned long long)s.notModified, (unsigned long long)s.rejected, s.nodes,
+               s.peakConnections);
+        printf("  waktu proses server p50 %u us, p99 %u us\n", percentile(s.handleUs, 0.50),
+               percentile(s.handleUs, 0.99));
+    }
+    return true;
+}
+
+int runFleet(int argc, char** argv) {
+    uint32_t nodes = 0;
+    double seconds = 10;
+    double speed = 60;
+    uint32_t seed = 42;
+    bool scoped = true;
+    const char* host = nullptr;
+    uint16_t port = 8000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--legacy") == 0) scoped = false;
+        else if (i + 1 < argc && strcmp(argv[i], "--nodes") == 0) nodes = (uint32_t)atoi(argv[i + 1]);
+        else if (i + 1 < argc && strcmp(argv[i], "--seconds") == 0) seconds = atof(argv[i + 1]);
+        else if (i + 1 < argc && strcmp(argv[i], "--speed") == 0) speed = atof(argv[i + 1]);
+        else if (i + 1 < argc && strcmp(argv[i], "--seed") == 0) seed = (uint32_t)atoi(argv[i + 1]);
+        else if (i + 1 < argc && strcmp(argv[i], "--host") == 0) host = argv[i + 1];
+        else if (i + 1 < argc && strcmp(argv[i], "--port") == 0) port = (uint16_t)atoi(argv[i + 1]);
+    }
+    if (speed <= 0) speed = 1;
+
+    FleetTarget external = {host ? inet_addr(host) : 0, port};
+    if (host && external.host == INADDR_NONE) {
+        printf("--host harus alamat IPv4\n");
+        return 1;
+    }
+    char targetName[64];
+    if (host) snprintf(targetName, sizeof(targetName), "%s:%u", host, port);
+    else snprintf(targetName, sizeof(targetName), "IngestServer (loopback)");
+    printf("Armada node -> %s, endpoint %s, seed %u\n", targetName,
+           scoped ? NODE_API_PREFIX "<id>/..." : "global + X-Node-Id", seed);
+
+    const uint32_t sweep[] = {100, 200, 500};
+    if (nodes) return runFleetOnce(host ? &external : nullptr, nodes, seconds, speed, scoped, seed) ? 0 : 1;
+    for (uint32_t n : sweep) {
+        if (!runFleetOnce(host ? &external : nullptr, n, seconds, speed, scoped, seed)) return 1;
+    }
+    printf("\nlatensi = request sampai body response terbaca (sisi node), tanpa radio WiFi\n");
+    return 0;
+}
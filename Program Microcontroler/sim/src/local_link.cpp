@@ -0,0 +1,267 @@
+/*
+ * SIMULASI LINK LOKAL - Sensor node -> control node lewat UDP tanpa server
+ *
+ * Memakai socket UDP sungguhan di loopback (Linux) dengan LocalLinkSender/
+ * LocalLinkReceiver firmware. Pengirim mengirim frame berurutan dengan
+ * gangguan buatan (frame dibuang, diduplikasi, ditukar urutan, sensor node
+ * reboot); penerima meniru networkTask: tidur hingga LOOP_MAX_SLEEP_MS lalu
+ * menguras semua datagram tanpa menunggu. Sensor node pasangan lain di LAN yang
+ * sama ikut mengirim ke grup (FOREIGN_EVERY); frame-nya harus ditolak.
+ *
+ * Dilaporkan per mode penerima:
+ *   - latensi  : sendto() -> record diterima receiver (p50/p99/maks)
+ *   - diterima / hilang / basi / reboot / asing : statistik LocalLinkReceiver
+ * ditambah umur bacaan soil lewat jalur server (upload batch + fetch) sebagai
+ * pembanding.
+ *
+ * Pemakaian: .pio/build/native/program --local-link [--frames N] [--seed N] [--multicast]
+ * (--multicast: grup 239.255.80.75 dengan IP_MULTICAST_LOOP, butuh route multicast)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "SimHardware.h"
+#include <LocalLinkProtocol.h>
+#include <NodeId.h>
+
+// ==================== KONSTANTA (sama dengan firmware) ====================
+const unsigned long LOOP_MAX_SLEEP_MS = 20;        // networkTask control node
+const unsigned long SENSOR_SAMPLE_INTERVAL = 30000;
+const unsigned long UPLOAD_INTERVAL = 300000;      // Jalur server: batch sensor node
+const unsigned long MOISTURE_FETCH_INTERVAL = 60000; // Jalur server: fetchMoisture control node
+
+// Simulasi (interval dipercepat; latensi tidak bergantung interval)
+const unsigned long FRAME_GAP_US = 7000;
+const uint16_t LINK_PORT = 4275;
+const float DROP_CHANCE = 0.05f;
+const float DUPLICATE_CHANCE = 0.02f;
+const float SWAP_CHANCE = 0.02f;
+const uint32_t FOREIGN_EVERY = 10;                 // Satu frame sensor node lain per 10 frame
+const uint8_t SENSOR_MAC[NODE_MAC_SIZE] = {0xa4, 0xcf, 0x12, 0xb3, 0xc4, 0xd5};
+const uint8_t FOREIGN_MAC[NODE_MAC_SIZE] = {0xa4, 0xcf, 0x12, 0x00, 0x00, 0x01};
+
+typedef std::chrono::steady_clock SteadyClock;
+
+static long long nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now().time_since_epoch()).count();
+}
+
+struct LinkResult {
+    uint32_t sent;
+    LocalLinkReceiver::Stats stats;
+    std::vector<long long> latencyUs;
+};
+
+static int openReceiver(bool multicast) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return -1;
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(LINK_PORT);
+    addr.sin_addr.s_addr = htonl(multicast ? INADDR_ANY : INADDR_LOOPBACK);
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    if (multicast) {
+        ip_mreq group = {};
+        group.imr_multiaddr.s_addr = inet_addr("239.255.80.75");
+        group.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+        if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &group, sizeof(group)) < 0) {
+            close(fd);
+            return -1;
+        }
+    }
+    return fd;
+}
+
+static int openSender(bool multicast, sockaddr_in& to) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) return -1;
+    to = {};
+    to.sin_family = AF_INET;
+    to.sin_port = htons(LINK_PORT);
+    if (multicast) {
+        to.sin_addr.s_addr = inet_addr("239.255.80.75");
+        in_addr iface = {};
+        iface.s_addr = htonl(INADDR_LOOPBACK);
+        unsigned char loop = 1, ttl = 1;
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface));
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    } else {
+        to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    }
+    return fd;
+}
+
+// pollSleepMs = 0: penerima menunggu datagram dengan poll() (batas bawah latensi)
+static bool runLink(uint32_t frames, uint32_t seed, bool multicast, unsigned long pollSleepMs, LinkResult& r) {
+    int rx = openReceiver(multicast);
+    sockaddr_in to;
+    int tx = openSender(multicast, to);
+    if (rx < 0 || tx < 0) {
+        if (rx >= 0) close(rx);
+        if (tx >= 0) close(tx);
+        return false;
+    }
+
+    r = LinkResult();
+    // Waktu kirim per frame, diindeks seq (bootId kedua melanjutkan indeks)
+    std::vector<std::atomic<long long>> sentAt(frames + 8);
+    std::atomic<bool> done(false);
+    const uint32_t rebootAt = frames / 2;
+
+    std::thread receiver([&] {
+        LocalLinkReceiver link;
+        link.setSource(SENSOR_MAC); // Control node dengan -DPAIRED_SENSOR_ID
+        uint8_t buf[64];
+        uint32_t secondBootBase = 0;
+        bool secondBoot = false;
+        uint16_t firstBootId = 0;
+        bool haveBootId = false;
+        for (;;) {
+            if (pollSleepMs) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(pollSleepMs));
+            } else {
+                pollfd p = {rx, POLLIN, 0};
+                poll(&p, 1, 20);
+            }
+            // Sama dengan LocalLink::poll(): kuras semua datagram yang sudah masuk
+            ssize_t n;
+            while ((n = recv(rx, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+                TelemetryRecord record;
+                unsigned long nowMs = (unsigned long)(nowUs() / 1000);
+                if (!link.accept(buf, (size_t)n, nowMs, record)) continue;
+                uint16_t bootId = (uint16_t)(buf[4] | (buf[5] << 8));
+                uint32_t seq = 0;
+                for (int i = 0; i < 4; i++) seq |= (uint32_t)buf[6 + i] << (8 * i);
+                if (!haveBootId) {
+                    firstBootId = bootId;
+                    haveBootId = true;
+                }
+                if (bootId != firstBootId && !secondBoot) {
+                    secondBoot = true;
+                    secondBootBase = rebootAt;
+                }
+                uint32_t index = (bootId == firstBootId ? 0 : secondBootBase) + seq;
+                if (index < sentAt.size()) r.latencyUs.push_back(nowUs() - sentAt[index].load());
+            }
+            if (done.load() && n <= 0) break;
+        }
+        r.stats = link.stats();
+    });
+
+    Prng rng(seed);
+    LocalLinkSender* sender = new LocalLinkSender((uint16_t)rng.next(), SENSOR_MAC);
+    LocalLinkSender foreign((uint16_t)rng.next(), FOREIGN_MAC);
+    uint8_t held[LOCAL_LINK_FRAME_SIZE];
+    size_t heldLength = 0;
+    for (uint32_t i = 0; i < frames; i++) {
+        if (i == rebootAt) {
+            // Sensor node reboot: bootId baru, seq mulai dari 0
+            delete sender;
+            sender = new LocalLinkSender((uint16_t)(rng.next() | 1), SENSOR_MAC);
+        }
+        TelemetryRecord record = {1736121600 + i * 30, 285, 712, (uint8_t)(40 + i % 20), 0};
+        uint8_t frame[LOCAL_LINK_FRAME_SIZE];
+        size_t length = sender->frame(frame, sizeof(frame), record);
+        sentAt[i].store(nowUs());
+        r.sent++;
+
+        float roll = rng.uniform();
+        if (roll < DROP_CHANCE) {
+            // Hilang di udara
+        } else if (roll < DROP_CHANCE + SWAP_CHANCE && !heldLength) {
+            memcpy(held, frame, length); // Ditahan, dikirim setelah frame berikutnya
+            heldLength = length;
+        } else {
+            sendto(tx, frame, length, 0, (sockaddr*)&to, sizeof(to));
+            if (roll < DROP_CHANCE + SWAP_CHANCE + DUPLICATE_CHANCE) {
+                sendto(tx, frame, length, 0, (sockaddr*)&to, sizeof(to));
+            }
+            if (heldLength) {
+                sendto(tx, held, heldLength, 0, (sockaddr*)&to, sizeof(to));
+                heldLength = 0;
+            }
+        }
+        if (i % FOREIGN_EVERY == FOREIGN_EVERY - 1) {
+            TelemetryRecord other = {record.timestamp, 301, 650, 15, 0};
+            size_t otherLength = foreign.frame(frame, sizeof(frame), other);
+            sendto(tx, frame, otherLength, 0, (sockaddr*)&to, sizeof(to));
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(FRAME_GAP_US));
+    }
+    delete sender;
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    done.store(true);
+    receiver.join();
+    close(rx);
+    close(tx);
+    return true;
+}
+
+static long long percentile(std::vector<long long>& v, double p) {
+    if (v.empty()) return 0;
+    size_t i = (size_t)(p * (v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + i, v.end());
+    return v[i];
+}
+
+int runLocalLink(int argc, char** argv) {
+    uint32_t frames = 500;
+    uint32_t seed = 42;
+    bool multicast = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--multicast") == 0) multicast = true;
+        else if (i + 1 < argc && strcmp(argv[i], "--frames") == 0) frames = (uint32_t)atoi(argv[i + 1]);
+        else if (i + 1 < argc && strcmp(argv[i], "--seed") == 0) seed = (uint32_t)atoi(argv[i + 1]);
+    }
+
+    printf("Link lokal UDP %s, %u frame, seed %u (buang %.0f%%, duplikat %.0f%%, tukar urutan %.0f%%, 1 reboot)\n\n",
+           multicast ? "multicast 239.255.80.75 (lo)" : "unicast 127.0.0.1", frames, seed,
+           DROP_CHANCE * 100, DUPLICATE_CHANCE * 100, SWAP_CHANCE * 100);
+    printf("%-26s %8s %8s %8s %8s %7s %6s %9s %9s %9s\n", "penerima", "dikirim", "diterima", "hilang", "basi",
+           "reboot", "asing", "p50", "p99", "maks");
+
+    const unsigned long modes[] = {LOOP_MAX_SLEEP_MS, 0};
+    for (unsigned long sleepMs : modes) {
+        LinkResult r;
+        if (!runLink(frames, seed, multicast, sleepMs, r)) {
+            printf("Socket UDP loopback gagal dibuka%s\n", multicast ? " (coba tanpa --multicast)" : "");
+            return 1;
+        }
+        char name[48];
+        if (sleepMs) snprintf(name, sizeof(name), "networkTask (tidur %lu ms)", sleepMs);
+        else snprintf(name, sizeof(name), "menunggu poll()");
+        long long p50 = percentile(r.latencyUs, 0.50);
+        long long p99 = percentile(r.latencyUs, 0.99);
+        long long max = r.latencyUs.empty() ? 0 : *std::max_element(r.latencyUs.begin(), r.latencyUs.end());
+        printf("%-26s %8u %8u %8u %8u %7u %6u %7.2fms %7.2fms %7.2fms\n", name, r.sent, r.stats.received,
+               r.stats.lost, r.stats.stale, r.stats.restarts, r.stats.foreign, p50 / 1000.0, p99 / 1000.0,
+               max / 1000.0);
+    }
+
+    // Jalur server: sampel menunggu batch upload, lalu menunggu fetchMoisture
+    printf("\nJalur server (perkiraan): umur bacaan soil di control node rata-rata %lu s, maks %lu s;\n",
+           (UPLOAD_INTERVAL + MOISTURE_FETCH_INTERVAL) / 2000, (UPLOAD_INTERVAL + MOISTURE_FETCH_INTERVAL) / 1000);
+    printf("link lokal: setiap sampel (tiap %lu s) langsung, tidak bergantung server.\n",
+           SENSOR_SAMPLE_INTERVAL / 1000);
+    printf("hilang = lompatan seq, basi = duplikat/terlambat (ditolak), asing = frame sensor node lain\n");
+    printf("(ditolak), latensi tanpa radio WiFi\n");
+    return 0;
+}
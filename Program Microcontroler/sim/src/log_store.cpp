@@ -0,0 +1,247 @@
+/*
+ * SIMULASI LOG STORE - Keausan flash, replay saat boot & listrik putus
+ *
+ * LogStore dijalankan di atas RamFlashRegion seukuran partisi "wlog"
+ * (16 sektor x 4 KB) dengan pola tulis control node: snapshot Config saat
+ * jadwal berubah / awal sektor baru, event WateringEvent setiap penyiraman.
+ *
+ *   - keausan : --years tahun pemakaian (2 jadwal + 1 manual per hari,
+ *               jadwal berubah seminggu sekali). Erase per sektor dibanding
+ *               cara lama (EEPROM.put + commit = satu erase sektor per
+ *               perubahan), dengan perkiraan umur pada 100.000 siklus erase.
+ *   - replay  : boot ulang di atas flash yang sama; wateringCount dan riwayat
+ *               harus sama dengan state sebelum reboot.
+ *   - putus   : tulis record terpotong di tengah (listrik mati); replay
+ *               berhenti di record rusak tanpa kehilangan record sebelumnya,
+ *               append berikutnya pindah ke sektor baru.
+ *   - bit rusak: satu bit payload terbalik; CRC menolaknya.
+ * Kode keluar 1 jika ada pemeriksaan yang gagal.
+ *
+ * Pemakaian: .pio/build/native/program --log-store [--years N]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "ScheduleTable.h"
+#include "Watering.h"
+#include <LogStore.h>
+
+// ==================== KONSTANTA (sama dengan firmware) ====================
+#define MAX_SCHEDULES 32
+#define MAGIC_NUMBER 54322
+const size_t LOG_SECTORS = 16;                  // Partisi wlog 0x10000
+const size_t SECTOR_SIZE = 4096;
+const uint32_t FLASH_ENDURANCE = 100000;        // Siklus erase per sektor (NOR ESP32)
+
+struct Config {
+    ScheduleEntry schedules[MAX_SCHEDULES];
+    int scheduleCount;
+    int wateringCount;
+    int magicNumber;
+};
+
+// ==================== FLASH TIRUAN ====================
+
+// RamFlashRegion yang bisa memotong satu tulis (listrik mati di tengah tulis)
+class TornFlashRegion : public FlashRegion {
+public:
+    explicit TornFlashRegion(RamFlashRegion& flash) : _flash(flash) {}
+
+    // Tulis ke-`nth` berikutnya hanya menulis `keep` byte pertama
+    void tearWrite(int nth, size_t keep) {
+        _tearIn = nth;
+        _keep = keep;
+    }
+
+    size_t size() const override { return _flash.size(); }
+    size_t sectorSize() const override { return _flash.sectorSize(); }
+    bool read(size_t offset, void* dst, size_t length) override { return _flash.read(offset, dst, length); }
+    bool erase(size_t offset) override { return _flash.erase(offset); }
+
+    bool write(size_t offset, const void* src, size_t length) override {
+        if (_tearIn > 0 && --_tearIn == 0) {
+            _flash.write(offset, src, _keep < length ? _keep : length);
+            return true; // CPU mati sebelum tahu tulisannya tidak lengkap
+        }
+        return _flash.write(offset, src, length);
+    }
+
+private:
+    RamFlashRegion& _flash;
+    int _tearIn = 0;
+    size_t _keep = 0;
+};
+
+static uint8_t flashMemory[LOG_SECTORS * SECTOR_SIZE];
+static uint32_t flashErases[LOG_SECTORS];
+
+// ==================== NODE TIRUAN ====================
+
+// State control node yang dipulihkan dari log (seperti loadConfig())
+struct ConfigState {
+    Config config;
+    bool hasSnapshot;
+    uint32_t events;
+    WateringEvent last;
+};
+
+static void onRollover(LogStore& store, void* ctx) {
+    ConfigState* state = (ConfigState*)ctx;
+    store.append(LOG_CONFIG_SNAPSHOT, &state->config, sizeof(state->config));
+}
+
+static void onRecord(uint8_t type, const uint8_t* payload, size_t length, void* ctx) {
+    ConfigState* state = (ConfigState*)ctx;
+    if (type == LOG_CONFIG_SNAPSHOT && length == sizeof(Config)) {
+        Config snapshot;
+        memcpy(&snapshot, payload, sizeof(snapshot));
+        if (snapshot.magicNumber != MAGIC_NUMBER) return;
+        state->config = snapshot;
+        state->hasSnapshot = true;
+    } else if (type == LOG_WATERING && length == sizeof(WateringEvent)) {
+        memcpy(&state->last, payload, sizeof(state->last));
+        if (state->last.source == WATERING_SCHEDULED) state->config.wateringCount++;
+        state->events++;
+    }
+}
+
+static void defaultConfig(Config& config) {
+    memset(&config, 0, sizeof(config));
+    config.schedules[0] = {6 * 60, 1800, WEEKDAYS_ALL, 0, true, 0};
+    config.schedules[1] = {18 * 60, 1800, WEEKDAYS_ALL, 0, true, 0};
+    config.scheduleCount = 2;
+    config.magicNumber = MAGIC_NUMBER;
+}
+
+// Boot: begin() + replay(); mengembalikan lama replay (us, host)
+static long boot(LogStore& log, ConfigState& state) {
+    memset(&state, 0, sizeof(state));
+    auto start = std::chrono::steady_clock::now();
+    log.begin();
+    log.onRollover(onRollover, &state);
+    log.replay(onRecord, &state);
+    return (long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+// Sama dengan recordWatering() firmware: append dulu, baru state naik, agar
+// snapshot rollover yang ditulis di dalam append() belum memuat event ini
+static void recordWatering(LogStore& log, ConfigState& state, const WateringEvent& event) {
+    log.append(LOG_WATERING, &event, sizeof(event));
+    if (event.source == WATERING_SCHEDULED) state.config.wateringCount++;
+    state.last = event;
+}
+
+// ==================== PEMERIKSAAN ====================
+
+static int failures = 0;
+
+static void check(bool condition, const char* what) {
+    printf("  %-6s %s\n", condition ? "ok" : "GAGAL", what);
+    if (!condition) failures++;
+}
+
+int runLogStore(int argc, char** argv) {
+    uint32_t years = 10;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--years") == 0) years = (uint32_t)atoi(argv[i + 1]);
+    }
+    if (years == 0) years = 1;
+
+    RamFlashRegion ram(flashMemory, sizeof(flashMemory), flashErases, SECTOR_SIZE);
+    TornFlashRegion flash(ram);
+
+    // ---------- Keausan ----------
+    LogStore log(flash);
+    ConfigState state;
+    boot(log, state);
+    defaultConfig(state.config);
+    log.append(LOG_CONFIG_SNAPSHOT, &state.config, sizeof(state.config)); // Migrasi/default pertama
+
+    uint32_t legacyCommits = 1;
+    uint32_t epoch = 1735689600;    // 2025-01-01
+    uint32_t days = years * 365;
+    for (uint32_t day = 0; day < days; day++, epoch += 86400) {
+        if (day % 7 == 6) {
+            // syncSchedulesFromAPI(): jadwal berubah -> snapshot
+            state.config.schedules[0].durationSec = (uint16_t)(1200 + (day % 5) * 120);
+            log.append(LOG_CONFIG_SNAPSHOT, &state.config, sizeof(state.config));
+            legacyCommits++;
+        }
+        recordWatering(log, state, {epoch + 6 * 3600, 1800, 0, WATERING_SCHEDULED});
+        recordWatering(log, state, {epoch + 12 * 3600, 0, 1, WATERING_MANUAL});
+        recordWatering(log, state, {epoch + 18 * 3600, 1800, 0, WATERING_SCHEDULED});
+        legacyCommits += 2; // EEPROM.put hanya saat wateringCount naik (jadwal)
+    }
+
+    uint32_t minErase = 0xFFFFFFFF, maxErase = 0;
+    for (size_t s = 0; s < LOG_SECTORS; s++) {
+        if (ram.eraseCount(s) < minErase) minErase = ram.eraseCount(s);
+        if (ram.eraseCount(s) > maxErase) maxErase = ram.eraseCount(s);
+    }
+    double logYears = maxErase ? (double)FLASH_ENDURANCE * years / maxErase : 0;
+    double legacyYears = (double)FLASH_ENDURANCE * years / legacyCommits;
+
+    printf("LogStore di partisi wlog (%zu sektor x %zu byte), %u tahun pemakaian\n\n", LOG_SECTORS, SECTOR_SIZE, years);
+    printf("%-30s %10s %12s %12s %14s\n", "penyimpanan", "tulis", "erase total", "erase/sektor", "umur 100k erase");
+    printf("%-30s %10u %12u %12u %11.0f th\n", "EEPROM.put + commit (lama)", legacyCommits, legacyCommits,
+           legacyCommits, legacyYears);
+    printf("%-30s %10u %12u %5u - %-5u %11.0f th\n\n", "LogStore (ring 16 sektor)", log.stats().appends,
+           log.stats().erases, minErase, maxErase, logYears);
+
+    check(maxErase - minErase <= 1, "erase merata di semua sektor (selisih <= 1)");
+    check(log.stats().erases * 20 < legacyCommits, "erase LogStore < 1/20 cara lama");
+
+    // ---------- Replay ----------
+    ConfigState expected = state;
+    LogStore rebooted(flash);
+    ConfigState replayed;
+    long replayUs = boot(rebooted, replayed);
+    printf("\n  replay %u record dalam %ld us (host)\n", rebooted.stats().replayed, replayUs);
+    check(replayed.hasSnapshot && replayed.config.wateringCount == expected.config.wateringCount &&
+              memcmp(replayed.config.schedules, expected.config.schedules, sizeof(expected.config.schedules)) == 0,
+          "boot ulang: jadwal & wateringCount sama dengan sebelum reboot");
+    check(memcmp(&replayed.last, &expected.last, sizeof(WateringEvent)) == 0 && rebooted.stats().corrupt == 0,
+          "boot ulang: event terakhir utuh, tanpa record rusak");
+
+    // ---------- Listrik putus saat tulis ----------
+    flash.tearWrite(2, 3); // Header utuh, payload hanya 3 byte
+    WateringEvent torn = {epoch, 1800, 0, WATERING_SCHEDULED};
+    recordWatering(rebooted, replayed, torn);
+
+    LogStore afterCut(flash);
+    ConfigState recovered;
+    boot(afterCut, recovered);
+    check(afterCut.stats().corrupt == 1 && recovered.config.wateringCount == expected.config.wateringCount &&
+              memcmp(&recovered.last, &expected.last, sizeof(WateringEvent)) == 0,
+          "listrik putus: record terpotong dibuang, record sebelumnya utuh");
+
+    uint32_t sectorBefore = (uint32_t)afterCut.activeSector();
+    WateringEvent next = {epoch + 60, 1800, 0, WATERING_SCHEDULED};
+    recordWatering(afterCut, recovered, next);
+    check(afterCut.activeSector() != sectorBefore && afterCut.stats().erases == 1,
+          "append setelah record rusak pindah ke sektor baru (snapshot dulu)");
+
+    LogStore afterNext(flash);
+    ConfigState again;
+    boot(afterNext, again);
+    check(again.config.wateringCount == expected.config.wateringCount + 1 &&
+              memcmp(&again.last, &next, sizeof(WateringEvent)) == 0,
+          "boot berikutnya: event baru terbaca setelah sektor rusak");
+
+    // ---------- Bit rusak ----------
+    size_t base = afterNext.activeSector() * SECTOR_SIZE;
+    size_t lastRecord = afterNext.writeOffset() - 16;  // WateringEvent: header 8 + payload 8
+    flashMemory[base + lastRecord + 8] ^= 0x01;        // Satu bit terbalik
+    LogStore afterFlip(flash);
+    ConfigState flipped;
+    boot(afterFlip, flipped);
+    check(afterFlip.stats().corrupt >= 1 && flipped.config.wateringCount == expected.config.wateringCount,
+          "bit payload rusak: CRC menolak record, state sebelumnya utuh");
+
+    printf("\n%s\n", failures == 0 ? "Semua pemeriksaan LogStore lulus." : "ADA PEMERIKSAAN LOGSTORE YANG GAGAL!");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,451 @@
+/*
+ * SIMULASI HOST - Sensor node + Control node + server tiruan dalam waktu virtual
+ *
+ * Menjalankan komponen firmware yang tidak bergantung pada Arduino (pipeline
+ * soil/DHT, ReadingBuffer, TelemetryCodec, ScheduleTable, MoistureController,
+ * ValveBank, Scheduler, LogStore) dengan konstanta yang sama seperti firmware,
+ * di atas model iklim/tanah dan server tiruan. Langkah upload batch
+ * (BatchUpload.h), jadwal & closed-loop (Watering.h) dan parse bacaan soil
+ * (RemoteApi.h) adalah kode firmware yang sama; glue di sini hanya
+ * menggantikan WiFi/HTTP/FreeRTOS. Satu minggu simulasi selesai
+ * dalam hitungan detik.
+ *
+ * Setiap skenario memakai seed cuaca yang sama sehingga hasilnya bisa
+ * dibandingkan dan diulang:
+ *   open-loop     : durasi jadwal tetap (perilaku lama)
+ *   closed-loop   : MoistureController aktif
+ *   server-putus  : closed-loop, server mati 6 jam di hari ke-3
+ *   deadband      : closed-loop, sensor node hanya mengirim pembacaan yang
+ *                   berubah melewati ambang atau heartbeat (Deadband.h)
+ *
+ * Pemakaian: pio run -e native -t exec
+ *           .pio/build/native/program --days 30 --seed 7
+ *           .pio/build/native/program --bench [--json|--csv] (lihat bench.cpp)
+ *           .pio/build/native/program --wifi-outage (lihat wifi_outage.cpp)
+ *           .pio/build/native/program --duty-cycle [--days N] (lihat duty_cycle.cpp)
+ *           .pio/build/native/program --local-link (lihat local_link.cpp)
+ *           .pio/build/native/program --fleet [--nodes N] (lihat fleet.cpp)
+ *           .pio/build/native/program --time-sync [--days N] (lihat time_sync.cpp)
+ *           .pio/build/native/program --ota [--make-delta lama baru keluar] (lihat ota.cpp)
+ *           .pio/build/native/program --valve-safety [--trials N] (lihat valve_safety.cpp)
+ *           .pio/build/native/program --sse [--commands N] (lihat sse.cpp)
+ *           .pio/build/native/program --scheduler [--minutes N] (lihat scheduler.cpp)
+ *           .pio/build/native/program --close-jitter [--runs N] (lihat close_jitter.cpp)
+ *           .pio/build/native/program --valve-bank (lihat valve_bank.cpp)
+ *           .pio/build/native/program --log-store [--years N] (lihat log_store.cpp)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "SimHardware.h"
+#include "PlantModel.h"
+#include "StandInServer.h"
+#include "RecordedResponses.h"
+
+#include "Scheduler.h"
+#include "ScheduleTable.h"
+#include "MoistureController.h"
+#include "ValveBank.h"
+#include "Watering.h"
+#include "RemoteApi.h"
+#include "ReadingBuffer.h"
+#include "SensorPipeline.h"
+#include "Deadband.h"
+#include "BatchUpload.h"
+#include <TelemetryCodec.h>
+#include <LogStore.h>
+
+// ==================== KONSTANTA (sama dengan firmware) ====================
+// Sensor node
+const unsigned long SENSOR_SAMPLE_INTERVAL = 30000;
+const unsigned long UPLOAD_INTERVAL = 300000;
+const unsigned long UPLOAD_RETRY_INTERVAL = 60000;
+const int UPLOAD_BATCH_SIZE = 20;
+const int MAX_BATCHES_PER_CYCLE = 5;
+const int SOIL_DRY = 3500;
+const int SOIL_WET = 1200;
+const CalibrationPoint SOIL_CALIBRATION[] = {{SOIL_DRY, 0}, {SOIL_WET, 100}};
+const SoilSamplerConfig SOIL_SAMPLER_CONFIG = {16, 0.2f, 400, 5};
+const DeadbandConfig DEADBAND_CONFIG = {10, 50, 2, 19};
+
+// Control node
+#define MAX_SCHEDULES 32
+const MoistureControllerConfig MOISTURE_CONFIG = {40.0f, 60.0f, 0.25f, 2.0f, 900000UL};
+const unsigned long MOISTURE_FETCH_INTERVAL = 60000UL;
+const uint32_t MOISTURE_ZONES = 0x01;   // Sensor mengukur bed zona 1
+const unsigned long SCHEDULE_MAX_SLEEP_MS = 60000UL;
+const uint32_t SCHEDULE_CATCH_UP_SEC = 300;
+const ValveBankConfig VALVE_BANK_CONFIG = {1, 5000UL};
+
+// Simulasi
+const uint32_t SIM_START_EPOCH = 1736121600; // Senin 2025-01-06 00:00 (waktu lokal RTC)
+const float FLOW_LITERS_PER_SEC = 0.1f;      // Debit satu zona
+const SoilModelConfig SOIL_MODEL = {50.0f, 75.0f, 0.02f, 1.2f, 0.5f, 0.2f, 5.0f};
+
+// Jadwal dari server: 06:00 & 17:00 setiap hari, 10 menit, zona 1
+const ScheduleEntry SIM_SCHEDULES[] = {
+    {6 * 60, 600, WEEKDAYS_ALL, 0, 1, 0},
+    {17 * 60, 600, WEEKDAYS_ALL, 0, 1, 0},
+};
+
+struct Scenario {
+    const char* name;
+    bool closedLoop;
+    bool serverOutage;
+    bool deadband;
+};
+
+struct ScenarioResult {
+    float liters;
+    uint32_t runs;
+    uint32_t skipped;
+    uint32_t earlyStops;
+    float meanMoisture;
+    float bandError;            // Rata-rata jarak di luar rentang target (%)
+    float belowLowPct;          // Persen waktu di bawah targetLow
+    uint32_t samples;
+    uint32_t records;           // Pembacaan masuk buffer (setelah deadband)
+    uint32_t uploads;
+    uint32_t uploadFailures;
+    uint32_t telemetryBytes;
+    size_t bufferPeak;
+    uint32_t dropped;
+    float maxErrTemp;           // Error rekonstruksi sample-and-hold terbesar per kanal
+    float maxErrHumid;
+    uint32_t maxErrSoil;
+    uint32_t reconstructed;     // Sampel yang bisa dibangun ulang server (record + skipped)
+    uint32_t gaps;
+    uint32_t logAppends;
+    uint32_t logErases;
+    double wallSec;
+};
+
+// ==================== DUNIA SIMULASI ====================
+// Komponen firmware memakai callback fungsi biasa (tanpa konteks), jadi satu
+// dunia aktif diakses lewat pointer global seperti global di firmware.
+
+struct World;
+World* world = nullptr;
+
+unsigned long simMillis();
+unsigned long simMicros();
+uint16_t simSoilAdc();
+bool simDhtRead(float& temperature, float& humidity);
+void simSleep(unsigned long ms);
+void checkSchedule();
+void fetchMoisture();
+
+#define SIM_FLASH_SECTORS 16
+
+struct World {
+    Scenario scenario;
+    VirtualClock clock;
+    ClimateModel climate;
+    SoilModel soil;
+    Prng sensorPrng;
+    StandInServer server;
+
+    // Sensor node
+    SoilSampler soilSampler;
+    DhtReader dhtReader;
+    ReadingBuffer<480> readings;
+    DeadbandFilter deadband;
+    DeadbandState deadbandState = {};
+    uint8_t uploadBuffer[telemetryEncodedSize(UPLOAD_BATCH_SIZE, true)];
+    unsigned long lastSample = 0;
+    unsigned long nextUpload = UPLOAD_INTERVAL;
+
+    // Control node
+    Scheduler<> valveTimer;
+    ScheduleTable<MAX_SCHEDULES> scheduleTable;
+    Scheduler<>::Handle scheduleJob = 0;
+    MoistureController moisture;
+    RecordingValveOutput valveOutput;
+    ValveBank<1> valves;
+    uint8_t flashMemory[SIM_FLASH_SECTORS * 4096];
+    uint32_t flashErases[SIM_FLASH_SECTORS];
+    RamFlashRegion flash;
+    LogStore log;
+
+    ScenarioResult result = {};
+
+    World(const Scenario& s, uint32_t seed)
+        : scenario(s), clock(SIM_START_EPOCH), soil(SOIL_MODEL, seed), sensorPrng(seed * 31 + 7),
+          soilSampler(SOIL_SAMPLER_CONFIG, simSoilAdc, simMicros),
+          dhtReader(simDhtRead, simMillis, simSleep, 2, 1000, 300000), deadband(DEADBAND_CONFIG),
+          valveTimer(simMillis), scheduleTable(SCHEDULE_CATCH_UP_SEC), moisture(MOISTURE_CONFIG),
+          valveOutput(clock), valves(valveOutput, VALVE_BANK_CONFIG),
+          flash(flashMemory, sizeof(flashMemory), flashErases), log(flash) {}
+};
+
+unsigned long simMillis() { return world->clock.millis(); }
+unsigned long simMicros() { return world->clock.micros(); }
+void simSleep(unsigned long) {} // Retry DHT tidak memajukan waktu simulasi
+
+uint16_t simSoilAdc() {
+    return world->soil.adc(SOIL_DRY, SOIL_WET);
+}
+
+// DHT11 gagal dibaca ~5% dari percobaan
+bool simDhtRead(float& temperature, float& humidity) {
+    if (world->sensorPrng.uniform() < 0.05f) return false;
+    uint32_t sec = world->clock.secondOfDay();
+    temperature = world->climate.temperature(sec) + world->sensorPrng.gaussian() * 0.5f;
+    humidity = world->climate.humidity(sec) + world->sensorPrng.gaussian() * 2.0f;
+    return true;
+}
+
+// ==================== SENSOR NODE ====================
+
+void sensorSample() {
+    World& w = *world;
+    ClimateReading climate;
+    if (!w.dhtReader.read(climate) || !w.soilSampler.ready()) {
+        w.deadband.markGap(w.deadbandState);
+        return;
+    }
+
+    float soilPercent = applyCalibration(SOIL_CALIBRATION, 2, w.soilSampler.raw());
+    SensorReading reading = {};
+    reading.timestamp = w.clock.epoch();
+    reading.flags = SensorReading::TS_EPOCH;
+    if (climate.cached) reading.flags |= SensorReading::DHT_CACHED;
+    reading.tempX10 = (int16_t)lroundf(climate.temperature * 10);
+    reading.humidX10 = (uint16_t)lroundf(climate.humidity * 10);
+    reading.soil = (uint8_t)lroundf(soilPercent);
+    w.result.samples++;
+
+    if (w.scenario.deadband && !w.deadband.admit(w.deadbandState, reading)) {
+        // Server menahan nilai record terakhir; ukur selisihnya dengan sampel ini
+        const SensorReading& held = w.deadbandState.reference;
+        float errTemp = fabsf((reading.tempX10 - held.tempX10) / 10.0f);
+        float errHumid = fabsf((reading.humidX10 - held.humidX10) / 10.0f);
+        uint32_t errSoil = reading.soil > held.soil ? reading.soil - held.soil : held.soil - reading.soil;
+        if (errTemp > w.result.maxErrTemp) w.result.maxErrTemp = errTemp;
+        if (errHumid > w.result.maxErrHumid) w.result.maxErrHumid = errHumid;
+        if (errSoil > w.result.maxErrSoil) w.result.maxErrSoil = errSoil;
+        return;
+    }
+    w.readings.push(reading);
+    w.result.records++;
+    if (w.readings.size() > w.result.bufferPeak) w.result.bufferPeak = w.readings.size();
+}
+
+// postBatch() firmware: server tiruan menggantikan HttpTransport
+int simPostBatch(const uint8_t* body, size_t length, size_t count, void* ctx) {
+    (void)count;
+    return static_cast<StandInServer*>(ctx)->receiveBatch(body, length);
+}
+
+// sendSensorData() firmware (mode biner): uploadBatch() BatchUpload.h
+bool sensorUpload() {
+    World& w = *world;
+    TelemetryEncoder encoder(w.uploadBuffer, sizeof(w.uploadBuffer));
+    if (w.scenario.deadband) encoder.setDeadband(deadbandInfo(DEADBAND_CONFIG, SENSOR_SAMPLE_INTERVAL));
+    BatchUploadResult batch = uploadBatch(w.readings, encoder, w.uploadBuffer, UPLOAD_BATCH_SIZE,
+                                          w.clock.epoch(), w.clock.millis(), simPostBatch, &w.server);
+
+    w.result.uploads++;
+    if (!batch.ok) {
+        w.result.uploadFailures++;
+        return false;
+    }
+    w.result.telemetryBytes += batch.length;
+    return true;
+}
+
+void sensorTick() {
+    World& w = *world;
+    unsigned long now = w.clock.millis();
+
+    w.soilSampler.sample(); // Burst tiap 1 detik
+    if (now - w.lastSample >= SENSOR_SAMPLE_INTERVAL) {
+        w.lastSample = now;
+        sensorSample();
+    }
+
+    if (now >= w.nextUpload && !w.readings.empty()) {
+        bool ok = true;
+        for (int i = 0; i < MAX_BATCHES_PER_CYCLE && ok && !w.readings.empty(); i++) ok = sensorUpload();
+        w.nextUpload = now + (ok ? UPLOAD_INTERVAL : UPLOAD_RETRY_INTERVAL);
+    }
+}
+
+// ==================== CONTROL NODE ====================
+
+// armScheduleCheck() firmware
+void armScheduleCheck(uint32_t now) {
+    World& w = *world;
+    w.valveTimer.cancel(w.scheduleJob);
+    w.scheduleJob = w.valveTimer.after(w.scheduleTable.sleepMs(now, SCHEDULE_MAX_SLEEP_MS), checkSchedule);
+}
+
+// checkSchedule()/runScheduledWatering() firmware; open-loop = durasi tetap
+void checkSchedule() {
+    World& w = *world;
+    w.scheduleJob = 0;
+    uint32_t now = w.clock.epoch();
+
+    ScheduleTable<MAX_SCHEDULES>::Event event;
+    while (w.scheduleTable.poll(now, event)) {
+        const ScheduleEntry& entry = w.scheduleTable.entry(event.index);
+        ScheduledRun run = startScheduledRun(entry, w.scenario.closedLoop ? &w.moisture : nullptr, MOISTURE_ZONES,
+                                             w.valves, w.clock.millis());
+        if (run.plan.action == MoistureController::SKIP) {
+            w.result.skipped++;
+        } else if (run.started) {
+            w.result.runs++;
+            WateringEvent logged = wateringEvent(entry, run, now);
+            w.log.append(LOG_WATERING, &logged, sizeof(logged));
+        }
+    }
+    armScheduleCheck(now);
+}
+
+// fetchMoisture() firmware + perintah VALVE_CMD_MOISTURE di valveTask
+void fetchMoisture() {
+    World& w = *world;
+    char body[96];
+    size_t length = w.server.latest(w.clock.epoch(), body, sizeof(body));
+    if (length == 0) return;
+
+    MemoryStream stream(body, length);
+    RemoteMoisture reading;
+    if (!parseMoisture(stream, reading) || !w.scenario.closedLoop) return;
+
+    unsigned long sampledAt = w.clock.millis() - reading.ageSeconds * 1000UL;
+    if (applyMoisture(w.moisture, w.valves, MOISTURE_ZONES, reading.soil, sampledAt, w.clock.millis()) > 0) {
+        w.result.earlyStops++;
+    }
+}
+
+// ==================== SKENARIO ====================
+
+ScenarioResult runScenario(const Scenario& scenario, uint32_t days, uint32_t seed) {
+    World* w = new World(scenario, seed);
+    world = w;
+
+    w->log.begin();
+    w->valves.begin();
+    w->scheduleTable.load(SIM_SCHEDULES, sizeof(SIM_SCHEDULES) / sizeof(SIM_SCHEDULES[0]), w->clock.epoch());
+    armScheduleCheck(w->clock.epoch());
+    w->valveTimer.every(MOISTURE_FETCH_INTERVAL, fetchMoisture);
+
+    clock_t wallStart = clock();
+    const uint32_t totalSec = days * 86400;
+    const uint32_t outageStart = 2 * 86400 + 9 * 3600;
+    double moistureSum = 0, errorSum = 0;
+    uint32_t belowLow = 0;
+
+    for (uint32_t s = 0; s < totalSec; s++) {
+        w->clock.advance(1000);
+        uint32_t epoch = w->clock.epoch();
+
+        if (scenario.serverOutage) w->server.setDown(s >= outageStart && s < outageStart + 6 * 3600);
+
+        float temp = w->climate.temperature(w->clock.secondOfDay());
+        w->soil.step(1.0f, epoch, temp, w->valveOutput.isOpen(0));
+
+        sensorTick();
+        w->valveTimer.run();
+        w->valves.update(w->clock.millis());
+
+        float m = w->soil.moisture();
+        moistureSum += m;
+        if (m < MOISTURE_CONFIG.targetLow) {
+            errorSum += MOISTURE_CONFIG.targetLow - m;
+            belowLow++;
+        } else if (m > MOISTURE_CONFIG.targetHigh) {
+            errorSum += m - MOISTURE_CONFIG.targetHigh;
+        }
+    }
+
+    ScenarioResult r = w->result;
+    r.liters = w->valveOutput.openMs(0) / 1000.0f * FLOW_LITERS_PER_SEC;
+    r.meanMoisture = moistureSum / totalSec;
+    r.bandError = errorSum / totalSec;
+    r.belowLowPct = 100.0f * belowLow / totalSec;
+    r.dropped = w->readings.dropped();
+    r.reconstructed = w->server.stats().reconstructed;
+    r.gaps = w->server.stats().gaps;
+    r.logAppends = w->log.stats().appends;
+    r.logErases = w->log.stats().erases;
+    r.wallSec = (double)(clock() - wallStart) / CLOCKS_PER_SEC;
+
+    world = nullptr;
+    delete w;
+    return r;
+}
+
+int runBenchmarks(int argc, char** argv); // bench.cpp
+int runWifiOutage(int argc, char** argv); // wifi_outage.cpp
+int runDutyCycleSim(int argc, char** argv); // duty_cycle.cpp
+int runLocalLink(int argc, char** argv); // local_link.cpp
+int runFleet(int argc, char** argv); // fleet.cpp
+int runTimeSync(int argc, char** argv); // time_sync.cpp
+int runOta(int argc, char** argv); // ota.cpp
+int runValveSafety(int argc, char** argv); // valve_safety.cpp
+int runSseLatency(int argc, char** argv); // sse.cpp
+int runScheduler(int argc, char** argv); // scheduler.cpp
+int runCloseJitter(int argc, char** argv); // close_jitter.cpp
+int runValveBank(int argc, char** argv); // valve_bank.cpp
+int runLogStore(int argc, char** argv); // log_store.cpp
+
+void printResult(const Scenario& scenario, const ScenarioResult& r, uint32_t days) {
+    printf("== %s ==\n", scenario.name);
+    printf("  Air          : %.1f L (%u penyiraman, %u dilewati, %u dihentikan awal)\n",
+           r.liters, r.runs, r.skipped, r.earlyStops);
+    printf("  Kelembapan   : rata-rata %.1f%%, error di luar %.0f-%.0f%% = %.2f, di bawah %.0f%% selama %.1f%% waktu\n",
+           r.meanMoisture, MOISTURE_CONFIG.targetLow, MOISTURE_CONFIG.targetHigh, r.bandError,
+           MOISTURE_CONFIG.targetLow, r.belowLowPct);
+    printf("  Telemetri    : %u sampel, %u record, %u upload (%u gagal), %u byte, buffer maks %zu, dibuang %u\n",
+           r.samples, r.records, r.uploads, r.uploadFailures, r.telemetryBytes, r.bufferPeak, r.dropped);
+    if (scenario.deadband) {
+        printf("  Deadband     : record x%.1f lebih sedikit, server merekonstruksi %u sampel (%u celah), "
+               "error maks T %.1f °C, H %.1f %%RH, soil %u %%\n",
+               r.records ? (float)r.samples / r.records : 0.0f, r.reconstructed, r.gaps,
+               r.maxErrTemp, r.maxErrHumid, r.maxErrSoil);
+    }
+    printf("  Log flash    : %u record, %u erase\n", r.logAppends, r.logErases);
+    printf("  Waktu nyata  : %.2f s untuk %u hari virtual (x%.0f)\n\n",
+           r.wallSec, days, r.wallSec > 0 ? days * 86400.0 / r.wallSec : 0.0);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) return runBenchmarks(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--wifi-outage") == 0) return runWifiOutage(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--duty-cycle") == 0) return runDutyCycleSim(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--local-link") == 0) return runLocalLink(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--fleet") == 0) return runFleet(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--time-sync") == 0) return runTimeSync(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--ota") == 0) return runOta(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--valve-safety") == 0) return runValveSafety(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--sse") == 0) return runSseLatency(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--scheduler") == 0) return runScheduler(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--close-jitter") == 0) return runCloseJitter(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--valve-bank") == 0) return runValveBank(argc, argv);
+    if (argc > 1 && strcmp(argv[1], "--log-store") == 0) return runLogStore(argc, argv);
+
+    uint32_t days = 7;
+    uint32_t seed = 42;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--days") == 0) days = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--seed") == 0) seed = (uint32_t)atoi(argv[i + 1]);
+    }
+
+    const Scenario scenarios[] = {
+        {"open-loop", false, false, false},
+        {"closed-loop", true, false, false},
+        {"server-putus", true, true, false},
+        {"deadband", true, false, true},
+    };
+
+    printf("Simulasi %u hari, seed %u\n\n", days, seed);
+    for (const Scenario& scenario : scenarios) {
+        printResult(scenario, runScenario(scenario, days, seed), days);
+    }
+    return 0;
+}
@@ -0,0 +1,827 @@
+/*
+ * SIMULASI OTA - Unduh image/patch dari server file lokal ke flash tiruan
+ *
+ * Memakai OtaClient & OtaTrial firmware (shared/Ota) di atas dua partisi app
+ * tiruan (RamFlashRegion, 0x140000 seperti partitions.csv) dan FileServer
+ * (HTTP sungguhan di loopback). step() dipanggil dengan jam virtual tiap
+ * OTA_STEP_INTERVAL_MS seperti networkTask, jadi jeda ulang & timeout
+ * OtaClient berjalan tanpa menunggu waktu nyata.
+ *
+ * Dilaporkan:
+ *   - ukuran image vs patch untuk beberapa jenis perubahan, perkiraan waktu
+ *     unduh di WiFi lemah (WEAK_WIFI_BPS), request, erase sektor, RAM sesi
+ *   - kegagalan: koneksi putus, image rusak, patch untuk versi lain, server
+ *     tanpa Range, listrik mati saat menulis (partisi boot tidak berubah)
+ *   - OtaClient: cek manifest, batas OTA_MAX_RESUMES, jeda sebelum request
+ *     ulang, timeout koneksi diam, 5xx diulang / 4xx langsung gagal
+ *   - boot trial: image sehat, crash loop, health check gagal (rollback)
+ *   - rollout bertahap: persen node yang ikut dari 1000 ID
+ * Kode keluar 1 jika ada skenario atau pemeriksaan yang tidak sesuai.
+ *
+ * Pemakaian: .pio/build/native/program --ota [--seed N]
+ *           .pio/build/native/program --ota --make-delta lama.bin baru.bin keluar.pd
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "SimHardware.h"
+#include "FileServer.h"
+#include "OtaDeltaEncoder.h"
+#include <LogStore.h>
+#include <NodeId.h>
+#include <OtaClient.h>
+
+// ==================== KONSTANTA (sama dengan firmware) ====================
+const size_t APP_PARTITION_SIZE = 0x140000;     // app0/app1 di partitions.csv
+const size_t FLASH_SECTOR = 4096;
+const unsigned long OTA_STEP_INTERVAL_MS = 20;  // Job stepFirmwareUpdate
+const uint8_t OTA_TRIAL_MAX_BOOTS = 3;
+const unsigned long OTA_HEALTH_TIMEOUT_MS = 600000UL;
+const unsigned long OTA_HEALTH_CHECK_MS = 10000UL;
+
+// Simulasi
+const size_t IMAGE_SIZE = 1150000;              // Image Arduino + WiFi + HTTP tipikal
+const double WEAK_WIFI_BPS = 25000;             // Throughput TCP di RSSI ~-80 dBm
+const double REQUEST_RTT_S = 0.3;               // Handshake + request per koneksi
+const unsigned long BOOT_MS = 1500;             // Boot sampai setup() selesai
+const unsigned long HEALTHY_AFTER_MS = 6000;    // WiFi + request API pertama
+const unsigned long CRASH_AFTER_MS = 4000;
+
+typedef std::chrono::steady_clock SteadyClock;
+
+// ==================== FLASH & PERANGKAT TIRUAN ====================
+
+// Dua partisi app; partisi boot berubah hanya lewat OtaTarget::end()
+struct SimDevice {
+    std::vector<uint8_t> memory[2];
+    std::vector<uint32_t> erases[2];
+    RamFlashRegion* slot[2];
+    int running = 0;
+    int boot = 0;
+    OtaTrialRecord trial = {};
+
+    SimDevice() {
+        for (int i = 0; i < 2; i++) {
+            memory[i].resize(APP_PARTITION_SIZE);
+            erases[i].resize(APP_PARTITION_SIZE / FLASH_SECTOR);
+            slot[i] = new RamFlashRegion(memory[i].data(), APP_PARTITION_SIZE, erases[i].data(), FLASH_SECTOR);
+        }
+    }
+    ~SimDevice() {
+        for (int i = 0; i < 2; i++) delete slot[i];
+    }
+
+    void flash(int index, const std::vector<uint8_t>& image) {
+        for (size_t s = 0; s < APP_PARTITION_SIZE; s += FLASH_SECTOR) slot[index]->erase(s);
+        slot[index]->write(0, image.data(), image.size());
+        std::fill(erases[index].begin(), erases[index].end(), 0);
+        running = boot = index;
+    }
+
+    uint32_t erasesIn(int index) const {
+        uint32_t total = 0;
+        for (uint32_t e : erases[index]) total += e;
+        return total;
+    }
+
+    bool holds(int index, const std::vector<uint8_t>& image) const {
+        return memcmp(memory[index].data(), image.data(), image.size()) == 0;
+    }
+};
+
+// esp_ota_begin/write/end di atas partisi tiruan: erase per sektor saat ditulis
+class SimOtaTarget : public OtaTarget {
+public:
+    explicit SimOtaTarget(SimDevice& device) : _device(device) {}
+
+    bool begin(uint32_t size) override {
+        _slot = 1 - _device.running;
+        _offset = 0;
+        return size <= APP_PARTITION_SIZE;
+    }
+
+    bool write(const uint8_t* data, size_t length) override {
+        RamFlashRegion& region = *_device.slot[_slot];
+        for (size_t s = (_offset + FLASH_SECTOR - 1) / FLASH_SECTOR * FLASH_SECTOR; s < _offset + length;
+             s += FLASH_SECTOR) {
+            if (!region.erase(s)) return false;
+        }
+        if (!region.write(_offset, data, length)) return false;
+        _offset += length;
+        return true;
+    }
+
+    // esp_ota_end() memeriksa magic header image (0xE9)
+    bool end() override {
+        uint8_t magic;
+        if (!_device.slot[_slot]->read(0, &magic, 1) || magic != 0xE9) return false;
+        _device.boot = _slot;
+        return true;
+    }
+
+    void abort() override {}
+
+private:
+    SimDevice& _device;
+    int _slot = 1;
+    size_t _offset = 0;
+};
+
+class SimRunningSource : public OtaSource {
+public:
+    explicit SimRunningSource(SimDevice& device) : _device(device) {}
+    uint32_t size() const override { return APP_PARTITION_SIZE; }
+    bool read(uint32_t offset, void* dst, size_t length) override {
+        return _device.slot[_device.running]->read(offset, dst, length);
+    }
+
+private:
+    SimDevice& _device;
+};
+
+// ==================== IMAGE TIRUAN ====================
+
+static std::vector<uint8_t> makeImage(Prng& prng, size_t size) {
+    std::vector<uint8_t> image(size);
+    for (uint8_t& b : image) b = (uint8_t)prng.next();
+    image[0] = 0xE9;
+    return image;
+}
+
+static void randomize(std::vector<uint8_t>& image, Prng& prng, size_t at, size_t length) {
+    for (size_t i = at; i < at + length && i < image.size(); i++) image[i] = (uint8_t)prng.next();
+}
+
+// Rilis baru dari image lama: fungsi yang diubah, kode baru yang menggeser
+// sisa image, dan alamat (4 byte) yang ikut berubah karena pergeseran itu
+static std::vector<uint8_t> makeRelease(const std::vector<uint8_t>& base, Prng& prng, size_t changedBytes,
+                                        size_t insertedBytes, size_t pointers) {
+    std::vector<uint8_t> image = base;
+    randomize(image, prng, 0x20, 32); // String versi & waktu build
+    for (size_t done = 0; done < changedBytes;) {
+        size_t length = std::min<size_t>(1500, changedBytes - done);
+        randomize(image, prng, 0x100 + prng.next() % (image.size() - 0x200 - length), length);
+        done += length;
+    }
+    size_t insertAt = image.size() / 2;
+    std::vector<uint8_t> inserted(insertedBytes);
+    for (uint8_t& b : inserted) b = (uint8_t)prng.next();
+    image.insert(image.begin() + insertAt, inserted.begin(), inserted.end());
+    for (size_t i = 0; i < pointers; i++) randomize(image, prng, 0x100 + prng.next() % (image.size() - 0x104), 4);
+    return image;
+}
+
+static OtaManifest makeManifest(const char* version, const std::vector<uint8_t>& image, const char* path,
+                                const std::vector<uint8_t>* delta, const char* deltaPath) {
+    OtaManifest m = {};
+    snprintf(m.version, sizeof(m.version), "%s", version);
+    snprintf(m.path, sizeof(m.path), "%s", path);
+    m.size = (uint32_t)image.size();
+    Sha256 sha;
+    sha.update(image.data(), image.size());
+    sha.finish(m.sha256);
+    if (delta) {
+        m.deltaSize = (uint32_t)delta->size();
+        snprintf(m.deltaPath, sizeof(m.deltaPath), "%s", deltaPath);
+    }
+    m.rollout = 100;
+    return m;
+}
+
+// ==================== PENGUNDUH (OtaClient firmware) ====================
+
+// Jam virtual OtaClient; step() dipanggil tiap OTA_STEP_INTERVAL_MS seperti networkTask
+static VirtualClock otaClock(0);
+static unsigned long otaMillis() { return otaClock.millis(); }
+
+static int openConnection(uint16_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    timeval timeout = {5, 0}; // HttpTransport::TIMEOUT_MS
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// OtaTransport di atas socket loopback ke FileServer (satu request per koneksi).
+// available()/read() tidak menunggu, seperti HttpTransport di firmware.
+class LoopbackTransport : public OtaTransport {
+public:
+    explicit LoopbackTransport(uint16_t port) : _port(port) {}
+    ~LoopbackTransport() { reset(); }
+
+    void setRange(uint32_t from) override { _range = from; }
+
+    int get(const char* path) override {
+        reset();
+        requests++;
+        uint32_t from = _range;
+        _range = 0;
+        if ((_fd = openConnection(_port)) < 0) return -1;
+        char request[256];
+        int n = from ? snprintf(request, sizeof(request),
+                                "GET %s HTTP/1.1\r\nHost: prokon\r\nRange: bytes=%u-\r\n\r\n", path, from)
+                     : snprintf(request, sizeof(request), "GET %s HTTP/1.1\r\nHost: prokon\r\n\r\n", path);
+        if (send(_fd, request, (size_t)n, MSG_NOSIGNAL) != n) return fail();
+        char chunk[1024];
+        size_t end;
+        while ((end = _pending.find("\r\n\r\n")) == std::string::npos) {
+            ssize_t got = recv(_fd, chunk, sizeof(chunk), 0);
+            if (got <= 0) return fail();
+            _pending.append(chunk, (size_t)got);
+        }
+        int code = atoi(_pending.c_str() + 9);
+        _pending.erase(0, end + 4);
+        return code;
+    }
+
+    // Server menutup koneksi setelah body (Connection: close)
+    const char* readBody(size_t& length) override {
+        char chunk[1024];
+        ssize_t got;
+        while (_fd >= 0 && (got = recv(_fd, chunk, sizeof(chunk), 0)) > 0) _pending.append(chunk, (size_t)got);
+        length = _pending.size() - _offset;
+        return _pending.c_str() + _offset;
+    }
+
+    int available() override {
+        if (_offset < _pending.size()) return (int)(_pending.size() - _offset);
+        if (_fd < 0 || _closed) return 0;
+        int n = 0;
+        ioctl(_fd, FIONREAD, &n);
+        char c;
+        if (n == 0 && recv(_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT) == 0) _closed = true;
+        return n;
+    }
+
+    size_t read(uint8_t* dst, size_t length) override {
+        if (_offset < _pending.size()) {
+            size_t n = std::min(length, _pending.size() - _offset);
+            memcpy(dst, _pending.data() + _offset, n);
+            _offset += n;
+            return n;
+        }
+        ssize_t got = _fd < 0 ? -1 : recv(_fd, dst, length, MSG_DONTWAIT);
+        return got > 0 ? (size_t)got : 0;
+    }
+
+    bool connected() override { return _fd >= 0 && (!_closed || _offset < _pending.size()); }
+    void end() override { reset(); }
+
+    void reset() override {
+        if (_fd >= 0) close(_fd);
+        _fd = -1;
+        _closed = false;
+        _pending.clear();
+        _offset = 0;
+    }
+
+    // Tunggu (waktu nyata) sampai socket punya data atau ditutup server
+    void wait(int ms) {
+        if (_fd < 0 || _closed || _offset < _pending.size()) return;
+        pollfd p = {_fd, POLLIN, 0};
+        poll(&p, 1, ms);
+    }
+
+    uint32_t requests = 0;
+
+private:
+    int fail() {
+        reset();
+        return -1;
+    }
+
+    uint16_t _port;
+    uint32_t _range = 0;
+    int _fd = -1;
+    bool _closed = false;
+    std::string _pending;   // Body yang ikut terbaca bersama header
+    size_t _offset = 0;
+};
+
+// OtaTransport di memori untuk pemeriksaan batas (waktu virtual saja):
+// koneksi putus setiap dropEvery byte, diam sekali di stallAt dengan koneksi
+// tetap terbuka, dan kode HTTP pilihan untuk request pertama
+class ScriptedTransport : public OtaTransport {
+public:
+    struct Request {
+        unsigned long at;
+        uint32_t from;
+        int code;
+    };
+
+    explicit ScriptedTransport(const std::vector<uint8_t>& body) : _body(body) {}
+
+    void setRange(uint32_t from) override { _range = from; }
+
+    int get(const char*) override {
+        int code = _range ? 206 : 200;
+        if (!codes.empty()) {
+            code = codes.front();
+            codes.erase(codes.begin());
+        }
+        requests.push_back({otaClock.millis(), _range, code});
+        _open = code == 200 || code == 206;
+        _pos = _connFrom = code == 206 ? _range : 0;
+        _range = 0;
+        return code;
+    }
+
+    const char* readBody(size_t&) override { return nullptr; }
+
+    int available() override {
+        if (!_open) return 0;
+        size_t end = _body.size();
+        if (dropEvery) end = std::min<size_t>(end, _connFrom + dropEvery);
+        if (stallAt && !_stalled) end = std::min<size_t>(end, std::max<size_t>(stallAt, _pos));
+        return (int)std::min<size_t>(end - _pos, 4096);
+    }
+
+    size_t read(uint8_t* dst, size_t length) override {
+        length = std::min<size_t>(length, (size_t)available());
+        memcpy(dst, _body.data() + _pos, length);
+        _pos += length;
+        if (stallAt && _pos == stallAt) stalledAt = otaClock.millis();
+        return length;
+    }
+
+    bool connected() override { return _open && !(dropEvery && _pos >= _connFrom + dropEvery); }
+    void end() override { _open = false; }
+
+    void reset() override {
+        if (_open) resets.push_back(otaClock.millis());
+        if (stallAt && _pos >= stallAt) _stalled = true;
+        _open = false;
+    }
+
+    std::vector<int> codes;
+    uint32_t dropEvery = 0;
+    uint32_t stallAt = 0;
+    std::vector<Request> requests;
+    std::vector<unsigned long> resets;  // Koneksi yang ditutup paksa OtaClient
+    unsigned long stalledAt = 0;        // Byte terakhir sebelum diam
+
+private:
+    const std::vector<uint8_t>& _body;
+    uint32_t _range = 0;
+    bool _open = false;
+    bool _stalled = false;
+    size_t _pos = 0;
+    size_t _connFrom = 0;
+};
+
+// step() sampai DONE/FAILED; socket != nullptr: beri server waktu mengirim
+static OtaClient::Status runSteps(OtaClient& ota, LoopbackTransport* socket) {
+    unsigned long limit = otaClock.millis() + 3600000UL;
+    OtaClient::Status status;
+    while ((status = ota.step()) == OtaClient::RUNNING && otaClock.millis() < limit) {
+        if (socket) socket->wait(100);
+        otaClock.advance(OTA_STEP_INTERVAL_MS);
+    }
+    return status;
+}
+
+struct DownloadResult {
+    bool ok;
+    const char* error;
+    uint32_t requests;
+    uint32_t resumes;
+    uint64_t bytes;             // Payload diterima, termasuk yang diulang
+    uint32_t erases;
+    double wallMs;
+};
+
+static DownloadResult download(SimDevice& device, uint16_t port, const OtaManifest& manifest) {
+    DownloadResult r = {};
+    SimOtaTarget target(device);
+    SimRunningSource source(device);
+    LoopbackTransport transport(port);
+    OtaClient ota(transport, target, source, otaMillis);
+    int slot = 1 - device.running;
+    uint32_t erasesBefore = device.erasesIn(slot);
+    SteadyClock::time_point start = SteadyClock::now();
+
+    r.ok = ota.start(manifest) && runSteps(ota, &transport) == OtaClient::DONE;
+    r.error = ota.lastError();
+    r.requests = transport.requests;
+    r.resumes = ota.stats().resumes;
+    r.bytes = ota.stats().bytes;
+    r.erases = device.erasesIn(slot) - erasesBefore;
+    r.wallMs = std::chrono::duration<double, std::milli>(SteadyClock::now() - start).count();
+    return r;
+}
+
+// ==================== PEMERIKSAAN OTACLIENT ====================
+
+static int failures = 0;
+
+static void check(bool condition, const char* what) {
+    printf("  %-6s %s\n", condition ? "ok" : "GAGAL", what);
+    if (!condition) failures++;
+}
+
+static std::string manifestJson(const OtaManifest& m) {
+    char sha[SHA256_SIZE * 2 + 1];
+    for (size_t i = 0; i < SHA256_SIZE; i++) snprintf(sha + i * 2, 3, "%02x", m.sha256[i]);
+    char json[512];
+    snprintf(json, sizeof(json), "{\"version\":\"%s\",\"url\":\"%s\",\"size\":%u,\"sha256\":\"%s\",\"rollout\":%u}",
+             m.version, m.path, m.size, sha, m.rollout);
+    return json;
+}
+
+// Satu unduhan lewat ScriptedTransport dari image v100 ke `image`
+struct ScriptedRun {
+    OtaClient::Status status;
+    OtaClient::Stats stats;
+    const char* error;
+    bool bootChanged;
+};
+
+static ScriptedRun runScripted(ScriptedTransport& transport, const std::vector<uint8_t>& base,
+                               const std::vector<uint8_t>& image) {
+    SimDevice device;
+    device.flash(0, base);
+    SimOtaTarget target(device);
+    SimRunningSource source(device);
+    OtaClient ota(transport, target, source, otaMillis);
+    OtaManifest m = makeManifest("1.1.0", image, "/firmware/prokon-1.1.0.bin", nullptr, "");
+    ScriptedRun r = {};
+    if (ota.start(m)) runSteps(ota, nullptr);
+    r.status = ota.status();
+    r.stats = ota.stats();
+    r.error = ota.lastError();
+    r.bootChanged = device.boot != 0;
+    return r;
+}
+
+// check() lewat HTTP loopback: manifest dari server yang sama dengan image
+static void checkManifest(FileServer& server, const std::vector<uint8_t>& image) {
+    SimDevice device;
+    device.flash(0, image);
+    SimOtaTarget target(device);
+    SimRunningSource source(device);
+    LoopbackTransport transport(server.port());
+    OtaClient ota(transport, target, source, otaMillis);
+    ota.setNodeId("prokon-a4cf12000001");
+    OtaManifest offered = makeManifest("1.1.0", image, "/firmware/prokon-1.1.0.bin", nullptr, "");
+    server.put("/api/firmware/prokon", manifestJson(offered));
+
+    OtaManifest m;
+    bool update = ota.check("/api/firmware/prokon", "1.0.0", m) == OtaClient::UPDATE;
+    check(update && strcmp(m.path, offered.path) == 0 && m.size == offered.size &&
+              memcmp(m.sha256, offered.sha256, SHA256_SIZE) == 0,
+          "check(): manifest terbaca, versi lain = UPDATE");
+    check(ota.check("/api/firmware/prokon", "1.1.0", m) == OtaClient::NO_UPDATE &&
+              ota.check("/api/firmware/tidak-ada", "1.0.0", m) == OtaClient::NO_UPDATE,
+          "check(): versi sama / 404 = NO_UPDATE");
+}
+
+// Koneksi putus berulang: tepat OTA_MAX_RESUMES kali masih selesai, sekali
+// lagi = gagal; setiap request ulang menunggu OTA_IDLE_TIMEOUT_MS dan
+// melanjutkan dari byte terakhir
+static void checkResumes(const std::vector<uint8_t>& base, const std::vector<uint8_t>& image) {
+    uint32_t size = (uint32_t)image.size();
+    ScriptedTransport atLimit(image);
+    atLimit.dropEvery = (size + OTA_MAX_RESUMES) / (OTA_MAX_RESUMES + 1);
+    ScriptedRun ok = runScripted(atLimit, base, image);
+
+    bool spaced = atLimit.requests.size() == atLimit.resets.size() + 1;
+    for (size_t i = 1; spaced && i < atLimit.requests.size(); i++) {
+        spaced = atLimit.requests[i].at - atLimit.resets[i - 1] >= OTA_IDLE_TIMEOUT_MS &&
+                 atLimit.requests[i].from == i * atLimit.dropEvery;
+    }
+    printf("  putus tiap %u byte: %zu request, %u ulang, %s\n", atLimit.dropEvery, atLimit.requests.size(),
+           ok.stats.resumes, ok.status == OtaClient::DONE ? "selesai" : ok.error);
+    check(ok.status == OtaClient::DONE && ok.stats.resumes == OTA_MAX_RESUMES && ok.bootChanged,
+          "putus OTA_MAX_RESUMES kali: unduhan selesai");
+    check(spaced, "request ulang setelah OTA_IDLE_TIMEOUT_MS, Range dari byte terakhir");
+
+    ScriptedTransport overLimit(image);
+    overLimit.dropEvery = (size + OTA_MAX_RESUMES + 1) / (OTA_MAX_RESUMES + 2);
+    ScriptedRun failed = runScripted(overLimit, base, image);
+    printf("  putus tiap %u byte: %zu request, %u ulang, %s\n", overLimit.dropEvery, overLimit.requests.size(),
+           failed.stats.resumes, failed.status == OtaClient::DONE ? "selesai" : failed.error);
+    check(failed.status == OtaClient::FAILED && strcmp(failed.error, "transport") == 0 &&
+              failed.stats.resumes == OTA_MAX_RESUMES + 1 && overLimit.requests.size() == OTA_MAX_RESUMES + 1 &&
+              failed.stats.failures == 1 && !failed.bootChanged,
+          "putus OTA_MAX_RESUMES + 1 kali: gagal (transport), partisi boot tetap");
+}
+
+// Server berhenti mengirim tanpa menutup koneksi
+static void checkIdleTimeout(const std::vector<uint8_t>& base, const std::vector<uint8_t>& image) {
+    ScriptedTransport stall(image);
+    stall.stallAt = (uint32_t)(image.size() * 4 / 10);
+    ScriptedRun r = runScripted(stall, base, image);
+    unsigned long idle = stall.resets.empty() ? 0 : stall.resets[0] - stall.stalledAt;
+    printf("  diam di byte %u: koneksi ditutup setelah %lu ms, %zu request\n", stall.stallAt, idle,
+           stall.requests.size());
+    check(idle > OTA_IDLE_TIMEOUT_MS && idle <= OTA_IDLE_TIMEOUT_MS + OTA_STEP_INTERVAL_MS,
+          "koneksi diam ditutup tepat setelah OTA_IDLE_TIMEOUT_MS");
+    check(r.status == OtaClient::DONE && r.stats.resumes == 1 && stall.requests.size() == 2 &&
+              stall.requests[1].from == stall.stallAt,
+          "lanjut dengan Range dari byte terakhir, unduhan selesai");
+}
+
+// 5xx = diulang (dihitung sebagai resume), 4xx = gagal tanpa mengulang
+static void checkHttpErrors(const std::vector<uint8_t>& base, const std::vector<uint8_t>& image) {
+    ScriptedTransport busy(image);
+    busy.codes = {503, 503, -1};
+    ScriptedRun retried = runScripted(busy, base, image);
+    check(retried.status == OtaClient::DONE && retried.stats.resumes == 3 && busy.requests.size() == 4,
+          "503 / error transport: diulang, dihitung ke batas ulang");
+
+    ScriptedTransport missing(image);
+    missing.codes = {404};
+    ScriptedRun failed = runScripted(missing, base, image);
+    check(failed.status == OtaClient::FAILED && failed.stats.resumes == 0 && missing.requests.size() == 1 &&
+              !failed.bootChanged,
+          "404: langsung gagal tanpa request ulang");
+}
+
+// ==================== BOOT TRIAL ====================
+
+enum TrialBehavior { TRIAL_HEALTHY, TRIAL_CRASH, TRIAL_NO_SERVER };
+
+struct TrialResult {
+    bool confirmed;
+    int finalSlot;
+    uint32_t boots;
+    unsigned long elapsedMs;    // Sejak restart ke image baru sampai keputusan
+};
+
+// Restart ke image baru (partisi boot) lalu jalankan setup() berulang
+static TrialResult runTrial(SimDevice& device, TrialBehavior behavior) {
+    OtaTrial trial(OTA_TRIAL_MAX_BOOTS, OTA_HEALTH_TIMEOUT_MS);
+    OtaTrial::arm(device.trial, (uint32_t)device.running);
+    TrialResult r = {false, 0, 0, 0};
+    for (;;) {
+        device.running = device.boot;
+        r.boots++;
+        r.elapsedMs += BOOT_MS;
+        OtaTrial::Action action = trial.boot(device.trial);
+        if (action == OtaTrial::NORMAL) break;
+        if (action == OtaTrial::ROLLBACK) {
+            OtaTrial::finish(device.trial);
+            device.boot = (int)device.trial.previous;
+            device.running = device.boot;
+            break;
+        }
+        if (behavior == TRIAL_CRASH) {
+            r.elapsedMs += CRASH_AFTER_MS; // Panic -> reset, partisi boot tetap image baru
+            continue;
+        }
+        // Health check tiap OTA_HEALTH_CHECK_MS sejak boot
+        unsigned long sinceBoot = 0;
+        OtaTrial::Verdict verdict = OtaTrial::WAIT;
+        while (verdict == OtaTrial::WAIT) {
+            sinceBoot += OTA_HEALTH_CHECK_MS;
+            verdict = trial.check(behavior == TRIAL_HEALTHY && sinceBoot >= HEALTHY_AFTER_MS, sinceBoot);
+        }
+        r.elapsedMs += sinceBoot;
+        OtaTrial::finish(device.trial);
+        if (verdict == OtaTrial::CONFIRM) {
+            r.confirmed = true;
+        } else {
+            device.boot = (int)device.trial.previous;
+            device.running = device.boot;
+            r.boots++;
+            r.elapsedMs += BOOT_MS;
+        }
+        break;
+    }
+    r.finalSlot = device.running;
+    return r;
+}
+
+// ==================== LAPORAN ====================
+
+static double weakWifiSeconds(uint64_t bytes, uint32_t requests) {
+    return bytes / WEAK_WIFI_BPS + requests * REQUEST_RTT_S;
+}
+
+static void printDownload(const char* name, const DownloadResult& r, bool booted) {
+    printf("  %-28s %-5s %9llu %4u %4u %6u %7.1f s %8.1f ms  %s\n", name, r.ok ? "ok" : "gagal",
+           (unsigned long long)r.bytes, r.requests, r.resumes, r.erases, weakWifiSeconds(r.bytes, r.requests),
+           r.wallMs, r.ok ? (booted ? "boot -> image baru" : "-") : r.error);
+}
+
+static int makeDeltaFile(const char* basePath, const char* targetPath, const char* outPath) {
+    auto readFile = [](const char* path, std::vector<uint8_t>& out) {
+        FILE* f = fopen(path, "rb");
+        if (!f) return false;
+        uint8_t buf[65536];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+        fclose(f);
+        return true;
+    };
+    std::vector<uint8_t> base, target;
+    if (!readFile(basePath, base) || !readFile(targetPath, target)) {
+        fprintf(stderr, "Tidak bisa membaca %s / %s\n", basePath, targetPath);
+        return 1;
+    }
+    std::vector<uint8_t> patch = otaMakeDelta(base, target);
+    FILE* f = fopen(outPath, "wb");
+    if (!f || fwrite(patch.data(), 1, patch.size(), f) != patch.size()) {
+        fprintf(stderr, "Tidak bisa menulis %s\n", outPath);
+        if (f) fclose(f);
+        return 1;
+    }
+    fclose(f);
+    Sha256 sha;
+    sha.update(target.data(), target.size());
+    uint8_t digest[SHA256_SIZE];
+    sha.finish(digest);
+    printf("%s: %zu byte (image %zu byte, %.1f%%), sha256 image ", outPath, patch.size(), target.size(),
+           100.0 * patch.size() / target.size());
+    for (uint8_t b : digest) printf("%02x", b);
+    printf("\n");
+    return 0;
+}
+
+int runOta(int argc, char** argv) {
+    uint32_t seed = 1;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--make-delta") == 0 && i + 3 < argc) {
+            return makeDeltaFile(argv[i + 1], argv[i + 2], argv[i + 3]);
+        }
+    }
+
+    Prng prng(seed * 2654435761u);
+    std::vector<uint8_t> v100 = makeImage(prng, IMAGE_SIZE);
+    std::vector<uint8_t> v090 = makeRelease(v100, prng, 20000, 4000, 300);
+    struct Release {
+        const char* name;
+        const char* version;
+        size_t changed, inserted, pointers;
+        std::vector<uint8_t> image, delta;
+    } releases[] = {
+        {"perbaikan kecil", "1.0.1", 1500, 0, 60, {}, {}},
+        {"fitur baru", "1.1.0", 6000, 12000, 400, {}, {}},
+        {"rilis besar", "2.0.0", 250000, 60000, 4000, {}, {}},
+    };
+
+    FileServer server;
+    std::vector<uint8_t> corrupt;
+    for (Release& rel : releases) {
+        rel.image = makeRelease(v100, prng, rel.changed, rel.inserted, rel.pointers);
+        rel.delta = otaMakeDelta(v100, rel.image);
+        server.put(std::string("/firmware/prokon-") + rel.version + ".bin", rel.image);
+        server.put(std::string("/firmware/prokon-1.0.0-") + rel.version + ".pd", rel.delta);
+    }
+    const Release& update = releases[1];
+    corrupt = update.image;
+    corrupt[corrupt.size() / 3] ^= 0x01;
+    server.put("/firmware/rusak.bin", corrupt);
+    server.put("/firmware/prokon-0.9.0-1.1.0.pd", otaMakeDelta(v090, update.image));
+    server.put("/firmware/putus.pd", update.delta);
+    server.put("/firmware/putus.bin", update.image);
+    server.dropAt("/firmware/putus.pd", {(uint32_t)(update.delta.size() * 3 / 10), (uint32_t)(update.delta.size() * 6 / 10),
+                                         (uint32_t)(update.delta.size() * 9 / 10)});
+    server.dropAt("/firmware/putus.bin", {200000, 500000, 800000, 1100000});
+    if (!server.start()) {
+        fprintf(stderr, "FileServer gagal start\n");
+        return 1;
+    }
+
+    printf("OTA, image %zu byte, partisi app 0x%zx, WiFi lemah %.0f KB/s + %.1f s per request, seed %u\n\n",
+           IMAGE_SIZE, APP_PARTITION_SIZE, WEAK_WIFI_BPS / 1000, REQUEST_RTT_S, seed);
+
+    printf("== Ukuran patch delta (dari 1.0.0) ==\n");
+    printf("  %-16s %-6s %10s %10s %7s %10s %10s\n", "perubahan", "versi", "image", "patch", "rasio", "penuh",
+           "delta");
+    for (const Release& rel : releases) {
+        printf("  %-16s %-6s %10zu %10zu %6.1f%% %8.1f s %8.1f s\n", rel.name, rel.version, rel.image.size(),
+               rel.delta.size(), 100.0 * rel.delta.size() / rel.image.size(), weakWifiSeconds(rel.image.size(), 1),
+               weakWifiSeconds(rel.delta.size(), 1));
+    }
+
+    printf("\n== Unduh & tulis (%s -> %s) ==\n", "1.0.0", update.version);
+    printf("  %-28s %-5s %9s %4s %4s %6s %9s %11s  %s\n", "skenario", "hasil", "byte", "req", "ulang", "erase",
+           "WiFi lemah", "host", "partisi boot");
+    struct Case {
+        const char* name;
+        const char* path;
+        const char* deltaPath;
+        const std::vector<uint8_t>* delta;
+        bool ignoreRange;
+    } cases[] = {
+        {"image penuh", "/firmware/prokon-1.1.0.bin", "", nullptr, false},
+        {"patch delta", "/firmware/prokon-1.1.0.bin", "/firmware/prokon-1.0.0-1.1.0.pd", &update.delta, false},
+        {"patch, putus 3x (Range)", "/firmware/prokon-1.1.0.bin", "/firmware/putus.pd", &update.delta, false},
+        {"penuh, putus 4x (Range)", "/firmware/putus.bin", "", nullptr, false},
+        {"penuh, server tanpa Range", "/firmware/putus.bin", "", nullptr, true},
+        {"image rusak (1 bit)", "/firmware/rusak.bin", "", nullptr, false},
+        {"patch dari versi lain", "/firmware/prokon-1.1.0.bin", "/firmware/prokon-0.9.0-1.1.0.pd", &update.delta, false},
+    };
+    bool allExpected = true;
+    for (const Case& c : cases) {
+        if (c.ignoreRange) server.dropAt("/firmware/putus.bin", {300000, 700000});
+        server.ignoreRange(c.ignoreRange);
+        SimDevice device;
+        device.flash(0, v100);
+        OtaManifest m = makeManifest(update.version, update.image, c.path, c.delta, c.deltaPath);
+        DownloadResult r = download(device, server.port(), m);
+        bool booted = device.boot != device.running && device.holds(device.boot, update.image);
+        bool oldIntact = device.holds(device.running, v100);
+        printDownload(c.name, r, booted);
+        bool expectOk = strstr(c.name, "rusak") == nullptr && strstr(c.name, "versi lain") == nullptr;
+        if (r.ok != expectOk || r.ok != booted || !oldIntact) allExpected = false;
+    }
+    server.ignoreRange(false);
+
+    // Listrik mati di tengah penulisan: partisi boot tetap image lama
+    {
+        SimDevice device;
+        device.flash(0, v100);
+        SimOtaTarget target(device);
+        SimRunningSource source(device);
+        OtaSession session(target, source);
+        OtaManifest m = makeManifest(update.version, update.image, "", nullptr, "");
+        session.begin(m, false);
+        session.feed(update.image.data(), update.image.size() / 2);
+        bool safe = device.boot == 0 && device.holds(0, v100);
+        printf("  %-28s %-5s %9zu %4s %4s %6u %9s %11s  %s\n", "listrik mati di 50%", safe ? "aman" : "RUSAK",
+               update.image.size() / 2, "-", "-", device.erasesIn(1), "-", "-", "tetap image lama");
+        if (!safe) allExpected = false;
+    }
+    printf("  RAM unduhan: OtaClient %zu byte, termasuk OtaSession & buffer 1 KB (image tidak disangga di RAM)\n",
+           sizeof(OtaClient));
+
+    printf("\n== OtaClient: cek manifest, ulang & timeout (maks. %u ulang, timeout %u ms) ==\n", OTA_MAX_RESUMES,
+           OTA_IDLE_TIMEOUT_MS);
+    checkManifest(server, update.image);
+    checkResumes(v100, update.image);
+    checkIdleTimeout(v100, update.image);
+    checkHttpErrors(v100, update.image);
+
+    printf("\n== Boot trial (maks. %u boot, health check %lu menit) ==\n", OTA_TRIAL_MAX_BOOTS,
+           OTA_HEALTH_TIMEOUT_MS / 60000);
+    struct TrialCase {
+        const char* name;
+        TrialBehavior behavior;
+    } trials[] = {
+        {"image sehat", TRIAL_HEALTHY},
+        {"crash loop", TRIAL_CRASH},
+        {"server tak terjangkau", TRIAL_NO_SERVER},
+    };
+    for (const TrialCase& t : trials) {
+        SimDevice device;
+        device.flash(0, v100);
+        OtaManifest m = makeManifest(update.version, update.image, "/firmware/prokon-1.1.0.bin", nullptr, "");
+        download(device, server.port(), m);
+        TrialResult r = runTrial(device, t.behavior);
+        printf("  %-24s %-12s %u boot, %6.1f s sampai keputusan, berjalan: %s\n", t.name,
+               r.confirmed ? "dikonfirmasi" : "rollback", r.boots, r.elapsedMs / 1000.0,
+               device.holds(r.finalSlot, update.image) ? "1.1.0" : (device.holds(r.finalSlot, v100) ? "1.0.0" : "?"));
+        bool expect = t.behavior == TRIAL_HEALTHY;
+        if (r.confirmed != expect || !device.holds(r.finalSlot, expect ? update.image : v100)) allExpected = false;
+    }
+
+    printf("\n== Rollout bertahap (1000 node, versi %s) ==\n", update.version);
+    const uint8_t percents[] = {5, 25, 50, 100};
+    std::vector<bool> previous(1000, false);
+    bool monotonic = true;
+    for (uint8_t percent : percents) {
+        uint32_t in = 0;
+        for (uint32_t i = 0; i < 1000; i++) {
+            uint8_t mac[NODE_MAC_SIZE] = {0xa4, 0xcf, 0x12, (uint8_t)(i >> 16), (uint8_t)(i >> 8), (uint8_t)i};
+            char id[NODE_ID_SIZE];
+            nodeIdFromMac(mac, id);
+            bool selected = otaInRollout(id, update.version, percent);
+            if (previous[i] && !selected) monotonic = false;
+            previous[i] = selected;
+            in += selected;
+        }
+        printf("  rollout %3u%% -> %4u node (%.1f%%)\n", percent, in, in / 10.0);
+    }
+    printf("  node yang sudah ikut tetap ikut saat persen dinaikkan: %s\n", monotonic ? "ya" : "TIDAK");
+
+    FileServerStats s = server.stats();
+    printf("\nServer: %u request (%u dengan Range), %u koneksi diputus, %llu byte\n", s.requests, s.ranged, s.drops,
+           (unsigned long long)s.bytesOut);
+    server.stop();
+    bool passed = allExpected && monotonic && failures == 0;
+    printf("Semua skenario sesuai harapan: %s\n", passed ? "ya" : "TIDAK");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,361 @@
+/*
+ * SIMULASI SCHEDULER - Uji jam tiruan & perbandingan loop dengan MinimalTimer
+ *
+ * Bagian 1: Scheduler.h dijalankan dengan jam tiruan (millis() diganti
+ * variabel) dan diperiksa: urutan deadline, nilai kembalian run(), job
+ * sekali jalan, cancel dari callback, handle lama setelah slot dipakai
+ * ulang, tanpa drift saat run() dipanggil tidak teratur, tanpa burst
+ * setelah loop macet, overflow millis() dan kapasitas penuh.
+ *
+ * Bagian 2: job set firmware lama (checkSchedule 1 s, checkRemoteStatus 5 s,
+ * syncSchedulesFromAPI 1 menit, syncRTCFromNTP 15 menit) dijalankan dalam
+ * waktu virtual (resolusi 1 us) dengan empat bentuk loop:
+ *   - MinimalTimer, loop() berputar tanpa tidur (firmware lama);
+ *   - MinimalTimer + delay(LOOP_MAX_SLEEP_MS) tetap;
+ *   - Scheduler, tidur min(run(), LOOP_MAX_SLEEP_MS) (networkTask);
+ *   - Scheduler, tidur min(run(), VALVE_HEARTBEAT_MS) (valveTask).
+ * Callback memakan waktu (request HTTP blocking), sehingga terlihat drift
+ * MinimalTimer (prevMillis = millis() saat callback jalan) dibanding
+ * deadline Scheduler yang dihitung dari deadline sebelumnya.
+ *
+ * Biaya satu iterasi loop dan durasi callback adalah perkiraan ESP32
+ * (lihat konstanta); yang dibandingkan adalah bentuk loop, bukan angka
+ * mutlak. Kode keluar 1 jika ada uji bagian 1 yang gagal.
+ *
+ * Pemakaian: .pio/build/native/program --scheduler [--minutes N]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "Scheduler.h"
+#include "MinimalTimer.h"
+
+// ==================== KONSTANTA ====================
+const unsigned long LOOP_MAX_SLEEP_MS = 20;   // networkTask (sama dengan firmware)
+const unsigned long VALVE_HEARTBEAT_MS = 1000; // valveTask (sama dengan firmware)
+const unsigned long BUSY_LOOP_US = 10;         // Perkiraan: timer.run() + Serial.available() di ESP32
+const unsigned long LOOP_OVERHEAD_US = 20;     // Perkiraan: satu iterasi loop yang tidur (run + vTaskDelay)
+
+// Job set firmware lama, durasi callback = perkiraan request di WiFi lokal
+struct JobSpec {
+    const char* name;
+    unsigned long intervalMs;
+    unsigned long costUs;
+};
+
+const JobSpec JOBS[] = {
+    {"checkSchedule", 1000, 1000},            // Baca RTC lewat I2C
+    {"checkRemoteStatus", 5000, 150000},      // GET /api/water-status
+    {"syncSchedulesFromAPI", 60000, 400000},  // GET /api/schedules
+    {"syncRTCFromNTP", 900000, 300000},       // Request NTP
+};
+const int JOB_COUNT = sizeof(JOBS) / sizeof(JOBS[0]);
+
+// ==================== JAM TIRUAN ====================
+
+static unsigned long long nowUs = 0;
+
+static unsigned long fakeMillis() {
+    return (unsigned long)(uint32_t)(nowUs / 1000);
+}
+
+static void setMillis(unsigned long ms) {
+    nowUs = (unsigned long long)ms * 1000;
+}
+
+// ==================== BAGIAN 1: UJI JAM TIRUAN ====================
+
+static int failures = 0;
+
+static void check(bool condition, const char* what) {
+    printf("  %-6s %s\n", condition ? "ok" : "GAGAL", what);
+    if (!condition) failures++;
+}
+
+// Catatan panggilan callback: huruf job + waktu (ms)
+static std::vector<char> firedJob;
+static std::vector<unsigned long> firedAt;
+
+static void resetTrace() {
+    firedJob.clear();
+    firedAt.clear();
+}
+
+template <char NAME>
+static void traceJob() {
+    firedJob.push_back(NAME);
+    firedAt.push_back(fakeMillis());
+}
+
+static int countFired(char name) {
+    int count = 0;
+    for (char c : firedJob) count += c == name;
+    return count;
+}
+
+static Scheduler<8>* cancelTarget = nullptr;
+static Scheduler<8>::Handle selfHandle = 0;
+static int selfCancelRuns = 0;
+
+static void cancelSelf() {
+    selfCancelRuns++;
+    cancelTarget->cancel(selfHandle);
+}
+
+static void testOrder() {
+    setMillis(0);
+    resetTrace();
+    Scheduler<8> s(fakeMillis);
+    s.every(300, traceJob<'A'>);
+    s.every(200, traceJob<'B'>);
+    s.after(250, traceJob<'C'>);
+    for (unsigned long t = 0; t <= 550; t += 50) {
+        setMillis(t);
+        s.run();
+    }
+
+    const char expectedJob[] = {'B', 'C', 'A', 'B'};
+    const unsigned long expectedAt[] = {200, 250, 300, 400};
+    bool same = firedJob.size() == 4;
+    for (size_t i = 0; same && i < 4; i++) {
+        same = firedJob[i] == expectedJob[i] && firedAt[i] == expectedAt[i];
+    }
+    check(same, "urutan deadline: B@200 C@250 A@300 B@400");
+}
+
+static void testReturnValue() {
+    setMillis(1000);
+    Scheduler<8> s(fakeMillis);
+    check(s.run() == Scheduler<8>::NO_DEADLINE, "run() tanpa job = NO_DEADLINE");
+
+    s.every(300, traceJob<'A'>);
+    setMillis(1100);
+    check(s.run() == 200, "run() = sisa waktu ke deadline berikutnya");
+    setMillis(1350);
+    check(s.run() == 250 && s.untilNext() == 250, "run()/untilNext() setelah job jalan");
+}
+
+static void testOneShot() {
+    setMillis(0);
+    resetTrace();
+    Scheduler<8> s(fakeMillis);
+    Scheduler<8>::Handle h = s.after(100, traceJob<'C'>);
+    for (unsigned long t = 0; t <= 1000; t += 10) {
+        setMillis(t);
+        s.run();
+    }
+    check(countFired('C') == 1 && firedAt[0] == 100, "after(): jalan sekali tepat waktu");
+    check(!s.active(h) && s.size() == 0, "after(): handle tidak aktif setelah jalan");
+}
+
+static void testCancel() {
+    setMillis(0);
+    selfCancelRuns = 0;
+    Scheduler<8> s(fakeMillis);
+    cancelTarget = &s;
+    selfHandle = s.every(100, cancelSelf);
+    for (unsigned long t = 0; t <= 1000; t += 50) {
+        setMillis(t);
+        s.run();
+    }
+    check(selfCancelRuns == 1 && !s.active(selfHandle), "cancel() dari dalam callback sendiri");
+
+    resetTrace();
+    Scheduler<8>::Handle old = s.every(100, traceJob<'A'>);
+    s.cancel(old);
+    Scheduler<8>::Handle reused = s.every(100, traceJob<'B'>); // Slot yang sama, generasi baru
+    check((old & 0xFFFF) == (reused & 0xFFFF) && !s.cancel(old) && s.active(reused),
+          "handle lama tidak membatalkan job baru di slot yang sama");
+}
+
+static void testNoDrift() {
+    setMillis(0);
+    resetTrace();
+    Scheduler<8> s(fakeMillis);
+    s.every(1000, traceJob<'A'>);
+
+    // run() dipanggil pada jarak acak 1-900 ms selama 1 jam
+    uint32_t state = 12345;
+    unsigned long t = 0;
+    while (t < 3600000UL) {
+        state = state * 1664525UL + 1013904223UL;
+        t += 1 + (state >> 8) % 900;
+        setMillis(t);
+        s.run();
+    }
+
+    bool onGrid = true;
+    for (size_t i = 0; i < firedAt.size(); i++) {
+        unsigned long deadline = (i + 1) * 1000UL;
+        if (firedAt[i] < deadline || firedAt[i] - deadline >= 900) onGrid = false;
+    }
+    check(countFired('A') == (int)(t / 1000) && onGrid,
+          "every(): tanpa drift, run() tidak teratur selama 1 jam");
+}
+
+static void testNoBurst() {
+    setMillis(0);
+    resetTrace();
+    Scheduler<8> s(fakeMillis);
+    s.every(1000, traceJob<'A'>);
+    setMillis(5500); // Loop macet 5,5 interval
+    unsigned long until = s.run();
+    check(countFired('A') == 1 && until == 1000, "tertinggal > 1 interval: sekali jalan, tanpa burst");
+}
+
+static void testOverflow() {
+    unsigned long start = 0xFFFFFFFFUL - 4500;
+    setMillis(start);
+    resetTrace();
+    Scheduler<8> s(fakeMillis);
+    s.every(1000, traceJob<'A'>);
+    s.after(6000, traceJob<'C'>);
+    for (unsigned long i = 1; i <= 10000; i++) {
+        setMillis((uint32_t)(start + i));
+        s.run();
+    }
+    bool onTime = countFired('A') == 10;
+    for (size_t i = 0, a = 0; i < firedAt.size(); i++) {
+        if (firedJob[i] == 'A') onTime = onTime && firedAt[i] == (uint32_t)(start + ++a * 1000);
+        if (firedJob[i] == 'C') onTime = onTime && firedAt[i] == (uint32_t)(start + 6000);
+    }
+    check(onTime && countFired('C') == 1, "overflow millis() (~49 hari): jadwal tetap tepat");
+}
+
+static void testCapacity() {
+    setMillis(0);
+    Scheduler<2> s(fakeMillis);
+    Scheduler<2>::Handle a = s.every(100, traceJob<'A'>);
+    Scheduler<2>::Handle b = s.every(100, traceJob<'B'>);
+    check(a != 0 && b != 0 && s.every(100, traceJob<'C'>) == 0 && s.after(1, nullptr) == 0,
+          "kapasitas penuh / callback null: handle 0");
+}
+
+// ==================== BAGIAN 2: PERBANDINGAN LOOP ====================
+
+enum LoopKind { MINIMAL_BUSY, MINIMAL_DELAY, SCHEDULER_NET, SCHEDULER_VALVE };
+
+struct JobTrace {
+    unsigned long fires;
+    unsigned long long lastUs;
+};
+
+static JobTrace traces[JOB_COUNT];
+static unsigned long long startUs;
+
+template <int I>
+static void firmwareJob() {
+    traces[I].fires++;
+    traces[I].lastUs = nowUs;
+    nowUs += JOBS[I].costUs; // Callback blocking
+}
+
+typedef void (*JobFn)();
+static const JobFn FIRMWARE_JOBS[JOB_COUNT] = {firmwareJob<0>, firmwareJob<1>, firmwareJob<2>, firmwareJob<3>};
+
+struct LoopResult {
+    unsigned long long iterations;
+    unsigned long long emptyRuns;   // Iterasi tanpa job yang jatuh tempo
+    unsigned long long sleepUs;
+};
+
+static unsigned long totalFires() {
+    unsigned long total = 0;
+    for (int i = 0; i < JOB_COUNT; i++) total += traces[i].fires;
+    return total;
+}
+
+static LoopResult runLoop(LoopKind kind, unsigned long long durationUs) {
+    memset(traces, 0, sizeof(traces));
+    nowUs = startUs;
+    unsigned long long endUs = startUs + durationUs;
+
+    MinimalTimer timer(fakeMillis);
+    Scheduler<> scheduler(fakeMillis);
+    for (int i = 0; i < JOB_COUNT; i++) {
+        if (kind == MINIMAL_BUSY || kind == MINIMAL_DELAY) timer.setInterval(JOBS[i].intervalMs, FIRMWARE_JOBS[i]);
+        else scheduler.every(JOBS[i].intervalMs, FIRMWARE_JOBS[i]);
+    }
+
+    LoopResult r = {0, 0, 0};
+    while (nowUs < endUs) {
+        unsigned long before = totalFires();
+        unsigned long sleepMs = 0;
+        if (kind == MINIMAL_BUSY) {
+            timer.run();
+            nowUs += BUSY_LOOP_US;
+        } else if (kind == MINIMAL_DELAY) {
+            timer.run();
+            nowUs += LOOP_OVERHEAD_US;
+            sleepMs = LOOP_MAX_SLEEP_MS;
+        } else {
+            unsigned long until = scheduler.run();
+            unsigned long cap = kind == SCHEDULER_NET ? LOOP_MAX_SLEEP_MS : VALVE_HEARTBEAT_MS;
+            nowUs += LOOP_OVERHEAD_US;
+            sleepMs = until < cap ? until : cap;
+        }
+        nowUs += (unsigned long long)sleepMs * 1000;
+        r.sleepUs += (unsigned long long)sleepMs * 1000;
+        r.iterations++;
+        if (totalFires() == before) r.emptyRuns++;
+    }
+    nowUs = endUs;
+    return r;
+}
+
+static void printLoop(const char* name, LoopKind kind, unsigned long long durationUs) {
+    LoopResult r = runLoop(kind, durationUs);
+    double seconds = durationUs / 1e6;
+    printf("%-36s %12.0f %7.1f%% %7.1f%%", name, r.iterations / seconds,
+           r.iterations ? 100.0 * r.emptyRuns / r.iterations : 0.0, 100.0 * r.sleepUs / durationUs);
+    for (int i = 0; i < JOB_COUNT; i++) {
+        // Drift = jalan terakhir dibanding deadline ideal ke-n (mulai + n x interval)
+        unsigned long long idealUs = startUs + (unsigned long long)traces[i].fires * JOBS[i].intervalMs * 1000;
+        long long driftMs = traces[i].fires ? ((long long)traces[i].lastUs - (long long)idealUs) / 1000 : 0;
+        unsigned long expected = durationUs / 1000 / JOBS[i].intervalMs;
+        printf(" %5lu/%-5lu %6lld", traces[i].fires, expected, driftMs);
+    }
+    printf("\n");
+}
+
+int runScheduler(int argc, char** argv) {
+    unsigned long minutes = 60;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--minutes") == 0) minutes = strtoul(argv[i + 1], nullptr, 10);
+    }
+    if (minutes < 15) minutes = 15; // Minimal satu kali syncRTCFromNTP
+
+    printf("Scheduler dengan jam tiruan\n");
+    testOrder();
+    testReturnValue();
+    testOneShot();
+    testCancel();
+    testNoDrift();
+    testNoBurst();
+    testOverflow();
+    testCapacity();
+
+    printf("\nLoop job set firmware lama selama %lu menit (iterasi loop %lu us, tidur %lu us)\n\n", minutes,
+           BUSY_LOOP_US, LOOP_OVERHEAD_US);
+    printf("%-36s %12s %8s %8s", "loop", "iterasi/s", "kosong", "idle");
+    for (int i = 0; i < JOB_COUNT; i++) printf(" %-19.19s", JOBS[i].name);
+    printf("\n%-36s %12s %8s %8s", "", "", "", "");
+    for (int i = 0; i < JOB_COUNT; i++) printf(" %11s %6s", "jalan/ideal", "drift");
+    printf("\n");
+
+    unsigned long long durationUs = (unsigned long long)minutes * 60000000ULL;
+    startUs = 0;
+    printLoop("MinimalTimer, berputar", MINIMAL_BUSY, durationUs);
+    printLoop("MinimalTimer + delay(20)", MINIMAL_DELAY, durationUs);
+    printLoop("Scheduler, tidur <= 20 ms (net)", SCHEDULER_NET, durationUs);
+    printLoop("Scheduler, tidur <= 1000 ms (valve)", SCHEDULER_VALVE, durationUs);
+
+    printf("\nkosong = iterasi tanpa job jatuh tempo, idle = waktu tidur (CPU bebas untuk task lain)\n");
+    printf("drift  = jalan terakhir - (mulai + n x interval), ms; terus tumbuh jika jadwal bergeser\n");
+
+    printf("\n%s\n", failures == 0 ? "Semua uji Scheduler lulus." : "ADA UJI SCHEDULER YANG GAGAL!");
+    return failures == 0 ? 0 : 1;
+}
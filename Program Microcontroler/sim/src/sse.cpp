@@ -0,0 +1,383 @@
+/*
+ * SIMULASI STREAM STATUS - Perintah valve dashboard -> relay lewat SSE
+ *
+ * SseClient firmware (logika StatusStream.h) membuka stream ke server SSE di
+ * loopback (Linux) yang menyajikan status valve StandInServer. Dashboard
+ * tiruan mengubah status valve; server mendorong event "data: {...}" seperti
+ * /api/water-status/stream. Thread networkTask meniru firmware: poll() lalu
+ * tidur hingga LOOP_MAX_SLEEP_MS; handler event meneruskan perintah ke antrian
+ * valveTask, yang membuka/menutup zona di ValveBank dengan relay tiruan yang
+ * mencatat waktu tulis.
+ *
+ * Dilaporkan:
+ *   - latensi  : event dikirim server -> relay berubah (p50/p99/maks)
+ *   - poll maks: poll() terlama di networkTask, termasuk saat connect
+ *                (socket non-blocking: tidak boleh mendekati CONNECT_TIMEOUT_MS)
+ *   - hilang   : perintah yang tidak pernah sampai ke relay
+ * ditambah perkiraan jalur polling REMOTE_CHECK_INTERVAL sebagai pembanding.
+ * Field JSON dibaca dengan strstr (ArduinoJson tidak dikompilasi di sini);
+ * parse dengan filter diukur terpisah di --bench.
+ *
+ * Pemakaian: .pio/build/native/program --sse [--commands N] [--seed N]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "SimHardware.h"
+#include "StandInServer.h"
+#include "SseClient.h"
+#include "ValveBank.h"
+
+// ==================== KONSTANTA (sama dengan firmware) ====================
+const unsigned long LOOP_MAX_SLEEP_MS = 20;          // networkTask control node
+const unsigned long VALVE_HEARTBEAT_MS = 1000;       // valveTask bangun minimal tiap 1 detik
+const unsigned long REMOTE_CHECK_INTERVAL = 5000;    // Polling fallback /api/water-status
+const uint8_t VALVE_ZONES = 4;
+// Stagger 0: yang diukur jalur perintah, bukan jeda pompa antar zona
+const ValveBankConfig SIM_BANK_CONFIG = {1, 0};
+
+// Simulasi
+const unsigned long COMMAND_GAP_MIN_MS = 30;
+const unsigned long COMMAND_GAP_SPREAD_MS = 100;
+const char* STREAM_PATH = "/api/water-status/stream";
+
+typedef std::chrono::steady_clock SteadyClock;
+
+static long long nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(SteadyClock::now().time_since_epoch()).count();
+}
+
+static unsigned long nowMs() { return (unsigned long)(nowUs() / 1000); }
+
+// ==================== TRANSPORT HOST ====================
+// Padanan NonBlockingTcp (StatusStream.h) dengan socket POSIX
+
+class PosixTcp {
+public:
+    bool start(const char* host, int port) {
+        stop();
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) return false;
+
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return false;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+            close(fd);
+            return false;
+        }
+        _fd = fd;
+        _connected = false;
+        return true;
+    }
+
+    int finish() {
+        if (_fd < 0) return -1;
+        pollfd p = {_fd, POLLOUT, 0};
+        int ready = ::poll(&p, 1, 0);
+        if (ready == 0) return 0;
+
+        int error = 0;
+        socklen_t length = sizeof(error);
+        if (ready < 0 || getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0) {
+            stop();
+            return -1;
+        }
+        _connected = true;
+        return 1;
+    }
+
+    bool connected() {
+        if (!_connected) return false;
+        fill();
+        return _connected;
+    }
+
+    int available() {
+        fill();
+        return (int)(_length - _pos);
+    }
+
+    int read() {
+        if (_pos == _length) fill();
+        return _pos < _length ? _buf[_pos++] : -1;
+    }
+
+    size_t write(const uint8_t* data, size_t length) {
+        ssize_t n = _fd >= 0 ? send(_fd, data, length, MSG_NOSIGNAL) : -1;
+        return n > 0 ? (size_t)n : 0;
+    }
+
+    void stop() {
+        if (_fd >= 0) close(_fd);
+        _fd = -1;
+        _connected = false;
+        _pos = _length = 0;
+    }
+
+private:
+    // Ambil byte yang sudah ada di socket tanpa menunggu
+    void fill() {
+        if (_fd < 0 || _pos < _length) return;
+        ssize_t n = recv(_fd, _buf, sizeof(_buf), MSG_DONTWAIT);
+        _pos = 0;
+        _length = n > 0 ? (size_t)n : 0;
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) _connected = false;
+    }
+
+    int _fd = -1;
+    bool _connected = false;
+    uint8_t _buf[512];
+    size_t _pos = 0;
+    size_t _length = 0;
+};
+
+// ==================== RELAY TIRUAN ====================
+
+class TimedRelay : public ValveOutput {
+public:
+    void write(uint8_t zone, bool open) override {
+        if (zone >= SIM_MAX_ZONES || open == _open[zone]) return;
+        _open[zone] = open;
+        _changedAt[zone] = nowUs();
+    }
+
+    bool isOpen(uint8_t zone) const { return _open[zone]; }
+    long long changedAt(uint8_t zone) const { return _changedAt[zone]; }
+
+private:
+    bool _open[SIM_MAX_ZONES] = {};
+    long long _changedAt[SIM_MAX_ZONES] = {};
+};
+
+// ==================== DUNIA SIMULASI ====================
+
+struct RemoteCommand {
+    uint32_t id;        // "id" status di server = indeks perintah dashboard
+    uint8_t zone;       // Mulai 0
+    bool on;
+};
+
+struct SseWorld {
+    // Server
+    StandInServer server;
+    std::mutex serverMutex;
+    std::condition_variable serverChanged;
+    uint32_t pushedId = 0;
+    std::vector<std::atomic<long long>> pushedAt; // Waktu event ditulis ke socket, per id
+
+    // valveQueue
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::deque<RemoteCommand> queue;
+
+    std::atomic<bool> streaming{false};
+    std::atomic<bool> done{false};
+    std::vector<long long> latencyUs;
+    long long pollMaxUs = 0;
+    uint32_t events = 0;
+};
+
+static SseWorld* world = nullptr;
+
+// Sama dengan onValveStatusEvent() + applyRemoteValveStatus() firmware
+static void onValveStatusEvent(const char* data) {
+    const char* id = strstr(data, "\"id\":");
+    const char* status = strstr(data, "\"valve_status\":\"");
+    const char* zone = strstr(data, "\"zone\":");
+    if (!id || !status) return;
+    int zoneNumber = zone ? atoi(zone + 7) : 1;
+    if (zoneNumber < 1 || zoneNumber > VALVE_ZONES) return;
+
+    RemoteCommand cmd;
+    cmd.id = (uint32_t)strtoul(id + 5, nullptr, 10);
+    cmd.zone = (uint8_t)(zoneNumber - 1);
+    cmd.on = strncmp(status + 16, "ON\"", 3) == 0;
+    world->events++;
+    {
+        std::lock_guard<std::mutex> lock(world->queueMutex);
+        world->queue.push_back(cmd);
+    }
+    world->queueReady.notify_one();
+}
+
+// Server SSE: satu klien, event status terkini saat terhubung lalu satu
+// event setiap status berubah
+static void serveStream(SseWorld& w, int listener) {
+    int fd = accept(listener, nullptr, nullptr);
+    if (fd < 0) return;
+
+    char request[512];
+    size_t length = 0;
+    while (length < sizeof(request) - 1) {
+        ssize_t n = recv(fd, request + length, sizeof(request) - 1 - length, 0);
+        if (n <= 0) break;
+        length += (size_t)n;
+        request[length] = '\0';
+        if (strstr(request, "\r\n\r\n")) break;
+    }
+
+    char body[128];
+    char event[192];
+    std::unique_lock<std::mutex> lock(w.serverMutex);
+    w.server.waterStatus(body, sizeof(body));
+    int n = snprintf(event, sizeof(event),
+                     "HTTP/1.0 200 OK\r\nContent-Type: text/event-stream\r\n\r\ndata: %s\n\n", body);
+    send(fd, event, n, MSG_NOSIGNAL);
+
+    uint32_t sentId = 0;
+    while (!w.done.load()) {
+        w.serverChanged.wait_for(lock, std::chrono::milliseconds(100));
+        if (w.pushedId == sentId) continue;
+        sentId = w.pushedId;
+        w.server.waterStatus(body, sizeof(body));
+        n = snprintf(event, sizeof(event), "data: %s\n\n", body);
+        if (sentId < w.pushedAt.size()) w.pushedAt[sentId].store(nowUs());
+        send(fd, event, n, MSG_NOSIGNAL);
+    }
+    close(fd);
+}
+
+// networkTask: poll() non-blocking lalu tidur hingga LOOP_MAX_SLEEP_MS
+static void networkTask(SseWorld& w, int port) {
+    PosixTcp tcp;
+    SseClient<PosixTcp> stream(tcp);
+    stream.begin("127.0.0.1", port, STREAM_PATH, onValveStatusEvent);
+
+    while (!w.done.load()) {
+        if (!stream.connected()) stream.connect(); // checkRemoteStatus() saat stream putus
+        long long t0 = nowUs();
+        if (stream.poll(nowMs()) == SseClient<PosixTcp>::OPENED_EVENT) w.streaming.store(true);
+        long long spent = nowUs() - t0;
+        if (spent > w.pollMaxUs) w.pollMaxUs = spent;
+        std::this_thread::sleep_for(std::chrono::milliseconds(LOOP_MAX_SLEEP_MS));
+    }
+    stream.drop();
+}
+
+// valveTask: tunggu antrian perintah paling lama VALVE_HEARTBEAT_MS
+static void valveTask(SseWorld& w) {
+    TimedRelay relay;
+    ValveBank<VALVE_ZONES> valves(relay, SIM_BANK_CONFIG);
+    valves.begin();
+
+    std::unique_lock<std::mutex> lock(w.queueMutex);
+    while (!w.done.load()) {
+        w.queueReady.wait_for(lock, std::chrono::milliseconds(VALVE_HEARTBEAT_MS),
+                              [&] { return !w.queue.empty() || w.done.load(); });
+        while (!w.queue.empty()) {
+            RemoteCommand cmd = w.queue.front();
+            w.queue.pop_front();
+            // handleValveCommand(): REMOTE_ON membuka zona manual, REMOTE_OFF menutupnya
+            if (cmd.on) valves.request(cmd.zone, 0, true, nowMs());
+            else if (valves.isManual(cmd.zone)) valves.close(cmd.zone, nowMs());
+            valves.update(nowMs());
+
+            if (relay.isOpen(cmd.zone) == cmd.on && cmd.id < w.pushedAt.size() && w.pushedAt[cmd.id].load()) {
+                w.latencyUs.push_back(relay.changedAt(cmd.zone) - w.pushedAt[cmd.id]);
+            }
+        }
+        valves.update(nowMs());
+    }
+}
+
+static long long percentile(std::vector<long long>& v, double p) {
+    if (v.empty()) return 0;
+    size_t i = (size_t)(p * (v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + i, v.end());
+    return v[i];
+}
+
+int runSseLatency(int argc, char** argv) {
+    uint32_t commands = 200;
+    uint32_t seed = 42;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--commands") == 0) commands = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--seed") == 0) seed = (uint32_t)atoi(argv[i + 1]);
+    }
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLength = sizeof(addr);
+    if (listener < 0 || bind(listener, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(listener, 1) < 0 ||
+        getsockname(listener, (sockaddr*)&addr, &addrLength) < 0) {
+        printf("Socket TCP loopback gagal dibuka\n");
+        return 1;
+    }
+
+    SseWorld w;
+    world = &w;
+    // id status awal di server = 1; perintah dashboard ke-i mendapat id i + 2
+    std::vector<std::atomic<long long>> pushedAt(commands + 2);
+    w.pushedAt.swap(pushedAt);
+
+    std::thread server(serveStream, std::ref(w), listener);
+    std::thread network(networkTask, std::ref(w), (int)ntohs(addr.sin_port));
+    std::thread valve(valveTask, std::ref(w));
+
+    for (int i = 0; i < 200 && !w.streaming.load(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (!w.streaming.load()) {
+        printf("Stream SSE tidak terhubung\n");
+    } else {
+        // Dashboard: buka lalu tutup zona 1..4 bergantian, jeda acak
+        Prng prng(seed);
+        for (uint32_t i = 0; i < commands; i++) {
+            {
+                std::lock_guard<std::mutex> lock(w.serverMutex);
+                w.server.setValveStatus(1 + (i / 2) % VALVE_ZONES, i % 2 == 0);
+                w.pushedId = i + 2;
+            }
+            w.serverChanged.notify_one();
+            unsigned long gap = COMMAND_GAP_MIN_MS + prng.next() % COMMAND_GAP_SPREAD_MS;
+            std::this_thread::sleep_for(std::chrono::milliseconds(gap));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    w.done.store(true);
+    w.serverChanged.notify_all();
+    w.queueReady.notify_all();
+    shutdown(listener, SHUT_RDWR); // accept() yang masih menunggu ikut selesai
+    server.join();
+    network.join();
+    valve.join();
+    close(listener);
+
+    printf("Stream status SSE (loopback 127.0.0.1), %u perintah dashboard, seed %u\n\n", commands, seed);
+    long long p50 = percentile(w.latencyUs, 0.50);
+    long long p99 = percentile(w.latencyUs, 0.99);
+    long long max = w.latencyUs.empty() ? 0 : *std::max_element(w.latencyUs.begin(), w.latencyUs.end());
+    uint32_t lost = commands > w.latencyUs.size() ? commands - (uint32_t)w.latencyUs.size() : 0;
+    printf("%-28s %8s %8s %9s %9s %9s %10s\n", "jalur", "event", "hilang", "p50", "p99", "maks", "poll maks");
+    printf("%-28s %8u %8u %7.2fms %7.2fms %7.2fms %8.2fms\n", "SSE (networkTask tidur 20ms)", w.events, lost,
+           p50 / 1000.0, p99 / 1000.0, max / 1000.0, w.pollMaxUs / 1000.0);
+    printf("%-28s %8s %8s %7.0fms %7s %7lums\n", "polling (perkiraan)", "-", "-", REMOTE_CHECK_INTERVAL / 2.0, "-",
+           REMOTE_CHECK_INTERVAL);
+    printf("\nlatensi = event ditulis server -> relay berubah, tanpa radio WiFi; event = termasuk status awal\n");
+    printf("poll maks = poll() terlama di networkTask termasuk connect (batas connect %lu ms)\n",
+           SseClient<PosixTcp>::CONNECT_TIMEOUT_MS);
+    return lost == 0 && !w.latencyUs.empty() ? 0 : 1;
+}
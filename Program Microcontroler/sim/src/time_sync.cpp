@@ -0,0 +1,282 @@
+/*
+ * SIMULASI WAKTU - Jalur jam lama (rtc.now() + rtc.adjust()) vs TimeService
+ *
+ * Model (waktu virtual, langkah 10 ms):
+ *   - esp_timer  : kristal ESP32 +18 ppm dengan ayunan harian +/-3 ppm (suhu)
+ *   - DS3231     : +2 ppm, dibaca per detik penuh; rtc.adjust() me-reset pembagi
+ *                  sub-detik, jadi nilai yang ditulis berlaku tepat saat ditulis
+ *   - NTP        : tersedia 30 s setelah boot, jitter ~10 ms (sigma), mati 12 jam
+ *                  pada hari ke-3 (08:00-20:00)
+ *   - jadwal     : 32 entri tiap 45 menit; checkSchedule memakai logika
+ *                  armScheduleCheck firmware (bangun saat event jatuh tempo,
+ *                  paling lama 60 s, dihitung dengan millis() = esp_timer)
+ *
+ * Jalur lama: checkSchedule & reloadSchedules membaca RTC lewat I2C; tiap 15
+ * menit getLocalTime() (jam sistem, didisiplinkan SNTP tiap 1 jam dan ikut
+ * drift kristal di antaranya, juga saat NTP mati) ditulis ke RTC lalu tabel
+ * jadwal dimuat ulang. Jalur baru: TimeService dengan konfigurasi firmware,
+ * sampel NTP tiap 15 menit, DS3231 hanya dibaca saat sync/cadangan.
+ *
+ * Dilaporkan per jalur: error jam (maks/p99, sampel per menit), error waktu
+ * eksekusi jadwal, langkah mundur, reload tabel, event dobel/terlewat dan
+ * transaksi I2C per hari.
+ *
+ * Pemakaian: .pio/build/native/program --time-sync [--days N] [--seed N]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "SimHardware.h"
+#include "ScheduleTable.h"
+#include "TimeService.h"
+
+// ==================== KONSTANTA (sama dengan firmware) ====================
+#define MAX_SCHEDULES 32
+const unsigned long SCHEDULE_MAX_SLEEP_MS = 60000UL;
+const uint32_t SCHEDULE_CATCH_UP_SEC = 300;
+const TimeServiceConfig TIME_SERVICE_CONFIG = {30000, 2000, 500, 3600, 14400, 1500, 2, 86400};
+const int64_t NTP_SYNC_INTERVAL_US = 900000000LL;   // Sync NTP/RTC tiap 15 menit
+const int64_t NTP_STALE_US = 3600000000LL;          // TimeService: cadangan DS3231 setelah 1 jam
+const int64_t SNTP_DEFAULT_INTERVAL_US = 3600000000LL; // Jalur lama: interval bawaan lwIP SNTP
+
+// Simulasi
+const uint32_t SIM_START_EPOCH = 1736121600;        // Senin 2025-01-06 00:00 (waktu lokal)
+const int64_t STEP_US = 10000;
+const double CRYSTAL_PPM = 18.0;
+const double CRYSTAL_SWING_PPM = 3.0;
+const double RTC_PPM = 2.0;
+const double RTC_BOOT_ERROR_SEC = 0.8;
+const double NTP_JITTER_US = 10000.0;
+const int64_t WIFI_UP_US = 30000000LL;
+const int64_t OUTAGE_START_US = (2 * 86400LL + 8 * 3600) * 1000000;
+const int64_t OUTAGE_END_US = (2 * 86400LL + 20 * 3600) * 1000000;
+
+// DS3231: nilai kontinu (detik) yang maju dengan drift; dibaca dibulatkan ke bawah
+struct Rtc {
+    double value;
+    int64_t setAtUs;
+
+    double at(int64_t trueUs) const { return value + (trueUs - setAtUs) / 1e6 * (1.0 + RTC_PPM * 1e-6); }
+    uint32_t read(int64_t trueUs) const { return (uint32_t)floor(at(trueUs)); }
+    void write(uint32_t epoch, int64_t trueUs) {
+        value = epoch;
+        setAtUs = trueUs;
+    }
+};
+
+struct PathResult {
+    const char* name;
+    std::vector<double> clockErrMs;      // |jam - waktu sebenarnya| per menit
+    double fireErrMaxMs = 0;             // |waktu eksekusi - jadwal| maks
+    uint32_t backward = 0;               // Jam terbaca mundur
+    uint32_t reloads = 0;                // Tabel jadwal dimuat ulang karena waktu
+    uint32_t doubles = 0;
+    uint32_t missed = 0;
+    uint32_t i2c = 0;                    // Transaksi I2C ke DS3231 (baca + tulis)
+    TimeService::Stats stats = {};
+};
+
+class Path {
+public:
+    Path(bool timeService, const ScheduleEntry* entries, size_t count)
+        : _useService(timeService), _entries(entries), _count(count), _table(SCHEDULE_CATCH_UP_SEC),
+          _service(TIME_SERVICE_CONFIG) {
+        _r.name = timeService ? "TimeService" : "rtc.now() + rtc.adjust()";
+    }
+
+    void boot(const Rtc& rtc, uint64_t mono) {
+        _rtc = rtc;
+        if (_useService) _service.begin(_rtc.read(0), mono);
+        _r.i2c++;
+        reload(0, mono, false);
+    }
+
+    // Satu langkah waktu virtual
+    void step(int64_t t, uint64_t mono, bool ntpUp, Prng& prng) {
+        if (mono >= _wakeMono) checkSchedule(t, mono);
+        if (t >= _nextSyncUs && t >= WIFI_UP_US) {
+            _nextSyncUs = t + NTP_SYNC_INTERVAL_US;
+            sync(t, mono, ntpUp, prng);
+        }
+        if (t % 1000000 == 0) {
+            int64_t reading = clockUs(t, mono, false);
+            if (reading < _lastReadingUs) _r.backward++;
+            _lastReadingUs = reading;
+            if (t % 60000000 == 0) _r.clockErrMs.push_back(fabs((double)(reading - trueEpochUs(t))) / 1000.0);
+        }
+    }
+
+    PathResult finish(int64_t endUs) {
+        // Event yang jatuh tempo setelah 30 s pertama dan >10 menit sebelum akhir
+        uint32_t from = SIM_START_EPOCH + 30, to = (uint32_t)(SIM_START_EPOCH + endUs / 1000000 - 600);
+        for (uint32_t day = from / 86400; day <= to / 86400; day++) {
+            for (size_t i = 0; i < _count; i++) {
+                uint32_t at = day * 86400 + _entries[i].minuteOfDay * 60;
+                if (at < from || at > to) continue;
+                auto it = _fires.find(key(at, i));
+                if (it == _fires.end()) _r.missed++;
+                else if (it->second > 1) _r.doubles += it->second - 1;
+            }
+        }
+        _r.stats = _service.stats();
+        return _r;
+    }
+
+private:
+    static int64_t trueEpochUs(int64_t t) { return (int64_t)SIM_START_EPOCH * 1000000 + t; }
+    static uint64_t key(uint32_t at, size_t index) { return (uint64_t)at * MAX_SCHEDULES + index; }
+
+    // Jam yang dipakai firmware; jalur lama = satu transaksi I2C
+    int64_t clockUs(int64_t t, uint64_t mono, bool countI2c) {
+        if (_useService) return _service.nowUs(mono);
+        if (countI2c) _r.i2c++;
+        return (int64_t)_rtc.read(t) * 1000000;
+    }
+
+    // armScheduleCheck()
+    void arm(uint32_t now, uint64_t mono) {
+        uint32_t waitSec = _table.untilNext(now);
+        unsigned long waitMs = waitSec >= SCHEDULE_MAX_SLEEP_MS / 1000 ? SCHEDULE_MAX_SLEEP_MS : waitSec * 1000UL;
+        if (waitMs == 0) waitMs = 1000UL;
+        _wakeMono = mono + (uint64_t)waitMs * 1000;
+    }
+
+    void checkSchedule(int64_t t, uint64_t mono) {
+        uint32_t now = (uint32_t)(clockUs(t, mono, true) / 1000000);
+        ScheduleTable<MAX_SCHEDULES>::Event event;
+        while (_table.poll(now, event)) {
+            _fires[key(event.at, event.index)]++;
+            double err = fabs((double)(trueEpochUs(t) - (int64_t)event.at * 1000000)) / 1000.0;
+            if (err > _r.fireErrMaxMs) _r.fireErrMaxMs = err;
+        }
+        arm(now, mono);
+    }
+
+    void reload(int64_t t, uint64_t mono, bool countReload) {
+        if (countReload) _r.reloads++;
+        uint32_t now = (uint32_t)(clockUs(t, mono, true) / 1000000);
+        _table.load(_entries, _count, now);
+        arm(now, mono);
+    }
+
+    void sync(int64_t t, uint64_t mono, bool ntpUp, Prng& prng) {
+        int64_t ntpUs = trueEpochUs(t) + (int64_t)(prng.gaussian() * NTP_JITTER_US);
+        if (_useService) syncService(t, mono, ntpUp, ntpUs);
+        else syncLegacy(t, mono, ntpUp, ntpUs);
+    }
+
+    // coreRTCSyncLogic() lama: jam sistem (SNTP) ditulis ke RTC tiap 15 menit
+    void syncLegacy(int64_t t, uint64_t mono, bool ntpUp, int64_t ntpUs) {
+        if (ntpUp && (!_sysSet || mono - _sysMono >= (uint64_t)SNTP_DEFAULT_INTERVAL_US)) {
+            _sysUs = ntpUs;
+            _sysMono = mono;
+            _sysSet = true;
+        }
+        if (!_sysSet) return; // getLocalTime() gagal
+        int64_t sysNow = _sysUs + (int64_t)(mono - _sysMono);
+        _r.i2c++; // rtcNow() untuk drift
+        _rtc.write((uint32_t)(sysNow / 1000000), t);
+        _r.i2c++;
+        reload(t, mono, true); // rtcAdjust() -> requestScheduleReload()
+    }
+
+    // applyNtpSample() + checkTimeSources()
+    void syncService(int64_t t, uint64_t mono, bool ntpUp, int64_t ntpUs) {
+        if (ntpUp) {
+            TimeService::Result result = _service.ntpSample(ntpUs, mono);
+            if (result == TimeService::STEPPED) reload(t, mono, true);
+            _r.i2c++;
+            if (_service.rtcCheck(_rtc.read(t), mono)) {
+                _rtc.write((uint32_t)((_service.referenceUs(mono) + 500000) / 1000000), t);
+                _r.i2c++;
+            }
+            return;
+        }
+        if (_service.ntpSynced() && (int64_t)(mono - _service.lastNtpMono()) <= NTP_STALE_US) return;
+        _r.i2c++;
+        if (_service.rtcSample(_rtc.read(t), mono) == TimeService::STEPPED) reload(t, mono, true);
+    }
+
+    bool _useService;
+    const ScheduleEntry* _entries;
+    size_t _count;
+    ScheduleTable<MAX_SCHEDULES> _table;
+    TimeService _service;
+    Rtc _rtc = {0, 0};
+    uint64_t _wakeMono = 0;
+    int64_t _nextSyncUs = 0;
+    int64_t _lastReadingUs = 0;
+    bool _sysSet = false;
+    int64_t _sysUs = 0;
+    uint64_t _sysMono = 0;
+    std::map<uint64_t, uint32_t> _fires;
+    PathResult _r;
+};
+
+static double percentile(std::vector<double> v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[(size_t)((v.size() - 1) * p)];
+}
+
+static void printPath(const PathResult& r, uint32_t days, bool service) {
+    printf("== %s ==\n", r.name);
+    printf("  Error jam    : p99 %.0f ms, maks %.0f ms; eksekusi jadwal maks %.0f ms\n",
+           percentile(r.clockErrMs, 0.99), percentile(r.clockErrMs, 1.0), r.fireErrMaxMs);
+    printf("  Jadwal       : %u dobel, %u terlewat, %u reload karena waktu, jam mundur %u kali\n",
+           r.doubles, r.missed, r.reloads, r.backward);
+    printf("  I2C DS3231   : %.0f transaksi per hari\n", (double)r.i2c / days);
+    if (service) {
+        printf("  TimeService  : %u sampel NTP, %u sampel RTC, %u step, %u slew; frekuensi %+.2f ppm "
+               "(kristal %+.0f), drift RTC %+.2f ppm (model %+.0f)\n",
+               r.stats.ntpSamples, r.stats.rtcSamples, r.stats.steps, r.stats.slews, r.stats.freqPpb / 1000.0,
+               -CRYSTAL_PPM, r.stats.rtcDriftPpb / 1000.0, RTC_PPM);
+    }
+    printf("\n");
+}
+
+int runTimeSync(int argc, char** argv) {
+    uint32_t days = 7, seed = 1;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--days") == 0) days = (uint32_t)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--seed") == 0) seed = (uint32_t)atoi(argv[i + 1]);
+    }
+    if (days < 1) days = 1;
+
+    ScheduleEntry entries[MAX_SCHEDULES];
+    for (int i = 0; i < MAX_SCHEDULES; i++) entries[i] = {(uint16_t)(5 + 45 * i), 600, WEEKDAYS_ALL, 1, 1, 0};
+
+    Rtc rtc = {SIM_START_EPOCH + RTC_BOOT_ERROR_SEC, 0};
+    Path legacy(false, entries, MAX_SCHEDULES), service(true, entries, MAX_SCHEDULES);
+    Prng legacyNtp(seed * 2654435761u), serviceNtp(seed * 2654435761u);
+
+    // esp_timer mulai dari waktu acak sejak boot ROM; kristal lebih cepat dari waktu sebenarnya
+    double mono = 1234567.0;
+    legacy.boot(rtc, (uint64_t)mono);
+    service.boot(rtc, (uint64_t)mono);
+
+    const int64_t endUs = (int64_t)days * 86400 * 1000000;
+    double rate = 1.0;
+    for (int64_t t = 0; t < endUs; t += STEP_US) {
+        if (t % 1000000 == 0) {
+            double phase = 2.0 * M_PI * (double)t / 86400e6;
+            rate = 1.0 + (CRYSTAL_PPM + CRYSTAL_SWING_PPM * sin(phase)) * 1e-6;
+        }
+        mono += STEP_US * rate;
+        bool ntpUp = t >= WIFI_UP_US && (t < OUTAGE_START_US || t >= OUTAGE_END_US);
+        legacy.step(t, (uint64_t)mono, ntpUp, legacyNtp);
+        service.step(t, (uint64_t)mono, ntpUp, serviceNtp);
+    }
+
+    printf("Jam & jadwal, %u hari, seed %u: kristal %+.0f+/-%.0f ppm, DS3231 %+.0f ppm, "
+           "NTP mati 12 jam di hari ke-3\n\n", days, seed, CRYSTAL_PPM, CRYSTAL_SWING_PPM, RTC_PPM);
+    printPath(legacy.finish(endUs), days, false);
+    printPath(service.finish(endUs), days, true);
+    return 0;
+}
@@ -0,0 +1,254 @@
+/*
+ * SIMULASI VALVE BANK - Timeline relay sequencer multi-zona
+ *
+ * ValveBank firmware dijalankan di atas relay tiruan yang merekam timeline
+ * (waktu virtual, zona, buka/tutup). Setiap skenario dicetak sebagai
+ * timeline lalu diperiksa:
+ *   - batas pompa : zona terbuka bersamaan <= maxConcurrent
+ *   - stagger     : jarak antar pembukaan >= staggerMs
+ *   - urutan      : zona antrian dibuka FIFO sesuai urutan request
+ *   - durasi      : zona terjadwal tertutup tepat pada durasinya
+ *   - manual      : zona manual (durasi 0) terbuka sampai ditutup; closeWhere()
+ *                   hanya menyentuh jenisnya sendiri
+ *   - kelembapan  : cutoff & SKIP closed-loop (Watering.h) hanya untuk zona
+ *                   di moistureZones, zona lain tetap durasi tetap
+ *   - update()    : nilai kembalian = ms ke aksi berikutnya; pemanggil yang
+ *                   tidur tepat selama itu tidak pernah terlambat, yang
+ *                   terlambat tercatat di maxCloseLateMs()
+ * Kode keluar 1 jika ada pemeriksaan yang gagal.
+ *
+ * Pemakaian: .pio/build/native/program --valve-bank
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "SimHardware.h"
+#include "ValveBank.h"
+#include "Watering.h"
+
+// ==================== KONSTANTA (sama dengan firmware) ====================
+const uint8_t VALVE_ZONES = 4;
+const ValveBankConfig BANK_CONFIG = {1, 5000UL};     // VALVE_MAX_CONCURRENT, VALVE_STAGGER_MS
+const unsigned long RUN_MS = 60000;
+
+// ==================== RELAY TIRUAN ====================
+
+struct RelayEvent {
+    unsigned long at;
+    uint8_t zone;
+    bool open;
+};
+
+// ValveOutput yang merekam setiap perubahan relay
+class TimelineOutput : public ValveOutput {
+public:
+    explicit TimelineOutput(const VirtualClock& clock) : _clock(clock) {}
+
+    void write(uint8_t zone, bool open) override {
+        if (zone >= SIM_MAX_ZONES || open == _open[zone]) return;
+        _open[zone] = open;
+        events.push_back({_clock.millis(), zone, open});
+    }
+
+    // Waktu buka/tutup ke-n sebuah zona (-1 = tidak ada)
+    long at(uint8_t zone, bool open, size_t n = 0) const {
+        for (const RelayEvent& e : events) {
+            if (e.zone == zone && e.open == open && n-- == 0) return (long)e.at;
+        }
+        return -1;
+    }
+
+    std::vector<RelayEvent> events;
+
+private:
+    const VirtualClock& _clock;
+    bool _open[SIM_MAX_ZONES] = {};
+};
+
+// ==================== PEMERIKSAAN ====================
+
+static int failures = 0;
+
+static void check(bool condition, const char* what) {
+    printf("  %-6s %s\n", condition ? "ok" : "GAGAL", what);
+    if (!condition) failures++;
+}
+
+static void printTimeline(const TimelineOutput& relay) {
+    for (const RelayEvent& e : relay.events) {
+        printf("    %8.1f s  zona %u %s\n", e.at / 1000.0, e.zone + 1, e.open ? "BUKA" : "tutup");
+    }
+}
+
+// Batas pompa & stagger sepanjang timeline
+static bool withinLimits(const TimelineOutput& relay, const ValveBankConfig& config) {
+    int open = 0;
+    long lastOpen = -1;
+    for (const RelayEvent& e : relay.events) {
+        if (!e.open) {
+            open--;
+            continue;
+        }
+        if (++open > config.maxConcurrent) return false;
+        if (lastOpen >= 0 && e.at - (unsigned long)lastOpen < config.staggerMs) return false;
+        lastOpen = (long)e.at;
+    }
+    return true;
+}
+
+// Jalankan valveTask tiruan: tidur tepat selama nilai kembalian update()
+template <uint8_t ZONES>
+static void runUntilIdle(ValveBank<ZONES>& valves, VirtualClock& clock, unsigned long limitMs) {
+    while (clock.millis() < limitMs) {
+        unsigned long until = valves.update(clock.millis());
+        if (until == ValveBank<ZONES>::NO_DEADLINE) break;
+        clock.advance(until);
+    }
+}
+
+// ==================== SKENARIO ====================
+
+// Empat zona terjadwal diminta bersamaan, pompa hanya kuat satu zona
+static void sequencedRuns() {
+    printf("\nEmpat zona sekaligus, maks 1 terbuka, stagger 5 s, %lu s per zona\n", RUN_MS / 1000);
+    VirtualClock clock(0);
+    TimelineOutput relay(clock);
+    ValveBank<VALVE_ZONES> valves(relay, BANK_CONFIG);
+    valves.begin();
+    const uint8_t order[] = {2, 0, 3, 1};
+    bool accepted = true;
+    for (uint8_t zone : order) accepted = valves.request(zone, RUN_MS, false, clock.millis()) && accepted;
+    runUntilIdle(valves, clock, 3600000UL);
+    printTimeline(relay);
+
+    bool fifo = true;
+    for (size_t i = 0; i < 4; i++) fifo = fifo && relay.at(order[i], true) == (long)(i * RUN_MS);
+    bool exact = true;
+    for (uint8_t z = 0; z < VALVE_ZONES; z++) exact = exact && relay.at(z, false) - relay.at(z, true) == (long)RUN_MS;
+    check(accepted && relay.events.size() == 8, "semua zona dibuka & ditutup sekali");
+    check(fifo, "zona antrian dibuka sesuai urutan request, tanpa jeda");
+    check(exact, "setiap zona terbuka tepat sesuai durasinya");
+    check(withinLimits(relay, BANK_CONFIG), "tidak pernah > 1 zona terbuka");
+    check(valves.maxCloseLateMs() == 0, "maxCloseLateMs() = 0 saat tidur sesuai update()");
+}
+
+// Pompa kuat dua zona: pembukaan kedua ditahan stagger
+static void concurrentRuns() {
+    const ValveBankConfig config = {2, 5000UL};
+    printf("\nEmpat zona sekaligus, maks 2 terbuka, stagger 5 s\n");
+    VirtualClock clock(0);
+    TimelineOutput relay(clock);
+    ValveBank<VALVE_ZONES> valves(relay, config);
+    valves.begin();
+    for (uint8_t z = 0; z < VALVE_ZONES; z++) valves.request(z, RUN_MS, false, clock.millis());
+    unsigned long firstWait = valves.update(clock.millis());
+    runUntilIdle(valves, clock, 3600000UL);
+    printTimeline(relay);
+
+    check(firstWait == config.staggerMs, "update() = sisa stagger saat zona antrian menunggu");
+    check(relay.at(0, true) == 0 && relay.at(1, true) == 5000 && relay.at(2, true) == 60000 &&
+              relay.at(3, true) == 65000,
+          "zona 2 menunggu stagger, zona 3/4 menunggu slot pompa");
+    check(withinLimits(relay, config), "tidak pernah > 2 zona terbuka, jarak buka >= 5 s");
+}
+
+// Override manual dari API water-status di tengah jadwal
+static void manualOverride() {
+    const ValveBankConfig config = {2, 5000UL};
+    printf("\nOverride manual: zona 2 dibuka manual di tengah jadwal zona 1, zona 3 dibatalkan\n");
+    VirtualClock clock(0);
+    TimelineOutput relay(clock);
+    ValveBank<VALVE_ZONES> valves(relay, config);
+    valves.begin();
+
+    valves.request(0, RUN_MS, false, clock.millis());
+    clock.advance(10000);
+    bool manualOk = valves.request(1, 0, true, clock.millis()); // Remote ON, sampai ditutup
+    bool duplicate = valves.request(1, RUN_MS, false, clock.millis());
+    bool outOfRange = valves.request(VALVE_ZONES, RUN_MS, false, clock.millis());
+    valves.request(2, RUN_MS, false, clock.millis());           // Antri (slot pompa penuh)
+    clock.advance(5000);
+    valves.update(clock.millis());
+    bool cancelled = valves.close(2, clock.millis());            // Dibatalkan sebelum dibuka
+    runUntilIdle(valves, clock, 120000UL);                       // Zona 1 selesai sendiri
+    bool manualStillOpen = valves.isOpen(1) && valves.isManual(1);
+    clock.advance(30000);
+    uint8_t closedScheduled = valves.closeWhere(false, clock.millis());
+    uint8_t closedManual = valves.closeWhere(true, clock.millis()); // Remote OFF
+    printTimeline(relay);
+
+    check(manualOk && !duplicate && !outOfRange, "request ke zona terbuka / di luar jumlah zona ditolak");
+    check(cancelled && relay.at(2, true) < 0, "zona antrian yang ditutup tidak pernah dibuka");
+    check(relay.at(0, false) == (long)RUN_MS, "jadwal zona 1 tidak terganggu override");
+    check(manualStillOpen && closedScheduled == 0 && closedManual == 1 && relay.at(1, false) == 90000,
+          "zona manual terbuka sampai ditutup, closeWhere() hanya jenisnya sendiri");
+}
+
+// Sensor soil hanya mengukur bed zona 1: tanah basah tidak menghentikan zona 2
+static void moistureZones() {
+    const ValveBankConfig config = {2, 5000UL};
+    const MoistureControllerConfig moistureConfig = {40.0f, 60.0f, 0.25f, 2.0f, 900000UL};
+    const uint32_t zones = moistureZoneBit(0);
+    printf("\nKelembapan: sensor di bed zona 1, tanah basah di tengah jadwal zona 1 & 2\n");
+    VirtualClock clock(0);
+    TimelineOutput relay(clock);
+    ValveBank<VALVE_ZONES> valves(relay, config);
+    MoistureController moisture(moistureConfig);
+    valves.begin();
+
+    const ScheduleEntry bed1 = {6 * 60, RUN_MS / 1000, WEEKDAYS_ALL, 0, 1, 0};
+    const ScheduleEntry bed2 = {6 * 60, RUN_MS / 1000, WEEKDAYS_ALL, 1, 1, 0};
+    const ScheduleEntry bed3 = {7 * 60, RUN_MS / 1000, WEEKDAYS_ALL, 2, 1, 0};
+    startScheduledRun(bed1, &moisture, zones, valves, clock.millis());
+    startScheduledRun(bed2, &moisture, zones, valves, clock.millis());
+    clock.advance(valves.update(clock.millis()));               // Zona 2 dibuka setelah stagger
+    valves.update(clock.millis());
+    clock.advance(15000);
+    uint8_t stopped = applyMoisture(moisture, valves, zones, 65.0f, clock.millis(), clock.millis());
+    runUntilIdle(valves, clock, 120000UL);
+    ScheduledRun skipped = startScheduledRun(bed1, &moisture, zones, valves, clock.millis());
+    ScheduledRun unmapped = startScheduledRun(bed3, &moisture, zones, valves, clock.millis());
+    runUntilIdle(valves, clock, 240000UL);
+    printTimeline(relay);
+
+    check(stopped == 1 && relay.at(0, false) == 20000 && relay.at(1, false) == 5000 + (long)RUN_MS,
+          "cutoff hanya menutup zona yang diukur sensor");
+    check(skipped.plan.action == MoistureController::SKIP && !skipped.started,
+          "jadwal zona yang diukur dilewati saat tanah basah");
+    check(unmapped.plan.action == MoistureController::RUN_OPEN_LOOP && unmapped.started &&
+              relay.at(2, true) >= 0,
+          "zona di luar moistureZones tetap open-loop");
+}
+
+// valveTask bangun terlambat: keterlambatan tutup tercatat
+static void lateUpdate() {
+    printf("\nvalveTask terlambat 1,5 s membangunkan ValveBank\n");
+    VirtualClock clock(0);
+    TimelineOutput relay(clock);
+    ValveBank<VALVE_ZONES> valves(relay, BANK_CONFIG);
+    valves.begin();
+    valves.request(0, RUN_MS, false, clock.millis());
+    clock.advance(valves.update(clock.millis()) + 1500);
+    valves.update(clock.millis());
+    printTimeline(relay);
+
+    check(relay.at(0, false) == (long)RUN_MS + 1500 && valves.maxCloseLateMs() == 1500,
+          "maxCloseLateMs() = keterlambatan tutup terbesar");
+}
+
+int runValveBank(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+    printf("ValveBank dengan relay tiruan (waktu virtual)\n");
+    sequencedRuns();
+    concurrentRuns();
+    manualOverride();
+    moistureZones();
+    lateUpdate();
+
+    printf("\n%s\n", failures == 0 ? "Semua pemeriksaan ValveBank lulus." : "ADA PEMERIKSAAN VALVEBANK YANG GAGAL!");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,516 @@
+/*
+ * SIMULASI PENGAMAN VALVE - Latensi tutup saat task macet & link putus
+ *
+ * Menjalankan ValveBank + ValveSafety + GuardedValveOutput dengan logika
+ * valveTask, networkTask dan timer pengaman firmware dalam waktu virtual
+ * (langkah 10 ms). Relay tiruan merekam kapan output benar-benar mati, jadi
+ * latensi tutup diukur dari luar ValveSafety: saat relay mati dikurangi
+ * batas yang dilanggar (dihitung ulang oleh simulasi dari heartbeat, kontak
+ * server dan waktu buka).
+ *
+ * Skenario tetap, masing-masing tanpa dan dengan pengaman:
+ *   - remote ON lalu server mati (perintah OFF tidak pernah sampai);
+ *   - zona manual lupa ditutup;
+ *   - valveTask macet 60 detik tepat sebelum jadwal selesai;
+ *   - server mati selama penyiraman terjadwal (networkTask tertahan timeout
+ *     HTTP 5 detik terus-menerus);
+ *   - pipa tersumbat (zona terbuka tanpa aliran);
+ *   - valve macet terbuka setelah ditutup (bocor).
+ *
+ * Lalu percobaan acak (default 1000): jenis gangguan, fase timer, valveTask
+ * lambat menangani perintah (0-1,5 detik), queue penuh dan server mati
+ * diacak. Kode keluar 1 jika ada latensi tutup di atas SAFETY_TICK_MS +
+ * graceMs atau zona yang tidak pernah ditutup.
+ *
+ * Pemakaian: .pio/build/native/program --valve-safety [--trials N] [--seed N]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <algorithm>
+#include <vector>
+
+#include "SimHardware.h"
+#include "ValveBank.h"
+#include "ValveSafety.h"
+
+// ==================== KONSTANTA (sama dengan firmware) ====================
+const uint8_t ZONES = 4;
+const ValveBankConfig BANK_CONFIG = {1, 5000UL};     // VALVE_MAX_CONCURRENT, VALVE_STAGGER_MS
+const unsigned long SAFETY_TICK_MS = 100;
+const unsigned long VALVE_HEARTBEAT_MS = 1000;
+const unsigned long VALVE_WDT_TIMEOUT_MS = 10000;
+const unsigned long REMOTE_CHECK_INTERVAL = 5000;
+const unsigned long HTTP_TIMEOUT_MS = 5000;
+const size_t VALVE_QUEUE_LENGTH = 8;
+// SAFETY_CONFIG dengan FLOW_SENSOR_PIN aktif, tanpa sensor arus
+const ValveSafetyConfig SAFETY_CONFIG = {7200000UL, 1800000UL, 90000UL, 500, 3000, 1.0f, 0.5f, 30000UL, 0, 0};
+const unsigned long CLOSE_BOUND_MS = SAFETY_TICK_MS + 500;
+
+// Simulasi
+const unsigned long STEP_MS = 10;
+const unsigned long HTTP_OK_MS = 100;
+const unsigned long REBOOT_MS = 2000;
+const float ZONE_FLOW_LPM = 8.0f;
+const long NEVER = -1;
+
+// ==================== SKENARIO ====================
+
+struct Scenario {
+    const char* name;
+    unsigned long durationMs;
+    long remoteOnAt;            // Operator menekan ON di server (zona 0)
+    long remoteOffAt;           // Operator menekan OFF
+    long serverDownAt;          // Server/AP mati: setiap request tertahan HTTP_TIMEOUT_MS
+    long serverUpAt;
+    long scheduleAt;            // Jadwal membuka zona 0 selama scheduleMs
+    unsigned long scheduleMs;
+    long stallAt;               // valveTask macet (mis. deadlock mutex) selama stallMs
+    unsigned long stallMs;
+    bool blocked;               // Pipa zona 0 tersumbat
+    bool stuckOpen;             // Valve zona 0 tetap mengalir setelah ditutup
+    unsigned long busyMs;       // valveTask lambat menangani setiap perintah
+    bool queueFull;             // Perintah tutup dari timer tidak masuk queue
+    unsigned long tickPhaseMs;
+    long intendedMs;            // Lama buka yang dimaksud operator/jadwal (NEVER = tidak ada)
+};
+
+struct RunResult {
+    unsigned long openMs;       // Relay zona 0 terbuka
+    uint32_t opens;
+    long latencyMs;             // Relay mati - batas dilanggar (-1 = tidak ada penutupan pengaman)
+    ValveFault fault;
+    bool closed;                // Zona dengan gangguan akhirnya tertutup
+    uint32_t cuts;
+    uint32_t resets;            // Task watchdog
+    long alarmAfterMs;          // Alarm bocor/stall sejak gangguan (-1 = tidak ada)
+};
+
+// ==================== NODE TIRUAN ====================
+
+enum SimCommandType { CMD_REMOTE_ON, CMD_REMOTE_OFF, CMD_SCHEDULE, CMD_SAFETY_CLOSE };
+
+struct SimCommand {
+    SimCommandType type;
+    uint8_t zone;
+    unsigned long durationMs;
+};
+
+class SimNode;
+static SimNode* activeNode = nullptr;
+static void onZoneChange(uint8_t zone, bool open, unsigned long openMs, bool manual);
+
+class SimNode {
+public:
+    SimNode(const Scenario& s, bool safetyOn)
+        : _s(s), _safetyOn(safetyOn), _relay(_clock), _guard(_relay), _valves(_guard, BANK_CONFIG, onZoneChange),
+          _safety(SAFETY_CONFIG) {
+        activeNode = this;
+        _valves.begin();
+        _safety.begin(0);
+    }
+
+    ~SimNode() { activeNode = nullptr; }
+
+    RunResult run() {
+        RunResult r = {};
+        r.latencyMs = -1;
+        r.alarmAfterMs = -1;
+        r.closed = true;
+        while (_clock.millis() < _s.durationMs) {
+            unsigned long now = _clock.millis();
+            operatorEvents(now);
+            networkTask(now);
+            valveTask(now);
+            if (_safetyOn && now % SAFETY_TICK_MS == _s.tickPhaseMs) safetyTick(now);
+
+            bool open = _relay.isOpen(0);
+            if (_wasOpen && !open && _latencyPending) {
+                _latencyPending = false;
+                long latency = (long)(now - _deadline);
+                if (latency > r.latencyMs) r.latencyMs = latency;
+            }
+            _wasOpen = open;
+            _clock.advance(STEP_MS);
+        }
+        r.openMs = _relay.openMs(0);
+        r.opens = _relay.opens(0);
+        r.fault = _fault;
+        r.closed = !_latencyPending;
+        r.cuts = _safety.cuts();
+        r.resets = _resets;
+        r.alarmAfterMs = _alarmAfterMs;
+        return r;
+    }
+
+    void zoneChanged(uint8_t zone, bool open, bool manual) {
+        unsigned long now = _clock.millis();
+        if (zone == 0 && open) _openedAt = now;
+        if (!_safetyOn) return;
+        if (open) _safety.opened(zone, manual, now);
+        else _safety.closed(zone, now);
+    }
+
+private:
+    // --- Server & operator ---
+    void operatorEvents(unsigned long now) {
+        if ((long)now == _s.remoteOnAt) _serverOn = true;
+        if ((long)now == _s.remoteOffAt) _serverOn = false;
+        if ((long)now == _s.scheduleAt) push({CMD_SCHEDULE, 0, _s.scheduleMs});
+    }
+
+    bool serverUp(unsigned long now) const {
+        return _s.serverDownAt == NEVER || (long)now < _s.serverDownAt ||
+               (_s.serverUpAt != NEVER && (long)now >= _s.serverUpAt);
+    }
+
+    // checkRemoteStatus tiap REMOTE_CHECK_INTERVAL; saat server mati request
+    // tertahan timeout sehingga job langsung jatuh tempo lagi
+    void networkTask(unsigned long now) {
+        if (now < _netBusyUntil) return;
+        if (_netReplyPending) {
+            _netReplyPending = false;
+            _linkAt = now;
+            if (_safetyOn) _safety.linkOk(now);
+            if (_s.remoteOnAt != NEVER) push({_serverOn ? CMD_REMOTE_ON : CMD_REMOTE_OFF, 0, 0});
+        }
+        if (now - _lastPoll < REMOTE_CHECK_INTERVAL && _lastPoll != 0) return;
+        _lastPoll = now ? now : 1;
+        bool up = serverUp(now);
+        _netBusyUntil = now + (up ? HTTP_OK_MS : HTTP_TIMEOUT_MS);
+        _netReplyPending = up;
+    }
+
+    bool push(const SimCommand& cmd) {
+        if (_queue.size() >= VALVE_QUEUE_LENGTH) return false;
+        _queue.push_back(cmd);
+        return true;
+    }
+
+    // --- valveTask ---
+    bool stalled(unsigned long now) const {
+        return _s.stallAt != NEVER && !_rebooted && (long)now >= _s.stallAt &&
+               (long)now < _s.stallAt + (long)_s.stallMs;
+    }
+
+    void valveTask(unsigned long now) {
+        if (_safetyOn && (long)(now - _heartbeatAt) >= (long)VALVE_WDT_TIMEOUT_MS) watchdogReset(now);
+        if (now < _rebootUntil || stalled(now)) return;
+        if (_pending) {
+            if (now < _busyUntil) return;
+            _pending = false;
+            handle(_pendingCmd, now);
+            _wakeAt = now;
+        }
+        if (_queue.empty() && now < _wakeAt) return;
+
+        if (_safetyOn) {
+            _heartbeatAt = now;
+            _safety.heartbeat(now);
+            uint32_t cut = _guard.cutZones();
+            for (uint8_t z = 0; cut && z < ZONES; z++) {
+                if (cut & (1UL << z)) safetyCloseZone(z, now);
+            }
+        }
+        unsigned long until = _valves.update(now);
+        if (_safetyOn && until > VALVE_HEARTBEAT_MS) until = VALVE_HEARTBEAT_MS;
+        _wakeAt = until >= ULONG_MAX - now ? ULONG_MAX : now + until;
+
+        if (_queue.empty()) return;
+        SimCommand cmd = _queue.front();
+        _queue.erase(_queue.begin());
+        if (_s.busyMs > 0) {
+            _pending = true;
+            _pendingCmd = cmd;
+            _busyUntil = now + _s.busyMs;
+        } else {
+            handle(cmd, now);
+            _wakeAt = now;
+        }
+    }
+
+    void handle(const SimCommand& cmd, unsigned long now) {
+        uint32_t bit = 1UL << cmd.zone;
+        if (cmd.type == CMD_REMOTE_ON) {
+            if (!(_latched & bit)) _valves.request(cmd.zone, 0, true, now);
+        } else if (cmd.type == CMD_REMOTE_OFF) {
+            _latched &= ~bit;
+            if (_valves.isManual(cmd.zone)) _valves.close(cmd.zone, now);
+        } else if (cmd.type == CMD_SCHEDULE) {
+            _valves.request(cmd.zone, cmd.durationMs, false, now);
+        } else {
+            safetyCloseZone(cmd.zone, now);
+        }
+    }
+
+    // Sama dengan safetyCloseZone() firmware
+    void safetyCloseZone(uint8_t zone, unsigned long now) {
+        if (!_valves.isOpen(zone)) return;
+        if (_valves.isManual(zone)) _latched |= 1UL << zone;
+        _valves.close(zone, now);
+    }
+
+    // Panic TWDT: reboot, relay kembali mati, ValveBank & pengaman mulai dari nol
+    void watchdogReset(unsigned long now) {
+        _resets++;
+        _rebooted = true;
+        _rebootUntil = now + REBOOT_MS;
+        _valves.closeWhere(true, now);
+        _valves.closeWhere(false, now);
+        _queue.clear();
+        _pending = false;
+        _latched = 0;
+        _heartbeatAt = _rebootUntil;
+        _safety.heartbeat(_rebootUntil);
+    }
+
+    // --- Timer pengaman (safetyTick firmware) ---
+    void safetyTick(unsigned long now) {
+        if (now - _flowAt >= 1000) {
+            _flowAt = now;
+            _safety.reportFlow(flowLpm(now), now);
+        }
+        ValveSafetyAction action = _safety.check(now);
+        if (action.cut) _guard.cut(action.cut);
+        if (action.alarm != VALVE_FAULT_NONE && _alarmAfterMs < 0) {
+            long from = action.alarm == VALVE_FAULT_LEAK ? (long)_closedAt : _s.stallAt;
+            _alarmAfterMs = (long)now - from;
+        }
+        if ((action.close & 1) && !_latencyPending) {
+            _fault = _safety.fault(0);
+            _deadline = expectedDeadline(_fault);
+            _latencyPending = true;
+        }
+        for (uint8_t z = 0; z < ZONES; z++) {
+            if ((action.close & (1UL << z)) && !_s.queueFull) push({CMD_SAFETY_CLOSE, z, 0});
+        }
+    }
+
+    // Batas yang dilanggar menurut pengamatan simulasi sendiri
+    unsigned long expectedDeadline(ValveFault fault) const {
+        switch (fault) {
+        case VALVE_FAULT_MAX_OPEN: return _openedAt + SAFETY_CONFIG.maxOpenMs;
+        case VALVE_FAULT_MANUAL_MAX: return _openedAt + SAFETY_CONFIG.manualMaxMs;
+        case VALVE_FAULT_LINK_LOST: return std::max(_linkAt, _openedAt) + SAFETY_CONFIG.linkLossMs;
+        case VALVE_FAULT_TASK_STALL: return _heartbeatAt + SAFETY_CONFIG.stallMs;
+        default: return _clock.millis(); // Sensor: batas = saat gangguan dinyatakan
+        }
+    }
+
+    float flowLpm(unsigned long now) {
+        bool open = _relay.isOpen(0);
+        if (_wasOpenFlow && !open) _closedAt = now;
+        _wasOpenFlow = open;
+        float lpm = 0;
+        if (open && !_s.blocked) lpm += ZONE_FLOW_LPM;
+        if (!open && _s.stuckOpen && _relay.opens(0) > 0) lpm += ZONE_FLOW_LPM * 0.75f;
+        for (uint8_t z = 1; z < ZONES; z++) lpm += _relay.isOpen(z) ? ZONE_FLOW_LPM : 0;
+        return lpm;
+    }
+
+    const Scenario& _s;
+    bool _safetyOn;
+    VirtualClock _clock{0};
+    RecordingValveOutput _relay;
+    GuardedValveOutput _guard;
+    ValveBank<ZONES> _valves;
+    ValveSafety<ZONES> _safety;
+
+    std::vector<SimCommand> _queue;
+    bool _serverOn = false;
+    unsigned long _lastPoll = 0;
+    unsigned long _netBusyUntil = 0;
+    bool _netReplyPending = false;
+    unsigned long _linkAt = 0;
+
+    unsigned long _wakeAt = 0;
+    unsigned long _busyUntil = 0;
+    bool _pending = false;
+    SimCommand _pendingCmd = {};
+    unsigned long _heartbeatAt = 0;
+    uint32_t _latched = 0;
+    bool _rebooted = false;
+    unsigned long _rebootUntil = 0;
+    uint32_t _resets = 0;
+
+    unsigned long _flowAt = 0;
+    bool _wasOpenFlow = false;
+    unsigned long _closedAt = 0;
+    long _alarmAfterMs = -1;
+
+    unsigned long _openedAt = 0;
+    bool _wasOpen = false;
+    bool _latencyPending = false;
+    unsigned long _deadline = 0;
+    ValveFault _fault = VALVE_FAULT_NONE;
+};
+
+static void onZoneChange(uint8_t zone, bool open, unsigned long openMs, bool manual) {
+    activeNode->zoneChanged(zone, open, manual);
+}
+
+// ==================== LAPORAN ====================
+
+static Scenario baseScenario(const char* name, unsigned long durationMs) {
+    Scenario s = {};
+    s.name = name;
+    s.durationMs = durationMs;
+    s.remoteOnAt = s.remoteOffAt = s.serverDownAt = s.serverUpAt = NEVER;
+    s.scheduleAt = s.stallAt = NEVER;
+    s.intendedMs = NEVER;
+    return s;
+}
+
+static void printDuration(long ms) {
+    if (ms < 0) printf(" %9s", "-");
+    else if (ms >= 3600000L) printf(" %7.1f j", ms / 3600000.0);
+    else if (ms >= 60000L) printf(" %5.1f mnt", ms / 60000.0);
+    else printf(" %8.1fs", ms / 1000.0);
+}
+
+static double percentile(std::vector<long>& v, double p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    size_t i = (size_t)(p * (v.size() - 1) + 0.5);
+    return (double)v[i];
+}
+
+int runValveSafety(int argc, char** argv) {
+    uint32_t seed = 1;
+    int trials = 1000;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--seed") == 0) seed = (uint32_t)atoi(argv[i + 1]);
+        if (strcmp(argv[i], "--trials") == 0) trials = atoi(argv[i + 1]);
+    }
+
+    std::vector<Scenario> scenarios;
+    Scenario s = baseScenario("remote ON, server mati", 9000000UL);
+    s.remoteOnAt = 10000;
+    s.serverDownAt = 60000;
+    s.remoteOffAt = 120000;     // Tidak sampai sampai server hidup lagi
+    s.serverUpAt = 7200000;
+    s.intendedMs = 110000;
+    scenarios.push_back(s);
+
+    s = baseScenario("manual lupa ditutup", 10800000UL);
+    s.remoteOnAt = 10000;
+    scenarios.push_back(s);
+
+    s = baseScenario("valveTask macet 60 s", 900000UL);
+    s.scheduleAt = 1000;
+    s.scheduleMs = 600000;
+    s.stallAt = 590000;
+    s.stallMs = 60000;
+    s.intendedMs = 600000;
+    scenarios.push_back(s);
+
+    s = baseScenario("jadwal, server mati", 900000UL);
+    s.serverDownAt = 0;
+    s.scheduleAt = 1000;
+    s.scheduleMs = 600000;
+    s.intendedMs = 600000;
+    scenarios.push_back(s);
+
+    s = baseScenario("pipa tersumbat", 1500000UL);
+    s.scheduleAt = 1000;
+    s.scheduleMs = 1200000;
+    s.blocked = true;
+    scenarios.push_back(s);
+
+    s = baseScenario("valve macet terbuka", 600000UL);
+    s.scheduleAt = 1000;
+    s.scheduleMs = 300000;
+    s.stuckOpen = true;
+    s.intendedMs = 300000;
+    scenarios.push_back(s);
+
+    printf("Pengaman valve (tick %lu ms, grace %lu ms, batas latensi %lu ms)\n\n", SAFETY_TICK_MS,
+           SAFETY_CONFIG.graceMs, CLOSE_BOUND_MS);
+    printf("%-24s %-12s %9s %9s %5s %-11s %9s %6s %6s %9s\n", "skenario", "mode", "terbuka", "lewat", "buka",
+           "gangguan", "latensi", "putus", "reset", "alarm");
+    bool ok = true;
+    for (const Scenario& sc : scenarios) {
+        for (int safetyOn = 0; safetyOn < 2; safetyOn++) {
+            SimNode node(sc, safetyOn);
+            RunResult r = node.run();
+            printf("%-24s %-12s", sc.name, safetyOn ? "ValveSafety" : "tanpa");
+            printDuration(r.openMs);
+            printDuration(sc.intendedMs == NEVER ? -1 : std::max(0L, (long)r.openMs - sc.intendedMs));
+            printf(" %5u %-11s", r.opens, safetyOn ? valveFaultName(r.fault) : "-");
+            if (r.latencyMs >= 0) printf(" %6ld ms", r.latencyMs);
+            else printf(" %9s", "-");
+            printf(" %6u %6u", r.cuts, r.resets);
+            printDuration(r.alarmAfterMs);
+            printf("\n");
+            if (safetyOn && (r.latencyMs > (long)CLOSE_BOUND_MS || !r.closed)) ok = false;
+        }
+    }
+    printf("\nlewat   = terbuka melebihi maksud operator/jadwal\n");
+    printf("latensi = relay mati - batas dilanggar (diukur dari relay)\n");
+    printf("alarm   = sejak valve ditutup (bocor) / valveTask macet\n\n");
+
+    // --- Percobaan acak ---
+    Prng rng(seed * 2654435761u);
+    std::vector<long> latencies;
+    uint32_t perFault[VALVE_FAULT_CURRENT + 1] = {};
+    int cutTrials = 0, violations = 0, unclosed = 0;
+    const ValveFault kinds[] = {VALVE_FAULT_LINK_LOST, VALVE_FAULT_TASK_STALL, VALVE_FAULT_NO_FLOW,
+                                VALVE_FAULT_MANUAL_MAX};
+    for (int t = 0; t < trials; t++) {
+        // Batas manual 30 menit paling mahal disimulasikan, jadi lebih jarang
+        ValveFault kind = kinds[rng.next() % 16 == 0 ? 3 : rng.next() % 3];
+        Scenario tr = baseScenario("acak", 0);
+        tr.tickPhaseMs = (rng.next() % (SAFETY_TICK_MS / STEP_MS)) * STEP_MS;
+        tr.busyMs = rng.uniform() < 0.5f ? 0 : (rng.next() % 151) * STEP_MS;
+        tr.queueFull = rng.uniform() < 0.2f;
+        if (kind == VALVE_FAULT_LINK_LOST || kind == VALVE_FAULT_MANUAL_MAX) {
+            tr.remoteOnAt = (long)(1 + rng.next() % 10) * 1000;
+            if (kind == VALVE_FAULT_LINK_LOST) tr.serverDownAt = tr.remoteOnAt + (long)(rng.next() % 60000 / STEP_MS * STEP_MS);
+            tr.durationMs = kind == VALVE_FAULT_LINK_LOST ? 200000UL : 1830000UL;
+        } else {
+            tr.scheduleAt = 1000;
+            tr.scheduleMs = 120000;
+            if (rng.uniform() < 0.5f) tr.serverDownAt = (long)(rng.next() % 60) * 1000;
+            if (kind == VALVE_FAULT_TASK_STALL) {
+                tr.stallAt = 2000 + (long)(rng.next() % 110000 / STEP_MS * STEP_MS);
+                tr.stallMs = 1000 + (rng.next() % 30) * 1000;
+            } else {
+                tr.blocked = true;
+            }
+            tr.durationMs = 180000UL;
+        }
+
+        SimNode node(tr, true);
+        RunResult r = node.run();
+        if (r.latencyMs < 0) {
+            // Zona tidak sempat dibuka (server mati sebelum polling) atau stall
+            // pendek (<= stallMs): memang tidak ada yang harus ditutup
+            bool expected = r.opens > 0 && (kind != VALVE_FAULT_TASK_STALL || tr.stallMs > SAFETY_CONFIG.stallMs);
+            if (expected) unclosed++;
+            continue;
+        }
+        if (!r.closed) unclosed++;
+        latencies.push_back(r.latencyMs);
+        perFault[r.fault]++;
+        if (r.cuts) cutTrials++;
+        if (r.latencyMs > (long)CLOSE_BOUND_MS) violations++;
+    }
+
+    printf("Percobaan acak: %d (seed %u)\n", trials, seed);
+    printf("  gangguan      :");
+    for (uint8_t f = VALVE_FAULT_MAX_OPEN; f <= VALVE_FAULT_CURRENT; f++) {
+        if (perFault[f]) printf(" %s %u", valveFaultName((ValveFault)f), perFault[f]);
+    }
+    printf("\n  output diputus: %d (valveTask lambat/macet atau queue penuh)\n", cutTrials);
+    double p50 = percentile(latencies, 0.5), p99 = percentile(latencies, 0.99);
+    long maxLatency = latencies.empty() ? 0 : latencies.back();
+    printf("  latensi tutup : p50 %.0f ms, p99 %.0f ms, maks %ld ms (batas %lu ms)\n", p50, p99, maxLatency,
+           CLOSE_BOUND_MS);
+    printf("  melewati batas: %d, tidak tertutup: %d\n", violations, unclosed);
+    if (violations || unclosed) ok = false;
+
+    printf("\n%s\n", ok ? "Semua penutupan dalam batas." : "ADA PENUTUPAN DI LUAR BATAS!");
+    return ok ? 0 : 1;
+}
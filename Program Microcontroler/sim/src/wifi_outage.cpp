@@ -0,0 +1,237 @@
+/*
+ * SIMULASI GANGGUAN AP - Waktu loop yang hilang saat WiFi putus
+ *
+ * Membandingkan reconnect lama (while (...) { delay(500); } hingga 10 detik,
+ * sensor node restart bila gagal) dengan WifiStateMachine (event + backoff
+ * eksponensial berjitter) untuk beberapa lama gangguan AP, dalam waktu
+ * virtual dengan langkah loop 10 ms.
+ *
+ * Per strategi & lama gangguan dilaporkan:
+ *   - loop terblokir : total waktu virtual loop tertahan di kode WiFi
+ *   - stall maks     : blokir terpanjang tanpa loop berjalan
+ *   - percobaan      : jumlah WiFi.begin() (beban ke AP)
+ *   - pulih          : dari AP hidup kembali sampai terhubung
+ *   - restart        : ESP.restart() (hanya sensor lama)
+ *   - ns/update      : biaya CPU nyata wifi.update() per iterasi loop (host)
+ *
+ * Radio tiruan: asosiasi 1.5-3.5 s saat AP hidup; saat AP mati, event
+ * STA_DISCONNECTED (NO_AP_FOUND) datang setelah scan 2.5 s.
+ *
+ * Pemakaian: .pio/build/native/program --wifi-outage [--seed N]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "SimHardware.h"
+#include <WifiStateMachine.h>
+
+// ==================== KONSTANTA (sama dengan firmware) ====================
+const unsigned long LEGACY_ATTEMPT_STEP_MS = 500;   // delay(500) x 20
+const int LEGACY_ATTEMPTS = 20;
+const unsigned long LEGACY_RESTART_MS = 3000 + 1000; // delay(3000) + boot
+const unsigned long REMOTE_CHECK_INTERVAL = 5000;    // checkRemoteStatus (control)
+const WifiBackoffConfig BACKOFF = {10000UL, 2000UL, 60000UL}; // WIFI_DEFAULT_BACKOFF
+
+// Simulasi
+const unsigned long LOOP_STEP_MS = 10;
+const unsigned long SCAN_FAIL_MS = 2500;
+const unsigned long CONNECTED_BEFORE_MS = 120000UL;
+const unsigned long RECOVERY_WINDOW_MS = 900000UL;
+
+// ==================== AP & RADIO TIRUAN ====================
+
+class SimRadio {
+public:
+    SimRadio(const VirtualClock& clock, Prng& rng) : _clock(clock), _rng(rng) {}
+
+    void setOutage(unsigned long start, unsigned long end) {
+        _outageStart = start;
+        _outageEnd = end;
+    }
+
+    bool apUp() const {
+        unsigned long now = _clock.millis();
+        return now < _outageStart || now >= _outageEnd;
+    }
+
+    // WiFi.begin(): hasil datang setelah asosiasi / scan
+    void begin() {
+        _attempts++;
+        _connected = false;
+        _pending = true;
+        _doneAt = _clock.millis() + (apUp() ? 1500 + _rng.next() % 2001 : SCAN_FAIL_MS);
+    }
+
+    void disconnect() { _pending = false; }
+
+    // Dipanggil tiap langkah; menghasilkan event "putus" seperti driver ESP32
+    void tick() {
+        unsigned long now = _clock.millis();
+        if (_pending && now >= _doneAt) {
+            _pending = false;
+            if (apUp()) _connected = true;
+            else _lost = true;
+        }
+        if (_connected && !apUp()) {
+            _connected = false;
+            _lost = true;
+        }
+    }
+
+    bool connected() const { return _connected; }                   // WiFi.status() == WL_CONNECTED
+    bool takeLost() { bool lost = _lost; _lost = false; return lost; } // Flag dari handler event
+    uint32_t attempts() const { return _attempts; }
+
+    void forceConnected() { _connected = true; }
+
+private:
+    const VirtualClock& _clock;
+    Prng& _rng;
+    unsigned long _outageStart = 0;
+    unsigned long _outageEnd = 0;
+    unsigned long _doneAt = 0;
+    bool _pending = false;
+    bool _connected = false;
+    bool _lost = false;
+    uint32_t _attempts = 0;
+};
+
+// ==================== STRATEGI ====================
+
+enum Strategy { LEGACY_CONTROL, LEGACY_SENSOR, STATE_MACHINE };
+const char* const STRATEGY_NAMES[] = {"control lama", "sensor lama", "WifiStateMachine"};
+
+struct OutageResult {
+    unsigned long blockedMs;
+    unsigned long longestStallMs;
+    uint32_t attempts;
+    unsigned long recoveryMs;   // AP hidup -> terhubung (0 jika tidak pulih)
+    uint32_t restarts;
+    double nsPerUpdate;
+};
+
+static Prng* jitterRng = nullptr;
+static uint32_t jitter() { return jitterRng->next(); }
+
+static void startAttempt(void* ctx) { static_cast<SimRadio*>(ctx)->begin(); }
+
+static void machineEvent(WifiStateMachine::Event event, unsigned long value, void* ctx) {
+    if (event == WifiStateMachine::ATTEMPT_FAILED_EVENT) static_cast<SimRadio*>(ctx)->disconnect();
+}
+
+// connectWiFi()/setupWiFi() lama: blok sampai terhubung atau 20 x 500 ms
+static bool legacyConnect(VirtualClock& clock, SimRadio& radio, unsigned long& blocked) {
+    radio.begin();
+    int attempts = 0;
+    while (!radio.connected() && attempts < LEGACY_ATTEMPTS) {
+        clock.advance(LEGACY_ATTEMPT_STEP_MS);
+        blocked += LEGACY_ATTEMPT_STEP_MS;
+        radio.tick();
+        if (radio.takeLost()) radio.begin(); // Auto-reconnect driver (bawaan) mencoba lagi
+        attempts++;
+    }
+    return radio.connected();
+}
+
+OutageResult runOutage(Strategy strategy, unsigned long outageMs, uint32_t seed) {
+    OutageResult r = {};
+    VirtualClock clock(0);
+    Prng rng(seed);
+    jitterRng = &rng;
+    SimRadio radio(clock, rng);
+
+    unsigned long outageEnd = CONNECTED_BEFORE_MS + outageMs;
+    unsigned long end = outageEnd + RECOVERY_WINDOW_MS;
+    radio.setOutage(CONNECTED_BEFORE_MS, outageEnd);
+
+    WifiStateMachine machine(BACKOFF, startAttempt, jitter, &radio);
+    machine.onEvent(machineEvent);
+    machine.start(0);
+    radio.forceConnected();
+    machine.onConnected(0);
+    uint32_t baseAttempts = radio.attempts();
+
+    unsigned long lastRemoteCheck = 0;
+    uint64_t updateNs = 0;
+    uint64_t updates = 0;
+
+    while (clock.millis() < end) {
+        unsigned long before = clock.millis();
+        unsigned long blocked = 0;
+        radio.tick();
+
+        if (strategy == STATE_MACHINE) {
+            // Sama dengan WifiManager::update()
+            auto t0 = std::chrono::steady_clock::now();
+            bool lost = radio.takeLost();
+            if (radio.connected()) {
+                if (!machine.connected()) machine.onConnected(before);
+            } else if (lost || machine.connected()) {
+                machine.onDisconnected(before);
+            }
+            machine.update(before);
+            updateNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - t0).count();
+            updates++;
+        } else if (strategy == LEGACY_CONTROL) {
+            // checkRemoteStatus tiap 5 s; blok 10 s membuat job langsung jatuh tempo lagi
+            if (before - lastRemoteCheck >= REMOTE_CHECK_INTERVAL) {
+                lastRemoteCheck = before;
+                if (!radio.connected()) legacyConnect(clock, radio, blocked);
+            }
+        } else {
+            // loop() sensor: reconnect setiap iterasi, restart bila gagal
+            if (!radio.connected() && !legacyConnect(clock, radio, blocked)) {
+                clock.advance(LEGACY_RESTART_MS);
+                blocked += LEGACY_RESTART_MS;
+                r.restarts++;
+            }
+        }
+
+        bool connected = strategy == STATE_MACHINE ? machine.connected() : radio.connected();
+        if (connected && r.recoveryMs == 0 && clock.millis() >= outageEnd) {
+            r.recoveryMs = clock.millis() - outageEnd;
+            if (r.recoveryMs == 0) r.recoveryMs = 1;
+        }
+
+        r.blockedMs += blocked;
+        if (blocked > r.longestStallMs) r.longestStallMs = blocked;
+        clock.advance(LOOP_STEP_MS);
+    }
+
+    r.attempts = radio.attempts() - baseAttempts;
+    r.nsPerUpdate = updates ? (double)updateNs / updates : 0.0;
+    jitterRng = nullptr;
+    return r;
+}
+
+int runWifiOutage(int argc, char** argv) {
+    uint32_t seed = 42;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--seed") == 0) seed = (uint32_t)atoi(argv[i + 1]);
+    }
+
+    const unsigned long outages[] = {30000UL, 300000UL, 3600000UL};
+    const Strategy strategies[] = {LEGACY_CONTROL, LEGACY_SENSOR, STATE_MACHINE};
+
+    printf("Gangguan AP, seed %u (loop %lu ms, pulih diamati %lu menit)\n\n", seed, LOOP_STEP_MS,
+           RECOVERY_WINDOW_MS / 60000);
+    printf("%-18s %8s %12s %8s %10s %10s %8s %10s\n", "strategi", "gangguan", "terblokir", "(%)",
+           "stall maks", "percobaan", "restart", "pulih");
+    for (unsigned long outage : outages) {
+        for (Strategy strategy : strategies) {
+            OutageResult r = runOutage(strategy, outage, seed);
+            printf("%-18s %7lus %11.1fs %7.1f%% %9.1fs %10u %8u %9.1fs", STRATEGY_NAMES[strategy],
+                   outage / 1000, r.blockedMs / 1000.0, 100.0 * r.blockedMs / outage, r.longestStallMs / 1000.0,
+                   r.attempts, r.restarts, r.recoveryMs / 1000.0);
+            if (strategy == STATE_MACHINE) printf("  (%.0f ns/update)", r.nsPerUpdate);
+            printf("\n");
+        }
+        printf("\n");
+    }
+    printf("(%%) = waktu loop terblokir dibanding lama gangguan\n");
+    return 0;
+}